@@ -0,0 +1,94 @@
+#pragma once
+
+// Duty y energia de los LEDs por escena (modo x base/movimiento). Compartido
+// por el firmware (src/virgencitaluces.cpp, comando "duty") y el barrido de
+// host (src/tools/profile_sweep.cpp, "profile_sweep duty").
+//
+// Por frame (dutyFrame): nivel x ms de cada canal y la mayor corriente
+// instantanea, con productos de 8x16 bits y sin divisiones. Una vez por
+// segundo, o al cambiar de escena (dutyFold), los segundos enteros pasan a la
+// escena: tiempo, carga de los LEDs en mA*s (corrientes de power_model.h) y pico
+// en mA. Los restos de menos de un segundo siguen en DutyLive y cuentan para
+// la escena siguiente (error < 1 s por cambio).
+//
+// Duty de una escena = corriente media de los LEDs / corriente con todos al
+// 100% (POWER_LED_TOTAL_MA). Con la misma corriente en cada canal es la media
+// de los duty de los canales.
+
+#include <stdint.h>
+
+#include "power_model.h"
+
+constexpr uint16_t powerLedTotalMa(uint8_t i = 0) {
+  return i >= POWER_CHANNEL_COUNT ? 0 : (uint16_t)(POWER_LED_FULL_MA[i] + powerLedTotalMa((uint8_t)(i + 1)));
+}
+
+const uint16_t POWER_LED_TOTAL_MA = powerLedTotalMa();
+static_assert(POWER_LED_TOTAL_MA * 255UL <= 0xFFFFUL, "duty: el pico instantaneo no cabe en 16 bits");
+
+struct DutyScene {
+  uint32_t seconds;  // tiempo en la escena (despierto)
+  uint32_t ledMaS;   // carga de los LEDs, mA*s
+  uint8_t peakMa;    // mayor corriente de LEDs en un frame
+};
+
+struct DutyLive {
+  uint32_t levelMs[POWER_CHANNEL_COUNT]; // nivel (0..255) x ms sin volcar
+  uint16_t ms;                           // ms sin volcar
+  uint16_t peak;                         // mayor sum(nivel x mA) desde el ultimo volcado
+  uint16_t uaS;                          // resto en uA*s de la carga volcada
+};
+
+// Un frame con los niveles de salida (0..255); true si toca dutyFold().
+inline bool dutyFrame(DutyLive& l, const uint8_t* levels, uint16_t dtMs) {
+  uint16_t inst = 0;
+  for (uint8_t i = 0; i < POWER_CHANNEL_COUNT; i++) {
+    l.levelMs[i] += (uint32_t)levels[i] * dtMs;
+    inst += (uint16_t)levels[i] * POWER_LED_FULL_MA[i];
+  }
+  if (inst > l.peak) l.peak = inst;
+  l.ms = (uint16_t)((uint32_t)l.ms + dtMs > 0xFFFF ? 0xFFFF : l.ms + dtMs);
+  return l.ms >= 1000;
+}
+
+// Vuelca los segundos enteros en la escena s y en los totales por canal
+// (nivel x s, desde el ultimo reset; channelS puede ser 0).
+inline void dutyFold(DutyLive& l, DutyScene& s, uint32_t* channelS) {
+  uint16_t secs = (uint16_t)(l.ms / 1000);
+  l.ms = (uint16_t)(l.ms - secs * 1000U);
+  s.seconds += secs;
+  uint32_t levelMaS = 0; // sum(nivel x s x mA)
+  for (uint8_t i = 0; i < POWER_CHANNEL_COUNT; i++) {
+    uint32_t q = l.levelMs[i] / 1000;
+    l.levelMs[i] -= q * 1000;
+    if (channelS) channelS[i] += q;
+    levelMaS += q * POWER_LED_FULL_MA[i];
+  }
+  uint32_t ua = levelMaS * 1000UL / 255UL + l.uaS;
+  s.ledMaS += ua / 1000;
+  l.uaS = (uint16_t)(ua % 1000);
+  uint8_t peakMa = (uint8_t)((l.peak + 254U) / 255U);
+  if (peakMa > s.peakMa) s.peakMa = peakMa;
+  l.peak = 0;
+}
+
+// Corriente media de los LEDs en decimas de mA.
+inline uint16_t dutyAvgDeciMa(const DutyScene& s) {
+  if (s.seconds == 0) return 0;
+  return (uint16_t)(s.ledMaS / s.seconds * 10 + s.ledMaS % s.seconds * 10 / s.seconds);
+}
+
+// Duty en decimas de % a partir de una corriente en decimas de mA.
+inline uint16_t dutyPermille(uint16_t deciMa) {
+  return (uint16_t)((uint32_t)deciMa * 100 / POWER_LED_TOTAL_MA);
+}
+
+// Duty medio de un canal en decimas de % (channelS = nivel x s en seconds s).
+inline uint16_t dutyChannelPermille(uint32_t channelS, uint32_t seconds) {
+  while (seconds > 4000000UL) { // el resto x 1000 debe caber en 32 bits
+    seconds >>= 1;
+    channelS >>= 1;
+  }
+  if (seconds == 0) return 0;
+  return (uint16_t)((channelS / seconds * 1000 + channelS % seconds * 1000 / seconds) / 255);
+}
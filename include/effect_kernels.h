@@ -0,0 +1,230 @@
+#pragma once
+
+// Nucleos de efecto sin Arduino ni estado global: descriptores, formas de onda
+// y el paso de los efectos aleatorios (candelita, deriva organica, fade).
+// Compartido por el firmware (src/virgencitaluces.cpp, que los llama con
+// descriptores constexpr: el compilador pliega las constantes) y el barrido de
+// parametros de host (src/tools/profile_sweep.cpp, con descriptores en tiempo
+// de ejecucion).
+//
+// Los pasos aleatorios reciben el generador como parametro: rng(lo, hi)
+// devuelve un entero en lo..hi-1, igual que random(lo, hi) de Arduino. El
+// orden de las llamadas es el del firmware original (misma secuencia con la
+// misma semilla).
+
+#include <stdint.h>
+
+constexpr uint8_t percentToPwm(uint8_t percent) {
+  return (uint8_t)(((percent > 100 ? 100 : percent) * 255UL + 50) / 100); // redondeo a entero mas cercano
+}
+
+// Timers relativos de 16 bits: se comparan por diferencia, asi que el wrap de
+// 65.5 s es inocuo mientras ningun intervalo supere EFFECT_TIMER_MAX_MS.
+const uint16_t EFFECT_TIMER_MAX_MS = 30000;
+
+inline uint16_t timerElapsed(uint16_t tick, uint16_t since) {
+  return (uint16_t)(tick - since);
+}
+
+inline bool timerDue(uint16_t tick, uint16_t deadline) {
+  return (int16_t)(tick - deadline) >= 0;
+}
+
+// ==== Formas de onda (respiracion, halo, ola) ====
+
+// Incremento de fase por ms en Q24 (2^24 = un periodo).
+constexpr uint32_t phaseIncForPeriod(uint32_t periodMs) {
+  return (16777216UL + periodMs / 2) / periodMs;
+}
+
+// Fase de 16 bits (65536 = un periodo): un producto de 32 bits en vez de now % periodo.
+inline uint16_t wavePhase(unsigned long now, uint32_t phaseInc) {
+  return (uint16_t)((uint32_t)(now * phaseInc) >> 8);
+}
+
+// Triangulo 0..256 (sube en la primera mitad del periodo, baja en la segunda).
+inline uint16_t triangleQ8(uint16_t phase) {
+  return (phase < 32768U) ? (uint16_t)(phase >> 7) : (uint16_t)((uint16_t)(0U - phase) >> 7);
+}
+
+inline uint8_t waveLevel(uint8_t minPwm, uint8_t spanPwm, uint16_t tri) {
+  return (uint8_t)(minPwm + (((uint16_t)spanPwm * tri) >> 8));
+}
+
+// Onda triangular min..max con periodo fijo (respiracion, halo, ola).
+struct WaveDesc {
+  uint8_t minPct;
+  uint8_t maxPct;
+  uint32_t periodMs;
+  uint8_t minPwm;
+  uint8_t spanPwm;
+  uint32_t phaseInc;
+};
+
+constexpr WaveDesc waveDesc(uint8_t minPct, uint8_t maxPct, uint32_t periodMs) {
+  return WaveDesc{minPct, maxPct, periodMs, percentToPwm(minPct),
+                  (uint8_t)(percentToPwm(maxPct) - percentToPwm(minPct)), phaseIncForPeriod(periodMs)};
+}
+
+// ==== Candelita (CAN1 + CAN2) ====
+
+// Coeficientes del parpadeo. CANDLE_COEFS_DEFAULT son los valores historicos;
+// profile_sweep vela busca otros.
+struct CandleCoefs {
+  uint8_t intervalMinMs; // intervalo entre ticks, aleatorio min..max
+  uint8_t intervalMaxMs;
+  uint8_t minBasePct;    // suelo del rango normal (% del maximo)
+  uint8_t dropMaxPct;    // techo de las caidas (% del maximo)
+  uint8_t dropTenths;    // caidas en N de cada 10 ticks
+  uint8_t snap1Pct;      // CAN1: % de ticks que saltan directo al objetivo
+  uint8_t snap2Pct;      // CAN2: idem
+  uint8_t keep1;         // CAN1: nivel = (nivel*keep1 + objetivo*(den1-keep1)) / den1
+  uint8_t den1;
+  uint8_t keep2;         // CAN2: idem
+  uint8_t den2;
+};
+
+constexpr CandleCoefs CANDLE_COEFS_DEFAULT = {15, 55, 35, 86, 4, 12, 8, 1, 3, 3, 4};
+
+const uint8_t CANDLE_FLOOR_PWM = 5; // ninguna caida baja de aqui
+
+// Limites de CAN1 y CAN2 precalculados desde el maximo PWM.
+struct CandleDesc {
+  uint8_t max1;
+  uint8_t max2;
+  uint8_t minBase1;
+  uint8_t minBase2;
+  uint8_t dropMax1;
+  uint8_t dropMax2;
+  CandleCoefs k;
+};
+
+constexpr uint8_t atLeastCandleFloor(uint16_t v) {
+  return (uint8_t)(v < CANDLE_FLOOR_PWM ? CANDLE_FLOOR_PWM : v);
+}
+
+constexpr CandleDesc candleDescFor(uint8_t max1, uint8_t max2, const CandleCoefs& k = CANDLE_COEFS_DEFAULT) {
+  return CandleDesc{max1, max2,
+                    atLeastCandleFloor(max1 * (uint16_t)k.minBasePct / 100), atLeastCandleFloor(max2 * (uint16_t)k.minBasePct / 100),
+                    atLeastCandleFloor(max1 * (uint16_t)k.dropMaxPct / 100), atLeastCandleFloor(max2 * (uint16_t)k.dropMaxPct / 100),
+                    k};
+}
+
+struct CandleState {
+  uint16_t lastUpdate;
+  uint8_t nextInterval; // ms hasta el siguiente tick
+  uint8_t level1;       // salida actual CAN1
+  uint8_t level2;       // salida actual CAN2
+};
+
+// Un tick de parpadeo si toca; true = niveles nuevos en level1/level2.
+template <class Rng>
+inline bool candleStep(CandleState& s, const CandleDesc& d, uint16_t tick, Rng& rng) {
+  if (timerElapsed(tick, s.lastUpdate) < s.nextInterval) return false;
+  s.lastUpdate = tick;
+
+  // Intervalo variable para evitar patron mecanico
+  s.nextInterval = (uint8_t)rng(d.k.intervalMinMs, d.k.intervalMaxMs + 1);
+
+  if (s.level1 == 0 && d.max1 > 0) s.level1 = (uint8_t)((d.minBase1 + d.max1) / 2);
+  if (s.level2 == 0 && d.max2 > 0) s.level2 = (uint8_t)((d.minBase2 + d.max2) / 2);
+
+  // CAN1 (mas vivo)
+  int target1 = (int)rng(d.minBase1, d.max1 + 1);
+  if (rng(0, 10) >= 10 - d.k.dropTenths) target1 = (int)rng(CANDLE_FLOOR_PWM, d.dropMax1 + 1);
+  if (rng(0, 100) < d.k.snap1Pct) s.level1 = (uint8_t)target1;
+  else s.level1 = (uint8_t)((s.level1 * d.k.keep1 + target1 * (d.k.den1 - d.k.keep1)) / d.k.den1);
+
+  // CAN2 (desincronizado y mas suave)
+  int target2 = (int)rng(d.minBase2, d.max2 + 1);
+  if (rng(0, 10) >= 10 - d.k.dropTenths) target2 = (int)rng(CANDLE_FLOOR_PWM, d.dropMax2 + 1);
+  if (rng(0, 100) < d.k.snap2Pct) s.level2 = (uint8_t)target2;
+  else s.level2 = (uint8_t)((s.level2 * d.k.keep2 + target2 * (d.k.den2 - d.k.keep2)) / d.k.den2);
+  return true;
+}
+
+// ==== Deriva organica (targets aleatorios en min..max, pasos aleatorios) ====
+
+struct DriftDesc {
+  uint8_t minPct;
+  uint8_t maxPct;
+  uint16_t targetMinMs;
+  uint16_t targetMaxMs;
+  uint8_t stepMinPct;
+  uint8_t stepMaxPct;
+  uint16_t stepIntervalMs;
+  uint8_t minPwm;
+  uint8_t maxPwm;
+  uint8_t stepMinPwm;
+  uint8_t stepMaxPwm;
+};
+
+constexpr DriftDesc driftDesc(uint8_t minPct, uint8_t maxPct, uint16_t targetMinMs, uint16_t targetMaxMs,
+                              uint8_t stepMinPct, uint8_t stepMaxPct, uint16_t stepIntervalMs) {
+  return DriftDesc{minPct, maxPct, targetMinMs, targetMaxMs, stepMinPct, stepMaxPct, stepIntervalMs,
+                   percentToPwm(minPct), percentToPwm(maxPct), percentToPwm(stepMinPct), percentToPwm(stepMaxPct)};
+}
+
+struct DriftSlot {
+  uint8_t current; // PWM
+  uint8_t target;  // PWM
+  uint16_t nextTargetAt;
+  uint16_t lastStepAt;
+};
+
+template <class Rng>
+inline void driftStart(DriftSlot& st, const DriftDesc& d, uint16_t tick, Rng& rng) {
+  uint8_t start = (uint8_t)rng(d.minPwm, d.maxPwm + 1);
+  st.current = start;
+  st.target = start;
+  st.nextTargetAt = (uint16_t)(tick + rng(d.targetMinMs, d.targetMaxMs + 1));
+  st.lastStepAt = (uint16_t)(tick - d.stepIntervalMs); // primer paso inmediato
+}
+
+// Avanza la deriva; devuelve el nivel actual.
+template <class Rng>
+inline uint8_t driftStep(DriftSlot& st, const DriftDesc& d, uint16_t tick, Rng& rng) {
+  if (timerDue(tick, st.nextTargetAt)) {
+    st.target = (uint8_t)rng(d.minPwm, d.maxPwm + 1);
+    st.nextTargetAt = (uint16_t)(tick + rng(d.targetMinMs, d.targetMaxMs + 1));
+  }
+  if (timerElapsed(tick, st.lastStepAt) < d.stepIntervalMs) return st.current;
+  st.lastStepAt = tick;
+
+  uint8_t step = (uint8_t)rng(d.stepMinPwm, d.stepMaxPwm + 1);
+  if (st.current < st.target) {
+    uint16_t next = st.current + step;
+    st.current = (next > st.target) ? st.target : (uint8_t)next;
+  } else if (st.current > st.target) {
+    int next = (int)st.current - step;
+    st.current = (next < st.target) ? st.target : (uint8_t)next;
+  }
+  return st.current;
+}
+
+// ==== Fade in/out con jitter ====
+
+struct FadeSlot {
+  uint8_t val;
+  uint8_t min;
+  uint8_t max;
+  uint8_t step;
+  int8_t dir;
+  bool active;
+  uint16_t last;
+  uint16_t interval;
+};
+
+// Un paso si vencio el intervalo; true = val nuevo.
+template <class Rng>
+inline bool fadeStep(FadeSlot& f, uint16_t tick, Rng& rng) {
+  if (timerElapsed(tick, f.last) < f.interval) return false;
+  f.last = tick;
+  int jitter = (int)rng(-1, 2); // -1,0,1
+  int step = (int)f.step + jitter;
+  int next = (int)f.val + (int)f.dir * step;
+  if (next >= f.max) { next = f.max; f.dir = -1; }
+  else if (next <= f.min) { next = f.min; f.dir = 1; }
+  f.val = (uint8_t)next;
+  return true;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+// Llama grabada para la candelita: formato ADPCM de 4 bits en flash y
+// reproductor por granos. Compartido por el firmware (src/virgencitaluces.cpp)
+// y el codificador de host (src/tools/flame_encoder.cpp).
+//
+// La grabacion es la intensidad de una llama real (0..255, 255 = pico), una
+// muestra cada sampleMs. Se guarda en bloques de FLAME_BLOCK_BYTES:
+//   0  prediccion inicial (nivel antes de la primera muestra del bloque)
+//   1  indice de paso inicial (0..FLAME_STEP_COUNT-1)
+//   2  FLAME_BLOCK_SAMPLES nibbles, el bajo primero: bit3 signo, bits2..0
+//      magnitud m; muestra = prediccion +- m * FLAME_STEPS[indice], saturada
+//      a 0..255, y el indice se adapta con FLAME_INDEX_ADAPT[m].
+// Cada bloque se decodifica sin el anterior: se puede empezar en cualquiera.
+//
+// Reproductor: cada candela lee un "grano" (tramo de FLAME_GRAIN_MIN_BLOCKS..
+// FLAME_GRAIN_MAX_BLOCKS bloques desde un bloque aleatorio, a un intervalo por
+// muestra aleatorio) y al acabarlo salta a otro con un fundido lineal de
+// FLAME_XFADE_SAMPLES muestras: no hay costura ni bucle reconocible.
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#endif
+#endif
+
+const uint8_t FLAME_BLOCK_SAMPLES = 64;
+const uint8_t FLAME_BLOCK_BYTES = 2 + FLAME_BLOCK_SAMPLES / 2;
+const uint8_t FLAME_STEP_COUNT = 12;
+const uint8_t FLAME_GRAIN_MIN_BLOCKS = 2;   // ~2 s a 16 ms por muestra
+const uint8_t FLAME_GRAIN_MAX_BLOCKS = 6;
+const uint8_t FLAME_XFADE_SHIFT = 4;
+const uint8_t FLAME_XFADE_SAMPLES = 1 << FLAME_XFADE_SHIFT;
+const uint8_t FLAME_RATE_MIN_MS = 12;       // intervalo por muestra de cada grano
+const uint8_t FLAME_RATE_MAX_MS = 20;
+
+const uint8_t FLAME_STEPS[FLAME_STEP_COUNT] PROGMEM = {1, 2, 3, 4, 6, 8, 11, 15, 20, 27, 36, 48};
+const int8_t FLAME_INDEX_ADAPT[8] = {-1, -1, 0, 0, 1, 2, 3, 4};
+
+// Un paso del decodificador (el codificador usa el mismo).
+inline uint8_t flameApplyNibble(uint8_t pred, uint8_t& stepIdx, uint8_t nibble) {
+  uint8_t m = nibble & 7;
+  int16_t delta = (int16_t)m * pgm_read_byte(&FLAME_STEPS[stepIdx]);
+  int16_t v = (nibble & 8) ? (int16_t)pred - delta : (int16_t)pred + delta;
+  int8_t idx = (int8_t)stepIdx + FLAME_INDEX_ADAPT[m];
+  stepIdx = (uint8_t)(idx < 0 ? 0 : (idx >= FLAME_STEP_COUNT ? FLAME_STEP_COUNT - 1 : idx));
+  return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// Lectura secuencial dentro de la grabacion.
+struct FlameCursor {
+  uint16_t block;
+  uint8_t pos;      // muestra dentro del bloque
+  uint8_t pred;
+  uint8_t stepIdx;
+};
+
+inline void flameSeek(FlameCursor& c, const uint8_t* blob, uint16_t block) {
+  const uint8_t* p = blob + (uint16_t)block * FLAME_BLOCK_BYTES;
+  c.block = block;
+  c.pos = 0;
+  c.pred = pgm_read_byte(p);
+  c.stepIdx = pgm_read_byte(p + 1);
+}
+
+// Siguiente muestra; al final de un bloque pasa al siguiente (el llamador
+// no pide mas alla del ultimo).
+inline uint8_t flameNext(FlameCursor& c, const uint8_t* blob) {
+  if (c.pos == FLAME_BLOCK_SAMPLES) flameSeek(c, blob, (uint16_t)(c.block + 1));
+  uint8_t b = pgm_read_byte(blob + (uint16_t)c.block * FLAME_BLOCK_BYTES + 2 + (c.pos >> 1));
+  uint8_t nibble = (c.pos & 1) ? (uint8_t)(b >> 4) : (uint8_t)(b & 0x0F);
+  c.pos++;
+  c.pred = flameApplyNibble(c.pred, c.stepIdx, nibble);
+  return c.pred;
+}
+
+// Reproductor de una candela.
+struct FlamePlayer {
+  FlameCursor cur;   // grano en curso
+  FlameCursor next;  // grano entrante durante el fundido
+  uint16_t left;     // muestras hasta el fin del grano
+  uint8_t xfade;     // muestras de fundido hechas (0 = sin fundido)
+  uint8_t intervalMs;
+  uint16_t lastAt;
+  uint8_t level;     // intensidad actual 0..255
+  bool started;
+};
+
+// Grano nuevo: bloque y velocidad aleatorios. El grano ocupa span bloques
+// justos contando el fundido de entrada y el de salida.
+template <class Rng>
+inline void flameStartGrain(FlamePlayer& p, FlameCursor& c, const uint8_t* blob, uint16_t blocks, Rng& rng) {
+  uint16_t span = (uint16_t)rng(FLAME_GRAIN_MIN_BLOCKS, FLAME_GRAIN_MAX_BLOCKS + 1);
+  flameSeek(c, blob, (uint16_t)rng(0, blocks - span + 1));
+  p.left = (uint16_t)(span * FLAME_BLOCK_SAMPLES - 2 * FLAME_XFADE_SAMPLES);
+  p.intervalMs = (uint8_t)rng(FLAME_RATE_MIN_MS, FLAME_RATE_MAX_MS + 1);
+}
+
+// Avanza una muestra si toca; true = level nuevo. Requiere blocks >= FLAME_GRAIN_MAX_BLOCKS.
+template <class Rng>
+inline bool flameStep(FlamePlayer& p, const uint8_t* blob, uint16_t blocks, uint16_t tick, Rng& rng) {
+  if (!p.started) {
+    p.started = true;
+    p.xfade = 0;
+    flameStartGrain(p, p.cur, blob, blocks, rng);
+    p.lastAt = tick;
+    p.level = flameNext(p.cur, blob);
+    return true;
+  }
+  if ((uint16_t)(tick - p.lastAt) < p.intervalMs) return false;
+  p.lastAt = tick;
+
+  uint8_t a = flameNext(p.cur, blob);
+  if (p.xfade == 0) {
+    if (--p.left == 0) {
+      flameStartGrain(p, p.next, blob, blocks, rng);
+      p.xfade = 1;
+    }
+    p.level = a;
+    return true;
+  }
+  // Fundido lineal grano saliente -> entrante en FLAME_XFADE_SAMPLES muestras.
+  uint8_t b = flameNext(p.next, blob);
+  p.level = (uint8_t)(a + ((((int16_t)b - a) * p.xfade) >> FLAME_XFADE_SHIFT));
+  if (++p.xfade > FLAME_XFADE_SAMPLES) {
+    p.cur = p.next;
+    p.xfade = 0;
+  }
+  return true;
+}
+
+// Intensidad 0..255 -> PWM con tope maxPwm y suelo floorPwm.
+inline uint8_t flameLevel(uint8_t intensity, uint8_t maxPwm, uint8_t floorPwm) {
+  uint8_t v = (uint8_t)(((uint16_t)intensity * (maxPwm + 1U)) >> 8);
+  return v < floorPwm ? floorPwm : v;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// Generado por src/tools/flame_encoder.cpp desde vela01.txt. No editar a mano.
+// 2048 muestras de 16 ms (32.8 s), 32 bloques; error RMS 1.59, maximo 8.
+
+#include "flame_format.h"
+
+const uint8_t FLAME_VELA_SAMPLE_MS = 16;
+const uint16_t FLAME_VELA_BLOCKS = 32;
+
+const uint8_t FLAME_VELA[] PROGMEM = {
+  0xE9, 0x00, 0x30, 0xA9, 0x01, 0x00, 0x9B, 0x1B, 0x1B, 0xA0, 0x0A, 0x0A,
+  0x91, 0x1B, 0x29, 0x0A, 0x1C, 0x21, 0x90, 0xAB, 0xA9, 0x93, 0x40, 0x09,
+  0x03, 0x91, 0x0A, 0x13, 0x92, 0x20, 0x11, 0x19, 0x39, 0x10, 0xE2, 0x00,
+  0x90, 0x11, 0x02, 0x19, 0x21, 0x01, 0x91, 0x92, 0x20, 0x99, 0xA9, 0x00,
+  0xB1, 0x11, 0x10, 0x19, 0xD9, 0x01, 0x2A, 0xB1, 0xA9, 0x9B, 0x01, 0x03,
+  0x2B, 0x01, 0xA0, 0xA9, 0x1A, 0x92, 0xAC, 0x0A, 0xD2, 0x00, 0x30, 0x00,
+  0x21, 0x30, 0x92, 0x99, 0xA3, 0x22, 0x9A, 0x90, 0x49, 0x99, 0x1A, 0x21,
+  0x39, 0x3A, 0x21, 0x19, 0x23, 0x1A, 0x90, 0x99, 0x01, 0x07, 0x01, 0x40,
+  0x90, 0x01, 0xAB, 0x92, 0x10, 0x2B, 0xEB, 0x00, 0x20, 0x1A, 0xA9, 0x3B,
+  0x90, 0x21, 0x20, 0x11, 0x3B, 0xD9, 0x01, 0x91, 0x19, 0x4B, 0x11, 0x32,
+  0x90, 0xBA, 0x0B, 0x01, 0x20, 0x09, 0x09, 0x09, 0x01, 0x0A, 0x14, 0xA0,
+  0xA1, 0xAB, 0x92, 0x20, 0xEB, 0x00, 0x10, 0x4A, 0x10, 0x2A, 0x29, 0x91,
+  0x92, 0x02, 0x3B, 0x02, 0x14, 0x1B, 0x00, 0x2A, 0x99, 0x91, 0x92, 0x19,
+  0xA2, 0x10, 0x9D, 0xB1, 0x29, 0x90, 0x03, 0x29, 0xA1, 0x22, 0x91, 0x10,
+  0xB0, 0x09, 0xF4, 0x00, 0x90, 0x09, 0xA4, 0x99, 0x10, 0x00, 0x12, 0x9C,
+  0x90, 0x02, 0xBB, 0x90, 0x19, 0x9A, 0x01, 0x1C, 0x93, 0x11, 0x10, 0xA1,
+  0x23, 0xB9, 0x30, 0x19, 0xB9, 0x03, 0xBA, 0x10, 0x10, 0x21, 0x2B, 0x00,
+  0xE6, 0x00, 0x00, 0x09, 0xA2, 0x99, 0x92, 0x20, 0xB0, 0xA0, 0x11, 0x1B,
+  0x12, 0xCA, 0x41, 0x91, 0x01, 0x23, 0x09, 0x21, 0x39, 0x22, 0x0A, 0xA9,
+  0x93, 0x22, 0x3A, 0xA1, 0xBA, 0xA0, 0x20, 0x91, 0x03, 0x2B, 0xF2, 0x00,
+  0x10, 0x13, 0x19, 0xA1, 0xB0, 0x02, 0x10, 0xA2, 0x91, 0x00, 0x00, 0x09,
+  0x11, 0xA1, 0x10, 0x91, 0x09, 0xA0, 0x12, 0xAA, 0x93, 0x12, 0x9B, 0xB1,
+  0x02, 0x02, 0x49, 0x0A, 0x99, 0x01, 0x05, 0x90, 0xFA, 0x00, 0xA0, 0x10,
+  0x2A, 0x2A, 0x19, 0x10, 0xA1, 0x1A, 0x0A, 0x1B, 0x99, 0x93, 0x0B, 0xED,
+  0x49, 0x9A, 0xB4, 0x12, 0x3C, 0xB0, 0x93, 0x6A, 0x0A, 0xB2, 0x02, 0x3B,
+  0xC0, 0xA4, 0x49, 0x1B, 0xC3, 0x12, 0xD9, 0x00, 0xF1, 0xBD, 0xB0, 0x19,
+  0x0C, 0xB1, 0x11, 0x55, 0x00, 0x97, 0x31, 0x2A, 0x91, 0x06, 0x30, 0x20,
+  0x12, 0x31, 0x22, 0x00, 0x32, 0x10, 0x11, 0x19, 0x20, 0x12, 0xB9, 0x10,
+  0x90, 0x31, 0x01, 0x09, 0xE6, 0x00, 0x30, 0x91, 0x09, 0xA3, 0x21, 0x90,
+  0xB1, 0x10, 0xB1, 0x29, 0x10, 0xC0, 0x91, 0x14, 0x0A, 0x2A, 0x0A, 0xA0,
+  0xAA, 0x90, 0x04, 0x29, 0xA0, 0x91, 0x01, 0x04, 0x09, 0x01, 0x99, 0x00,
+  0x0B, 0x09, 0xE4, 0x00, 0xC0, 0x99, 0x09, 0x22, 0x10, 0x13, 0x20, 0x90,
+  0x13, 0x09, 0x9A, 0x21, 0x1B, 0xB0, 0x20, 0x2C, 0x00, 0x09, 0x30, 0xC2,
+  0x99, 0x92, 0x02, 0x29, 0x00, 0x90, 0x01, 0xA2, 0xB9, 0xAA, 0x10, 0x92,
+  0xE2, 0x00, 0x90, 0x23, 0x9A, 0x01, 0x90, 0xA3, 0x09, 0x32, 0x09, 0x13,
+  0x21, 0x20, 0x10, 0x0A, 0x90, 0x02, 0xA0, 0x10, 0x02, 0xAB, 0x21, 0xB1,
+  0xD1, 0x01, 0x99, 0xA3, 0x99, 0xF0, 0x1F, 0xA0, 0xA3, 0x30, 0xB1, 0x04,
+  0x40, 0xC2, 0x95, 0x3A, 0x1B, 0xD3, 0x92, 0x59, 0x0A, 0xB2, 0x02, 0x4A,
+  0x0B, 0xB4, 0x92, 0x5A, 0x0A, 0xC3, 0x02, 0x4A, 0x1B, 0xB2, 0x93, 0x4A,
+  0x1B, 0xD3, 0x92, 0x59, 0x0A, 0xB2, 0x03, 0x4B, 0xC5, 0x02, 0x60, 0xC4,
+  0x03, 0x3A, 0x19, 0x01, 0x90, 0xA3, 0x22, 0x02, 0x09, 0xCB, 0x10, 0x10,
+  0xAA, 0x01, 0xA9, 0x12, 0x01, 0x00, 0x11, 0x00, 0x02, 0x00, 0x11, 0x04,
+  0x90, 0x00, 0x1A, 0x90, 0xA9, 0x31, 0xF9, 0x00, 0x00, 0x21, 0xB1, 0x94,
+  0x11, 0x01, 0x19, 0x9A, 0xA1, 0x90, 0x02, 0x91, 0xAA, 0x3A, 0x03, 0x1A,
+  0x99, 0x19, 0x91, 0x21, 0x02, 0x0A, 0x09, 0x9B, 0x91, 0x29, 0x20, 0x2B,
+  0x09, 0xA9, 0x92, 0x31, 0xFB, 0x00, 0x10, 0xA0, 0x02, 0xA1, 0x19, 0x09,
+  0xA2, 0x00, 0x12, 0x02, 0x90, 0x01, 0x00, 0x00, 0xB0, 0xA0, 0xA9, 0x00,
+  0x91, 0x00, 0x12, 0x00, 0x90, 0x02, 0xA9, 0x20, 0x00, 0x1B, 0xA3, 0x0A,
+  0x1C, 0x0B, 0xF0, 0x00, 0x10, 0xB9, 0x19, 0xA2, 0xB1, 0x92, 0x93, 0x11,
+  0x91, 0x00, 0x30, 0x22, 0x92, 0x01, 0x21, 0x09, 0x29, 0x9A, 0x1B, 0xB1,
+  0x09, 0xAA, 0x93, 0x9C, 0x39, 0x09, 0xA9, 0x1F, 0x1F, 0x9B, 0x04, 0x2C,
+  0xD9, 0x05, 0xD0, 0x40, 0xAA, 0x12, 0x1C, 0xB3, 0x59, 0xB9, 0x13, 0x1A,
+  0x94, 0x30, 0x00, 0x1B, 0x09, 0x99, 0x20, 0x14, 0x01, 0xC2, 0x11, 0x22,
+  0xAB, 0x23, 0x9B, 0xA9, 0x13, 0x39, 0x09, 0x01, 0x92, 0xA1, 0xE4, 0x00,
+  0xB0, 0x90, 0x1B, 0x93, 0x04, 0x2B, 0x91, 0x9A, 0x91, 0x0A, 0x0A, 0x0A,
+  0x00, 0x93, 0x93, 0x13, 0x0A, 0x39, 0xB9, 0x09, 0x02, 0x12, 0x0B, 0x91,
+  0x0B, 0x10, 0x01, 0x99, 0xB9, 0xA2, 0xA1, 0x21, 0xD6, 0x00, 0x00, 0xB0,
+  0x14, 0x91, 0xA9, 0x90, 0x99, 0x21, 0x02, 0x1C, 0x00, 0x19, 0x49, 0xB0,
+  0x00, 0x03, 0x02, 0x09, 0x32, 0xB9, 0xB0, 0xC2, 0x92, 0xCB, 0x21, 0x9A,
+  0x01, 0x39, 0xA2, 0xA1, 0x11, 0x33, 0xDA, 0x05, 0xD0, 0x30, 0xB9, 0x04,
+  0x2C, 0xC2, 0x31, 0x9B, 0xA5, 0x39, 0xC0, 0x22, 0x1C, 0xB2, 0x31, 0xBA,
+  0x04, 0x2C, 0xD1, 0x31, 0x0B, 0x93, 0x3C, 0xD0, 0x22, 0x1C, 0xA2, 0x30,
+  0x9B, 0x06, 0x3B, 0xC0, 0xC8, 0x05, 0x40, 0x0C, 0x93, 0x4A, 0xC0, 0x31,
+  0x1D, 0xB2, 0x40, 0xAA, 0x03, 0x2C, 0xB2, 0x50, 0x0B, 0x02, 0x3A, 0xB0,
+  0x13, 0x29, 0x10, 0x01, 0x29, 0x09, 0x10, 0x1A, 0xA9, 0x29, 0xB2, 0x12,
+  0x92, 0x11, 0xE0, 0x00, 0x90, 0x90, 0x19, 0x1A, 0xA2, 0x0A, 0x1A, 0x3A,
+  0x29, 0x19, 0xA3, 0x10, 0x21, 0x1B, 0x11, 0xDE, 0xA2, 0x21, 0x3B, 0x2B,
+  0xC1, 0xB4, 0x03, 0x3B, 0x3B, 0x0A, 0xC2, 0xA4, 0x11, 0x39, 0x1A, 0x90,
+  0xE6, 0x00, 0xA0, 0x01, 0x01, 0x90, 0x30, 0x1A, 0x30, 0x29, 0xA2, 0x93,
+  0x10, 0x00, 0x0B, 0x10, 0x1B, 0xB0, 0x02, 0x29, 0xC2, 0x21, 0x01, 0xBA,
+  0x22, 0xA9, 0x20, 0x11, 0xCA, 0x30, 0x90, 0x29, 0x91, 0x02, 0xEE, 0x00,
+  0x50, 0xDB, 0x2E, 0xB0, 0xA3, 0x30, 0x1D, 0xC1, 0x03, 0x4C, 0x0A, 0xC3,
+  0x21, 0x2C, 0xB1, 0xA3, 0x4A, 0x0A, 0xC3, 0x21, 0x2C, 0xC1, 0xA3, 0x30,
+  0x0B, 0xC4, 0x21, 0x4B, 0x9A, 0xA4, 0x30, 0x1C, 0xCC, 0x06, 0xC0, 0x93,
+  0x5B, 0x1B, 0xC3, 0x21, 0x2C, 0xB1, 0xA3, 0x49, 0x0B, 0xD3, 0x21, 0x2B,
+  0xC1, 0xA4, 0x30, 0x1C, 0xC2, 0x12, 0x3C, 0x0B, 0xA4, 0x30, 0x1C, 0xC1,
+  0x03, 0x4C, 0x0A, 0xA3, 0x21, 0x1A, 0xD4, 0x00, 0x00, 0x07, 0x00, 0x01,
+  0x10, 0x99, 0xB3, 0x91, 0xBA, 0x30, 0x1A, 0x90, 0x10, 0xA0, 0x11, 0x9A,
+  0x03, 0x90, 0x10, 0x2A, 0x23, 0xA9, 0x11, 0x21, 0x02, 0x09, 0x30, 0x9A,
+  0x91, 0xB0, 0xA1, 0x99, 0xDA, 0x00, 0x40, 0x01, 0x93, 0x22, 0x39, 0x19,
+  0x11, 0x02, 0x0C, 0x12, 0x00, 0x92, 0x03, 0x0A, 0x1B, 0x13, 0x0A, 0x92,
+  0xA9, 0x00, 0x9A, 0x01, 0xA9, 0x0A, 0x1B, 0x01, 0x00, 0x32, 0x2A, 0x91,
+  0x00, 0x0A, 0xE8, 0x00, 0x90, 0x04, 0x91, 0x00, 0x19, 0x01, 0x19, 0xC0,
+  0x90, 0x01, 0x10, 0x1A, 0x1A, 0xB1, 0x3B, 0x0B, 0x04, 0x19, 0x11, 0x00,
+  0x11, 0x09, 0xB3, 0xF3, 0x0E, 0xC3, 0x21, 0x2B, 0xC1, 0x03, 0x4B, 0xC0,
+  0xEB, 0x05, 0xD0, 0x59, 0x0A, 0xC3, 0x11, 0x2D, 0xB0, 0x94, 0x3A, 0x9A,
+  0xB5, 0x31, 0x1C, 0xC2, 0x02, 0x3A, 0xB9, 0xA5, 0x30, 0x0B, 0xB5, 0x31,
+  0x1C, 0xC2, 0x02, 0x4B, 0xA9, 0xA4, 0x49, 0x0A, 0xC3, 0x21, 0xBC, 0x05,
+  0x50, 0xB0, 0xA4, 0x59, 0x0B, 0xB3, 0x41, 0x1C, 0xC2, 0x12, 0x3B, 0x9A,
+  0xA5, 0x30, 0x1C, 0xC2, 0x12, 0x2C, 0x99, 0x04, 0x4B, 0x0B, 0xB4, 0x40,
+  0x1C, 0xB2, 0x13, 0x3B, 0x00, 0x02, 0x00, 0x9A
+};
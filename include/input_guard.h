@@ -0,0 +1,197 @@
+#pragma once
+
+// Entradas de una hornacina sin Arduino: antirrebote del boton, intensidad de
+// movimiento del PIR y proteccion contra tormentas de entradas.
+// Compartido por el firmware (src/virgencitaluces.cpp) y el banco de
+// tormentas de host (src/tools/input_storm.cpp).
+//
+// Proteccion (InputGuardConfig; a 0 = sin proteccion, como antes):
+//   pressMinMs   una pulsacion solo vale si el nivel estable del boton llevaba
+//                pressMinMs sin cambiar: el corte de un contacto gastado, mas
+//                largo que el antirrebote, no cambia de modo dos veces ni al
+//                soltar.
+//   settleMs     el modo cambia al instante, pero el snapshot por serie (~1.5 KB,
+//                ~130 ms de UART) sale cuando el modo lleva settleMs sin
+//                cambiar: una rafaga de pulsaciones imprime uno solo.
+//   pirLogMinMs  como maximo un aviso de PIR (re-disparo o PIR bajo) cada
+//                pirLogMinMs; los flancos de mas se cuentan y se informan en el
+//                siguiente aviso.
+// Abrir y cerrar la ventana de movimiento no se limita: es barato y cada
+// deteccion cuenta.
+//
+// Intensidad de movimiento (motionLevel, Q24: MOTION_FULL = 100%): cada flanco
+// de subida del PIR, tambien los re-disparos, suma motionGain a la carga (tope
+// 100%) y la intensidad sube hacia la carga a motionAttackPerMs. La carga se
+// sostiene movementMs desde el ultimo flanco y despues baja a motionDecayPerMs;
+// la intensidad la sigue. La ventana (inMovementMode) se abre con el primer
+// flanco y se cierra cuando la intensidad vuelve a 0. Con ganancia 100% y
+// subida y bajada inmediatas es la ventana fija de antes, renovada por cada
+// re-disparo.
+#include <stdint.h>
+
+struct InputGuardConfig {
+  uint16_t debounceMs;
+  uint32_t movementMs;        // carga sostenida tras el ultimo flanco del PIR
+  uint16_t pressMinMs;
+  uint16_t settleMs;
+  uint16_t pirLogMinMs;
+  uint32_t motionGain;        // carga por flanco del PIR (Q24)
+  uint32_t motionAttackPerMs; // subida de la intensidad (Q24 por ms)
+  uint32_t motionDecayPerMs;  // bajada de la carga pasado movementMs (Q24 por ms)
+};
+
+const uint16_t INPUT_PRESS_MIN_MS = 100;
+const uint16_t INPUT_SETTLE_MS = 400;
+const uint16_t INPUT_PIR_LOG_MIN_MS = 1000;
+
+const uint32_t MOTION_FULL = 1UL << 24; // intensidad 100% (Q24)
+
+constexpr uint32_t motionGainPct(uint8_t pct) {
+  return pct >= 100 ? MOTION_FULL : MOTION_FULL / 100 * pct;
+}
+
+// Paso por ms para recorrer 0..100% en ms (0 = inmediato).
+constexpr uint32_t motionRatePerMs(uint16_t ms) {
+  return ms == 0 ? MOTION_FULL : (MOTION_FULL + ms - 1) / ms;
+}
+
+// Resultado de inputStep() (bits).
+const uint8_t INPUT_PRESS = 1 << 0;          // pulsacion aceptada: cambiar de modo
+const uint8_t INPUT_SNAPSHOT = 1 << 1;       // el modo se asento: imprimir el snapshot
+const uint8_t INPUT_MOTION_START = 1 << 2;   // se abre la ventana de movimiento
+const uint8_t INPUT_PIR_RETRIGGER = 1 << 3;  // PIR alto con la ventana ya abierta: refuerza (avisar)
+const uint8_t INPUT_PIR_LOW = 1 << 4;        // PIR bajo (avisar)
+const uint8_t INPUT_TIMEOUT = 1 << 5;        // la intensidad llego a 0: se cierra la ventana
+
+struct InputGuard {
+  uint32_t lastDebounceTime;
+  uint32_t lastEdgeAt;      // ultimo cambio del nivel estable del boton
+  uint32_t modeChangedAt;
+  uint32_t lastMotionTime;  // ultimo flanco del PIR (desde ahi se sostiene la carga)
+  uint32_t motionStartAt;   // apertura de la ventana
+  uint32_t lastPirLogAt;
+  uint32_t lastStepAt;
+  uint32_t motionCharge;    // Q24
+  uint32_t motionLevel;     // intensidad, Q24 (sigue a la carga)
+  uint16_t pirSuppressed;   // flancos de PIR sin aviso desde el ultimo
+  uint16_t pirFolded;       // flancos agrupados en el aviso de este paso
+  uint16_t pressesDropped;  // pulsaciones descartadas por pressMinMs (total)
+  uint8_t lastReading;      // lectura cruda anterior del boton (0 = pulsado)
+  uint8_t stableLevel;      // nivel del boton tras el antirrebote
+  bool lastMotionState;
+  bool inMovementMode;
+  bool snapshotPending;
+};
+
+inline void inputBegin(InputGuard& g, uint32_t now) {
+  g = InputGuard();
+  g.lastReading = 1;
+  g.stableLevel = 0; // un boton ya pulsado al arrancar no cuenta como pulsacion
+  g.lastEdgeAt = now - 0xFFFFUL; // la primera pulsacion no espera pressMinMs
+  g.lastStepAt = now;
+}
+
+// Intensidad de movimiento 0..256 (Q8) para mezclar la escena base y la de
+// movimiento.
+inline uint16_t inputMotionQ8(const InputGuard& g) {
+  return (uint16_t)(g.motionLevel >> 16);
+}
+
+// Un flanco de movimiento (PIR, otro nodo del bus, escena retomada tras un
+// reset): suma carga y renueva el sostenido; true si abre la ventana.
+inline bool inputMotionStart(InputGuard& g, const InputGuardConfig& c, uint32_t now) {
+  g.lastMotionTime = now;
+  g.motionCharge = MOTION_FULL - g.motionCharge <= c.motionGain ? MOTION_FULL : g.motionCharge + c.motionGain;
+  if (g.inMovementMode) return false;
+  g.inMovementMode = true;
+  g.motionStartAt = now;
+  g.lastPirLogAt = now;
+  g.pirSuppressed = 0;
+  return true;
+}
+
+// Boton pulsado, PIR alto o ventana abierta (para el reposo).
+inline bool inputActive(const InputGuard& g) {
+  return g.inMovementMode || g.lastMotionState || g.stableLevel == 0;
+}
+
+// Desplaza las marcas de tiempo (salto del reloj del bus multi-nodo).
+inline void inputShift(InputGuard& g, int32_t delta) {
+  g.lastDebounceTime += (uint32_t)delta;
+  g.lastEdgeAt += (uint32_t)delta;
+  g.modeChangedAt += (uint32_t)delta;
+  g.lastMotionTime += (uint32_t)delta;
+  g.motionStartAt += (uint32_t)delta;
+  g.lastPirLogAt += (uint32_t)delta;
+  g.lastStepAt += (uint32_t)delta;
+}
+
+// Un paso por frame con la lectura cruda del boton (0 = pulsado) y del PIR.
+inline uint8_t inputStep(InputGuard& g, const InputGuardConfig& c, uint32_t now, uint8_t buttonReading, bool pir) {
+  uint8_t out = 0;
+  uint32_t dt = now - g.lastStepAt; // como mucho 255 ms por paso: dt x paso cabe en 32 bits
+  g.lastStepAt = now;
+  if (dt > 255) dt = 255;
+
+  if (buttonReading != g.lastReading) g.lastDebounceTime = now;
+  if ((uint32_t)(now - g.lastDebounceTime) > c.debounceMs && buttonReading != g.stableLevel) {
+    bool settled = (uint32_t)(now - g.lastEdgeAt) >= c.pressMinMs;
+    g.stableLevel = buttonReading;
+    g.lastEdgeAt = now;
+    if (buttonReading == 0) {
+      if (!settled) {
+        if (g.pressesDropped < 0xFFFF) g.pressesDropped++;
+      } else {
+        g.modeChangedAt = now;
+        g.snapshotPending = true;
+        out |= INPUT_PRESS;
+      }
+    }
+  }
+  g.lastReading = buttonReading;
+  if (g.snapshotPending && (uint32_t)(now - g.modeChangedAt) >= c.settleMs) {
+    g.snapshotPending = false;
+    out |= INPUT_SNAPSHOT;
+  }
+
+  uint8_t pirEdge = 0;
+  if (pir && !g.lastMotionState) {
+    g.lastMotionState = true;
+    if (inputMotionStart(g, c, now)) out |= INPUT_MOTION_START;
+    else pirEdge = INPUT_PIR_RETRIGGER;
+  } else if (!pir && g.lastMotionState) {
+    g.lastMotionState = false;
+    pirEdge = INPUT_PIR_LOW;
+  }
+  if (pirEdge) {
+    if ((uint32_t)(now - g.lastPirLogAt) >= c.pirLogMinMs) {
+      g.lastPirLogAt = now;
+      g.pirFolded = g.pirSuppressed;
+      g.pirSuppressed = 0;
+      out |= pirEdge;
+    } else if (g.pirSuppressed < 0xFFFF) {
+      g.pirSuppressed++;
+    }
+  }
+
+  // Envolvente: la carga baja pasado movementMs desde el ultimo flanco y la
+  // intensidad la sigue (sube a motionAttackPerMs, baja con ella).
+  if (g.inMovementMode) {
+    if ((uint32_t)(now - g.lastMotionTime) >= c.movementMs) {
+      uint32_t down = dt * c.motionDecayPerMs;
+      g.motionCharge = down >= g.motionCharge ? 0 : g.motionCharge - down;
+    }
+    if (g.motionLevel < g.motionCharge) {
+      uint32_t up = dt * c.motionAttackPerMs;
+      g.motionLevel = g.motionCharge - g.motionLevel <= up ? g.motionCharge : g.motionLevel + up;
+    } else {
+      g.motionLevel = g.motionCharge;
+    }
+    // Timeout de movimiento: carga e intensidad a 0, salir del submodo
+    if (g.motionCharge == 0) {
+      g.inMovementMode = false;
+      out |= INPUT_TIMEOUT;
+    }
+  }
+  return out;
+}
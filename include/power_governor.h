@@ -0,0 +1,73 @@
+#pragma once
+
+// Gobernador de potencia de la placa. Compartido por el firmware
+// (src/virgencitaluces.cpp, boardFlush y comando "power") y el duty de host
+// (src/tools/profile_sweep.cpp, "profile_sweep duty").
+//
+// Estima la corriente del frame con el duty de cada canal y su corriente
+// nominal (POWER_LED_FULL_MA) y, si pasa de POWER_BUDGET_MA, recorta primero
+// los canales de menor prioridad. CARA y las candelitas (prioridad 0) solo se
+// tocan si el resto ya esta a cero. La ganancia baja en el mismo frame (la
+// fuente no llega a caer) y se recupera en ~1 s. Coste fijo: 6 productos por
+// frame; 1-2 divisiones solo al recortar.
+
+#include <stdint.h>
+
+#include "power_model.h"
+
+#ifndef POWER_BUDGET_MA
+#define POWER_BUDGET_MA 80
+#endif
+
+const uint8_t POWER_TIER_COUNT = 2;
+const uint8_t POWER_CHANNEL_TIER[POWER_CHANNEL_COUNT] = {0, 0, 0, 1, 1, 1}; // CAN1 CAN2 CARA | FIZO FDEP ATRA
+
+struct PowerGovernor {
+  uint16_t gain[POWER_TIER_COUNT]; // Q8 aplicada por prioridad (256 = sin recorte)
+  uint16_t events;                 // veces que empezo a recortar
+  uint32_t throttledMs;            // tiempo total recortando
+  uint16_t peakMa;                 // mayor demanda vista (antes de recortar)
+  bool throttling;
+};
+
+const PowerGovernor POWER_GOVERNOR_IDLE = {{256, 256}, 0, 0, 0, false};
+
+// Recorta en el sitio los niveles de salida (0..255) de un frame de dtMs.
+inline void powerGovernorStep(PowerGovernor& gov, uint8_t* levels, uint16_t dtMs) {
+  // Demanda en unidades de mA*255 (sin dividir por 255).
+  uint32_t demand[POWER_TIER_COUNT] = {0, 0};
+  for (uint8_t i = 0; i < POWER_CHANNEL_COUNT; i++) {
+    demand[POWER_CHANNEL_TIER[i]] += (uint32_t)levels[i] * POWER_LED_FULL_MA[i];
+  }
+  uint32_t total = demand[0] + demand[1];
+  uint16_t totalMa = (uint16_t)(total / 255);
+  if (totalMa > gov.peakMa) gov.peakMa = totalMa;
+  const uint32_t budget = POWER_BUDGET_MA * 255UL;
+  uint32_t excess = (total > budget) ? total - budget : 0;
+  bool throttling = excess > 0;
+  if (throttling && !gov.throttling) gov.events++;
+  if (throttling) gov.throttledMs += dtMs;
+  gov.throttling = throttling;
+
+  uint16_t release = (uint16_t)((dtMs >> 2) + 1); // 256 en ~1 s
+  for (int8_t t = POWER_TIER_COUNT - 1; t >= 0; t--) {
+    uint16_t target = 256;
+    if (excess > 0 && demand[t] > 0) {
+      if (demand[t] > excess) {
+        target = (uint16_t)(((demand[t] - excess) << 8) / demand[t]);
+        excess = 0;
+      } else {
+        target = 0;
+        excess -= demand[t];
+      }
+    }
+    uint16_t g = gov.gain[t];
+    if (target < g) g = target;                        // ataque inmediato
+    else g = (uint16_t)((target - g > release) ? g + release : target); // recuperacion suave
+    gov.gain[t] = g;
+  }
+  for (uint8_t i = 0; i < POWER_CHANNEL_COUNT; i++) {
+    uint16_t g = gov.gain[POWER_CHANNEL_TIER[i]];
+    if (g < 256) levels[i] = (uint8_t)(((uint16_t)levels[i] * g) >> 8);
+  }
+}
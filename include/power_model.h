@@ -0,0 +1,51 @@
+#pragma once
+
+// Modelo de consumo para estimar la corriente media por estado. Compartido por
+// el firmware (src/virgencitaluces.cpp, comando "sleep") y el simulador de
+// noches de host (src/tools/power_sim.cpp).
+//
+// Valores a 5 V: hoja de datos del ATmega328P a 16 MHz y una placa Nano
+// tipica (LED de power, regulador y conversor USB-serie siempre alimentados).
+// Son estimaciones: conviene ajustarlos con un amperimetro en la instalacion.
+
+#include <stdint.h>
+
+const uint8_t POWER_CHANNEL_COUNT = 6;
+
+const uint32_t POWER_MCU_ACTIVE_UA = 9500;  // loop() girando
+const uint32_t POWER_MCU_IDLE_UA = 3000;    // SLEEP_MODE_IDLE: timers y PWM vivos
+const uint32_t POWER_MCU_PWRDOWN_UA = 1;    // power-down con BOD y ADC apagados
+const uint32_t POWER_BOARD_UA = 6000;       // resto de la placa, no se puede dormir
+
+// Corriente de cada canal al 100% de duty (orden CAN1 CAN2 CARA FIZO FDEP ATRA).
+const uint16_t POWER_LED_FULL_MA[POWER_CHANNEL_COUNT] = {20, 20, 20, 20, 20, 20};
+
+enum PowerState : uint8_t {
+  POWER_ACTIVE = 0,  // escena normal
+  POWER_FADING,      // bajando al suelo (CPU activa)
+  POWER_SLEEP_FLOOR, // dormido en idle con los LEDs al suelo
+  POWER_SLEEP_OFF,   // power-down con los LEDs apagados
+  POWER_STATE_COUNT
+};
+
+// Corriente de los LEDs (uA) para unos niveles PWM 0..255 escalados por dimQ8.
+inline uint32_t powerLedUa(const uint8_t* levels, uint8_t dimQ8) {
+  uint32_t ua = 0;
+  for (uint8_t i = 0; i < POWER_CHANNEL_COUNT; i++) {
+    uint16_t level = (uint16_t)(((uint16_t)levels[i] * dimQ8 + 255) >> 8);
+    ua += (uint32_t)level * POWER_LED_FULL_MA[i] * 1000UL / 255UL;
+  }
+  return ua;
+}
+
+// Corriente total (uA) de un estado; ledUa = powerLedUa() de lo que se ve.
+inline uint32_t powerStateUa(PowerState s, uint32_t ledUa) {
+  switch (s) {
+    case POWER_SLEEP_FLOOR:
+      return POWER_MCU_IDLE_UA + POWER_BOARD_UA + ledUa;
+    case POWER_SLEEP_OFF:
+      return POWER_MCU_PWRDOWN_UA + POWER_BOARD_UA;
+    default:
+      return POWER_MCU_ACTIVE_UA + POWER_BOARD_UA + ledUa;
+  }
+}
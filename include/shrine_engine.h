@@ -0,0 +1,2081 @@
+#pragma once
+
+// Motor de escena de una hornacina, sin Arduino: modos, efectos, capas,
+// secuencias, timeline, VM, soft-off y commit del frame sobre un
+// ShrineController que cada funcion recibe explicito. Lo que el motor necesita
+// de fuera entra por dos interfaces de punteros a funcion: ShrinePlatform
+// (azar, micros(), lectura de la EEPROM de escenas) y ShrineSink (niveles y
+// eventos de cada frame); el reloj llega en el FrameContext. Compartido por el
+// firmware (src/virgencitaluces.cpp, con random(), micros() y EEPROM de la
+// placa) y el banco de hornacinas de host (src/tools/shrine_bench.cpp).
+
+#include <stdint.h>
+#include <string.h>
+
+#include "timeline_fiesta.h"
+#include "flame_vela.h"
+#include "vm_bytecode.h"
+#include "effect_kernels.h"
+#include "input_guard.h"
+
+// Canales logicos de una hornacina (CAN1 CAN2 CARA FIZO FDEP ATRA).
+const uint8_t LED_COUNT = 6;
+
+// Compositor de capas por canal: los efectos escriben en la capa activa y
+// composeFrame(s) mezcla base + overlays en frameLevels antes del commit.
+const uint8_t LAYER_COUNT = 3;
+const uint8_t LAYER_BASE = 0;     // escena del modo (siempre presente)
+const uint8_t LAYER_OVERLAY = 1;  // acentos (p.ej. bienvenida por movimiento)
+const uint8_t LAYER_ACCENT = 2;   // reservado para acentos adicionales
+
+enum BlendMode : uint8_t {
+  BLEND_REPLACE = 0, // sustituye (ignora opacidad)
+  BLEND_MAX,         // el mayor de los dos
+  BLEND_ADD,         // suma con saturacion a 255
+  BLEND_MULTIPLY,    // atenua la base (255 = sin cambio)
+  BLEND_CROSSFADE    // mezcla lineal base -> capa segun opacidad
+};
+
+struct EffectLayer {
+  uint8_t level[6];
+  uint8_t mask;    // bit i = el canal i tiene contenido en esta capa
+  uint8_t blend;   // BlendMode
+  uint8_t opacity; // 0..255
+};
+
+// ==============================================================================
+// Modos de presentación
+// ==============================================================================
+enum Mode {
+  MODE_1_CONTEMPLATIVO = 0,
+  MODE_2_SOLO_CANDELITA,
+  MODE_3_CANDELITA_PASTOR,
+  MODE_4_CANDELITA_PASTOR_VIRGEN,
+  MODE_5_CANDELITA_PASTOR_VIRGEN_CARA,
+  MODE_6_ENFASIS_VIRGEN,
+  MODE_7_SECUENCIA,
+  MODE_8_ESCENA_1,   // escenas VM desde EEPROM (slots 0..2); se saltan si estan vacias
+  MODE_9_ESCENA_2,
+  MODE_10_ESCENA_3,
+  MODE_COUNT
+};
+
+// Control de tiempo
+const unsigned long DEBOUNCE_DELAY = 50;
+
+// PIR y movimiento
+const unsigned long MOVEMENT_TIMEOUT_MS = 30000; // 30 segundos (ventana fija, MOTION_BLEND 0)
+
+// Intensidad de movimiento: 1 = cada flanco del PIR suma MOTION_GAIN_PCT de
+// intensidad (sube en MOTION_ATTACK_MS de 0 a 100%), se sostiene MOTION_HOLD_MS
+// desde el ultimo flanco y baja en MOTION_DECAY_MS de 100% a 0; la escena mezcla
+// sus parametros base y de movimiento por la intensidad. 0 = submodo binario con
+// ventana de MOVEMENT_TIMEOUT_MS desde el ultimo flanco.
+#ifndef MOTION_BLEND
+#define MOTION_BLEND 1
+#endif
+
+const uint8_t MOTION_GAIN_PCT = 60;      // un flanco: 60%; dos seguidos: 100%
+const uint16_t MOTION_ATTACK_MS = 1200;
+const uint16_t MOTION_HOLD_MS = 15000;
+const uint16_t MOTION_DECAY_MS = 25000;  // un flanco suelto: 15 s + 15 s, como la ventana de 30 s
+
+// Entradas con proteccion contra tormentas (boton sucio, PIR que chisporrotea):
+// pulsaciones limitadas, snapshot al asentarse el modo y avisos de PIR agrupados.
+#if MOTION_BLEND
+const InputGuardConfig INPUT_GUARD = {DEBOUNCE_DELAY, MOTION_HOLD_MS, INPUT_PRESS_MIN_MS, INPUT_SETTLE_MS, INPUT_PIR_LOG_MIN_MS,
+                                      motionGainPct(MOTION_GAIN_PCT), motionRatePerMs(MOTION_ATTACK_MS),
+                                      motionRatePerMs(MOTION_DECAY_MS)};
+#else
+const InputGuardConfig INPUT_GUARD = {DEBOUNCE_DELAY, MOVEMENT_TIMEOUT_MS, INPUT_PRESS_MIN_MS, INPUT_SETTLE_MS, INPUT_PIR_LOG_MIN_MS,
+                                      MOTION_FULL, motionRatePerMs(0), motionRatePerMs(0)};
+#endif
+
+
+// Contexto de frame: se construye una vez por vuelta de loop() con una sola
+// lectura de millis() y se pasa a todos los efectos (fase coherente entre canales).
+struct FrameContext {
+  unsigned long now; // ms, instante unico del frame
+  uint16_t tick;     // 16 bits bajos de now (base de los timers relativos)
+  uint16_t dtMs;     // ms desde el frame anterior (saturado a 65535)
+  uint32_t frame;    // contador de frames
+  bool motion;       // submodo movimiento activo en este frame (ventana abierta)
+  uint16_t motionQ8; // intensidad de movimiento 0..256: mezcla base -> movimiento
+};
+
+// Timers relativos de 16 bits (timerElapsed/timerDue): include/effect_kernels.h.
+
+// Candelita: 1 = llama grabada en flash (include/flame_vela.h, un reproductor
+// por candela con offset y velocidad propios), 0 = parpadeo heuristico de
+// candleStep (el que ajusta profile_sweep vela).
+#ifndef CANDLE_SAMPLED
+#define CANDLE_SAMPLED 1
+#endif
+
+#if CANDLE_SAMPLED
+static_assert(FLAME_VELA_BLOCKS >= FLAME_GRAIN_MAX_BLOCKS, "llama grabada: menos bloques que un grano");
+#endif
+
+// Estado de efectos por canal: un slot etiquetado compartido por el efecto
+// activo en ese canal (fade, destello o deriva). Los timers son relativos de
+// 16 bits (ver timerElapsed/timerDue).
+enum EffectTag : uint8_t {
+  EFFECT_NONE = 0,
+  EFFECT_FADE,
+  EFFECT_FLASH,
+  EFFECT_DRIFT
+};
+
+// Reusable FADE state (usable for CARA or any other LED): FadeSlot en include/effect_kernels.h.
+
+// Efecto tenue + destello aleatorio
+struct FlashSlot {
+  bool on;
+  uint8_t peak; // PWM
+  uint16_t endAt;
+  uint16_t nextCheckAt;
+};
+
+// Deriva organica: brillo no periodico con targets aleatorios (DriftSlot en include/effect_kernels.h).
+
+union EffectSlot {
+  FadeSlot fade;
+  FlashSlot flash;
+  DriftSlot drift;
+};
+
+// Tabla struct-of-arrays: tag + slot + timer de soft-off por canal.
+// SRAM por canal: 1 (tag) + 10 (slot) + 2 (soft-off) = 13 bytes, frente a
+// ~40 bytes del layout anterior (FadeState + arrays de destello/deriva/soft-off
+// con timestamps de 32 bits).
+struct EffectStateTable {
+  uint8_t tag[6];
+  EffectSlot slot[6];
+  uint16_t softOffLast[6];
+};
+
+const uint8_t EFFECT_STATE_BYTES_PER_CHANNEL =
+  (uint8_t)(sizeof(uint8_t) + sizeof(EffectSlot) + sizeof(uint16_t));
+static_assert(sizeof(EffectSlot) <= 10, "EffectSlot debe mantenerse compacto");
+
+// ==============================================================================
+// Controlador de hornacina (estado por instancia)
+// ==============================================================================
+// Todo el estado de una escena vive en un ShrineController: modo, boton con
+// debounce, ventana del PIR, capas, slots de efecto, candelas, secuencias,
+// timeline y VM. Cada funcion del motor recibe el controlador sobre el que
+// trabaja; no hay controlador activo global. Lo que es uno por placa (reposo,
+// gobernador, luz ambiente) no va en el controlador; la cache de escena es de
+// la placa y se presta (ShrineController::cache).
+//
+// Configuracion (ShrineConfig): pines de boton y PIR y la salida de la placa de
+// cada canal logico (SHRINE_UNWIRED = canal sin LED: se calcula y no se ve).
+// Plataforma (ShrinePlatform): azar, micros() y EEPROM de escenas.
+// Salida (ShrineSink): el controlador no toca hardware; entrega los niveles de
+// cada frame y sus eventos (modo, PIR, timeout, cache, fallo de VM) a su sink.
+
+// Secuencias (corrutinas sin pila, ver seccion "Secuencias").
+enum CoroStatus : uint8_t {
+  CORO_WAITING = 0, // sigue viva, se reanuda el siguiente frame
+  CORO_DONE         // termino (el slot queda libre)
+};
+
+struct Coro {
+  uint16_t resume; // linea de reanudacion (0 = inicio)
+  uint16_t timer;  // tick de referencia de WAIT_MS / RAMP
+  uint8_t from;    // nivel inicial de la rampa en curso
+  uint8_t count;   // contador libre para bucles de la secuencia
+};
+
+struct ShrineController;
+
+typedef CoroStatus (*SequenceFn)(ShrineController& s, Coro& c, const FrameContext& fc);
+
+struct SequenceTask {
+  SequenceFn fn; // 0 = slot libre
+  Coro coro;
+};
+
+const uint8_t SEQUENCE_SLOTS = 4;
+
+// Reproductor de timeline (seccion "Reproductor de timeline").
+struct TimelinePlayer {
+  const uint8_t* blob;
+  TimelineTrack tracks[TIMELINE_MAX_CHANNELS];
+  uint8_t trackCount;
+  uint32_t durationMs;
+  uint32_t loopMs;
+  unsigned long startMs; // millis() equivalente al instante 0 del timeline
+};
+
+// Maquina virtual de escenas (seccion "Maquina virtual").
+const uint8_t VM_STACK_DEPTH = 8;
+
+// Rampa lineal por canal; progreso con reciproco precalculado (sin division por frame).
+struct VmRamp {
+  uint8_t from;
+  uint8_t to;
+  uint16_t start; // tick de inicio
+  uint16_t dur;   // ms (<= EFFECT_TIMER_MAX_MS)
+  uint32_t recip; // 2^24 / dur
+};
+
+struct VmMachine {
+  const uint8_t* flash;   // != 0: programa en PROGMEM (benchmark); si no, EEPROM
+  uint16_t base;          // direccion del codigo en EEPROM
+  uint16_t len;
+  uint16_t pc;
+  uint8_t sp;
+  uint8_t status;
+  uint8_t chMask;         // canales escritos por el programa
+  uint8_t rampMask;
+  uint8_t level[6];
+  uint8_t fault;          // VmFault del ultimo VM_FAULT
+  uint16_t waitUntil;
+  unsigned long startMs;  // base de tiempo de OSC/WAVE
+  int16_t stack[VM_STACK_DEPTH];
+  int16_t vars[VM_VAR_COUNT];
+  VmRamp ramp[6];
+};
+
+const uint8_t SHRINE_UNWIRED = 0xFF;
+
+struct ShrineConfig {
+  uint8_t btnPin;
+  uint8_t pirPin;
+  uint8_t output[6]; // indice en LED_PINS de cada canal logico (o SHRINE_UNWIRED)
+};
+
+enum ShrineEvent : uint8_t {
+  SHRINE_EVT_MODE = 0, // boton: arg = modo nuevo
+  SHRINE_EVT_MOTION,   // flanco del PIR: arg 0 = abre la ventana, 1 = re-disparo (suma intensidad)
+  SHRINE_EVT_PIR_LOW,  // PIR bajo (la ventana sigue hasta el timeout)
+  SHRINE_EVT_TIMEOUT,  // fin de la ventana de movimiento
+  SHRINE_EVT_SNAPSHOT, // el modo lleva INPUT_SETTLE_MS sin cambiar: arg = modo
+  SHRINE_EVT_CACHE,    // cache de escena rehecha: arg 1 = reproduce, 0 = en vivo
+  SHRINE_EVT_VM_FAULT  // la VM se detuvo: arg = VmFault (pc en s.vm.pc)
+};
+
+// Todo lo que el motor pide a la plataforma. random(lo, hi) devuelve lo..hi-1
+// como el de Arduino (los efectos lo llaman en el orden de siempre); micros()
+// solo mide la cache de escena; storageRead lee la EEPROM de las escenas VM.
+// sceneSlots: bit s = slot VM s con programa valido (el boton salta los vacios).
+struct ShrinePlatform {
+  long (*random)(void* ctx, long lo, long hi);
+  unsigned long (*micros)(void* ctx);
+  uint8_t (*storageRead)(void* ctx, uint16_t addr);
+  uint8_t (*sceneSlots)(void* ctx);
+  void* ctx;
+};
+
+// Generador de los nucleos de include/effect_kernels.h sobre la plataforma.
+struct ShrineRng {
+  const ShrinePlatform* p;
+  long operator()(long lo, long hi) const { return p->random(p->ctx, lo, hi); }
+};
+
+struct SceneCache;
+
+// write recibe los niveles del frame por canal logico (ya con soft-off y
+// atenuacion, copiados en s.ledBrightness); si la salida real es otra (el
+// gobernador de la placa recorta) el sink corrige s.ledBrightness.
+struct ShrineSink {
+  void (*write)(void* ctx, ShrineController& s, const uint8_t* levels);
+  void (*event)(void* ctx, ShrineController& s, ShrineEvent type, uint8_t arg);
+  void* ctx;
+};
+
+struct ShrineController {
+  const ShrineConfig* config;
+  const ShrinePlatform* platform;
+  ShrineSink sink;
+  SceneCache* cache; // buffer de la placa prestado (0 = partes periodicas en vivo)
+  Mode currentMode;
+  // Boton (debounce), PIR y ventana de movimiento
+  InputGuard input;
+  // Niveles ya mostrados (de ellos parte el soft-off) y frame compuesto de las capas
+  uint8_t ledBrightness[6];
+  uint8_t frameLevels[6];
+  EffectLayer layers[LAYER_COUNT];
+  uint8_t activeLayer;
+  EffectStateTable effects;
+  CandleState candle; // CAN2 con 20% menos de maximo
+#if CANDLE_SAMPLED
+  FlamePlayer flame[2]; // CAN1, CAN2
+#endif
+  SequenceTask sequences[SEQUENCE_SLOTS];
+  uint8_t pendingEvents; // eventos del frame (se limpian tras correr las secuencias)
+  TimelinePlayer timelinePlayer;
+  VmMachine vm;
+  uint8_t lastSceneKey; // modo * 2 + movimiento de la escena en curso (0xFF = ninguna)
+  uint32_t sceneClock;  // reloj de las ondas con periodo mezclado (ms a ritmo variable)
+  uint8_t sceneClockFrac;
+};
+
+// Toma el slot del canal para un efecto; devuelve true si estaba en otro uso
+// (el llamador debe inicializarlo).
+inline bool claimEffectSlot(ShrineController& s, uint8_t idx, EffectTag tag) {
+  if (s.effects.tag[idx] == tag) return false;
+  s.effects.tag[idx] = tag;
+  memset(&s.effects.slot[idx], 0, sizeof(EffectSlot));
+  return true;
+}
+
+inline void releaseEffectSlot(ShrineController& s, uint8_t idx, EffectTag tag) {
+  if (s.effects.tag[idx] == tag) s.effects.tag[idx] = EFFECT_NONE;
+}
+
+// Entrega un evento al sink del controlador.
+inline void shrineNotify(ShrineController& s, ShrineEvent type, uint8_t arg) {
+  if (s.sink.event) s.sink.event(s.sink.ctx, s, type, arg);
+}
+
+// Defaults for CARA fade (40% - 60%)
+const uint8_t DEFAULT_CARA_MIN_PCT = 40;
+const uint8_t DEFAULT_CARA_MAX_PCT = 60;
+const unsigned long DEFAULT_CARA_SPEED_MS = 40; // ms
+// Modo 1 - Contemplativo (3 variantes seleccionables)
+struct Mode1Profile {
+  const char* name;
+  uint8_t canBasePct;
+  uint8_t canMovePct;
+  uint8_t caraBaseMinPct;
+  uint8_t caraBaseMaxPct;
+  uint8_t caraMoveMinPct;
+  uint8_t caraMoveMaxPct;
+  unsigned long caraBaseTargetMinMs;
+  unsigned long caraBaseTargetMaxMs;
+  unsigned long caraMoveTargetMinMs;
+  unsigned long caraMoveTargetMaxMs;
+  uint8_t caraBaseStepMinPct;
+  uint8_t caraBaseStepMaxPct;
+  uint8_t caraMoveStepMinPct;
+  uint8_t caraMoveStepMaxPct;
+  unsigned long caraBaseStepIntervalMs;
+  unsigned long caraMoveStepIntervalMs;
+  uint8_t triadBasePct;
+  uint8_t triadPeakBasePct;
+  unsigned long triadBasePeriodMs;
+  uint8_t triadMoveBasePct;
+  uint8_t triadMovePeakPct;
+  unsigned long triadMovePeriodMs;
+};
+
+constexpr Mode1Profile MODE1_PROFILES[] = {
+  // 0 - Contemplativo profundo (muy sereno)
+  {"Contemplativo", 25, 60, 14, 26, 28, 52, 1100, 2500, 420, 1100, 1, 2, 1, 2, 55, 35, 2, 16, 11000, 6, 38, 4500},
+  // 1 - Balanceado (RECOMENDADO)
+  {"Balanceado", 35, 75, 18, 32, 35, 65, 900, 2200, 320, 900, 1, 2, 1, 3, 45, 28, 3, 22, 9000, 8, 55, 3600},
+  // 2 - Vivo (mas presencia en movimiento)
+  {"Vivo", 45, 90, 22, 40, 40, 78, 700, 1700, 220, 700, 1, 3, 2, 4, 30, 20, 5, 30, 7000, 12, 75, 2600},
+};
+const uint8_t MODE1_PROFILE_COUNT = sizeof(MODE1_PROFILES) / sizeof(MODE1_PROFILES[0]);
+const uint8_t MODE1_PROFILE_INDEX = 1; // 0=Contemplativo, 1=Balanceado, 2=Vivo
+static_assert(MODE1_PROFILE_INDEX < MODE1_PROFILE_COUNT, "MODE1_PROFILE_INDEX fuera de rango");
+
+// Perfil seleccionado, disponible en compilacion para los descriptores de escena.
+constexpr const Mode1Profile& MODE1 = MODE1_PROFILES[MODE1_PROFILE_INDEX];
+
+inline const Mode1Profile& getMode1Profile() {
+  return MODE1;
+}
+
+// Bienvenida por movimiento en Modo 1 (overlay sobre la deriva de CARA)
+const uint8_t MODE1_WELCOME_PEAK_PCT = 85;
+const unsigned long MODE1_WELCOME_MS = 1800; // ms
+
+const uint8_t MODE5_CARA_MIN_PCT = 40;
+const uint8_t MODE5_CARA_MAX_PCT = 90;
+const unsigned long MODE5_CARA_SPEED_MS = 35; // ms
+const uint8_t MODE5_FIZO_FDEP_MIN_PCT = 0;
+const uint8_t MODE5_FIZO_FDEP_MAX_PCT = 5;
+const unsigned long MODE5_FIZO_FDEP_SPEED_MS = 32; // ms (medio-rapido)
+const uint8_t MODE6_OLA_ATRA_MIN_PCT = 10;
+const uint8_t MODE6_OLA_ATRA_MAX_PCT = 30;
+const uint8_t MODE6_OLA_GRUPO_MIN_PCT = 8;
+const uint8_t MODE6_OLA_GRUPO_MAX_PCT = 24;
+const unsigned long MODE6_OLA_PERIOD_MS = 5200; // ms
+const uint8_t DEFAULT_FDEP_MIN_PCT = 5;
+const uint8_t DEFAULT_FDEP_MAX_PCT = 100;
+const unsigned long DEFAULT_FDEP_SPEED_MS = 40; // ms (velocidad media)
+const uint8_t DEFAULT_ATRA_M4_MIN_PCT = 0;
+const uint8_t DEFAULT_ATRA_M4_MAX_PCT = 100;
+const unsigned long DEFAULT_ATRA_M4_SPEED_MS = 30;
+
+// Suavizado al apagar (soft-off) - etapa de salida en commitFrame(s), por LED.
+// Se activa sola cuando el frame pide 0 y el LED sigue encendido.
+const uint8_t SOFTOFF_STEP = 8; // decrement per step
+const uint16_t SOFTOFF_INTERVAL = 30; // ms per step
+
+// ==============================================================================
+// Grupos de canales
+// ==============================================================================
+// Tabla de acoplamientos entre canales: hoy solo la pareja de candelas. Los
+// efectos escriben canal a canal; los desfases de ondas y halos salen de la
+// posicion de cada canal (ver Espacio).
+//   GROUP_GANG     setLedState(s) sobre un miembro escribe todo el grupo.
+//   GROUP_SOFTOFF  el soft-off de todos sigue al primer miembro (lider).
+// Un canal puede estar en varios grupos, pero solo en uno con acoplamiento.
+
+const uint8_t GROUP_MAX_MEMBERS = 3;
+const uint8_t GROUP_GANG = 1 << 0;
+const uint8_t GROUP_SOFTOFF = 1 << 1;
+const uint8_t GROUP_NONE = 0xFF;
+
+struct ChannelGroup {
+  uint8_t count;
+  uint8_t coupling;
+  uint8_t member[GROUP_MAX_MEMBERS];
+};
+
+enum ChannelGroupId : uint8_t {
+  GROUP_CANDELAS = 0, // CAN1 + CAN2 (cada candela lleva su propio parpadeo)
+  GROUP_COUNT
+};
+
+constexpr ChannelGroup CHANNEL_GROUPS[GROUP_COUNT] = {
+  {2, GROUP_GANG | GROUP_SOFTOFF, {0, 1}},
+};
+
+// Grupo con acoplamiento al que pertenece idx (GROUP_NONE si ninguno).
+constexpr uint8_t coupledGroupOf(uint8_t idx, uint8_t g = 0, uint8_t m = 0) {
+  return g >= GROUP_COUNT ? GROUP_NONE
+         : m >= CHANNEL_GROUPS[g].count ? coupledGroupOf(idx, (uint8_t)(g + 1), 0)
+         : (CHANNEL_GROUPS[g].coupling != 0 && CHANNEL_GROUPS[g].member[m] == idx) ? g
+         : coupledGroupOf(idx, g, (uint8_t)(m + 1));
+}
+
+constexpr uint8_t coupledGroupCount(uint8_t idx, uint8_t g = 0, uint8_t m = 0) {
+  return g >= GROUP_COUNT ? 0
+         : m >= CHANNEL_GROUPS[g].count ? coupledGroupCount(idx, (uint8_t)(g + 1), 0)
+         : (uint8_t)((CHANNEL_GROUPS[g].coupling != 0 && CHANNEL_GROUPS[g].member[m] == idx) +
+                     coupledGroupCount(idx, g, (uint8_t)(m + 1)));
+}
+
+constexpr bool groupsValid(uint8_t g = 0, uint8_t m = 0) {
+  return g >= GROUP_COUNT ? true
+         : CHANNEL_GROUPS[g].count < 1 || CHANNEL_GROUPS[g].count > GROUP_MAX_MEMBERS ? false
+         : m >= CHANNEL_GROUPS[g].count ? groupsValid((uint8_t)(g + 1), 0)
+         : CHANNEL_GROUPS[g].member[m] >= LED_COUNT ? false
+         : CHANNEL_GROUPS[g].coupling != 0 && coupledGroupCount(CHANNEL_GROUPS[g].member[m]) > 1 ? false
+         : groupsValid(g, (uint8_t)(m + 1));
+}
+static_assert(groupsValid(), "grupos de canales: miembro fuera de rango o canal en dos grupos acoplados");
+
+constexpr uint8_t CHANNEL_COUPLED_GROUP[6] = {
+  coupledGroupOf(0), coupledGroupOf(1), coupledGroupOf(2), coupledGroupOf(3), coupledGroupOf(4), coupledGroupOf(5)};
+static_assert(LED_COUNT == 6, "CHANNEL_COUPLED_GROUP: una entrada por canal");
+
+// ==============================================================================
+// Espacio de la hornacina (posicion 2D de cada canal)
+// ==============================================================================
+// Cada canal tiene una posicion en la hornacina vista de frente: x de -100
+// (izquierda) a 100 (derecha), y de -100 (frente) a 100 (fondo), CARA en el
+// centro. Un campo espacial convierte esas posiciones en un desfase por canal
+// (fase de 16 bits), calculado en compilacion:
+//   SPATIAL_BEAM    haz que gira: desfase = angulo del canal visto desde el centro.
+//   SPATIAL_TRAVEL  onda que cruza la hornacina: desfase = proyeccion sobre una direccion.
+//   SPATIAL_RADIAL  pulso desde el centro: desfase = distancia al centro.
+// En cada frame la fase de la onda se calcula una vez y cada canal solo lee su
+// desfase: sumar canales no suma calculo de geometria.
+
+struct ChannelPos {
+  int8_t x;
+  int8_t y;
+};
+
+constexpr ChannelPos CHANNEL_POS[6] = {
+  {-30, -100}, // CAN1 (candelas al frente)
+  {30, -100},  // CAN2
+  {0, 0},      // CARA (centro)
+  {-90, -60},  // FIZO (frente izquierda)
+  {90, -60},   // FDEP (frente derecha)
+  {0, 100},    // ATRA (detras)
+};
+static_assert(LED_COUNT == 6, "CHANNEL_POS: una entrada por canal");
+
+enum SpatialPattern : uint8_t {
+  SPATIAL_BEAM = 0,
+  SPATIAL_TRAVEL,
+  SPATIAL_RADIAL
+};
+
+struct SpatialField {
+  uint8_t pattern;
+  uint8_t mask;        // canales del campo
+  uint16_t gainQ8;     // estrechamiento del perfil (256 = triangulo completo)
+  uint16_t offset[6];  // desfase por canal
+};
+
+// atan en el primer octante (0 <= mn <= mx): t * (pi/4 + 0.273 * (1 - t)),
+// error < 0.3 grados. Fase de 16 bits: 8192 = 45 grados.
+constexpr uint16_t octantAngle(int32_t mn, int32_t mx) {
+  return mx == 0 ? 0 : (uint16_t)((8192L * mn * mx + 2847L * mn * (mx - mn)) / (mx * mx));
+}
+
+constexpr uint16_t quadrantAngle(int32_t ax, int32_t ay) {
+  return ay <= ax ? octantAngle(ay, ax) : (uint16_t)(16384U - octantAngle(ax, ay));
+}
+
+// Angulo de (x, y): 0 = derecha, 16384 = fondo (sentido antihorario visto de frente).
+constexpr uint16_t posAngle(int32_t x, int32_t y) {
+  return x >= 0 && y >= 0 ? quadrantAngle(x, y)
+         : x < 0 && y >= 0 ? (uint16_t)(32768U - quadrantAngle(-x, y))
+         : x < 0 ? (uint16_t)(32768U + quadrantAngle(-x, -y))
+         : (uint16_t)(65536UL - quadrantAngle(x, -y));
+}
+
+constexpr uint16_t isqrtSearch(uint32_t n, uint32_t lo, uint32_t hi) {
+  return lo >= hi ? (uint16_t)lo
+         : ((lo + hi + 1) / 2) * ((lo + hi + 1) / 2) <= n ? isqrtSearch(n, (lo + hi + 1) / 2, hi)
+         : isqrtSearch(n, lo, (lo + hi + 1) / 2 - 1);
+}
+
+constexpr uint16_t posDistance(int32_t x, int32_t y) {
+  return isqrtSearch((uint32_t)(x * x + y * y), 0, 256);
+}
+
+// Coordenada del canal i segun el patron (a, b = direccion en SPATIAL_TRAVEL).
+constexpr int32_t spatialCoord(uint8_t pattern, int32_t a, int32_t b, uint8_t i) {
+  return pattern == SPATIAL_BEAM ? (int32_t)posAngle(CHANNEL_POS[i].x, CHANNEL_POS[i].y)
+         : pattern == SPATIAL_TRAVEL ? (int32_t)CHANNEL_POS[i].x * a + (int32_t)CHANNEL_POS[i].y * b
+         : (int32_t)posDistance(CHANNEL_POS[i].x, CHANNEL_POS[i].y);
+}
+
+constexpr int32_t spatialMin(uint8_t pattern, int32_t a, int32_t b, uint8_t mask, uint8_t i = 0, int32_t best = 0x7FFFFFFFL) {
+  return i >= LED_COUNT ? best
+         : spatialMin(pattern, a, b, mask, (uint8_t)(i + 1),
+                      ((mask >> i) & 1) && spatialCoord(pattern, a, b, i) < best ? spatialCoord(pattern, a, b, i) : best);
+}
+
+constexpr int32_t spatialMax(uint8_t pattern, int32_t a, int32_t b, uint8_t mask, uint8_t i = 0, int32_t best = -0x7FFFFFFFL - 1) {
+  return i >= LED_COUNT ? best
+         : spatialMax(pattern, a, b, mask, (uint8_t)(i + 1),
+                      ((mask >> i) & 1) && spatialCoord(pattern, a, b, i) > best ? spatialCoord(pattern, a, b, i) : best);
+}
+
+// Desfase del canal i. Haz: el canal se enciende cuando el haz (que sale de
+// startPhase) pasa por su angulo. Onda y pulso: el primer canal del campo va
+// sin desfase y el ultimo con spread (fraccion de periodo, Q16) de retraso.
+constexpr uint16_t spatialOffset(uint8_t pattern, int32_t a, int32_t b, uint8_t mask, uint32_t spread, uint8_t i) {
+  return !((mask >> i) & 1) ? 0
+         : pattern == SPATIAL_BEAM ? (uint16_t)(a - spatialCoord(pattern, a, b, i))
+         : spatialMax(pattern, a, b, mask) == spatialMin(pattern, a, b, mask) ? 0
+         : (uint16_t)(0U - (uint16_t)((uint32_t)(spatialCoord(pattern, a, b, i) - spatialMin(pattern, a, b, mask)) * spread /
+                                      (uint32_t)(spatialMax(pattern, a, b, mask) - spatialMin(pattern, a, b, mask))));
+}
+
+constexpr SpatialField spatialField(uint8_t pattern, int32_t a, int32_t b, uint8_t mask, uint32_t spread, uint16_t gainQ8) {
+  return SpatialField{pattern, mask, gainQ8,
+                      {spatialOffset(pattern, a, b, mask, spread, 0), spatialOffset(pattern, a, b, mask, spread, 1),
+                       spatialOffset(pattern, a, b, mask, spread, 2), spatialOffset(pattern, a, b, mask, spread, 3),
+                       spatialOffset(pattern, a, b, mask, spread, 4), spatialOffset(pattern, a, b, mask, spread, 5)}};
+}
+
+// Haz giratorio que arranca en startDeg; halfWidthDeg = media anchura del haz
+// (180 = triangulo completo, cada canal sube y baja una vez por vuelta).
+constexpr SpatialField beamField(uint8_t mask, uint16_t startDeg, uint8_t halfWidthDeg) {
+  return spatialField(SPATIAL_BEAM, (int32_t)((uint32_t)startDeg * 65536UL / 360), 0, mask, 0,
+                      (uint16_t)(256U * 180U / halfWidthDeg));
+}
+
+// Onda que cruza la hornacina en la direccion (dx, dy); el ultimo canal va
+// spreadPct % de periodo detras del primero.
+constexpr SpatialField travelField(uint8_t mask, int8_t dx, int8_t dy, uint8_t spreadPct) {
+  return spatialField(SPATIAL_TRAVEL, dx, dy, mask, (uint32_t)spreadPct * 65536UL / 100, 256);
+}
+
+// Pulso que sale del centro; el canal mas lejano va spreadPct % de periodo detras.
+constexpr SpatialField radialField(uint8_t mask, uint8_t spreadPct) {
+  return spatialField(SPATIAL_RADIAL, 0, 0, mask, (uint32_t)spreadPct * 65536UL / 100, 256);
+}
+
+// Campos de las escenas.
+constexpr SpatialField TRIAD_HALO_FIELD = beamField((1 << 3) | (1 << 4) | (1 << 5), 90, 180); // halo: haz desde ATRA
+constexpr SpatialField SEA_WAVE_FIELD = travelField((1 << 3) | (1 << 4) | (1 << 5), 0, -1, 50); // ola: fondo -> frente
+
+// Perfil del campo: triangulo 0..256 (pico en fase 32768) estrechado por gainQ8.
+inline uint16_t spatialProfileQ8(uint16_t phase, uint16_t gainQ8) {
+  uint16_t tri = triangleQ8(phase);
+  if (gainQ8 == 256) return tri;
+  uint32_t drop = ((uint32_t)(256 - tri) * gainQ8) >> 8;
+  return drop >= 256 ? 0 : (uint16_t)(256 - drop);
+}
+
+// ==============================================================================
+// Funciones auxiliares
+// ==============================================================================
+
+// Forward declarations (definidas mas abajo)
+inline void initFade(ShrineController& s, uint8_t idx, uint8_t minV, uint8_t maxV, uint8_t step, uint16_t interval);
+inline void setFadeActive(ShrineController& s, uint8_t idx, bool active);
+
+// Escribe un solo canal en la capa activa (no toca hardware).
+inline void writeChannel(ShrineController& s, uint8_t idx, uint8_t value) {
+  EffectLayer& layer = s.layers[s.activeLayer];
+  layer.level[idx] = value;
+  layer.mask |= (uint8_t)(1 << idx);
+}
+
+// Escribe el mismo nivel en todos los miembros del grupo.
+inline void writeGroup(ShrineController& s, uint8_t g, uint8_t value) {
+  const ChannelGroup& grp = CHANNEL_GROUPS[g];
+  for (uint8_t m = 0; m < grp.count; m++) writeChannel(s, grp.member[m], value);
+}
+
+// Escribe el nivel pedido en la capa activa. Los canales de un grupo
+// GROUP_GANG (CAN1/CAN2) se escriben juntos.
+inline void setLedState(ShrineController& s, uint8_t idx, uint8_t value) {
+  if (idx >= LED_COUNT) return;
+  uint8_t g = CHANNEL_COUPLED_GROUP[idx];
+  if (g != GROUP_NONE && (CHANNEL_GROUPS[g].coupling & GROUP_GANG)) writeGroup(s, g, value);
+  else writeChannel(s, idx, value);
+}
+
+// Soft-off en curso: la escena base pide 0 pero la salida aun no llego a 0.
+inline bool isSoftOffActive(ShrineController& s, uint8_t idx) {
+  return s.layers[LAYER_BASE].level[idx] == 0 && s.ledBrightness[idx] > 0;
+}
+
+inline bool isGroupSoftOffActive(ShrineController& s, uint8_t g) {
+  const ChannelGroup& grp = CHANNEL_GROUPS[g];
+  for (uint8_t m = 0; m < grp.count; m++) {
+    if (isSoftOffActive(s, grp.member[m])) return true;
+  }
+  return false;
+}
+
+// Los efectos llamados entre beginLayer(s) y endLayer(s) actuan como fuente de
+// esa capa. Cualquier efecto existente sirve sin cambios.
+inline void beginLayer(ShrineController& s, uint8_t layer, BlendMode blend, uint8_t opacity) {
+  if (layer >= LAYER_COUNT) return;
+  s.activeLayer = layer;
+  s.layers[layer].blend = blend;
+  s.layers[layer].opacity = opacity;
+}
+
+inline void endLayer(ShrineController& s) {
+  s.activeLayer = LAYER_BASE;
+}
+
+inline void clearLayer(ShrineController& s, uint8_t layer) {
+  if (layer == LAYER_BASE || layer >= LAYER_COUNT) return;
+  s.layers[layer].mask = 0;
+  s.layers[layer].opacity = 0;
+}
+
+inline void clearOverlayLayers(ShrineController& s) {
+  for (uint8_t l = LAYER_BASE + 1; l < LAYER_COUNT; l++) clearLayer(s, l);
+  s.activeLayer = LAYER_BASE;
+}
+
+inline void setLedStaticPercent(ShrineController& s, uint8_t idx, uint8_t percent) {
+  setLedState(s, idx, percentToPwm(percent));
+}
+
+// ==============================================================================
+// Descriptores de efecto (constexpr, validados con static_assert)
+// ==============================================================================
+// Los parametros de cada efecto se fijan en compilacion: el descriptor guarda
+// los valores originales (para validar) y los ya convertidos a PWM / fase, de
+// modo que el render solo hace la aritmetica que depende del tiempo. Onda,
+// deriva y candelita estan en include/effect_kernels.h (compartidos con host).
+
+// Ola de mar: ATRA y grupo FIZO+FDEP en oposicion de fase, mismo periodo.
+struct SeaWaveDesc {
+  WaveDesc atra;
+  WaveDesc grupo;
+};
+
+constexpr SeaWaveDesc seaWaveDesc(uint8_t atraMinPct, uint8_t atraMaxPct, uint8_t grupoMinPct, uint8_t grupoMaxPct, uint32_t periodMs) {
+  return SeaWaveDesc{waveDesc(atraMinPct, atraMaxPct, periodMs), waveDesc(grupoMinPct, grupoMaxPct, periodMs)};
+}
+
+// Respiracion devocional: CARA lidera, ATRA desfasado delayMs y escalado.
+struct DevotionalDesc {
+  WaveDesc cara;
+  uint32_t delayMs;
+  uint8_t atraScalePct;
+  uint16_t delayPhase;
+  uint16_t atraScaleQ8;
+};
+
+constexpr DevotionalDesc devotionalDesc(uint8_t caraMinPct, uint8_t caraMaxPct, uint32_t periodMs, uint32_t delayMs, uint8_t atraScalePct) {
+  return DevotionalDesc{waveDesc(caraMinPct, caraMaxPct, periodMs), delayMs, atraScalePct,
+                        (uint16_t)(((uint64_t)delayMs * 65536ULL) / periodMs),
+                        (uint16_t)((atraScalePct * 256UL + 50) / 100)};
+}
+
+// Tenue + destello aleatorio.
+struct FlashDesc {
+  uint8_t basePct;
+  uint8_t flashMinPct;
+  uint8_t flashMaxPct;
+  uint16_t checkIntervalMs;
+  uint8_t chancePct;
+  uint16_t flashMinMs;
+  uint16_t flashMaxMs;
+  uint8_t basePwm;
+  uint8_t flashMinPwm;
+  uint8_t flashMaxPwm;
+};
+
+constexpr FlashDesc flashDesc(uint8_t basePct, uint8_t flashMinPct, uint8_t flashMaxPct, uint16_t checkIntervalMs,
+                              uint8_t chancePct, uint16_t flashMinMs, uint16_t flashMaxMs) {
+  return FlashDesc{basePct, flashMinPct, flashMaxPct, checkIntervalMs, chancePct, flashMinMs, flashMaxMs,
+                   percentToPwm(basePct), percentToPwm(flashMinPct), percentToPwm(flashMaxPct)};
+}
+
+// FADE IN/OUT por porcentaje y velocidad.
+struct FadeDesc {
+  uint8_t minPct;
+  uint8_t maxPct;
+  uint16_t speedMs;
+  uint8_t minPwm;
+  uint8_t maxPwm;
+};
+
+constexpr FadeDesc fadeDesc(uint8_t minPct, uint8_t maxPct, uint16_t speedMs) {
+  return FadeDesc{minPct, maxPct, speedMs, percentToPwm(minPct), percentToPwm(maxPct)};
+}
+
+// Candelita: CandleDesc / candleDescFor en include/effect_kernels.h. Coeficientes
+// del parpadeo de todas las candelitas (buscarlos con profile_sweep vela).
+constexpr CandleCoefs CANDLE_COEFS = CANDLE_COEFS_DEFAULT;
+
+constexpr CandleDesc candleDesc(uint8_t maxValueCan1) {
+  return candleDescFor(maxValueCan1, (uint8_t)((uint16_t)maxValueCan1 * 80 / 100), CANDLE_COEFS); // CAN2 siempre 20% menor de maximo
+}
+
+// Acento de bienvenida: opacidad = 255 - elapsed * fadeQ16 >> 16.
+struct WelcomeDesc {
+  uint8_t peakPct;
+  uint16_t durationMs;
+  uint8_t peakPwm;
+  uint32_t fadeQ16;
+};
+
+constexpr WelcomeDesc welcomeDesc(uint8_t peakPct, uint16_t durationMs) {
+  return WelcomeDesc{peakPct, durationMs, percentToPwm(peakPct), (uint32_t)((255UL * 65536UL) / durationMs)};
+}
+
+// ==============================================================================
+// Efectos (render: solo aritmetica dependiente del tiempo)
+// ==============================================================================
+
+template <const FadeDesc& D>
+void configureLedFadeInOut(ShrineController& s, uint8_t idx) {
+  static_assert(D.minPct <= D.maxPct && D.maxPct <= 100, "fade: rango de % invalido");
+  static_assert(D.speedMs >= 5 && D.speedMs <= EFFECT_TIMER_MAX_MS, "fade: velocidad fuera de 5..30000 ms");
+  // Evita reiniciar el fade cuando ya esta configurado igual.
+  const FadeSlot& f = s.effects.slot[idx].fade;
+  if (s.effects.tag[idx] == EFFECT_FADE && f.min == D.minPwm && f.max == D.maxPwm && f.interval == D.speedMs) return;
+  initFade(s, idx, D.minPwm, D.maxPwm, 1, D.speedMs);
+}
+
+inline void setLedFadeInOutActive(ShrineController& s, uint8_t idx, bool active) {
+  setFadeActive(s, idx, active);
+}
+
+inline void disableRandomFlashEffect(ShrineController& s, uint8_t idx) {
+  if (idx >= LED_COUNT) return;
+  releaseEffectSlot(s, idx, EFFECT_FLASH);
+}
+
+inline void resetOrganicDriftState(ShrineController& s, uint8_t idx) {
+  if (idx >= LED_COUNT) return;
+  releaseEffectSlot(s, idx, EFFECT_DRIFT);
+}
+
+// Efecto general: LED tenue (basePct) con destellos altos aleatorios.
+inline void randomFlashTenue(ShrineController& s, const FrameContext& fc, uint8_t idx, const FlashDesc& D) {
+  FlashSlot& st = s.effects.slot[idx].flash;
+  if (claimEffectSlot(s, idx, EFFECT_FLASH)) st.nextCheckAt = fc.tick;
+
+  if (st.on) {
+    if (timerDue(fc.tick, st.endAt)) {
+      st.on = false;
+      setLedState(s, idx, D.basePwm);
+      return;
+    }
+    setLedState(s, idx, st.peak);
+    return;
+  }
+
+  if (timerDue(fc.tick, st.nextCheckAt)) {
+    st.nextCheckAt = fc.tick + D.checkIntervalMs;
+    ShrineRng rng = {s.platform};
+    if (rng(0, 100) < D.chancePct) {
+      st.on = true;
+      st.peak = (uint8_t)rng(D.flashMinPwm, D.flashMaxPwm + 1);
+      st.endAt = fc.tick + (uint16_t)rng(D.flashMinMs, D.flashMaxMs + 1);
+      setLedState(s, idx, st.peak);
+      return;
+    }
+  }
+
+  setLedState(s, idx, D.basePwm);
+}
+
+template <const FlashDesc& D>
+void applyRandomFlashTenue(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  static_assert(D.basePct <= 100, "destello: basePct > 100");
+  static_assert(D.flashMinPct >= 1 && D.flashMinPct <= D.flashMaxPct && D.flashMaxPct <= 100, "destello: rango de % invalido");
+  static_assert(D.checkIntervalMs >= 20 && D.checkIntervalMs <= EFFECT_TIMER_MAX_MS, "destello: checkIntervalMs fuera de 20..30000");
+  static_assert(D.chancePct >= 1 && D.chancePct <= 100, "destello: chancePct fuera de 1..100");
+  static_assert(D.flashMinMs >= 20 && D.flashMinMs <= D.flashMaxMs && D.flashMaxMs <= EFFECT_TIMER_MAX_MS, "destello: duracion invalida");
+  randomFlashTenue(s, fc, idx, D);
+}
+
+// Efecto respiracion devocional: CARA lidera, ATRA sigue con desfase e intensidad relativa.
+template <const DevotionalDesc& D>
+void applyDevotionalBreathing(ShrineController& s, const FrameContext& fc) {
+  static_assert(D.cara.minPct >= 1 && D.cara.minPct <= D.cara.maxPct && D.cara.maxPct <= 100, "devocional: rango de % invalido");
+  static_assert(D.cara.periodMs >= 1000, "devocional: periodo minimo 1000 ms");
+  static_assert(D.delayMs < D.cara.periodMs, "devocional: el desfase debe ser menor que el periodo");
+  static_assert(D.atraScalePct >= 1 && D.atraScalePct <= 100, "devocional: atraScalePct fuera de 1..100");
+
+  uint16_t phase = wavePhase(fc.now, D.cara.phaseInc);
+  uint8_t caraLevel = waveLevel(D.cara.minPwm, D.cara.spanPwm, triangleQ8(phase));
+  uint8_t atraBase = waveLevel(D.cara.minPwm, D.cara.spanPwm, triangleQ8(phase + D.delayPhase));
+  setLedState(s, 2, caraLevel);                                       // CARA
+  setLedState(s, 5, (uint8_t)(((uint16_t)atraBase * D.atraScaleQ8) >> 8)); // ATRA
+}
+
+// Respiracion suave para un LED individual (0..5), por porcentaje.
+template <const WaveDesc& D>
+void applySingleBreathing(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  static_assert(D.minPct >= 1 && D.minPct <= D.maxPct && D.maxPct <= 100, "respiracion: rango de % invalido");
+  static_assert(D.periodMs >= 1000, "respiracion: periodo minimo 1000 ms");
+  uint16_t phase = wavePhase(fc.now, D.phaseInc);
+  setLedState(s, idx, waveLevel(D.minPwm, D.spanPwm, triangleQ8(phase)));
+}
+
+// Efecto nuevo: deriva organica (sin ciclo fijo).
+inline void organicDrift(ShrineController& s, const FrameContext& fc, uint8_t idx, const DriftDesc& D) {
+  DriftSlot& st = s.effects.slot[idx].drift;
+  ShrineRng rng = {s.platform};
+  if (claimEffectSlot(s, idx, EFFECT_DRIFT)) driftStart(st, D, fc.tick, rng);
+  setLedState(s, idx, driftStep(st, D, fc.tick, rng));
+}
+
+template <const DriftDesc& D>
+void applyOrganicDrift(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  static_assert(D.minPct <= D.maxPct && D.maxPct <= 100, "deriva: rango de % invalido");
+  static_assert(D.targetMinMs >= 60 && D.targetMinMs <= D.targetMaxMs && D.targetMaxMs <= EFFECT_TIMER_MAX_MS, "deriva: tiempos de target invalidos");
+  static_assert(D.stepMinPct >= 1 && D.stepMinPct <= D.stepMaxPct && D.stepMaxPct <= 20, "deriva: pasos fuera de 1..20%");
+  static_assert(D.stepIntervalMs >= 10 && D.stepIntervalMs <= EFFECT_TIMER_MAX_MS, "deriva: stepIntervalMs fuera de 10..30000");
+  organicDrift(s, fc, idx, D);
+}
+
+// Reparte una onda sobre los canales de mask del campo: cada canal suma su
+// desfase a la fase ya calculada y aplica el perfil.
+inline void writeSpatialWave(ShrineController& s, const SpatialField& f, uint16_t phase, uint8_t mask, const WaveDesc& w) {
+  for (uint8_t i = 0; i < LED_COUNT; i++) {
+    if (!((mask >> i) & 1)) continue;
+    uint16_t q = spatialProfileQ8((uint16_t)(phase + f.offset[i]), f.gainQ8);
+    writeChannel(s, i, waveLevel(w.minPwm, w.spanPwm, q));
+  }
+}
+
+// Onda D sobre el campo espacial F (haz, onda que cruza o pulso radial).
+template <const WaveDesc& D, const SpatialField& F>
+void applySpatialWave(ShrineController& s, const FrameContext& fc) {
+  static_assert(D.minPct <= D.maxPct && D.maxPct <= 100, "campo: rango de % invalido");
+  static_assert(F.mask != 0 && (F.mask >> LED_COUNT) == 0, "campo: mascara de canales invalida");
+  static_assert(F.gainQ8 >= 256, "campo: media anchura del haz fuera de 1..180 grados");
+  writeSpatialWave(s, F, wavePhase(fc.now, D.phaseInc), F.mask, D);
+}
+
+// Efecto nuevo: halo circular, un haz que gira por FIZO, FDEP y ATRA segun su
+// posicion (TRIAD_HALO_FIELD).
+template <const WaveDesc& D>
+void applyTriadCircularHalo(ShrineController& s, const FrameContext& fc) {
+  static_assert(D.minPct <= D.maxPct && D.maxPct <= 100, "halo: rango de % invalido");
+  static_assert(D.periodMs >= 1200, "halo: periodo minimo 1200 ms");
+  applySpatialWave<D, TRIAD_HALO_FIELD>(s, fc);
+}
+
+// Efecto "ola de mar" circular para Modo 6 base: la onda cruza la hornacina
+// del fondo al frente con medio periodo de retraso (SEA_WAVE_FIELD).
+// Fase A: ATRA sube mientras FIZO+FDEP bajan.
+// Fase B: FIZO+FDEP suben juntos mientras ATRA baja.
+template <const SeaWaveDesc& D>
+void applySeaWaveCircularMode6Base(ShrineController& s, const FrameContext& fc) {
+  static_assert(D.atra.minPct <= D.atra.maxPct && D.atra.maxPct <= 100, "ola: rango ATRA invalido");
+  static_assert(D.grupo.minPct <= D.grupo.maxPct && D.grupo.maxPct <= 100, "ola: rango grupo invalido");
+  static_assert(D.atra.periodMs >= 1200, "ola: periodo minimo 1200 ms");
+  const uint8_t atra = 1 << 5;
+  uint16_t phase = wavePhase(fc.now, D.atra.phaseInc);
+  writeSpatialWave(s, SEA_WAVE_FIELD, phase, atra, D.atra);                                   // ATRA lider
+  writeSpatialWave(s, SEA_WAVE_FIELD, phase, (uint8_t)(SEA_WAVE_FIELD.mask & ~atra), D.grupo); // frente
+}
+
+// Acento de bienvenida: al entrar en movimiento, el LED sube a peakPct en una
+// capa overlay (MAX) y la opacidad cae linealmente hasta 0 en durationMs.
+template <const WelcomeDesc& D>
+void applyWelcomeFlash(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  static_assert(D.peakPct <= 100, "bienvenida: peakPct > 100");
+  static_assert(D.durationMs >= 100, "bienvenida: duracion minima 100 ms");
+  unsigned long elapsed = fc.now - s.input.motionStartAt;
+  if (elapsed >= D.durationMs) {
+    clearLayer(s, LAYER_OVERLAY);
+    return;
+  }
+  uint8_t opacity = (uint8_t)(255 - ((elapsed * D.fadeQ16) >> 16));
+  beginLayer(s, LAYER_OVERLAY, BLEND_MAX, opacity);
+  setLedState(s, idx, D.peakPwm);
+  endLayer(s);
+}
+
+inline void allLedsOff(ShrineController& s) {
+  clearOverlayLayers(s);
+  for (uint8_t i = 0; i < LED_COUNT; i++) {
+    disableRandomFlashEffect(s, i);
+    resetOrganicDriftState(s, i);
+    setFadeActive(s, i, false);
+    setLedState(s, i, 0);
+  }
+}
+
+// ==============================================================================
+// Función de flicker para candelitas (CON INDEPENDENCIA)
+// ==============================================================================
+
+inline void candleFlicker(ShrineController& s, const FrameContext& fc, const CandleDesc& D) {
+  ShrineRng rng = {s.platform};
+#if CANDLE_SAMPLED
+  // Una muestra de la grabacion cada ~16 ms por candela: lectura de flash y un
+  // nibble ADPCM, sin random() salvo al cambiar de grano (cada 2-6 s).
+  bool fresh1 = flameStep(s.flame[0], FLAME_VELA, FLAME_VELA_BLOCKS, fc.tick, rng);
+  bool fresh2 = flameStep(s.flame[1], FLAME_VELA, FLAME_VELA_BLOCKS, fc.tick, rng);
+  if (!fresh1 && !fresh2) return;
+  s.candle.level1 = flameLevel(s.flame[0].level, D.max1, CANDLE_FLOOR_PWM);
+  s.candle.level2 = flameLevel(s.flame[1].level, D.max2, CANDLE_FLOOR_PWM);
+#else
+  // CAN1 mas vivo, CAN2 desincronizado y mas suave (candleStep en include/effect_kernels.h).
+  if (!candleStep(s.candle, D, fc.tick, rng)) return;
+#endif
+
+  // Respeta el soft-off del grupo (p.ej. tras cambio de modo)
+  if (isGroupSoftOffActive(s, GROUP_CANDELAS)) return;
+  writeChannel(s, 0, s.candle.level1);
+  writeChannel(s, 1, s.candle.level2);
+}
+
+template <const CandleDesc& D>
+void updateCandleFlicker(ShrineController& s, const FrameContext& fc) {
+  candleFlicker(s, fc, D);
+}
+
+// ======================================================================
+// FADE reutilizable (estado y funciones)
+// ======================================================================
+
+inline void initFade(ShrineController& s, uint8_t idx, uint8_t minV, uint8_t maxV, uint8_t step, uint16_t interval) {
+  if (idx >= LED_COUNT) return;
+  claimEffectSlot(s, idx, EFFECT_FADE);
+  FadeSlot& f = s.effects.slot[idx].fade;
+  f.min = minV;
+  f.max = maxV;
+  f.step = step;
+  f.interval = interval;
+  f.val = minV;
+  f.dir = 1;
+  f.last = 0;
+  f.active = false;
+}
+
+inline void setFadeActive(ShrineController& s, uint8_t idx, bool active) {
+  if (idx >= LED_COUNT) return;
+  if (s.effects.tag[idx] != EFFECT_FADE) return; // el slot lo usa otro efecto (o no hay fade configurado)
+  FadeSlot& f = s.effects.slot[idx].fade;
+  f.active = active;
+  if (active && f.val == 0) f.val = f.min;
+}
+
+inline void updateFade(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  if (idx >= LED_COUNT) return;
+  if (s.effects.tag[idx] != EFFECT_FADE) return;
+  FadeSlot& f = s.effects.slot[idx].fade;
+  if (!f.active) return;
+  ShrineRng rng = {s.platform};
+  if (fadeStep(f, fc.tick, rng)) setLedState(s, idx, f.val);
+}
+
+// ==============================================================================
+// Mezcla base / movimiento por intensidad
+// ==============================================================================
+// fc.motionQ8 (0..256) interpola cada parametro de la escena entre su valor base
+// y el de movimiento: base + delta * q / 256, con delta = mov - base constante de
+// compilacion (los dos descriptores son argumentos de plantilla). En los
+// extremos corre el efecto de siempre (cache periodica incluida); en medio,
+// una multiplicacion y una suma por parametro y frame sobre un descriptor en
+// pila. Un canal cuyo efecto cambia de tipo entre base y movimiento (destello
+// -> fade, ola -> respiracion) mezcla el nivel de los dos. A media intensidad
+// (MOTION_HALF_Q8) solo cambia la clave de escena (secuencias, duty, caja negra).
+
+const uint16_t MOTION_HALF_Q8 = 128;
+
+inline uint8_t motionBlend(uint8_t base, int16_t delta, uint16_t q) {
+  return (uint8_t)(base + (int16_t)(((int32_t)delta * q) >> 8));
+}
+
+inline uint16_t motionBlend16(uint16_t base, int32_t delta, uint16_t q) {
+  return (uint16_t)(base + ((delta * q) >> 8));
+}
+
+inline void setLedStaticBlend(ShrineController& s, const FrameContext& fc, uint8_t idx, uint8_t basePct, uint8_t movePct) {
+  uint8_t b = percentToPwm(basePct);
+  setLedState(s, idx, motionBlend(b, (int16_t)percentToPwm(movePct) - b, fc.motionQ8));
+}
+
+template <const CandleDesc& B, const CandleDesc& M>
+void updateCandleFlickerBlend(ShrineController& s, const FrameContext& fc) {
+  uint16_t q = fc.motionQ8;
+  if (q == 0) return updateCandleFlicker<B>(s, fc);
+  if (q >= 256) return updateCandleFlicker<M>(s, fc);
+  CandleDesc d = B;
+  d.max1 = motionBlend(B.max1, M.max1 - B.max1, q);
+  d.max2 = motionBlend(B.max2, M.max2 - B.max2, q);
+  d.minBase1 = motionBlend(B.minBase1, M.minBase1 - B.minBase1, q);
+  d.minBase2 = motionBlend(B.minBase2, M.minBase2 - B.minBase2, q);
+  d.dropMax1 = motionBlend(B.dropMax1, M.dropMax1 - B.dropMax1, q);
+  d.dropMax2 = motionBlend(B.dropMax2, M.dropMax2 - B.dropMax2, q);
+  candleFlicker(s, fc, d);
+}
+
+template <const DriftDesc& B, const DriftDesc& M>
+void applyOrganicDriftBlend(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  uint16_t q = fc.motionQ8;
+  if (q == 0) return applyOrganicDrift<B>(s, fc, idx);
+  if (q >= 256) return applyOrganicDrift<M>(s, fc, idx);
+  DriftDesc d = B;
+  d.minPwm = motionBlend(B.minPwm, M.minPwm - B.minPwm, q);
+  d.maxPwm = motionBlend(B.maxPwm, M.maxPwm - B.maxPwm, q);
+  d.stepMinPwm = motionBlend(B.stepMinPwm, M.stepMinPwm - B.stepMinPwm, q);
+  d.stepMaxPwm = motionBlend(B.stepMaxPwm, M.stepMaxPwm - B.stepMaxPwm, q);
+  d.targetMinMs = motionBlend16(B.targetMinMs, (int32_t)M.targetMinMs - B.targetMinMs, q);
+  d.targetMaxMs = motionBlend16(B.targetMaxMs, (int32_t)M.targetMaxMs - B.targetMaxMs, q);
+  d.stepIntervalMs = motionBlend16(B.stepIntervalMs, (int32_t)M.stepIntervalMs - B.stepIntervalMs, q);
+  organicDrift(s, fc, idx, d);
+}
+
+template <const FlashDesc& B, const FlashDesc& M>
+void applyRandomFlashBlend(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  uint16_t q = fc.motionQ8;
+  if (q == 0) return applyRandomFlashTenue<B>(s, fc, idx);
+  if (q >= 256) return applyRandomFlashTenue<M>(s, fc, idx);
+  FlashDesc d = B;
+  d.basePwm = motionBlend(B.basePwm, M.basePwm - B.basePwm, q);
+  d.flashMinPwm = motionBlend(B.flashMinPwm, M.flashMinPwm - B.flashMinPwm, q);
+  d.flashMaxPwm = motionBlend(B.flashMaxPwm, M.flashMaxPwm - B.flashMaxPwm, q);
+  d.chancePct = motionBlend(B.chancePct, M.chancePct - B.chancePct, q);
+  d.checkIntervalMs = motionBlend16(B.checkIntervalMs, (int32_t)M.checkIntervalMs - B.checkIntervalMs, q);
+  d.flashMinMs = motionBlend16(B.flashMinMs, (int32_t)M.flashMinMs - B.flashMinMs, q);
+  d.flashMaxMs = motionBlend16(B.flashMaxMs, (int32_t)M.flashMaxMs - B.flashMaxMs, q);
+  randomFlashTenue(s, fc, idx, d);
+}
+
+// Fade o nivel fijo (min == max) en un extremo de la mezcla.
+template <const FadeDesc& D>
+void applyFadeOrStatic(ShrineController& s, uint8_t idx) {
+  if (D.minPct == D.maxPct) {
+    setLedFadeInOutActive(s, idx, false);
+    setLedStaticPercent(s, idx, D.minPct);
+    return;
+  }
+  configureLedFadeInOut<D>(s, idx);
+  setLedFadeInOutActive(s, idx, true);
+}
+
+// Fade mezclado: el slot conserva nivel y sentido y solo cambian los limites y
+// la velocidad (sin reiniciar el fade al llegar al extremo de movimiento).
+template <const FadeDesc& B, const FadeDesc& M>
+void applyFadeBlend(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  uint16_t q = fc.motionQ8;
+  if (q == 0) return applyFadeOrStatic<B>(s, idx);
+  uint8_t lo = motionBlend(B.minPwm, M.minPwm - B.minPwm, q);
+  uint8_t hi = motionBlend(B.maxPwm, M.maxPwm - B.maxPwm, q);
+  uint16_t interval = motionBlend16(B.speedMs, (int32_t)M.speedMs - B.speedMs, q);
+  FadeSlot& f = s.effects.slot[idx].fade;
+  if (s.effects.tag[idx] != EFFECT_FADE) initFade(s, idx, lo, hi, 1, interval);
+  f.min = lo;
+  f.max = hi;
+  f.interval = interval;
+  f.active = true;
+  if (f.val < lo) f.val = lo;
+  if (f.val > hi) f.val = hi;
+  setLedState(s, idx, f.val);
+}
+
+// Respiracion con amplitud mezclada (mismo periodo en los dos extremos).
+template <const WaveDesc& B, const WaveDesc& M>
+void applySingleBreathingBlend(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  static_assert(B.periodMs == M.periodMs, "mezcla: la respiracion debe tener el mismo periodo");
+  uint8_t minPwm = motionBlend(B.minPwm, M.minPwm - B.minPwm, fc.motionQ8);
+  uint8_t spanPwm = motionBlend(B.spanPwm, M.spanPwm - B.spanPwm, fc.motionQ8);
+  setLedState(s, idx, waveLevel(minPwm, spanPwm, triangleQ8(wavePhase(fc.now, B.phaseInc))));
+}
+
+// Reloj de escena para ondas con periodo distinto en base y movimiento: avanza
+// dtMs * ritmo, con ritmo 1 en base y BASE_MS / MOVE_MS en movimiento, y la
+// onda se evalua siempre con el periodo base. La fase no salta al cambiar la
+// intensidad y la cache periodica sigue valiendo (reproduce a ese ritmo).
+template <uint32_t BASE_MS, uint32_t MOVE_MS>
+FrameContext motionClockFrame(ShrineController& s, const FrameContext& fc) {
+  const uint16_t RATE_MOVE_Q8 = (uint16_t)((BASE_MS * 256UL + MOVE_MS / 2) / MOVE_MS);
+  uint16_t rate = motionBlend16(256, (int32_t)RATE_MOVE_Q8 - 256, fc.motionQ8);
+  uint32_t acc = (uint32_t)fc.dtMs * rate + s.sceneClockFrac;
+  s.sceneClock += acc >> 8;
+  s.sceneClockFrac = (uint8_t)acc;
+  FrameContext c = fc;
+  c.now = s.sceneClock;
+  c.dtMs = (acc >> 8) > 65535UL ? 65535 : (uint16_t)(acc >> 8);
+  return c;
+}
+
+// Halo con amplitud mezclada sobre el reloj de escena (fc de motionClockFrame).
+template <const WaveDesc& B, const WaveDesc& M>
+void applyTriadHaloBlend(ShrineController& s, const FrameContext& fc) {
+  WaveDesc w = B;
+  w.minPwm = motionBlend(B.minPwm, M.minPwm - B.minPwm, fc.motionQ8);
+  w.spanPwm = motionBlend(B.spanPwm, M.spanPwm - B.spanPwm, fc.motionQ8);
+  writeSpatialWave(s, TRIAD_HALO_FIELD, wavePhase(fc.now, B.phaseInc), TRIAD_HALO_FIELD.mask, w);
+}
+
+// Destello -> onda: el destello sigue en su slot y la onda (sin estado) se
+// mezcla por nivel; en movimiento completo el destello suelta el slot.
+template <const FlashDesc& B, const WaveDesc& M>
+void applyFlashWaveBlend(ShrineController& s, const FrameContext& fc, uint8_t idx) {
+  uint16_t q = fc.motionQ8;
+  if (q == 0) return applyRandomFlashTenue<B>(s, fc, idx);
+  uint8_t wave = waveLevel(M.minPwm, M.spanPwm, triangleQ8(wavePhase(fc.now, M.phaseInc)));
+  if (q >= 256) {
+    disableRandomFlashEffect(s, idx);
+    setLedState(s, idx, wave);
+    return;
+  }
+  applyRandomFlashTenue<B>(s, fc, idx);
+  const FlashSlot& st = s.effects.slot[idx].flash;
+  uint8_t flash = st.on ? st.peak : B.basePwm;
+  setLedState(s, idx, motionBlend(flash, (int16_t)wave - flash, q));
+}
+
+// ==============================================================================
+// Composicion de capas (base + overlays) en punto fijo
+// ==============================================================================
+
+// Mezcla las capas sobre la base. El modo de mezcla es invariante por capa y
+// la opacidad se aplica como lerp 8.8 en uint16 (sin divisiones ni 32 bits).
+// Coste fijo: (LAYER_COUNT - 1) * LED_COUNT mezclas de ~30 ciclos AVR en el peor
+// caso, unos 360 ciclos (~23 us a 16 MHz) por frame con todas las capas activas.
+inline void composeFrame(ShrineController& s) {
+  memcpy(s.frameLevels, s.layers[LAYER_BASE].level, LED_COUNT);
+  for (uint8_t l = LAYER_BASE + 1; l < LAYER_COUNT; l++) {
+    const EffectLayer& layer = s.layers[l];
+    if (layer.mask == 0) continue;
+    uint8_t opacity = layer.opacity;
+    if (opacity == 0 && layer.blend != BLEND_REPLACE) continue;
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+      if (!(layer.mask & (1 << i))) continue;
+      uint8_t dst = s.frameLevels[i];
+      uint8_t src = layer.level[i];
+      uint8_t mixed;
+      switch (layer.blend) {
+        case BLEND_REPLACE: s.frameLevels[i] = src; continue;
+        case BLEND_MAX: mixed = (src > dst) ? src : dst; break;
+        case BLEND_ADD: { uint16_t sum = (uint16_t)dst + src; mixed = (sum > 255) ? 255 : (uint8_t)sum; } break;
+        case BLEND_MULTIPLY: mixed = (uint8_t)(((uint16_t)dst * src + 255) >> 8); break;
+        default: mixed = src; break; // BLEND_CROSSFADE
+      }
+      // lerp dst -> mixed segun opacidad (255 = capa completa)
+      uint16_t a = (uint16_t)opacity + 1;
+      s.frameLevels[i] = (uint8_t)(((uint16_t)dst * (256 - a) + (uint16_t)mixed * a) >> 8);
+    }
+  }
+}
+
+// Etapa soft-off: si el frame pide 0 y el LED esta encendido, baja por pasos
+// (no bloqueante). Los miembros de un grupo GROUP_SOFTOFF siguen al lider.
+inline uint8_t applySoftOffStage(ShrineController& s, uint8_t idx, uint8_t level, uint16_t tick) {
+  if (level != 0) return level;
+  uint8_t prev = s.ledBrightness[idx];
+  if (prev == 0) return 0;
+  uint8_t g = CHANNEL_COUPLED_GROUP[idx];
+  if (g != GROUP_NONE && (CHANNEL_GROUPS[g].coupling & GROUP_SOFTOFF)) {
+    uint8_t leader = CHANNEL_GROUPS[g].member[0];
+    if (idx != leader && s.frameLevels[leader] == 0) return s.ledBrightness[leader]; // ya resuelto por el lider
+  }
+  if (timerElapsed(tick, s.effects.softOffLast[idx]) < SOFTOFF_INTERVAL) return prev;
+  s.effects.softOffLast[idx] = tick;
+  return (prev <= SOFTOFF_STEP) ? 0 : (uint8_t)(prev - SOFTOFF_STEP);
+}
+
+// Etapas de salida del controlador (soft-off y atenuacion por el brillo
+// maestro dim, 255 = sin cambio); el frame resultante pasa a ledBrightness y al
+// sink del controlador.
+inline void commitFrame(ShrineController& s, const FrameContext& fc, uint8_t dim) {
+  uint8_t out[6];
+  for (uint8_t i = 0; i < LED_COUNT; i++) {
+    uint8_t level = applySoftOffStage(s, i, s.frameLevels[i], fc.tick);
+    // Atenuacion: solo sobre niveles pedidos; el soft-off ya parte del valor en hardware.
+    if (s.frameLevels[i] != 0 && dim != 255) level = (uint8_t)(((uint16_t)level * dim + 255) >> 8);
+    out[i] = level;
+  }
+  memcpy(s.ledBrightness, out, LED_COUNT);
+  if (s.sink.write) s.sink.write(s.sink.ctx, s, out);
+}
+
+// ==============================================================================
+// Funciones de modo (aplican configuración base o submodo)
+// ==============================================================================
+
+// ==============================================================================
+// Cache de escena periodica (pre-render de un periodo + reproduccion)
+// ==============================================================================
+// Las partes estrictamente periodicas de una escena (halo, ola, respiraciones)
+// son funciones puras de fc.now. Al entrar en la escena se renderiza un periodo
+// completo a SCENE_CACHE_FRAME_MS por frame en un buffer delta-codificado
+// (keyframe + un nibble con signo por canal y frame) y luego se reproduce
+// avanzando un indice. Si no cabe o no es codificable, se evalua en vivo.
+// El buffer es de la placa (uno, por RAM) y cada controlador lo recibe
+// prestado en s.cache; sin cache, todo en vivo.
+
+typedef void (*PeriodicRenderFn)(ShrineController& s, const FrameContext& fc);
+
+const uint16_t SCENE_CACHE_FRAME_MS = 40;    // 25 fps de reproduccion
+
+// Bytes de un periodo: keyframe + un nibble por canal y frame restante.
+constexpr uint16_t sceneCacheBytes(uint32_t periodMs, uint8_t channels) {
+  return (uint16_t)(channels + (((periodMs / SCENE_CACHE_FRAME_MS) - 1) * channels + 1) / 2);
+}
+
+// Buffer reservado en SRAM: la parte periodica mas larga (las de triada, 3
+// canales; las demas se comprueban con static_assert junto a applyMode).
+const uint16_t SCENE_CACHE_BYTES = sceneCacheBytes(
+  MODE1.triadBasePeriodMs > MODE6_OLA_PERIOD_MS ? MODE1.triadBasePeriodMs : MODE6_OLA_PERIOD_MS, 3);
+
+struct SceneCache {
+  ShrineController* owner; // hornacina que usa el buffer (0 = libre)
+  PeriodicRenderFn render; // escena cacheada (o intentada) actualmente
+  bool valid;              // true = reproduciendo desde buffer
+  uint8_t mask;            // canales cubiertos
+  uint8_t channels[6];     // indices de canal en orden de codificacion
+  uint8_t channelCount;
+  uint16_t frameCount;
+  uint16_t frameIndex;
+  uint16_t accMs;          // ms acumulados hacia el siguiente frame
+  uint16_t usedBytes;
+  uint16_t liveUs;         // coste medido de un render en vivo
+  uint16_t playUs;         // coste medido de un paso de reproduccion (x100)
+  uint8_t levels[6];       // niveles actuales reconstruidos
+  uint8_t data[SCENE_CACHE_BYTES];
+};
+
+inline int8_t sceneCacheDelta(const SceneCache& c, uint16_t nibbleIdx) {
+  uint8_t b = c.data[c.channelCount + (nibbleIdx >> 1)];
+  uint8_t n = (nibbleIdx & 1) ? (b >> 4) : (b & 0x0F);
+  return (int8_t)((n ^ 0x08) - 0x08); // nibble con signo -8..7
+}
+
+// Avanza un frame: aplica deltas o vuelve al keyframe al cerrar el periodo.
+inline void sceneCacheStep(SceneCache& c) {
+  if (++c.frameIndex >= c.frameCount) {
+    c.frameIndex = 0;
+    memcpy(c.levels, c.data, c.channelCount);
+    return;
+  }
+  uint16_t base = (uint16_t)(c.frameIndex - 1) * c.channelCount;
+  for (uint8_t k = 0; k < c.channelCount; k++) {
+    c.levels[k] = (uint8_t)(c.levels[k] + sceneCacheDelta(c, base + k));
+  }
+}
+
+// Coloca la reproduccion en la fase de 'now' (solo al construir la cache).
+inline void sceneCacheSeek(SceneCache& c, unsigned long now, uint32_t periodMs) {
+  uint32_t ph = now % periodMs;
+  uint16_t target = (uint16_t)(ph / SCENE_CACHE_FRAME_MS);
+  c.accMs = (uint16_t)(ph % SCENE_CACHE_FRAME_MS);
+  c.frameIndex = 0;
+  memcpy(c.levels, c.data, c.channelCount);
+  for (uint16_t k = 0; k < target; k++) sceneCacheStep(c);
+}
+
+inline bool buildSceneCache(ShrineController& s, const FrameContext& fc, PeriodicRenderFn render, uint8_t mask, uint32_t periodMs) {
+  SceneCache& c = *s.cache;
+  const ShrinePlatform& p = *s.platform;
+  c.render = render;
+  c.valid = false;
+  c.mask = mask;
+  c.channelCount = 0;
+  for (uint8_t i = 0; i < LED_COUNT; i++) {
+    if (mask & (1 << i)) c.channels[c.channelCount++] = i;
+  }
+  if (c.channelCount == 0 || periodMs % SCENE_CACHE_FRAME_MS != 0) return false;
+  c.frameCount = (uint16_t)(periodMs / SCENE_CACHE_FRAME_MS);
+  uint32_t nibbles = (uint32_t)(c.frameCount - 1) * c.channelCount;
+  c.usedBytes = (uint16_t)(c.channelCount + (nibbles + 1) / 2);
+  if (c.usedBytes > SCENE_CACHE_BYTES) return false;
+
+  // Render de un periodo completo sobre la capa base (se sobrescribe luego).
+  uint8_t savedLayer = s.activeLayer;
+  s.activeLayer = LAYER_BASE;
+  FrameContext rc = fc;
+  uint8_t prev[6];
+  bool ok = true;
+  unsigned long t0 = p.micros(p.ctx);
+  for (uint16_t f = 0; f < c.frameCount && ok; f++) {
+    rc.now = (unsigned long)f * SCENE_CACHE_FRAME_MS;
+    rc.tick = (uint16_t)rc.now;
+    render(s, rc);
+    for (uint8_t k = 0; k < c.channelCount; k++) {
+      uint8_t v = s.layers[LAYER_BASE].level[c.channels[k]];
+      if (f == 0) {
+        c.data[k] = v;
+      } else {
+        int16_t d = (int16_t)v - prev[k];
+        if (d < -8 || d > 7) { ok = false; break; }
+        uint16_t n = (uint16_t)(f - 1) * c.channelCount + k;
+        uint8_t& b = c.data[c.channelCount + (n >> 1)];
+        if (n & 1) b = (uint8_t)((b & 0x0F) | ((d & 0x0F) << 4));
+        else b = (uint8_t)(d & 0x0F);
+      }
+      prev[k] = v;
+    }
+  }
+  c.liveUs = (uint16_t)((p.micros(p.ctx) - t0) / c.frameCount);
+  s.activeLayer = savedLayer;
+  if (!ok) return false;
+
+  // Coste de reproduccion: 100 pasos medidos (us x100 por paso).
+  t0 = p.micros(p.ctx);
+  for (uint8_t k = 0; k < 100; k++) sceneCacheStep(c);
+  c.playUs = (uint16_t)(p.micros(p.ctx) - t0);
+
+  sceneCacheSeek(c, fc.now, periodMs);
+  c.valid = true;
+  return true;
+}
+
+inline void invalidateSceneCache(ShrineController& s) {
+  SceneCache* c = s.cache;
+  if (!c || c->owner != &s) return; // sin cache o es de otra hornacina
+  c->owner = 0;
+  c->render = 0;
+  c->valid = false;
+}
+
+// Parte periodica de la escena: reproduce desde cache o evalua en vivo.
+inline void applyPeriodicCached(ShrineController& s, const FrameContext& fc, PeriodicRenderFn render, uint8_t mask, uint32_t periodMs) {
+  // Un buffer por placa: es de la primera hornacina que lo pide; las demas
+  // evaluan en vivo hasta que su duena cambie de escena.
+  if (!s.cache || (s.cache->owner && s.cache->owner != &s)) {
+    render(s, fc);
+    return;
+  }
+  SceneCache& c = *s.cache;
+  c.owner = &s;
+  if (c.render != render) {
+    bool ok = buildSceneCache(s, fc, render, mask, periodMs);
+    shrineNotify(s, SHRINE_EVT_CACHE, ok ? 1 : 0);
+  }
+  if (!c.valid) {
+    render(s, fc);
+    return;
+  }
+  c.accMs += fc.dtMs;
+  if (c.accMs >= periodMs) { // salto largo (p.ej. bloqueo de serial): re-sincroniza
+    sceneCacheSeek(c, fc.now, periodMs);
+  } else {
+    while (c.accMs >= SCENE_CACHE_FRAME_MS) {
+      c.accMs -= SCENE_CACHE_FRAME_MS;
+      sceneCacheStep(c);
+    }
+  }
+  for (uint8_t k = 0; k < c.channelCount; k++) setLedState(s, c.channels[k], c.levels[k]);
+}
+
+// ==============================================================================
+// Secuencias: corrutinas sin pila sobre el frame
+// ==============================================================================
+// Una secuencia es una funcion que se reanuda cada frame donde se quedo
+// (switch sobre la linea guardada). Entre reanudaciones solo sobrevive su Coro
+// (6 bytes): las variables locales no se conservan, los contadores van en
+// c.count. Las secuencias escriben en la capa de acento (MAX sobre la escena)
+// y la capa conserva el ultimo nivel mientras esperan.
+// Regla: una primitiva CORO_* por linea (el punto de reanudacion es __LINE__).
+
+// Eventos del frame actual (se limpian tras correr las secuencias).
+const uint8_t EVT_MOTION_START = 1 << 0;
+const uint8_t EVT_MOTION_END = 1 << 1;
+
+inline void raiseEvent(ShrineController& s, uint8_t ev) {
+  s.pendingEvents |= ev;
+}
+
+inline bool eventPending(ShrineController& s, uint8_t ev) {
+  return (s.pendingEvents & ev) != 0;
+}
+
+// La espera entra en su propio case al pasar por primera vez: caida explicita
+// para que -Wextra (-Wimplicit-fallthrough) no avise en cada uso.
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define CORO_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define CORO_FALLTHROUGH ((void)0)
+#endif
+
+#define CORO_BEGIN(c) switch ((c).resume) { case 0:
+#define CORO_END(c) } (c).resume = 0; return CORO_DONE
+#define CORO_YIELD(c) do { (c).resume = __LINE__; return CORO_WAITING; case __LINE__:; } while (0)
+#define CORO_WAIT_UNTIL(c, cond) do { (c).resume = __LINE__; CORO_FALLTHROUGH; case __LINE__: if (!(cond)) return CORO_WAITING; } while (0)
+#define CORO_WAIT_EVENT(s, c, ev) CORO_WAIT_UNTIL(c, eventPending((s), ev))
+#define CORO_WAIT_MS(c, fc, ms) do { (c).timer = (uint16_t)((fc).tick + (ms)); CORO_WAIT_UNTIL(c, timerDue((fc).tick, (c).timer)); } while (0)
+#define CORO_RAMP(s, c, fc, ch, to, ms) do { (c).from = accentLevel((s), ch); (c).timer = (fc).tick; CORO_WAIT_UNTIL(c, coroRampStep((s), (c), (fc), (ch), (to), (ms))); } while (0)
+
+// Punto de partida de una rampa: el nivel de la secuencia si ya escribe el
+// canal; si no, lo que se ve (ultimo frame compuesto), para arrancar sin salto.
+inline uint8_t accentLevel(ShrineController& s, uint8_t ch) {
+  const EffectLayer& layer = s.layers[LAYER_ACCENT];
+  return (layer.mask & (1 << ch)) ? layer.level[ch] : s.frameLevels[ch];
+}
+
+// Deja de aportar el canal: la escena base vuelve a verse tal cual.
+inline void releaseChannel(ShrineController& s, uint8_t ch) {
+  s.layers[LAYER_ACCENT].mask &= (uint8_t)~(1 << ch);
+}
+
+// Un paso de rampa lineal c.from -> to en ms; true al llegar.
+inline bool coroRampStep(ShrineController& s, Coro& c, const FrameContext& fc, uint8_t ch, uint8_t to, uint16_t ms) {
+  uint16_t e = timerElapsed(fc.tick, c.timer);
+  if (e >= ms) {
+    writeChannel(s, ch, to);
+    return true;
+  }
+  uint16_t p = (uint16_t)(((uint32_t)e << 8) / ms);
+  writeChannel(s, ch, (uint8_t)(((uint16_t)c.from * (256 - p) + (uint16_t)to * p) >> 8));
+  return false;
+}
+
+inline bool startSequence(ShrineController& s, SequenceFn fn) {
+  for (uint8_t i = 0; i < SEQUENCE_SLOTS; i++) {
+    if (s.sequences[i].fn) continue;
+    s.sequences[i].fn = fn;
+    s.sequences[i].coro = Coro{0, 0, 0, 0};
+    return true;
+  }
+  return false;
+}
+
+inline void stopSequences(ShrineController& s) {
+  for (uint8_t i = 0; i < SEQUENCE_SLOTS; i++) s.sequences[i].fn = 0;
+  clearLayer(s, LAYER_ACCENT);
+}
+
+// Reanuda todas las secuencias vivas una vez por frame (despues de la escena).
+inline void runSequences(ShrineController& s, const FrameContext& fc) {
+  beginLayer(s, LAYER_ACCENT, BLEND_MAX, 255);
+  for (uint8_t i = 0; i < SEQUENCE_SLOTS; i++) {
+    SequenceTask& t = s.sequences[i];
+    if (t.fn && t.fn(s, t.coro, fc) == CORO_DONE) t.fn = 0;
+  }
+  endLayer(s);
+  s.pendingEvents = 0;
+}
+
+// Saludo por movimiento: CARA sube a 80% en 2 s, se sostiene, ATRA destella
+// dos veces y todo vuelve a la escena.
+inline CoroStatus seqSaludoMovimiento(ShrineController& s, Coro& c, const FrameContext& fc) {
+  CORO_BEGIN(c);
+  for (;;) {
+    CORO_WAIT_EVENT(s, c, EVT_MOTION_START);
+    CORO_RAMP(s, c, fc, 2, percentToPwm(80), 2000);
+    CORO_WAIT_MS(c, fc, 1500);
+    for (c.count = 0; c.count < 2; c.count++) {
+      writeChannel(s, 5, percentToPwm(90));
+      CORO_WAIT_MS(c, fc, 150);
+      writeChannel(s, 5, 0);
+      CORO_WAIT_MS(c, fc, 250);
+    }
+    releaseChannel(s, 5);
+    CORO_RAMP(s, c, fc, 2, 0, 1500);
+    releaseChannel(s, 2);
+  }
+  CORO_END(c);
+}
+
+// ==============================================================================
+// Reproductor de timeline (coreografia en flash)
+// ==============================================================================
+// Las coreografias se escriben en texto (timelines/*.tl) y se compilan en host
+// (src/tools/timeline_compiler.cpp) a un blob PROGMEM. El reproductor decodifica
+// cada pista en streaming: RAM constante por pista sin importar la duracion.
+
+inline void startTimeline(ShrineController& s, const uint8_t* blob, unsigned long now) {
+  TimelinePlayer& p = s.timelinePlayer;
+  p.blob = blob;
+  p.trackCount = timelineOpen(blob, p.tracks);
+  p.durationMs = p.trackCount ? timelineReadU32(blob, 4) : 0;
+  p.loopMs = p.trackCount ? timelineReadU32(blob, 8) : 0;
+  p.startMs = now;
+}
+
+// Escribe en la capa activa los canales con pista; al llegar al final vuelve al loop.
+inline void applyTimeline(ShrineController& s, const FrameContext& fc) {
+  TimelinePlayer& p = s.timelinePlayer;
+  if (p.trackCount == 0) return;
+  uint32_t t = (uint32_t)(fc.now - p.startMs);
+  if (t >= p.durationMs) {
+    uint32_t span = p.durationMs - p.loopMs;
+    t = p.loopMs + (t - p.loopMs) % span;
+    p.startMs = fc.now - t;
+    for (uint8_t k = 0; k < p.trackCount; k++) timelineRewind(p.blob, p.tracks[k]);
+  }
+  for (uint8_t k = 0; k < p.trackCount; k++) {
+    writeChannel(s, p.tracks[k].channel, timelineSample(p.blob, p.tracks[k], t));
+  }
+}
+
+// ==============================================================================
+// Maquina virtual de escenas (bytecode en EEPROM)
+// ==============================================================================
+// Escenas subidas por serie a slots de EEPROM (cabecera + CRC, ver
+// include/vm_bytecode.h) que se ejecutan como modos 8..10. El programa corre
+// hasta YIELD/WAIT o hasta VM_MAX_OPS_PER_FRAME opcodes (coste acotado por
+// frame); las rampas avanzan solas cada frame aunque el programa espere.
+
+const uint8_t VM_SLOT_COUNT = 3;
+const uint16_t VM_EEPROM_BASE = 0;          // slots en 0..767; el resto queda libre
+const uint8_t VM_MAX_OPS_PER_FRAME = 48;
+
+enum VmStatus : uint8_t {
+  VM_IDLE = 0,  // sin programa
+  VM_RUNNING,
+  VM_WAITING,   // WAIT en curso
+  VM_HALTED,    // END: canales congelados
+  VM_FAULT      // error de pila u opcode: canales congelados
+};
+
+// Causa de VM_FAULT (VmMachine::fault, arg de SHRINE_EVT_VM_FAULT).
+enum VmFault : uint8_t {
+  VM_FAULT_NONE = 0,
+  VM_FAULT_UNDERFLOW, // pila vacia
+  VM_FAULT_OVERFLOW,  // pila llena
+  VM_FAULT_OPCODE     // opcode desconocido
+};
+
+inline uint16_t vmSlotAddr(uint8_t slot) {
+  return (uint16_t)(VM_EEPROM_BASE + (uint16_t)slot * VM_SLOT_BYTES);
+}
+
+inline uint8_t storageRead(const ShrinePlatform& p, uint16_t addr) {
+  return p.storageRead(p.ctx, addr);
+}
+
+inline uint16_t storageReadU16(const ShrinePlatform& p, uint16_t addr) {
+  return (uint16_t)(storageRead(p, addr) | ((uint16_t)storageRead(p, addr + 1) << 8));
+}
+
+inline uint8_t vmFetch(const VmMachine& m, const ShrinePlatform& p, uint16_t addr) {
+  return m.flash ? pgm_read_byte(m.flash + addr) : storageRead(p, m.base + addr);
+}
+
+// Cabecera valida + CRC del codigo; longitud en lenOut.
+inline bool vmCheckSlot(const ShrinePlatform& p, uint8_t slot, uint16_t& lenOut) {
+  uint16_t at = vmSlotAddr(slot);
+  if (storageRead(p, at) != 'V' || storageRead(p, at + 1) != 'M' || storageRead(p, at + 2) != VM_BYTECODE_VERSION) return false;
+  uint16_t len = storageReadU16(p, at + 4);
+  if (len == 0 || len > VM_MAX_CODE_BYTES) return false;
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < len; i++) crc = vmCrc16Update(crc, storageRead(p, at + VM_HEADER_BYTES + i));
+  if (crc != storageReadU16(p, at + 6)) return false;
+  lenOut = len;
+  return true;
+}
+
+inline void vmReset(VmMachine& m, unsigned long now) {
+  m.pc = 0;
+  m.sp = 0;
+  m.chMask = 0;
+  m.rampMask = 0;
+  m.startMs = now;
+  for (uint8_t i = 0; i < 6; i++) m.level[i] = 0;
+  for (uint8_t i = 0; i < VM_VAR_COUNT; i++) m.vars[i] = 0;
+  m.fault = VM_FAULT_NONE;
+  m.status = m.len ? VM_RUNNING : VM_IDLE;
+}
+
+// Carga el slot (CRC + verificacion estatica); si falla la VM queda inactiva.
+inline bool vmLoadSlot(ShrineController& s, uint8_t slot, unsigned long now) {
+  s.vm.flash = 0;
+  s.vm.len = 0;
+  uint16_t len = 0;
+  const ShrinePlatform& p = *s.platform;
+  if (slot < VM_SLOT_COUNT && vmCheckSlot(p, slot, len)) {
+    uint16_t base = (uint16_t)(vmSlotAddr(slot) + VM_HEADER_BYTES);
+    uint16_t errAt;
+    if (vmVerifyProgram([&p, base](uint16_t a) { return storageRead(p, base + a); }, len, errAt) == VM_VERIFY_OK) {
+      s.vm.base = base;
+      s.vm.len = len;
+    }
+  }
+  vmReset(s.vm, now);
+  return s.vm.len != 0;
+}
+
+// El aviso lo da applyVmScene() por el sink (SHRINE_EVT_VM_FAULT).
+inline void vmFault(VmMachine& m, VmFault why) {
+  m.status = VM_FAULT;
+  m.fault = why;
+}
+
+// Rampas y salida de la VM (una vez por frame).
+inline void vmUpdateChannels(VmMachine& m, const FrameContext& fc) {
+  for (uint8_t ch = 0; ch < 6; ch++) {
+    if (!(m.rampMask & (1 << ch))) continue;
+    VmRamp& r = m.ramp[ch];
+    uint16_t e = timerElapsed(fc.tick, r.start);
+    if (e >= r.dur) {
+      m.level[ch] = r.to;
+      m.rampMask &= (uint8_t)~(1 << ch);
+    } else {
+      uint16_t p = (uint16_t)(((uint32_t)e * r.recip) >> 16); // 0..255
+      m.level[ch] = (uint8_t)(((uint16_t)r.from * (256 - p) + (uint16_t)r.to * p) >> 8);
+    }
+  }
+}
+
+inline uint8_t vmClampLevel(int16_t v) {
+  return (v < 0) ? 0 : (v > 255) ? 255 : (uint8_t)v;
+}
+
+// Ejecuta como maximo maxOps opcodes; devuelve los ejecutados.
+inline uint16_t vmExecute(VmMachine& m, const ShrinePlatform& p, const FrameContext& fc, uint16_t maxOps) {
+  uint16_t ops = 0;
+  while (m.status == VM_RUNNING && ops < maxOps) {
+    if (m.pc >= m.len) {
+      m.status = VM_HALTED; // fin del codigo = END implicito
+      break;
+    }
+    uint8_t op = vmFetch(m, p, m.pc);
+    uint16_t imm = 0;
+    uint8_t immBytes = vmImmBytes(op);
+    if (immBytes >= 1) imm = vmFetch(m, p, m.pc + 1);
+    if (immBytes == 2) imm |= (uint16_t)vmFetch(m, p, m.pc + 2) << 8;
+    uint16_t next = (uint16_t)(m.pc + 1 + immBytes);
+    ops++;
+
+    // Pila: cuantos valores consume y produce (se valida antes de ejecutar).
+    uint8_t pops = 0, pushes = 0;
+    switch (op) {
+      case VM_OP_PUSH8: case VM_OP_PUSH16: case VM_OP_LOAD: case VM_OP_LEVEL: case VM_OP_MOTION: case VM_OP_INTENSITY: pushes = 1; break;
+      case VM_OP_DUP: pops = 1; pushes = 2; break;
+      case VM_OP_DROP: case VM_OP_STORE: case VM_OP_JZ: case VM_OP_JNZ: case VM_OP_OUT: case VM_OP_WAIT: pops = 1; break;
+      case VM_OP_SWAP: pops = 2; pushes = 2; break;
+      case VM_OP_ADD: case VM_OP_SUB: case VM_OP_SCALE: case VM_OP_RAND: case VM_OP_OSC: case VM_OP_WAVE: pops = 2; pushes = 1; break;
+      case VM_OP_DEC: pops = 1; pushes = 1; break;
+      case VM_OP_RAMP: pops = 2; break;
+      default: break;
+    }
+    if (m.sp < pops) { vmFault(m, VM_FAULT_UNDERFLOW); break; }
+    if (m.sp - pops + pushes > VM_STACK_DEPTH) { vmFault(m, VM_FAULT_OVERFLOW); break; }
+    int16_t* s = &m.stack[m.sp];
+
+    switch (op) {
+      case VM_OP_END: m.status = VM_HALTED; break;
+      case VM_OP_PUSH8:
+      case VM_OP_PUSH16: s[0] = (int16_t)imm; break;
+      case VM_OP_DUP: s[0] = s[-1]; break;
+      case VM_OP_DROP: break;
+      case VM_OP_SWAP: { int16_t t = s[-1]; s[-1] = s[-2]; s[-2] = t; } break;
+      case VM_OP_ADD: s[-2] = (int16_t)(s[-2] + s[-1]); break;
+      case VM_OP_SUB: s[-2] = (int16_t)(s[-2] - s[-1]); break;
+      case VM_OP_SCALE: s[-2] = (int16_t)(((int32_t)s[-2] * s[-1]) >> 8); break;
+      case VM_OP_DEC: s[-1]--; break;
+      case VM_OP_LOAD: s[0] = m.vars[imm]; break;
+      case VM_OP_STORE: m.vars[imm] = s[-1]; break;
+      case VM_OP_JMP: next = imm; break;
+      case VM_OP_JZ: if (s[-1] == 0) next = imm; break;
+      case VM_OP_JNZ: if (s[-1] != 0) next = imm; break;
+      case VM_OP_OUT:
+        m.level[imm] = vmClampLevel(s[-1]);
+        m.rampMask &= (uint8_t)~(1 << imm);
+        m.chMask |= (uint8_t)(1 << imm);
+        break;
+      case VM_OP_RAMP: {
+        uint16_t dur = (s[-1] <= 0) ? 1 : (s[-1] > (int16_t)EFFECT_TIMER_MAX_MS) ? EFFECT_TIMER_MAX_MS : (uint16_t)s[-1];
+        VmRamp& r = m.ramp[imm];
+        uint8_t to = vmClampLevel(s[-2]);
+        m.chMask |= (uint8_t)(1 << imm);
+        // Repetir la rampa en curso (o hacia el nivel actual) no la reinicia.
+        bool ramping = m.rampMask & (1 << imm);
+        if ((ramping && r.to == to) || (!ramping && m.level[imm] == to)) break;
+        r.from = m.level[imm];
+        r.to = to;
+        r.start = fc.tick;
+        r.dur = dur;
+        r.recip = 16777216UL / dur;
+        m.rampMask |= (uint8_t)(1 << imm);
+      } break;
+      case VM_OP_LEVEL: s[0] = m.level[imm]; break;
+      case VM_OP_WAIT: {
+        int16_t ms = s[-1];
+        if (ms > 0) {
+          m.waitUntil = (uint16_t)(fc.tick + (ms > (int16_t)EFFECT_TIMER_MAX_MS ? EFFECT_TIMER_MAX_MS : (uint16_t)ms));
+          m.status = VM_WAITING;
+        }
+      } break;
+      case VM_OP_YIELD: maxOps = ops; break;
+      case VM_OP_RAND: {
+        int16_t lo = s[-2], hi = s[-1];
+        s[-2] = (hi > lo) ? (int16_t)p.random(p.ctx, lo, (long)hi + 1) : lo;
+      } break;
+      case VM_OP_OSC:
+      case VM_OP_WAVE: {
+        uint16_t tri = triangleQ8(wavePhase(fc.now - m.startMs, phaseIncForPeriod(imm)));
+        if (op == VM_OP_WAVE) tri = timelineEase(EASE_IN_OUT, tri);
+        int16_t lo = s[-2], hi = s[-1];
+        s[-2] = (int16_t)(lo + (((int32_t)(hi - lo) * tri) >> 8));
+      } break;
+      case VM_OP_MOTION: s[0] = fc.motion ? 1 : 0; break;
+      case VM_OP_INTENSITY: s[0] = (int16_t)fc.motionQ8; break;
+      default: vmFault(m, VM_FAULT_OPCODE); break;
+    }
+    if (m.status == VM_FAULT) break;
+    m.sp = (uint8_t)(m.sp - pops + pushes);
+    m.pc = next;
+  }
+  return ops;
+}
+
+// Frame de escena VM: rampas, programa (acotado) y salida a la capa activa.
+inline void applyVmScene(ShrineController& s, const FrameContext& fc) {
+  if (s.vm.status == VM_IDLE) return;
+  if (s.vm.status == VM_WAITING && timerDue(fc.tick, s.vm.waitUntil)) s.vm.status = VM_RUNNING;
+  bool running = s.vm.status == VM_RUNNING;
+  vmExecute(s.vm, *s.platform, fc, VM_MAX_OPS_PER_FRAME);
+  if (running && s.vm.status == VM_FAULT) shrineNotify(s, SHRINE_EVT_VM_FAULT, s.vm.fault);
+  vmUpdateChannels(s.vm, fc);
+  for (uint8_t ch = 0; ch < 6; ch++) {
+    if (s.vm.chMask & (1 << ch)) writeChannel(s, ch, s.vm.level[ch]);
+  }
+}
+
+inline bool isVmMode(Mode m) {
+  return m >= MODE_8_ESCENA_1 && m <= MODE_10_ESCENA_3;
+}
+
+inline uint8_t vmSlotForMode(Mode m) {
+  return (uint8_t)(m - MODE_8_ESCENA_1);
+}
+
+// Siguiente modo del boton: los modos VM sin programa valido (bit de
+// validSlots a 0) se saltan.
+inline Mode nextMode(Mode m, uint8_t validSlots) {
+  do {
+    m = (Mode)((m + 1) % MODE_COUNT);
+  } while (isVmMode(m) && !(validSlots & (1 << vmSlotForMode(m))));
+  return m;
+}
+
+// Descriptores de escena: parametros de cada modo validados y convertidos en
+// compilacion (un parametro fuera de rango es un error de compilacion).
+constexpr CandleDesc CAN_20 = candleDesc(51);   // ~20%
+constexpr CandleDesc CAN_70 = candleDesc(178);  // ~70%
+constexpr CandleDesc CAN_80 = candleDesc(204);  // ~80%
+constexpr CandleDesc CAN_90 = candleDesc(230);  // ~90%
+constexpr CandleDesc CAN_100 = candleDesc(255); // ~100%
+
+// Modo 1 (perfil MODE1_PROFILE_INDEX)
+constexpr CandleDesc M1_CAN_BASE = candleDesc(percentToPwm(MODE1.canBasePct));
+constexpr CandleDesc M1_CAN_MOVE = candleDesc(percentToPwm(MODE1.canMovePct));
+constexpr DriftDesc M1_CARA_BASE = driftDesc(
+  MODE1.caraBaseMinPct, MODE1.caraBaseMaxPct,
+  MODE1.caraBaseTargetMinMs, MODE1.caraBaseTargetMaxMs,
+  MODE1.caraBaseStepMinPct, MODE1.caraBaseStepMaxPct,
+  MODE1.caraBaseStepIntervalMs);
+constexpr DriftDesc M1_CARA_MOVE = driftDesc(
+  MODE1.caraMoveMinPct, MODE1.caraMoveMaxPct,
+  MODE1.caraMoveTargetMinMs, MODE1.caraMoveTargetMaxMs,
+  MODE1.caraMoveStepMinPct, MODE1.caraMoveStepMaxPct,
+  MODE1.caraMoveStepIntervalMs);
+constexpr WaveDesc M1_HALO_BASE = waveDesc(MODE1.triadBasePct, MODE1.triadPeakBasePct, MODE1.triadBasePeriodMs);
+constexpr WaveDesc M1_HALO_MOVE = waveDesc(MODE1.triadMoveBasePct, MODE1.triadMovePeakPct, MODE1.triadMovePeriodMs);
+// Halo de movimiento con el periodo base: el reloj de escena lo acelera al de movimiento.
+constexpr WaveDesc M1_HALO_MOVE_ON_BASE = waveDesc(MODE1.triadMoveBasePct, MODE1.triadMovePeakPct, MODE1.triadBasePeriodMs);
+constexpr WelcomeDesc M1_WELCOME = welcomeDesc(MODE1_WELCOME_PEAK_PCT, MODE1_WELCOME_MS);
+
+// Modo 2 (nivel fijo = fade con min == max, para mezclarlo con el fade)
+constexpr FadeDesc M2_CARA_STILL = fadeDesc(5, 5, DEFAULT_CARA_SPEED_MS);
+constexpr FadeDesc M2_CARA_FADE = fadeDesc(DEFAULT_CARA_MIN_PCT, DEFAULT_CARA_MAX_PCT, DEFAULT_CARA_SPEED_MS);
+
+// Modo 3
+constexpr WaveDesc M3_FIZO_BREATH = waveDesc(10, 50, 4200);
+constexpr WaveDesc M3_FIZO_STILL = waveDesc(10, 10, 4200); // FIZO fijo 10% en movimiento
+constexpr FadeDesc M3_FDEP_STILL = fadeDesc(40, 40, DEFAULT_FDEP_SPEED_MS);
+constexpr FadeDesc M3_FDEP_FADE = fadeDesc(DEFAULT_FDEP_MIN_PCT, DEFAULT_FDEP_MAX_PCT, DEFAULT_FDEP_SPEED_MS);
+
+// Modo 4 (FIZO/FDEP fijos al 80% en movimiento = destello de 80% a 80%)
+constexpr FlashDesc M4_FIZO_FLASH = flashDesc(10, 60, 100, 120, 18, 50, 130);
+constexpr FlashDesc M4_FDEP_FLASH = flashDesc(10, 60, 100, 140, 16, 50, 130);
+constexpr FlashDesc M4_FIZO_STEADY = flashDesc(80, 80, 80, 120, 18, 50, 130);
+constexpr FlashDesc M4_FDEP_STEADY = flashDesc(80, 80, 80, 140, 16, 50, 130);
+constexpr FlashDesc M4_ATRA_FLASH = flashDesc(10, 55, 95, 160, 14, 60, 150);
+// ATRA en movimiento: el fade 0..100% a un paso por DEFAULT_ATRA_M4_SPEED_MS
+// como onda triangular del mismo periodo (sin estado: se mezcla con el destello).
+constexpr WaveDesc M4_ATRA_WAVE = waveDesc(DEFAULT_ATRA_M4_MIN_PCT, DEFAULT_ATRA_M4_MAX_PCT,
+  2UL * (percentToPwm(DEFAULT_ATRA_M4_MAX_PCT) - percentToPwm(DEFAULT_ATRA_M4_MIN_PCT)) * DEFAULT_ATRA_M4_SPEED_MS);
+
+// Modo 5
+constexpr FadeDesc M5_CARA_STILL = fadeDesc(MODE5_CARA_MIN_PCT, MODE5_CARA_MIN_PCT, MODE5_CARA_SPEED_MS);
+constexpr FadeDesc M5_CARA_FADE = fadeDesc(MODE5_CARA_MIN_PCT, MODE5_CARA_MAX_PCT, MODE5_CARA_SPEED_MS);
+constexpr FadeDesc M5_FRENTE_STILL = fadeDesc(10, 10, MODE5_FIZO_FDEP_SPEED_MS);
+constexpr FadeDesc M5_FRENTE_FADE = fadeDesc(MODE5_FIZO_FDEP_MIN_PCT, MODE5_FIZO_FDEP_MAX_PCT, MODE5_FIZO_FDEP_SPEED_MS);
+
+// Modo 6
+const uint8_t M6_CARA_BASE_PCT = 60;   // CARA fija en base
+const uint8_t M6_FRENTE_MOVE_PCT = 30; // FIZO/FDEP fijos en movimiento
+constexpr DevotionalDesc M6_DEVOTIONAL = devotionalDesc(40, 80, 4200, 450, 70);
+constexpr SeaWaveDesc M6_SEA_WAVE = seaWaveDesc(
+  MODE6_OLA_ATRA_MIN_PCT, MODE6_OLA_ATRA_MAX_PCT,
+  MODE6_OLA_GRUPO_MIN_PCT, MODE6_OLA_GRUPO_MAX_PCT,
+  MODE6_OLA_PERIOD_MS);
+// Devocional con el periodo de la ola (desfase en la misma fraccion): el reloj
+// de escena la acelera a M6_DEVOTIONAL.cara.periodMs en movimiento.
+constexpr DevotionalDesc M6_DEVOTIONAL_ON_BASE = devotionalDesc(40, 80, MODE6_OLA_PERIOD_MS,
+  M6_DEVOTIONAL.delayMs * MODE6_OLA_PERIOD_MS / M6_DEVOTIONAL.cara.periodMs, 70);
+
+// Partes periodicas cacheables (funciones puras del tiempo).
+const uint8_t MASK_TRIAD = (1 << 3) | (1 << 4) | (1 << 5); // FIZO, FDEP, ATRA
+const uint8_t MASK_CARA_ATRA = (1 << 2) | (1 << 5);
+const uint8_t MASK_FIZO = (1 << 3);
+
+constexpr bool sceneCacheFits(uint32_t periodMs, uint8_t channels) {
+  return periodMs % SCENE_CACHE_FRAME_MS == 0 && sceneCacheBytes(periodMs, channels) <= SCENE_CACHE_BYTES;
+}
+static_assert(sceneCacheFits(M1_HALO_BASE.periodMs, 3), "cache: el halo del Modo 1 no cabe en SCENE_CACHE_BYTES");
+static_assert(sceneCacheFits(M1_HALO_MOVE_ON_BASE.periodMs, 3), "cache: el halo del Modo 1 no cabe en SCENE_CACHE_BYTES");
+static_assert(sceneCacheFits(M3_FIZO_BREATH.periodMs, 1), "cache: la respiracion del Modo 3 no cabe en SCENE_CACHE_BYTES");
+static_assert(sceneCacheFits(M6_DEVOTIONAL_ON_BASE.cara.periodMs, 2), "cache: la devocional del Modo 6 no cabe en SCENE_CACHE_BYTES");
+static_assert(sceneCacheFits(M6_SEA_WAVE.atra.periodMs, 3), "cache: la ola del Modo 6 no cabe en SCENE_CACHE_BYTES");
+
+inline void renderM3FizoBreath(ShrineController& s, const FrameContext& fc) {
+  applySingleBreathing<M3_FIZO_BREATH>(s, fc, 3);
+}
+
+// Modo 6 a media intensidad, sobre el reloj de escena (fc de motionClockFrame):
+// ola y devocional con la misma fase y nivel mezclado por canal. CARA va de
+// fija a respiracion, FIZO/FDEP de la ola a fijos y ATRA de ola a respiracion.
+inline void renderM6SeaToDevotional(ShrineController& s, const FrameContext& fc) {
+  static_assert(M6_DEVOTIONAL_ON_BASE.cara.periodMs == M6_SEA_WAVE.atra.periodMs, "Modo 6: ola y devocional deben compartir periodo");
+  const DevotionalDesc& D = M6_DEVOTIONAL_ON_BASE;
+  const uint16_t q = fc.motionQ8;
+  uint16_t phase = wavePhase(fc.now, M6_SEA_WAVE.atra.phaseInc);
+  uint8_t caraBase = percentToPwm(M6_CARA_BASE_PCT);
+  uint8_t cara = waveLevel(D.cara.minPwm, D.cara.spanPwm, triangleQ8(phase));
+  setLedState(s, 2, motionBlend(caraBase, (int16_t)cara - caraBase, q));
+  uint8_t atra = waveLevel(D.cara.minPwm, D.cara.spanPwm, triangleQ8(phase + D.delayPhase));
+  atra = (uint8_t)(((uint16_t)atra * D.atraScaleQ8) >> 8);
+  for (uint8_t i = 3; i < LED_COUNT; i++) {
+    const WaveDesc& w = i == 5 ? M6_SEA_WAVE.atra : M6_SEA_WAVE.grupo;
+    uint8_t sea = waveLevel(w.minPwm, w.spanPwm, spatialProfileQ8((uint16_t)(phase + SEA_WAVE_FIELD.offset[i]), SEA_WAVE_FIELD.gainQ8));
+    uint8_t move = i == 5 ? atra : percentToPwm(M6_FRENTE_MOVE_PCT);
+    writeChannel(s, i, motionBlend(sea, (int16_t)move - sea, q));
+  }
+}
+
+// Clave de escena: modo * 2 + movimiento (intensidad a partir de la mitad).
+// Una sola definicion para la cache, las secuencias y lo que la placa cuenta
+// por escena (duty, memoria, telemetria, caja negra).
+inline uint8_t sceneKeyFor(Mode m, uint16_t motionQ8) {
+  return (uint8_t)((m << 1) | (motionQ8 >= MOTION_HALF_Q8 ? 1 : 0));
+}
+
+inline uint8_t shrineSceneKey(const ShrineController& s) {
+  return sceneKeyFor(s.currentMode, inputMotionQ8(s.input));
+}
+
+inline void applyMode(ShrineController& s, const FrameContext& fc) {
+  // Parametros y niveles: mezcla continua por fc.motionQ8 (tambien los canales
+  // que cambian de efecto). Clave de escena (cache, secuencias): a media intensidad.
+  // Entrada en escena (modo o submodo distinto): la cache periodica se rehace.
+  uint8_t sceneKey = sceneKeyFor(s.currentMode, fc.motionQ8);
+  if (sceneKey != s.lastSceneKey) {
+    // Timeline y escenas VM empiezan al entrar en el modo; el PIR no los reinicia.
+    bool modeEntered = (s.lastSceneKey >> 1) != s.currentMode;
+    if (modeEntered) {
+      stopSequences(s);
+      if (s.currentMode == MODE_4_CANDELITA_PASTOR_VIRGEN) startSequence(s, seqSaludoMovimiento);
+      s.sceneClock = fc.now - fc.dtMs; // motionClockFrame suma el dt de este frame
+      s.sceneClockFrac = 0;
+    }
+    if (modeEntered && s.currentMode == MODE_7_SECUENCIA) startTimeline(s, TIMELINE_FIESTA, fc.now);
+    if (modeEntered && isVmMode(s.currentMode)) vmLoadSlot(s, vmSlotForMode(s.currentMode), fc.now);
+    s.lastSceneKey = sceneKey;
+    invalidateSceneCache(s);
+  }
+  // Por defecto, FIZO/FDEP/ATRA no hacen fade; se habilita solo donde aplique.
+  setLedFadeInOutActive(s, 3, false);
+  setLedFadeInOutActive(s, 4, false);
+  setLedFadeInOutActive(s, 5, false);
+  
+  switch (s.currentMode) {
+    
+    case MODE_1_CONTEMPLATIVO: {
+      setLedFadeInOutActive(s, 2, false);
+      updateCandleFlickerBlend<M1_CAN_BASE, M1_CAN_MOVE>(s, fc);
+      applyOrganicDriftBlend<M1_CARA_BASE, M1_CARA_MOVE>(s, fc, 2);
+      if (fc.motion) applyWelcomeFlash<M1_WELCOME>(s, fc, 2); // CARA: overlay sobre la deriva
+      FrameContext hc = motionClockFrame<M1_HALO_BASE.periodMs, M1_HALO_MOVE.periodMs>(s, fc); // halo: periodo 9 s -> 3.6 s
+      if (fc.motionQ8 == 0) {
+        applyPeriodicCached(s, hc, applyTriadCircularHalo<M1_HALO_BASE>, MASK_TRIAD, M1_HALO_BASE.periodMs);
+      } else if (fc.motionQ8 >= 256) {
+        applyPeriodicCached(s, hc, applyTriadCircularHalo<M1_HALO_MOVE_ON_BASE>, MASK_TRIAD, M1_HALO_MOVE_ON_BASE.periodMs);
+      } else {
+        applyTriadHaloBlend<M1_HALO_BASE, M1_HALO_MOVE_ON_BASE>(s, hc);
+      }
+      break;
+    }
+    
+    case MODE_2_SOLO_CANDELITA:
+      updateCandleFlickerBlend<CAN_20, CAN_70>(s, fc); // CAN ~20% base, ~70% movimiento
+      applyFadeBlend<M2_CARA_STILL, M2_CARA_FADE>(s, fc, 2); // CARA ~5% -> fade
+      setLedState(s, 3, 0);
+      setLedState(s, 4, 0);
+      setLedState(s, 5, 0);
+      break;
+    
+    case MODE_3_CANDELITA_PASTOR:
+      updateCandleFlickerBlend<CAN_70, CAN_90>(s, fc); // candelita ~70% -> ~90%
+      setLedStaticBlend(s, fc, 2, 10, 50); // CARA
+      if (fc.motionQ8 == 0) {
+        applyPeriodicCached(s, fc, renderM3FizoBreath, MASK_FIZO, M3_FIZO_BREATH.periodMs); // FIZO respiracion devocional hasta 50%
+      } else {
+        applySingleBreathingBlend<M3_FIZO_BREATH, M3_FIZO_STILL>(s, fc, 3); // -> FIZO fijo 10% (forzado)
+      }
+      applyFadeBlend<M3_FDEP_STILL, M3_FDEP_FADE>(s, fc, 4); // FDEP 40% -> fade in/out (0..100%)
+      setLedState(s, 5, 0);
+      break;
+    
+    case MODE_4_CANDELITA_PASTOR_VIRGEN:
+      updateCandleFlickerBlend<CAN_70, CAN_90>(s, fc); // CAN ~70% -> ~90%
+      setLedStaticBlend(s, fc, 2, 10, 40); // CARA
+      applyRandomFlashBlend<M4_FIZO_FLASH, M4_FIZO_STEADY>(s, fc, 3); // FIZO destellos -> 80%
+      applyRandomFlashBlend<M4_FDEP_FLASH, M4_FDEP_STEADY>(s, fc, 4); // FDEP destellos -> 80%
+      applyFlashWaveBlend<M4_ATRA_FLASH, M4_ATRA_WAVE>(s, fc, 5); // ATRA destellos -> fade 0..100%
+      break;
+    
+    case MODE_5_CANDELITA_PASTOR_VIRGEN_CARA:
+      updateCandleFlickerBlend<CAN_70, CAN_80>(s, fc); // CAN ~70% -> ~80%
+      applyFadeBlend<M5_CARA_STILL, M5_CARA_FADE>(s, fc, 2); // CARA 40% -> fade 40%..90%
+      applyFadeBlend<M5_FRENTE_STILL, M5_FRENTE_FADE>(s, fc, 3); // FIZO 10% -> fade 0%..5%
+      applyFadeBlend<M5_FRENTE_STILL, M5_FRENTE_FADE>(s, fc, 4); // FDEP 10% -> fade 0%..5%
+      applyFadeBlend<M5_FRENTE_STILL, M5_FRENTE_FADE>(s, fc, 5); // ATRA 10% -> fade 0%..5%
+      break;
+    
+    case MODE_6_ENFASIS_VIRGEN: {
+      updateCandleFlickerBlend<CAN_70, CAN_100>(s, fc); // CAN ~70% -> ~100%
+      FrameContext wc = motionClockFrame<M6_SEA_WAVE.atra.periodMs, M6_DEVOTIONAL.cara.periodMs>(s, fc); // ola 5.2 s -> devocional 4.2 s
+      if (fc.motionQ8 == 0) {
+        setLedStaticPercent(s, 2, M6_CARA_BASE_PCT); // CARA
+        applyPeriodicCached(s, wc, applySeaWaveCircularMode6Base<M6_SEA_WAVE>, MASK_TRIAD, M6_SEA_WAVE.atra.periodMs);
+      } else if (fc.motionQ8 >= 256) {
+        applyPeriodicCached(s, wc, applyDevotionalBreathing<M6_DEVOTIONAL_ON_BASE>, MASK_CARA_ATRA, M6_DEVOTIONAL_ON_BASE.cara.periodMs); // CARA + ATRA
+        setLedStaticPercent(s, 3, M6_FRENTE_MOVE_PCT);  // FIZO
+        setLedStaticPercent(s, 4, M6_FRENTE_MOVE_PCT);  // FDEP
+      } else {
+        renderM6SeaToDevotional(s, wc);
+      }
+      break;
+    }
+
+    case MODE_7_SECUENCIA:
+      setLedFadeInOutActive(s, 2, false);
+      updateCandleFlickerBlend<CAN_70, CAN_90>(s, fc); // CAN ~70% -> ~90%
+      applyTimeline(s, fc); // CARA/FIZO/FDEP/ATRA desde TIMELINE_FIESTA
+      break;
+
+    case MODE_8_ESCENA_1:
+    case MODE_9_ESCENA_2:
+    case MODE_10_ESCENA_3:
+      setLedFadeInOutActive(s, 2, false);
+      applyVmScene(s, fc); // canales no escritos por el programa quedan apagados
+      break;
+
+    default:
+      break;
+  }
+}
+
+// ==============================================================================
+// Frame de un controlador (entradas, escena y salida)
+// ==============================================================================
+// API de la instancia: shrineBegin() una vez; cada vuelta shrineInputs() con los
+// niveles de boton y PIR ya leidos y shrineRender() con el frame de la placa.
+// Todo el estado es del controlador: instancias distintas no comparten nada
+// salvo la cache prestada (con dueno) y lo que la plataforma entregue.
+
+// cache: buffer de la placa compartido por sus hornacinas (0 = sin cache);
+// now: instante de arranque (el reloj del FrameContext).
+inline void shrineBegin(ShrineController& s, const ShrineConfig& config, const ShrinePlatform& platform,
+                        const ShrineSink& sink, SceneCache* cache, unsigned long now) {
+  memset(&s, 0, sizeof(s));
+  s.config = &config;
+  s.platform = &platform;
+  s.sink = sink;
+  s.cache = cache;
+  s.currentMode = MODE_1_CONTEMPLATIVO;
+  inputBegin(s.input, now);
+  s.activeLayer = LAYER_BASE;
+  s.candle.nextInterval = 30;
+  s.lastSceneKey = 0xFF;
+}
+
+// Boton (debounce + cambio de modo) y PIR (ventana con latch y timeout). La
+// logica vive en input_guard.h; aqui solo se traducen sus resultados a
+// acciones y eventos.
+inline void shrineInputs(ShrineController& s, const FrameContext& fc, int buttonReading, bool motionActive) {
+  uint8_t r = inputStep(s.input, INPUT_GUARD, fc.now, (uint8_t)buttonReading, motionActive);
+
+  if (r & INPUT_PRESS) {
+    // Boton presionado: cambiar modo (el snapshot sale cuando el modo se asienta)
+    s.currentMode = nextMode(s.currentMode, s.platform->sceneSlots(s.platform->ctx));
+    allLedsOff(s);
+    shrineNotify(s, SHRINE_EVT_MODE, s.currentMode);
+  }
+  if (r & INPUT_SNAPSHOT) shrineNotify(s, SHRINE_EVT_SNAPSHOT, s.currentMode);
+  if (r & INPUT_MOTION_START) {
+    raiseEvent(s, EVT_MOTION_START);
+    shrineNotify(s, SHRINE_EVT_MOTION, 0);
+  }
+  // Solo informativos (y limitados): no cortan el submodo
+  if (r & INPUT_PIR_RETRIGGER) shrineNotify(s, SHRINE_EVT_MOTION, 1);
+  if (r & INPUT_PIR_LOW) shrineNotify(s, SHRINE_EVT_PIR_LOW, 0);
+  if (r & INPUT_TIMEOUT) {
+    raiseEvent(s, EVT_MOTION_END);
+    shrineNotify(s, SHRINE_EVT_TIMEOUT, 0);
+  }
+}
+
+// Fades, escena del modo, secuencias, composicion y commit al sink. dimQ8 es
+// el brillo maestro de la placa (255 = sin cambio).
+inline void shrineRender(ShrineController& s, const FrameContext& board, uint8_t dimQ8) {
+  FrameContext fc = board;
+  fc.motion = s.input.inMovementMode;
+  fc.motionQ8 = inputMotionQ8(s.input);
+  // Actualizaciones no bloqueantes de animaciones: cualquier fade activo (por ejemplo CARA)
+  for (uint8_t i = 0; i < LED_COUNT; i++) updateFade(s, fc, i);
+  applyMode(s, fc);
+  runSequences(s, fc); // corrutinas sobre la escena
+  composeFrame(s);
+  commitFrame(s, fc, dimQ8);
+}
+
+// Salto del reloj de escena (bus multi-nodo): se desplazan las marcas absolutas
+// y la escena se reinicia.
+inline void shrineJump(ShrineController& s, int32_t delta) {
+  inputShift(s.input, delta);
+  allLedsOff(s);
+  s.lastSceneKey = 0xFF;
+}
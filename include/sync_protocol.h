@@ -0,0 +1,216 @@
+#pragma once
+
+// Sincronizacion entre varios controladores (un Nano por hornacina) sobre un
+// bus UART compartido. Compartido por el firmware (src/virgencitaluces.cpp) y
+// el simulador de host (src/tools/sync_sim.cpp).
+//
+// Mensaje (todos los campos little endian):
+//   0  SYNC_MAGIC
+//   1  tipo (SyncMsgType)
+//   2  id del nodo emisor (1..254; el menor vivo es el maestro)
+//   3  u32 marca de tiempo sincronizada del emisor al empezar a transmitir
+//   7  modo
+//   8  flags (SYNC_FLAG_*)
+//   9  checksum (suma de los bytes 1..8 mod 256, complementada)
+//
+// Eleccion: solo el maestro emite BEACON (cada SYNC_BEACON_INTERVAL_MS). Un
+// seguidor que no oye maestro durante SYNC_MASTER_TIMEOUT_MS (+ escalon por id)
+// se proclama maestro; un maestro que oye un BEACON de id menor cede.
+// Reloj: el seguidor mide el error contra el BEACON y lo corrige con slew
+// acotado (1 ms cada SYNC_SLEW_DIV ms) mas una estimacion de deriva del
+// oscilador; solo salta si el error supera SYNC_JUMP_THRESHOLD_MS (al unirse).
+
+#include <stdint.h>
+
+const uint8_t SYNC_MAGIC = 0xA5;
+const uint8_t SYNC_MSG_BYTES = 10;
+const uint32_t SYNC_BAUD = 9600;
+// Tiempo en el bus de un mensaje completo (10 bits por byte): lo que tarda en
+// llegar la marca de tiempo capturada al empezar a transmitir.
+const uint16_t SYNC_TRANSIT_MS = (uint16_t)((SYNC_MSG_BYTES * 10UL * 1000UL + SYNC_BAUD / 2) / SYNC_BAUD);
+
+const uint16_t SYNC_BEACON_INTERVAL_MS = 1000;
+const uint16_t SYNC_MASTER_TIMEOUT_MS = 3500;
+const uint16_t SYNC_TIMEOUT_STEP_MS = 150;   // escalon por id para no proclamarse a la vez
+const int32_t SYNC_JUMP_THRESHOLD_MS = 500;
+const uint8_t SYNC_SLEW_DIV = 32;            // slew maximo ~3% (31 ms por segundo)
+const int32_t SYNC_DRIFT_MAX_Q16 = 1311;     // 2% en Q16 (los resonadores van por 0.5%)
+
+enum SyncMsgType : uint8_t {
+  SYNC_MSG_BEACON = 1, // maestro: reloj + modo + movimiento
+  SYNC_MSG_MODE,       // cualquier nodo: cambio de modo por boton
+  SYNC_MSG_MOTION      // cualquier nodo: su PIR disparo
+};
+
+const uint8_t SYNC_FLAG_MOTION = 1 << 0;
+
+struct SyncMessage {
+  uint8_t type;
+  uint8_t node;
+  uint32_t ts;
+  uint8_t mode;
+  uint8_t flags;
+};
+
+inline uint8_t syncChecksum(const uint8_t* b) {
+  uint8_t sum = 0;
+  for (uint8_t i = 1; i < SYNC_MSG_BYTES - 1; i++) sum = (uint8_t)(sum + b[i]);
+  return (uint8_t)~sum;
+}
+
+inline void syncEncode(const SyncMessage& m, uint8_t* out) {
+  out[0] = SYNC_MAGIC;
+  out[1] = m.type;
+  out[2] = m.node;
+  for (uint8_t i = 0; i < 4; i++) out[3 + i] = (uint8_t)(m.ts >> (8 * i));
+  out[7] = m.mode;
+  out[8] = m.flags;
+  out[9] = syncChecksum(out);
+}
+
+// Decodificador byte a byte; se re-sincroniza solo tras basura o cortes.
+struct SyncParser {
+  uint8_t buf[SYNC_MSG_BYTES];
+  uint8_t len;
+};
+
+inline bool syncParse(SyncParser& p, uint8_t byte, SyncMessage& out) {
+  if (p.len == 0 && byte != SYNC_MAGIC) return false;
+  p.buf[p.len++] = byte;
+  if (p.len < SYNC_MSG_BYTES) return false;
+  p.len = 0;
+  if (syncChecksum(p.buf) != p.buf[SYNC_MSG_BYTES - 1] || p.buf[2] == 0) {
+    // Quiza el MAGIC real esta dentro: re-escanea el resto del buffer.
+    for (uint8_t i = 1; i < SYNC_MSG_BYTES; i++) {
+      if (p.buf[i] != SYNC_MAGIC) continue;
+      for (uint8_t k = i; k < SYNC_MSG_BYTES; k++) p.buf[p.len++] = p.buf[k];
+      break;
+    }
+    return false;
+  }
+  out.type = p.buf[1];
+  out.node = p.buf[2];
+  out.ts = (uint32_t)p.buf[3] | ((uint32_t)p.buf[4] << 8) | ((uint32_t)p.buf[5] << 16) | ((uint32_t)p.buf[6] << 24);
+  out.mode = p.buf[7];
+  out.flags = p.buf[8];
+  return true;
+}
+
+// Base de tiempo sincronizada: local + offset, con slew y deriva.
+struct SyncClock {
+  int32_t offset;       // ms sumados al reloj local
+  int32_t pending;      // error aun por corregir con slew
+  int32_t driftQ16;     // deriva estimada (ms por ms, Q16)
+  int32_t driftAcc;     // fraccion Q16 acumulada de la deriva
+  uint16_t slewAcc;     // ms locales acumulados para el siguiente paso de slew
+  uint32_t lastLocal;
+  uint32_t lastBeaconLocal;
+  bool locked;          // ya recibio al menos un BEACON
+};
+
+inline uint32_t syncClockNow(SyncClock& c, uint32_t local) {
+  uint32_t elapsed = local - c.lastLocal;
+  c.lastLocal = local;
+  if (elapsed > 60000UL) elapsed = 60000UL;
+  // Deriva: corrige la frecuencia del oscilador local de forma continua.
+  c.driftAcc += c.driftQ16 * (int32_t)elapsed;
+  c.offset += c.driftAcc / 65536;
+  c.driftAcc %= 65536;
+  // Slew: como maximo 1 ms de correccion por cada SYNC_SLEW_DIV ms.
+  c.slewAcc = (uint16_t)(c.slewAcc + elapsed);
+  int32_t steps = c.slewAcc / SYNC_SLEW_DIV;
+  c.slewAcc %= SYNC_SLEW_DIV;
+  if (c.pending > 0) {
+    int32_t s = (steps < c.pending) ? steps : c.pending;
+    c.offset += s;
+    c.pending -= s;
+  } else if (c.pending < 0) {
+    int32_t s = (steps < -c.pending) ? steps : -c.pending;
+    c.offset -= s;
+    c.pending += s;
+  }
+  return local + (uint32_t)c.offset;
+}
+
+// BEACON recibido (local = instante de recepcion del ultimo byte).
+// Devuelve true si hubo salto (error grande: union al bus o cambio de maestro).
+inline bool syncClockOnBeacon(SyncClock& c, uint32_t local, uint32_t masterTs) {
+  uint32_t mine = syncClockNow(c, local);
+  int32_t err = (int32_t)(masterTs + SYNC_TRANSIT_MS - mine);
+  if (!c.locked || err > SYNC_JUMP_THRESHOLD_MS || err < -SYNC_JUMP_THRESHOLD_MS) {
+    c.offset += err;
+    c.pending = 0;
+    c.driftAcc = 0;
+    c.locked = true;
+    c.lastBeaconLocal = local;
+    return true;
+  }
+  // El error medido ya incluye lo pendiente: se reemplaza, no se acumula.
+  c.pending = err;
+  uint32_t interval = local - c.lastBeaconLocal;
+  c.lastBeaconLocal = local;
+  if (interval >= SYNC_BEACON_INTERVAL_MS / 2 && interval <= 4UL * SYNC_BEACON_INTERVAL_MS) {
+    // Ganancia 1/4 sobre el error por ms de intervalo.
+    c.driftQ16 += (int32_t)((err * 65536L) / (int32_t)interval) / 4;
+    if (c.driftQ16 > SYNC_DRIFT_MAX_Q16) c.driftQ16 = SYNC_DRIFT_MAX_Q16;
+    if (c.driftQ16 < -SYNC_DRIFT_MAX_Q16) c.driftQ16 = -SYNC_DRIFT_MAX_Q16;
+  }
+  return false;
+}
+
+// Estado de un nodo del bus (eleccion + reloj).
+struct SyncNode {
+  uint8_t id;
+  uint8_t masterId;       // 0 = sin maestro conocido
+  bool isMaster;
+  uint32_t lastMasterLocal;
+  uint32_t nextBeaconLocal;
+  uint32_t bootLocal;
+  SyncClock clock;
+  uint16_t jumps;
+  uint16_t beaconsHeard;
+  int16_t lastError;      // ms, ultimo error medido contra el maestro
+};
+
+inline void syncNodeInit(SyncNode& n, uint8_t id, uint32_t local) {
+  n = SyncNode();
+  n.id = id;
+  n.bootLocal = local;
+  n.lastMasterLocal = local;
+  n.clock.lastLocal = local;
+}
+
+// Procesa un mensaje ajeno. Solo los BEACON tocan eleccion y reloj.
+inline void syncNodeOnMessage(SyncNode& n, const SyncMessage& m, uint32_t local) {
+  if (m.type != SYNC_MSG_BEACON || m.node == n.id) return;
+  if (m.node > n.id) {
+    // Maestro de id mayor: este nodo tiene prioridad y toma el relevo ya.
+    if (!n.isMaster) {
+      n.isMaster = true;
+      n.masterId = n.id;
+      n.nextBeaconLocal = local;
+    }
+    return;
+  }
+  n.isMaster = false;
+  n.masterId = m.node;
+  n.lastMasterLocal = local;
+  n.beaconsHeard++;
+  uint32_t before = syncClockNow(n.clock, local);
+  n.lastError = (int16_t)(int32_t)(m.ts + SYNC_TRANSIT_MS - before);
+  if (syncClockOnBeacon(n.clock, local, m.ts)) n.jumps++;
+}
+
+// Llamar cada frame. true = toca emitir BEACON ahora (el nodo es maestro).
+inline bool syncNodePoll(SyncNode& n, uint32_t local) {
+  if (!n.isMaster) {
+    uint32_t timeout = SYNC_MASTER_TIMEOUT_MS + (uint32_t)n.id * SYNC_TIMEOUT_STEP_MS;
+    if (local - n.lastMasterLocal < timeout) return false;
+    n.isMaster = true; // nadie con prioridad responde: asume el reloj
+    n.masterId = n.id;
+    n.nextBeaconLocal = local;
+  }
+  if ((int32_t)(local - n.nextBeaconLocal) < 0) return false;
+  n.nextBeaconLocal = local + SYNC_BEACON_INTERVAL_MS;
+  return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+// Telemetria de ocupacion: eventos y contadores por hora. Compartido por el
+// firmware (src/virgencitaluces.cpp) y el decodificador de host
+// (src/tools/telemetry_decoder.cpp).
+//
+// Evento (TLM_EVENT_BYTES, en un anillo de RAM):
+//   0  tipo (bits 7..4, TlmEventType) | argumento (bits 3..0)
+//   1  u16 segundos desde el evento anterior (delta; TLM_EVT_GAP encadena
+//      deltas mayores de 65535 s)
+//
+// Registro horario (TLM_RECORD_BYTES, anillo en EEPROM; cada hora se escribe
+// el siguiente hueco, asi cada celda se reescribe una vez cada
+// TLM_RECORD_COUNT horas):
+//   0  u16 secuencia (horas desde el primer registro; el mayor es el ultimo)
+//   2  subidas del PIR (saturado a 255)
+//   3  fines de submodo movimiento por timeout
+//   4  cambios de modo
+//   5  tiempo en submodo movimiento, en unidades de 16 s (225 = la hora entera)
+//   6  modo con mas tiempo en la hora (bits 3..0) | reposos (bits 7..4, saturado)
+//   7  CRC-8 de los bytes 0..6
+//
+// Volcado por serie ("tlm dump"), en hexadecimal dentro de lineas
+// "tlm begin <version> <bytes>" / "tlm data <hex>" / "tlm end <crc16>":
+//   0  'T' 'M'
+//   2  version (TLM_VERSION)
+//   3  numero de modos del firmware
+//   4  u32 segundos de reloj de telemetria al volcar
+//   8  causa del ultimo reset (TLM_RESET_*)
+//   9  numero de eventos
+//   10 u32 segundos del instante base (evento anterior al mas antiguo)
+//   14 eventos, del mas antiguo al mas reciente
+//   .. registro de la hora en curso (sin cerrar)
+//   .. numero de registros guardados
+//   .. registros de EEPROM, del mas antiguo al mas reciente
+// El CRC-16 de "tlm end" es el de include/vm_bytecode.h (vmCrc16Update).
+//
+// El reloj de telemetria cuenta segundos despiertos: durante el reposo en
+// power-down millis() se para (no hay RTC).
+
+#include <stdint.h>
+
+const uint8_t TLM_VERSION = 1;
+const uint8_t TLM_EVENT_BYTES = 3;
+const uint8_t TLM_RECORD_BYTES = 8;
+const uint8_t TLM_RECORD_COUNT = 32;
+const uint16_t TLM_HOUR_S = 3600;
+const uint8_t TLM_MOVEMENT_UNIT_S = 16;
+
+enum TlmEventType : uint8_t {
+  TLM_EVT_RESET = 0, // arg: causa (TLM_RESET_*)
+  TLM_EVT_MODE,      // arg: modo nuevo (0 = Modo 1)
+  TLM_EVT_PIR,       // arg: 1 = re-disparo (submodo ya activo, suma intensidad)
+  TLM_EVT_TIMEOUT,   // fin del submodo movimiento
+  TLM_EVT_SLEEP,     // entra en reposo
+  TLM_EVT_WAKE,      // despierta (arg: 1 = boton, 0 = PIR)
+  TLM_EVT_GAP,       // solo transporta delta
+  TLM_EVT_COUNT
+};
+
+// Bits de MCUSR del ATmega328P.
+const uint8_t TLM_RESET_POWER = 1 << 0;
+const uint8_t TLM_RESET_EXTERNAL = 1 << 1;
+const uint8_t TLM_RESET_BROWNOUT = 1 << 2;
+const uint8_t TLM_RESET_WATCHDOG = 1 << 3;
+
+struct TlmHourRecord {
+  uint16_t seq;
+  uint8_t pirRises;
+  uint8_t timeouts;
+  uint8_t modeChanges;
+  uint8_t movementUnits;
+  uint8_t mainMode;
+  uint8_t sleeps;
+};
+
+inline uint8_t tlmCrc8(const uint8_t* b, uint8_t len) {
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= b[i];
+    for (uint8_t k = 0; k < 8; k++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+inline void tlmEncodeRecord(const TlmHourRecord& r, uint8_t* out) {
+  out[0] = (uint8_t)r.seq;
+  out[1] = (uint8_t)(r.seq >> 8);
+  out[2] = r.pirRises;
+  out[3] = r.timeouts;
+  out[4] = r.modeChanges;
+  out[5] = r.movementUnits;
+  out[6] = (uint8_t)((r.mainMode & 0x0F) | ((r.sleeps > 15 ? 15 : r.sleeps) << 4));
+  out[7] = tlmCrc8(out, TLM_RECORD_BYTES - 1);
+}
+
+// false si el hueco esta borrado o el CRC no cuadra (escritura cortada).
+inline bool tlmDecodeRecord(const uint8_t* in, TlmHourRecord& r) {
+  bool erased = true;
+  for (uint8_t i = 0; i < TLM_RECORD_BYTES; i++) erased = erased && in[i] == 0xFF;
+  if (erased || tlmCrc8(in, TLM_RECORD_BYTES - 1) != in[TLM_RECORD_BYTES - 1]) return false;
+  r.seq = (uint16_t)(in[0] | (in[1] << 8));
+  r.pirRises = in[2];
+  r.timeouts = in[3];
+  r.modeChanges = in[4];
+  r.movementUnits = in[5];
+  r.mainMode = in[6] & 0x0F;
+  r.sleeps = in[6] >> 4;
+  return true;
+}
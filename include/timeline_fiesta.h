@@ -0,0 +1,25 @@
+#pragma once
+
+// Generado por src/tools/timeline_compiler.cpp desde fiesta.tl. No editar a mano.
+// 4 pistas, 72 keyframes, 60000 ms (loop en 12000 ms).
+
+#include "timeline_format.h"
+
+const uint16_t TIMELINE_FIESTA_SIZE = 166;
+
+const uint8_t TIMELINE_FIESTA[] PROGMEM = {
+  0x54, 0x4C, 0x01, 0x3C, 0x60, 0xEA, 0x00, 0x00, 0xE0, 0x2E, 0x00, 0x00,
+  0xA6, 0x00, 0x16, 0x00, 0x48, 0x00, 0x69, 0x00, 0x7F, 0x00, 0x40, 0x00,
+  0xD0, 0xA0, 0x1F, 0x59, 0x70, 0xB3, 0x60, 0x99, 0xE0, 0xA0, 0x06, 0xD9,
+  0x50, 0x99, 0x60, 0xD9, 0x4F, 0x04, 0x03, 0x50, 0x99, 0x85, 0xE8, 0x07,
+  0x05, 0x05, 0x05, 0x06, 0xF0, 0x88, 0x27, 0xBF, 0xF0, 0xF0, 0x2E, 0xE6,
+  0x80, 0xC0, 0x3E, 0xF0, 0xF0, 0x2E, 0xB3, 0x60, 0x9E, 0x9B, 0xA0, 0x1F,
+  0x40, 0x00, 0xD0, 0xF0, 0x2E, 0x4D, 0xF0, 0xA0, 0x1F, 0x73, 0xC0, 0xD0,
+  0x0F, 0x66, 0x70, 0x8C, 0x70, 0x66, 0x4F, 0x04, 0x02, 0xF0, 0xF0, 0x2E,
+  0x80, 0xF0, 0x90, 0x4E, 0xA6, 0x70, 0x73, 0x70, 0x66, 0x40, 0x00, 0xD0,
+  0xC0, 0x3E, 0x33, 0xC0, 0xA0, 0x1F, 0x40, 0x80, 0xC0, 0x3E, 0x70, 0x73,
+  0x70, 0x99, 0x00, 0x70, 0x59, 0x60, 0x40, 0x40, 0x00, 0xD0, 0x88, 0x27,
+  0x4D, 0xF0, 0xD8, 0x36, 0x66, 0xE0, 0x90, 0x03, 0xCC, 0x50, 0x66, 0x60,
+  0xCC, 0x4F, 0x04, 0x06, 0x50, 0x66, 0xF0, 0xB0, 0x3B, 0x8C, 0xF0, 0xC0,
+  0x3E, 0xBF, 0x70, 0x8C, 0x70, 0xBF, 0xF0, 0x90, 0x4E, 0x66
+};
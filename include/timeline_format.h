@@ -0,0 +1,185 @@
+#pragma once
+
+// Formato binario de coreografias (timeline) en flash + decodificador en streaming.
+// Compartido por el firmware (src/virgencitaluces.cpp) y el compilador de host
+// (src/tools/timeline_compiler.cpp).
+//
+// Cabecera (little endian):
+//   0  'T' 'L'
+//   2  version (TIMELINE_VERSION)
+//   3  mascara de canales (bit i = hay pista para el canal i)
+//   4  u32 duracion total en ms
+//   8  u32 punto de loop en ms (al llegar al final se vuelve aqui)
+//   12 u16 tamano total del blob
+//   14 u16 offset de cada pista (una por bit de la mascara, en orden de canal)
+//
+// Pista: secuencia de registros. Cabecera de registro H:
+//   bit7    nuevo dt: sigue un varint (LEB128) con los ms desde el keyframe anterior;
+//           si es 0 se reutiliza el dt anterior (RLE de tiempo)
+//   bit6    valor absoluto: sigue un byte con el nivel PWM (bits 3..0 = 0)
+//   bit5..4 easing del tramo que termina en este keyframe (TimelineEasing)
+//   bit3..0 delta de nivel con signo (-8..7) respecto al keyframe anterior
+//   H == TIMELINE_REPEAT: sigue u8 'back' (bytes) y u8 'veces'; repite los
+//   'back' bytes anteriores ese numero de veces (RLE de patrones).
+// El primer registro de cada pista es absoluto con dt 0.
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#endif
+#endif
+
+const uint8_t TIMELINE_VERSION = 1;
+const uint8_t TIMELINE_HEADER_BYTES = 14;
+const uint8_t TIMELINE_MAX_CHANNELS = 6;
+
+const uint8_t TIMELINE_FLAG_NEW_DT = 0x80;
+const uint8_t TIMELINE_FLAG_ABS = 0x40;
+const uint8_t TIMELINE_REPEAT = 0x4F;
+
+enum TimelineEasing : uint8_t {
+  EASE_LINEAR = 0,
+  EASE_IN,
+  EASE_OUT,
+  EASE_IN_OUT
+};
+
+// Progreso 0..256 -> 0..256 con easing (punto fijo, sin tablas).
+inline uint16_t timelineEase(uint8_t easing, uint16_t p) {
+  switch (easing) {
+    case EASE_IN: return (uint16_t)((p * p) >> 8);
+    case EASE_OUT: { uint32_t q = 256 - p; return (uint16_t)(256 - ((q * q) >> 8)); }
+    case EASE_IN_OUT:
+      if (p < 128) return (uint16_t)((p * p) >> 7);
+      { uint16_t q = 256 - p; return (uint16_t)(256 - ((q * q) >> 7)); }
+    default: return p;
+  }
+}
+
+inline uint16_t timelineReadU16(const uint8_t* blob, uint16_t at) {
+  return (uint16_t)(pgm_read_byte(blob + at) | ((uint16_t)pgm_read_byte(blob + at + 1) << 8));
+}
+
+inline uint32_t timelineReadU32(const uint8_t* blob, uint16_t at) {
+  return (uint32_t)timelineReadU16(blob, at) | ((uint32_t)timelineReadU16(blob, (uint16_t)(at + 2)) << 16);
+}
+
+inline bool timelineValid(const uint8_t* blob) {
+  return pgm_read_byte(blob) == 'T' && pgm_read_byte(blob + 1) == 'L' &&
+         pgm_read_byte(blob + 2) == TIMELINE_VERSION;
+}
+
+// Cursor de una pista: RAM constante (26 bytes en AVR) sin importar la longitud.
+struct TimelineTrack {
+  uint16_t pos;        // siguiente registro
+  uint16_t begin;      // primer registro de la pista
+  uint16_t end;        // fin de la pista (exclusivo)
+  uint16_t repeatEnd;  // posicion del REPEAT en curso (0xFFFF = ninguno)
+  uint8_t repeatLeft;
+  uint8_t channel;
+  uint8_t v0;          // nivel al inicio del tramo
+  uint8_t v1;          // nivel al final del tramo
+  uint8_t easing;
+  bool done;           // sin mas registros: se mantiene v1
+  uint16_t dt;         // ultimo dt leido (RLE de tiempo)
+  uint16_t segLen;     // duracion del tramo actual
+  uint32_t segStart;   // ms de inicio del tramo (tiempo de timeline)
+  uint32_t recip;      // 2^24 / segLen (progreso sin dividir por frame)
+};
+
+// Lee el siguiente keyframe y abre el tramo v1 -> nuevo valor. false = fin de pista.
+inline bool timelineNextRecord(const uint8_t* blob, TimelineTrack& t) {
+  for (;;) {
+    if (t.pos >= t.end) return false;
+    uint8_t h = pgm_read_byte(blob + t.pos);
+    if (h == TIMELINE_REPEAT) {
+      if (t.repeatEnd != t.pos) {
+        t.repeatEnd = t.pos;
+        t.repeatLeft = pgm_read_byte(blob + t.pos + 2);
+      }
+      if (t.repeatLeft > 0) {
+        t.repeatLeft--;
+        t.pos = (uint16_t)(t.pos - pgm_read_byte(blob + t.pos + 1));
+      } else {
+        t.repeatEnd = 0xFFFF;
+        t.pos = (uint16_t)(t.pos + 3);
+      }
+      continue;
+    }
+    t.pos++;
+    if (h & TIMELINE_FLAG_NEW_DT) {
+      uint16_t dt = 0;
+      uint8_t shift = 0;
+      uint8_t b;
+      do {
+        b = pgm_read_byte(blob + t.pos++);
+        dt |= (uint16_t)(b & 0x7F) << shift;
+        shift += 7;
+      } while ((b & 0x80) && shift < 16);
+      t.dt = dt;
+    }
+    uint8_t next;
+    if (h & TIMELINE_FLAG_ABS) {
+      next = pgm_read_byte(blob + t.pos++);
+    } else {
+      int8_t d = (int8_t)(((h & 0x0F) ^ 0x08) - 0x08);
+      next = (uint8_t)(t.v1 + d);
+    }
+    t.v0 = t.v1;
+    t.v1 = next;
+    t.easing = (uint8_t)((h >> 4) & 0x03);
+    t.segStart += t.segLen;
+    t.segLen = t.dt;
+    t.recip = t.segLen ? (16777216UL / t.segLen) : 0;
+    return true;
+  }
+}
+
+// Reinicia la pista al principio (tiempo 0).
+inline void timelineRewind(const uint8_t* blob, TimelineTrack& t) {
+  t.pos = t.begin;
+  t.repeatEnd = 0xFFFF;
+  t.repeatLeft = 0;
+  t.v0 = t.v1 = 0;
+  t.dt = 0;
+  t.segLen = 0;
+  t.segStart = 0;
+  t.done = !timelineNextRecord(blob, t);
+  t.v0 = t.v1;
+}
+
+// Nivel de la pista en el instante ms (debe ser no decreciente entre llamadas
+// salvo tras timelineRewind).
+inline uint8_t timelineSample(const uint8_t* blob, TimelineTrack& t, uint32_t ms) {
+  while (!t.done && ms >= t.segStart + t.segLen) {
+    if (!timelineNextRecord(blob, t)) t.done = true;
+  }
+  if (t.done || t.segLen == 0) return t.v1;
+  uint16_t p = (uint16_t)(((ms - t.segStart) * t.recip) >> 16); // 0..256
+  uint16_t e = timelineEase(t.easing, p);
+  return (uint8_t)(((uint16_t)t.v0 * (256 - e) + (uint16_t)t.v1 * e) >> 8);
+}
+
+// Prepara hasta TIMELINE_MAX_CHANNELS pistas desde la cabecera; devuelve cuantas.
+inline uint8_t timelineOpen(const uint8_t* blob, TimelineTrack* tracks) {
+  if (!timelineValid(blob)) return 0;
+  uint8_t mask = pgm_read_byte(blob + 3);
+  uint16_t size = timelineReadU16(blob, 12);
+  uint8_t n = 0;
+  for (uint8_t ch = 0; ch < TIMELINE_MAX_CHANNELS; ch++) {
+    if (mask & (1 << ch)) tracks[n++].channel = ch;
+  }
+  for (uint8_t k = 0; k < n; k++) {
+    tracks[k].begin = timelineReadU16(blob, (uint16_t)(TIMELINE_HEADER_BYTES + 2 * k));
+    tracks[k].end = (k + 1 < n) ? timelineReadU16(blob, (uint16_t)(TIMELINE_HEADER_BYTES + 2 * (k + 1))) : size;
+    timelineRewind(blob, tracks[k]);
+  }
+  return n;
+}
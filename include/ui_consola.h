@@ -0,0 +1,194 @@
+#pragma once
+
+// Generado por src/tools/ui_text_compiler.cpp desde consola.txt. No editar a mano.
+// 42 textos: 3048 bytes como literales F() -> 1552 bytes (diccionario 57 fragmentos 438,
+// textos 1000, indice 84, nombres de LED 30).
+
+#include "ui_text_format.h"
+
+enum UiText : uint8_t {
+  UI_ARRANQUE = 0,
+  UI_PINES,
+  UI_MODOS,
+  UI_MODOS_VM,
+  UI_AYUDA,
+  UI_REPOSO_AVISO,
+  UI_MODO_1,
+  UI_MODO_2,
+  UI_MODO_3,
+  UI_MODO_4,
+  UI_MODO_5,
+  UI_MODO_6,
+  UI_MODO_7,
+  UI_MODO_VM,
+  UI_MODO_DESCONOCIDO,
+  UI_PERFIL_BASE,
+  UI_PERFIL_MOVIMIENTO,
+  UI_M1_VARIANTE,
+  UI_M1_MOVIMIENTO,
+  UI_M1_BASE,
+  UI_M2_MOVIMIENTO,
+  UI_M2_BASE,
+  UI_M3_MOVIMIENTO,
+  UI_M3_BASE,
+  UI_M4_MOVIMIENTO,
+  UI_M4_BASE,
+  UI_M5_MOVIMIENTO,
+  UI_M5_BASE,
+  UI_M6_MOVIMIENTO,
+  UI_M6_BASE,
+  UI_M7_MOVIMIENTO,
+  UI_M7_BASE,
+  UI_M7_TIMELINE,
+  UI_VM_PROGRAMA,
+  UI_PERFIL_INDEFINIDO,
+  UI_SNAPSHOT_CABECERA,
+  UI_SEPARADOR,
+  UI_DUTY_CABECERA,
+  UI_DUTY_BASE,
+  UI_DUTY_MOV,
+  UI_DUTY_SIN_MEDIR,
+  UI_CIERRE,
+  UI_TEXT_COUNT
+};
+
+const uint16_t UI_TEXT_RAW_BYTES = 3048;    // como literales F()
+const uint16_t UI_TEXT_PACKED_BYTES = 1552;
+
+const char UI_LED_NAMES[6][5] PROGMEM = {"CAN1", "CAN2", "CARA", "FIZO", "FDEP", "ATRA"};
+
+const uint8_t UI_DICT[] PROGMEM = {
+  0x17, 0x20, 0x28, 0x02, 0x20, 0x63, 0x6F, 0x6E, 0x20, 0x0E, 0x14, 0x20,
+  0x6D, 0x65, 0x6E, 0x6F, 0x73, 0x20, 0x74, 0x6F, 0x70, 0x65, 0x29, 0x0A,
+  0x10, 0x20, 0x01, 0x2F, 0x02, 0x3A, 0x20, 0x43, 0x61, 0x6E, 0x64, 0x65,
+  0x6C, 0x69, 0x74, 0x61, 0x20, 0x10, 0x20, 0x3E, 0x20, 0x4D, 0x4F, 0x44,
+  0x4F, 0x20, 0x41, 0x43, 0x54, 0x55, 0x41, 0x4C, 0x3A, 0x20, 0x0B, 0x3A,
+  0x20, 0x45, 0x73, 0x74, 0x61, 0x74, 0x69, 0x63, 0x6F, 0x20, 0x0E, 0x3D,
+  0x3D, 0x3D, 0x3D, 0x3D, 0x3D, 0x3D, 0x3D, 0x3D, 0x3D, 0x3D, 0x3D, 0x3D,
+  0x3D, 0x13, 0x20, 0x43, 0x41, 0x4E, 0x44, 0x45, 0x4C, 0x49, 0x54, 0x41,
+  0x20, 0x2B, 0x20, 0x50, 0x41, 0x53, 0x54, 0x4F, 0x52, 0x27, 0x0A, 0x20,
+  0x48, 0x41, 0x4C, 0x4F, 0x20, 0x54, 0x52, 0x49, 0x41, 0x44, 0x41, 0x3A,
+  0x20, 0x06, 0x2D, 0x3E, 0x04, 0x2D, 0x3E, 0x05, 0x20, 0x28, 0x0F, 0x03,
+  0x25, 0x2D, 0x0F, 0x04, 0x25, 0x2C, 0x20, 0x63, 0x69, 0x63, 0x6C, 0x6F,
+  0x20, 0x07, 0x20, 0x56, 0x49, 0x52, 0x47, 0x45, 0x4E, 0x06, 0x2D, 0x2D,
+  0x2D, 0x2D, 0x2D, 0x2D, 0x02, 0x0A, 0x20, 0x1B, 0x20, 0x03, 0x3A, 0x20,
+  0x44, 0x65, 0x72, 0x69, 0x76, 0x61, 0x20, 0x4F, 0x72, 0x67, 0x61, 0x6E,
+  0x69, 0x63, 0x61, 0x20, 0x0F, 0x01, 0x25, 0x2D, 0x0F, 0x02, 0x25, 0x07,
+  0x04, 0x2F, 0x05, 0x2F, 0x06, 0x3A, 0x20, 0x15, 0x20, 0x43, 0x4F, 0x4E,
+  0x54, 0x45, 0x4D, 0x50, 0x4C, 0x41, 0x54, 0x49, 0x56, 0x4F, 0x20, 0x41,
+  0x55, 0x52, 0x4F, 0x52, 0x41, 0x07, 0x3A, 0x20, 0x46, 0x61, 0x64, 0x65,
+  0x20, 0x02, 0x20, 0x28, 0x11, 0x20, 0x53, 0x45, 0x43, 0x55, 0x45, 0x4E,
+  0x43, 0x49, 0x41, 0x20, 0x46, 0x49, 0x45, 0x53, 0x54, 0x41, 0x06, 0x20,
+  0x53, 0x4F, 0x4C, 0x4F, 0x20, 0x02, 0x3A, 0x20, 0x07, 0x20, 0x45, 0x45,
+  0x50, 0x52, 0x4F, 0x4D, 0x07, 0x20, 0x45, 0x53, 0x43, 0x45, 0x4E, 0x41,
+  0x03, 0x20, 0x64, 0x65, 0x02, 0x20, 0x03, 0x0B, 0x52, 0x65, 0x73, 0x70,
+  0x69, 0x72, 0x61, 0x63, 0x69, 0x6F, 0x6E, 0x02, 0x20, 0x20, 0x04, 0x4F,
+  0x46, 0x46, 0x0A, 0x02, 0x61, 0x20, 0x02, 0x64, 0x6F, 0x02, 0x20, 0x2D,
+  0x03, 0x20, 0x4D, 0x4F, 0x02, 0x29, 0x0A, 0x03, 0x2C, 0x20, 0x44, 0x09,
+  0x43, 0x41, 0x4E, 0x44, 0x45, 0x4C, 0x49, 0x54, 0x41, 0x02, 0x65, 0x6E,
+  0x08, 0x20, 0x45, 0x4E, 0x46, 0x41, 0x53, 0x49, 0x53, 0x02, 0x65, 0x20,
+  0x02, 0x65, 0x6C, 0x02, 0x69, 0x6E, 0x02, 0x6F, 0x6E, 0x03, 0x04, 0x2F,
+  0x05, 0x02, 0x20, 0x2B, 0x04, 0x20, 0x50, 0x49, 0x52, 0x04, 0x6D, 0x65,
+  0x64, 0x69, 0x06, 0x20, 0x66, 0x6C, 0x61, 0x73, 0x68, 0x06, 0x50, 0x45,
+  0x52, 0x46, 0x49, 0x4C, 0x02, 0x65, 0x73, 0x02, 0x72, 0x61, 0x05, 0x49,
+  0x4E, 0x50, 0x55, 0x54, 0x05, 0x4F, 0x73, 0x63, 0x69, 0x6C, 0x05, 0x6F,
+  0x76, 0x69, 0x6D, 0x69, 0x03, 0x73, 0x2C, 0x20, 0x02, 0x74, 0x6F, 0x03,
+  0x0E, 0x28, 0x2D, 0x02, 0x20, 0x62, 0x02, 0x20, 0x73, 0x02, 0x2E, 0x0A,
+  0x02, 0x44, 0x4F, 0x02, 0x45, 0x44
+};
+
+const uint16_t UI_TEXT_INDEX[] PROGMEM = {
+  0, 39, 101, 171, 187, 260, 309, 315, 322, 328, 336, 344,
+  351, 357, 372, 385, 393, 409, 423, 454, 466, 479, 491, 524,
+  556, 608, 642, 672, 689, 732, 809, 814, 819, 846, 881, 898,
+  936, 945, 971, 981, 988, 995
+};
+
+const uint8_t UI_TEXTS[] PROGMEM = {
+  0x0A, 0x3D, 0x3D, 0x3D, 0x20, 0x56, 0x49, 0x52, 0x47, 0x4F, 0x20, 0x43,
+  0x49, 0x54, 0x41, 0x20, 0x4C, 0x55, 0x43, 0x45, 0x53, 0x9B, 0x20, 0x37,
+  0x9C, 0xB7, 0x53, 0xA7, 0x93, 0x53, 0x20, 0x56, 0x4D, 0x20, 0x3D, 0x3D,
+  0x3D, 0x0A, 0x00, 0x50, 0xA4, 0xAC, 0x20, 0x63, 0xA5, 0x66, 0x69, 0x67,
+  0x75, 0xAD, 0x9A, 0x73, 0x3A, 0x89, 0x20, 0x42, 0x54, 0x4E, 0x91, 0x44,
+  0x32, 0x8E, 0xAE, 0x5F, 0x50, 0x55, 0x4C, 0x4C, 0x55, 0x50, 0x29, 0x89,
+  0xA8, 0x91, 0x44, 0x34, 0x8E, 0xAE, 0x29, 0x89, 0x20, 0x4C, 0xB8, 0x73,
+  0x91, 0x44, 0x33, 0x9E, 0x35, 0x9E, 0x36, 0x9E, 0x39, 0x9E, 0x31, 0x30,
+  0x9E, 0x31, 0x31, 0x0A, 0x00, 0x0A, 0x4D, 0x6F, 0x9A, 0x73, 0x20, 0x64,
+  0x69, 0x73, 0x70, 0xA5, 0x69, 0x62, 0x6C, 0xAC, 0x3A, 0x89, 0x20, 0x31,
+  0x2E, 0x8C, 0x89, 0x20, 0x32, 0x2E, 0x90, 0x9F, 0x89, 0x20, 0x33, 0x2E,
+  0x85, 0x89, 0x20, 0x34, 0x2E, 0x85, 0xA7, 0x87, 0x89, 0x20, 0x35, 0x2E,
+  0x85, 0xA7, 0x87, 0x90, 0x03, 0x89, 0x20, 0x36, 0x2E, 0xA1, 0x87, 0x89,
+  0x20, 0x37, 0x2E, 0x8F, 0x8E, 0x74, 0x69, 0x6D, 0xA3, 0xA4, 0xA2, 0xA0,
+  0xAA, 0x9D, 0x00, 0x97, 0x38, 0x2D, 0x31, 0x30, 0x2E, 0x93, 0x53, 0x92,
+  0x8E, 0x56, 0x4D, 0x29, 0x3A, 0x0A, 0x00, 0x0A, 0x50, 0x75, 0x6C, 0x73,
+  0x99, 0xA3, 0xB4, 0x6F, 0x74, 0xA5, 0x20, 0x70, 0x61, 0x72, 0x99, 0x63,
+  0x61, 0x6D, 0x62, 0x69, 0x61, 0x72, 0x20, 0x6D, 0x6F, 0x9A, 0xB6, 0x4D,
+  0xB0, 0xA0, 0xB2, 0x94, 0x74, 0x65, 0x63, 0x74, 0x61, 0x62, 0x6C, 0xA2,
+  0x70, 0x6F, 0x72, 0xA8, 0x8E, 0x44, 0x34, 0x29, 0xB6, 0x43, 0xA5, 0x73,
+  0x6F, 0x6C, 0x99, 0x73, 0x65, 0x72, 0x69, 0x65, 0x91, 0xAC, 0x63, 0x72,
+  0x69, 0x62, 0xA2, 0x68, 0xA3, 0x70, 0xB6, 0x00, 0x52, 0x65, 0x70, 0x6F,
+  0x73, 0x6F, 0x20, 0x74, 0xAD, 0x73, 0x20, 0x0F, 0x00, 0x20, 0x6D, 0xA4,
+  0xB5, 0xA4, 0x20, 0x61, 0x63, 0x74, 0x69, 0x76, 0x69, 0x64, 0x61, 0x64,
+  0x8E, 0x64, 0xAC, 0x70, 0x69, 0x65, 0x72, 0x74, 0x99, 0x63, 0xA5, 0xA8,
+  0x20, 0x6F, 0xB4, 0x6F, 0x74, 0xA5, 0x29, 0xB6, 0x00, 0x82, 0x31, 0x9B,
+  0x8C, 0x0A, 0x00, 0x82, 0x32, 0x9B, 0x90, 0x9F, 0x0A, 0x00, 0x82, 0x33,
+  0x9B, 0x85, 0x0A, 0x00, 0x82, 0x34, 0x9B, 0x85, 0xA7, 0x87, 0x0A, 0x00,
+  0x82, 0x35, 0x9B, 0x87, 0x90, 0x03, 0x0A, 0x00, 0x82, 0x36, 0x9B, 0xA1,
+  0x87, 0x0A, 0x00, 0x82, 0x37, 0x9B, 0x8F, 0x0A, 0x00, 0x82, 0x0F, 0x00,
+  0x9B, 0x93, 0x92, 0xB5, 0x6C, 0x6F, 0x74, 0x20, 0x0F, 0x01, 0x0A, 0x00,
+  0x82, 0x44, 0x45, 0x53, 0x43, 0x4F, 0x4E, 0x4F, 0x43, 0x49, 0xB7, 0x0A,
+  0x00, 0xAB, 0x20, 0x42, 0x41, 0x53, 0x45, 0x0A, 0x00, 0xAB, 0x9C, 0x56,
+  0x49, 0x4D, 0x49, 0x45, 0x4E, 0x54, 0x4F, 0x8E, 0x33, 0x30, 0x73, 0x9D,
+  0x00, 0x20, 0x56, 0x41, 0x52, 0x49, 0x41, 0x4E, 0x54, 0x45, 0x20, 0x4D,
+  0x31, 0x91, 0x00, 0x81, 0x0F, 0x00, 0x25, 0x80, 0x8A, 0xA7, 0xB4, 0x69,
+  0xA0, 0x76, 0xA0, 0x69, 0x64, 0x61, 0x8E, 0x63, 0x61, 0x70, 0x99, 0x4D,
+  0x41, 0x58, 0x29, 0x86, 0xAD, 0x70, 0x69, 0x9A, 0x9D, 0x00, 0x81, 0x0F,
+  0x00, 0x25, 0x80, 0x8A, 0x86, 0x6C, 0xA0, 0xB2, 0x9D, 0x00, 0x81, 0x0E,
+  0x46, 0x80, 0x95, 0x8D, 0xB3, 0x0E, 0x3C, 0x89, 0x8B, 0x98, 0x00, 0x81,
+  0x0E, 0x14, 0x80, 0x95, 0x83, 0x0E, 0x05, 0x89, 0x8B, 0x98, 0x00, 0x81,
+  0x0E, 0x5A, 0x80, 0x95, 0x83, 0x0E, 0x32, 0x89, 0x04, 0x83, 0x0E, 0x0A,
+  0x89, 0x05, 0x8D, 0x0E, 0x05, 0x2D, 0x0E, 0x64, 0x8E, 0x76, 0xA3, 0x20,
+  0xA9, 0x61, 0x29, 0x89, 0x06, 0x91, 0x98, 0x00, 0x81, 0x0E, 0x46, 0x80,
+  0x95, 0x83, 0x0E, 0x0A, 0x89, 0x04, 0x91, 0x96, 0xB5, 0x75, 0x61, 0x76,
+  0xA2, 0x0E, 0x0A, 0x2D, 0x0E, 0x32, 0x89, 0x05, 0x83, 0x0E, 0x28, 0x89,
+  0x06, 0x91, 0x98, 0x00, 0x81, 0x0E, 0x5A, 0x80, 0x95, 0x83, 0x0E, 0x28,
+  0xA7, 0xB5, 0x61, 0x6C, 0x75, 0x9A, 0x8E, 0x73, 0x75, 0x62, 0xA2, 0x99,
+  0x0E, 0x50, 0x20, 0xA0, 0x20, 0x32, 0xB1, 0x06, 0x94, 0x73, 0x74, 0xA3,
+  0x6C, 0x99, 0x78, 0x32, 0x29, 0x89, 0xA6, 0x83, 0x0E, 0x50, 0x89, 0x06,
+  0x8D, 0x0E, 0x00, 0x2D, 0x0E, 0x64, 0x0A, 0x00, 0x81, 0x0E, 0x46, 0x80,
+  0x95, 0x83, 0x0E, 0x0A, 0x89, 0x8B, 0x54, 0xA0, 0x75, 0xA2, 0x0E, 0x0A,
+  0xA7, 0x94, 0x73, 0x74, 0xA3, 0x6C, 0x6F, 0x20, 0x61, 0x6C, 0x65, 0x61,
+  0xB2, 0x72, 0x69, 0x6F, 0x0A, 0x00, 0x81, 0x0E, 0x50, 0x80, 0x95, 0x8D,
+  0xB3, 0x0E, 0x5A, 0x89, 0x8B, 0x46, 0x61, 0x64, 0xA2, 0x0E, 0x00, 0x2D,
+  0x0E, 0x05, 0x8E, 0xA9, 0x6F, 0x2D, 0xAD, 0x70, 0x69, 0x9A, 0x9D, 0x00,
+  0x81, 0x0E, 0x46, 0x80, 0x95, 0x83, 0x0E, 0x28, 0x89, 0xA6, 0x2F, 0x06,
+  0x83, 0x0E, 0x0A, 0x0A, 0x00, 0x81, 0x0E, 0x64, 0x80, 0x95, 0x2B, 0x06,
+  0x91, 0x96, 0x94, 0x76, 0x6F, 0x63, 0x69, 0xA5, 0x61, 0x6C, 0x20, 0xB3,
+  0x0E, 0x50, 0x8E, 0x06, 0x94, 0x73, 0x66, 0x61, 0x73, 0x61, 0x9A, 0x2F,
+  0x74, 0xA0, 0x75, 0x65, 0x29, 0x89, 0xA6, 0x83, 0x0E, 0x1E, 0x0A, 0x00,
+  0x81, 0x0E, 0x46, 0x80, 0x95, 0x83, 0x0E, 0x3C, 0x89, 0x4F, 0x4C, 0x41,
+  0x20, 0x4D, 0x41, 0x52, 0x20, 0x63, 0x69, 0x72, 0x63, 0x75, 0x6C, 0x61,
+  0x72, 0x91, 0x06, 0x20, 0x3C, 0x2D, 0x3E, 0x8E, 0x04, 0x2B, 0x05, 0x29,
+  0x20, 0x6A, 0x75, 0x6E, 0xB2, 0x73, 0x89, 0x06, 0x91, 0xAF, 0x99, 0x0E,
+  0x0A, 0x2D, 0x0E, 0x1E, 0x89, 0xA6, 0x91, 0xAF, 0x61, 0x6E, 0x20, 0x0E,
+  0x08, 0x2D, 0x0E, 0x18, 0x8E, 0x73, 0xA4, 0x63, 0x72, 0xA5, 0x69, 0x7A,
+  0x61, 0x9A, 0x73, 0x9D, 0x00, 0x81, 0x0E, 0x5A, 0x80, 0x00, 0x81, 0x0E,
+  0x46, 0x80, 0x00, 0x95, 0x2F, 0x8B, 0x54, 0x69, 0x6D, 0xA3, 0xA4, 0xA2,
+  0x66, 0x69, 0xAC, 0x74, 0x61, 0x8E, 0x0F, 0x00, 0xB1, 0x0F, 0x01, 0xB4,
+  0x79, 0x74, 0xAC, 0xAA, 0x9D, 0x00, 0x20, 0x50, 0x72, 0x6F, 0x67, 0xAD,
+  0x6D, 0x99, 0x56, 0x4D, 0x94, 0x73, 0x64, 0x65, 0x92, 0x8E, 0xA3, 0x20,
+  0x70, 0x72, 0x6F, 0x67, 0xAD, 0x6D, 0x99, 0x6C, 0x65, 0x65, 0x9C, 0x54,
+  0x49, 0x4F, 0x4E, 0x9D, 0x00, 0x20, 0x50, 0x65, 0x72, 0x66, 0x69, 0x6C,
+  0x20, 0x6E, 0x6F, 0x94, 0x66, 0xA4, 0x69, 0x9A, 0x0A, 0x00, 0x84, 0x84,
+  0x84, 0x89, 0x97, 0x97, 0x97, 0x97, 0x43, 0x41, 0x4D, 0x42, 0x49, 0x4F,
+  0x20, 0x44, 0x45, 0x9C, 0xB7, 0x20, 0x2F, 0x9C, 0x44, 0x45, 0x20, 0x43,
+  0x48, 0x41, 0x4E, 0x47, 0xB8, 0x0A, 0x84, 0x84, 0x84, 0x89, 0x20, 0x00,
+  0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x0A, 0x00, 0x44, 0x55, 0x54,
+  0x59, 0x20, 0x4D, 0xB8, 0x49, 0xB7, 0x8E, 0x4C, 0xB8, 0xB1, 0x63, 0x6F,
+  0x6D, 0x61, 0x6E, 0x9A, 0x20, 0x64, 0x75, 0x74, 0x79, 0x9D, 0x00, 0x97,
+  0x62, 0x61, 0x73, 0x65, 0x91, 0x97, 0x97, 0x97, 0x00, 0x97, 0x6D, 0xB0,
+  0xA0, 0xB2, 0x91, 0x00, 0x73, 0xA4, 0x20, 0xA9, 0x72, 0x0A, 0x00, 0x84,
+  0x84, 0x84, 0x0A, 0x00
+};
+
+const UiTextTable UI_TEXT_TABLE = {UI_DICT, UI_TEXT_INDEX, UI_TEXTS, UI_LED_NAMES};
@@ -0,0 +1,124 @@
+#pragma once
+
+// Textos de la consola serie comprimidos con diccionario. Compartido por el
+// firmware (src/virgencitaluces.cpp) y el compilador de host
+// (src/tools/ui_text_compiler.cpp), que genera la tabla desde ui/textos.txt.
+//
+// Cada texto es una secuencia de bytes terminada en 0:
+//   0x20..0x7E        caracter literal
+//   '\n'              fin de linea (se emite "\r\n", igual que println)
+//   UI_TOK_LED + i    nombre del LED i (0..5)
+//   UI_TOK_PCT n      porcentaje literal: "n%"
+//   UI_TOK_ARG k      argumento k en decimal
+//   UI_TOK_ARG3 k     argumento k alineado a la derecha en 3 columnas
+//   UI_TOK_ARGLED k   nombre del LED cuyo indice es el argumento k
+//   0x80 + f          fragmento f del diccionario
+// El diccionario son fragmentos seguidos, cada uno con un byte de longitud
+// delante; un fragmento usa la misma codificacion pero no otros fragmentos.
+// El decodificador escribe byte a byte en la salida, sin buffer.
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#endif
+#ifndef pgm_read_word
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#endif
+#endif
+
+const uint8_t UI_TOK_LED = 0x01;    // 0x01..0x06
+const uint8_t UI_TOK_PCT = 0x0E;
+const uint8_t UI_TOK_ARG = 0x0F;
+const uint8_t UI_TOK_ARG3 = 0x10;
+const uint8_t UI_TOK_ARGLED = 0x11;
+const uint8_t UI_FRAGMENT = 0x80;
+const uint8_t UI_MAX_FRAGMENTS = 128;
+const uint8_t UI_LED_COUNT = 6;
+const uint8_t UI_LED_NAME_BYTES = 5;
+const uint8_t UI_MAX_ARGS = 8;
+
+// Tabla generada (ver ui_textos.h).
+struct UiTextTable {
+  const uint8_t* dict;
+  const uint16_t* index;  // desplazamiento de cada texto en texts
+  const uint8_t* texts;
+  const char (*ledNames)[UI_LED_NAME_BYTES];
+};
+
+template <class Out>
+inline void uiEmitNumber(Out& out, uint16_t v, uint8_t width) {
+  char digits[5];
+  uint8_t n = 0;
+  do {
+    digits[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  while (width > n) {
+    out.write((uint8_t)' ');
+    width--;
+  }
+  while (n) out.write((uint8_t)digits[--n]);
+}
+
+template <class Out>
+inline void uiEmitLedName(Out& out, const UiTextTable& t, uint16_t led) {
+  if (led >= UI_LED_COUNT) return;
+  for (uint8_t i = 0; i < UI_LED_NAME_BYTES; i++) {
+    char c = (char)pgm_read_byte(&t.ledNames[led][i]);
+    if (!c) break;
+    out.write((uint8_t)c);
+  }
+}
+
+// Emite los bytes [p, end) (end = 0: hasta el 0 final). Devuelve el puntero
+// al primer fragmento encontrado (y deja *frag con su numero), o 0 al terminar.
+template <class Out>
+inline const uint8_t* uiEmitRun(Out& out, const UiTextTable& t, const uint8_t* p, const uint8_t* end,
+                                const uint16_t* args, uint8_t& frag) {
+  while (end == 0 || p < end) {
+    uint8_t b = pgm_read_byte(p++);
+    if (b == 0) return 0;
+    if (b >= UI_FRAGMENT) {
+      frag = (uint8_t)(b - UI_FRAGMENT);
+      return p;
+    }
+    if (b == '\n') {
+      out.write((uint8_t)'\r');
+      out.write((uint8_t)'\n');
+    } else if (b >= UI_TOK_LED && b < UI_TOK_LED + UI_LED_COUNT) {
+      uiEmitLedName(out, t, (uint16_t)(b - UI_TOK_LED));
+    } else if (b == UI_TOK_PCT) {
+      uiEmitNumber(out, pgm_read_byte(p++), 0);
+      out.write((uint8_t)'%');
+    } else if (b == UI_TOK_ARG || b == UI_TOK_ARG3 || b == UI_TOK_ARGLED) {
+      uint8_t k = pgm_read_byte(p++);
+      uint16_t v = args ? args[k] : 0;
+      if (b == UI_TOK_ARGLED) uiEmitLedName(out, t, v);
+      else uiEmitNumber(out, v, b == UI_TOK_ARG3 ? 3 : 0);
+    } else {
+      out.write(b);
+    }
+  }
+  return 0;
+}
+
+// Decodifica el texto id directamente en out (cualquier objeto con write(uint8_t)).
+template <class Out>
+inline void uiTextEmit(Out& out, const UiTextTable& t, uint8_t id, const uint16_t* args) {
+  const uint8_t* p = t.texts + pgm_read_word(&t.index[id]);
+  uint8_t frag = 0;
+  while ((p = uiEmitRun(out, t, p, (const uint8_t*)0, args, frag)) != 0) {
+    const uint8_t* f = t.dict;
+    for (uint8_t i = 0; i < frag; i++) f += 1 + pgm_read_byte(f);
+    uint8_t len = pgm_read_byte(f);
+    uint8_t unused;
+    uiEmitRun(out, t, f + 1, f + 1 + len, args, unused);
+  }
+}
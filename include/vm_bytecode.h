@@ -0,0 +1,132 @@
+#pragma once
+
+// Bytecode de escenas para la VM del firmware (src/virgencitaluces.cpp).
+// Compartido con el ensamblador de host (src/tools/vm_assembler.cpp).
+//
+// Maquina de pila de enteros de 16 bits. Los operandos inmediatos siguen al
+// opcode (little endian). Notacion de pila: "a b -> c" (b es la cima).
+//
+// Slot en EEPROM (VM_SLOT_BYTES por slot):
+//   0  'V' 'M'
+//   2  version del formato (VM_BYTECODE_VERSION)
+//   3  revision del programa (libre, la pone quien sube la escena)
+//   4  u16 longitud del codigo
+//   6  u16 CRC-16/CCITT del codigo
+//   8  codigo
+
+#include <stdint.h>
+
+const uint8_t VM_BYTECODE_VERSION = 1;
+const uint8_t VM_HEADER_BYTES = 8;
+const uint16_t VM_SLOT_BYTES = 256;
+const uint16_t VM_MAX_CODE_BYTES = VM_SLOT_BYTES - VM_HEADER_BYTES;
+const uint8_t VM_VAR_COUNT = 4;
+const uint8_t VM_CHANNEL_COUNT = 6;
+
+enum VmOpcode : uint8_t {
+  VM_OP_END = 0,  //                 detiene el programa (los canales conservan su nivel)
+  VM_OP_PUSH8,    // imm8            -> v
+  VM_OP_PUSH16,   // imm16           -> v
+  VM_OP_DUP,      // a -> a a
+  VM_OP_DROP,     // a ->
+  VM_OP_SWAP,     // a b -> b a
+  VM_OP_ADD,      // a b -> a+b
+  VM_OP_SUB,      // a b -> a-b
+  VM_OP_SCALE,    // a b -> a*b/256
+  VM_OP_DEC,      // a -> a-1
+  VM_OP_LOAD,     // imm8 var        -> v
+  VM_OP_STORE,    // imm8 var        v ->
+  VM_OP_JMP,      // imm16 destino
+  VM_OP_JZ,       // imm16 destino   v ->   (salta si v == 0)
+  VM_OP_JNZ,      // imm16 destino   v ->   (salta si v != 0)
+  VM_OP_OUT,      // imm8 canal      nivel ->   (cancela la rampa del canal)
+  VM_OP_RAMP,     // imm8 canal      nivel ms ->   (rampa no bloqueante; repetirla no la reinicia)
+  VM_OP_LEVEL,    // imm8 canal      -> nivel actual
+  VM_OP_WAIT,     // ms ->           suspende el programa (las rampas siguen)
+  VM_OP_YIELD,    //                 suspende hasta el siguiente frame
+  VM_OP_RAND,     // lo hi -> aleatorio en lo..hi
+  VM_OP_OSC,      // imm16 periodo   min max -> triangulo min..max
+  VM_OP_WAVE,     // imm16 periodo   min max -> onda suave (in-out) min..max
+  VM_OP_MOTION,   // -> 1 si el submodo movimiento esta activo, 0 si no
+  VM_OP_INTENSITY, // -> intensidad de movimiento 0..256 (la mezcla base -> movimiento de las escenas)
+  VM_OP_COUNT
+};
+
+// Bytes de operando inmediato de cada opcode.
+inline uint8_t vmImmBytes(uint8_t op) {
+  switch (op) {
+    case VM_OP_PUSH8:
+    case VM_OP_LOAD:
+    case VM_OP_STORE:
+    case VM_OP_OUT:
+    case VM_OP_RAMP:
+    case VM_OP_LEVEL:
+      return 1;
+    case VM_OP_PUSH16:
+    case VM_OP_JMP:
+    case VM_OP_JZ:
+    case VM_OP_JNZ:
+    case VM_OP_OSC:
+    case VM_OP_WAVE:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+inline uint16_t vmCrc16Update(uint16_t crc, uint8_t b) {
+  crc ^= (uint16_t)b << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+enum VmVerifyResult : uint8_t {
+  VM_VERIFY_OK = 0,
+  VM_VERIFY_EMPTY,
+  VM_VERIFY_BAD_OPCODE,
+  VM_VERIFY_TRUNCATED,
+  VM_VERIFY_BAD_OPERAND,
+  VM_VERIFY_BAD_JUMP
+};
+
+// Verificacion estatica: opcodes validos, operandos en rango y saltos a inicio
+// de instruccion. Con esto el interprete solo vigila la pila en ejecucion.
+// fetch(addr) devuelve el byte addr del codigo; errAt recibe la direccion del fallo.
+template <typename Fetch>
+VmVerifyResult vmVerifyProgram(Fetch fetch, uint16_t len, uint16_t& errAt) {
+  errAt = 0;
+  if (len == 0 || len > VM_MAX_CODE_BYTES) return VM_VERIFY_EMPTY;
+  // Mapa de inicios de instruccion (1 bit por byte de codigo).
+  uint8_t starts[(VM_MAX_CODE_BYTES + 7) / 8] = {};
+  for (uint16_t pc = 0; pc < len;) {
+    uint8_t op = fetch(pc);
+    errAt = pc;
+    if (op >= VM_OP_COUNT) return VM_VERIFY_BAD_OPCODE;
+    uint8_t imm = vmImmBytes(op);
+    if (pc + 1 + imm > len) return VM_VERIFY_TRUNCATED;
+    if (imm == 1) {
+      uint8_t v = fetch((uint16_t)(pc + 1));
+      if ((op == VM_OP_LOAD || op == VM_OP_STORE) && v >= VM_VAR_COUNT) return VM_VERIFY_BAD_OPERAND;
+      if ((op == VM_OP_OUT || op == VM_OP_RAMP || op == VM_OP_LEVEL) && v >= VM_CHANNEL_COUNT) return VM_VERIFY_BAD_OPERAND;
+    }
+    if ((op == VM_OP_OSC || op == VM_OP_WAVE) &&
+        (fetch((uint16_t)(pc + 1)) | fetch((uint16_t)(pc + 2))) == 0) {
+      return VM_VERIFY_BAD_OPERAND;  // periodo 0
+    }
+    starts[pc >> 3] |= (uint8_t)(1 << (pc & 7));
+    pc = (uint16_t)(pc + 1 + imm);
+  }
+  for (uint16_t pc = 0; pc < len;) {
+    uint8_t op = fetch(pc);
+    if (op == VM_OP_JMP || op == VM_OP_JZ || op == VM_OP_JNZ) {
+      uint16_t to = (uint16_t)(fetch((uint16_t)(pc + 1)) | ((uint16_t)fetch((uint16_t)(pc + 2)) << 8));
+      errAt = pc;
+      if (to >= len || !(starts[to >> 3] & (1 << (to & 7)))) return VM_VERIFY_BAD_JUMP;
+    }
+    pc = (uint16_t)(pc + 1 + vmImmBytes(op));
+  }
+  errAt = 0;
+  return VM_VERIFY_OK;
+}
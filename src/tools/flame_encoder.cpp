@@ -0,0 +1,277 @@
+// Codificador de llama grabada: intensidad de una llama real -> blob ADPCM
+// para PROGMEM (include/flame_format.h).
+//
+// Uso:
+//   flame_encoder <grabacion.txt> <salida.h> [NOMBRE=FLAME_VELA] [ms_muestra=16] [segundos_max=33]
+//   flame_encoder sintetica <segundos> <salida.txt> [semilla=1]
+//
+// Grabacion: una lectura por linea (p.ej. analogRead de un fotodiodo o una LDR
+// rapida frente a una vela, en una caja oscura), '#' = comentario y una
+// directiva "hz N" con la frecuencia de muestreo (por defecto 200). Las
+// lecturas se remuestrean a ms_muestra (media de cada ventana, que hace de
+// filtro antialias), se normalizan (percentil 99.5 = 255) y se cortan a
+// bloques enteros de FLAME_BLOCK_SAMPLES. El blob se valida decodificandolo
+// con el mismo codigo del firmware y se informa el error.
+//
+// "sintetica" escribe una grabacion de prueba con el mismo formato: deriva
+// lenta, episodios de oscilacion de 9-13 Hz (la llama "bailando") y rafagas
+// que la hunden. Sirve hasta tener una grabacion real.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../include/flame_format.h"
+
+namespace {
+
+[[noreturn]] void fail(const std::string& msg) {
+  std::fprintf(stderr, "error: %s\n", msg.c_str());
+  std::exit(1);
+}
+
+// ==== Grabacion sintetica ====
+
+int writeSynthetic(double seconds, const char* path, unsigned seed) {
+  const int hz = 200;
+  const double dt = 1.0 / hz;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  std::normal_distribution<double> gauss(0.0, 1.0);
+
+  std::ofstream out(path);
+  if (!out) fail(std::string("no se puede escribir ") + path);
+  out << "# Grabacion SINTETICA de llama (flame_encoder sintetica " << seconds << " s, semilla " << seed << ").\n"
+      << "# Sustituir por una captura real: una lectura por linea a 'hz' muestras/s.\n"
+      << "hz " << hz << "\n";
+
+  double base = 0.82;          // deriva lenta (Ornstein-Uhlenbeck, tau 1.5 s)
+  double danceAmp = 0, danceLeft = 0, danceHz = 11, phase = 0;
+  double gust = 0, gustTarget = 0, gustLeft = 0;
+  const long total = (long)(seconds * hz);
+  for (long i = 0; i < total; i++) {
+    base += (0.82 - base) * dt / 1.5 + 0.04 * std::sqrt(2.0 * dt / 1.5) * gauss(rng);
+
+    // Episodio de baile: 0.3..2.5 s, 9..13 Hz, amplitud 5..30%.
+    if (danceLeft <= 0 && uni(rng) < 0.25 * dt) {
+      danceLeft = 0.3 + 2.2 * uni(rng);
+      danceHz = 9.0 + 4.0 * uni(rng);
+      danceAmp = 0.05 + 0.25 * uni(rng);
+    }
+    double dance = 0;
+    if (danceLeft > 0) {
+      danceLeft -= dt;
+      double env = std::min(1.0, std::min(danceLeft, 0.15) / 0.15);
+      phase += 2.0 * M_PI * (danceHz + 0.6 * gauss(rng)) * dt;
+      // La llama se alarga y se acorta: las caidas son mas hondas que los picos.
+      dance = -danceAmp * env * (std::fabs(std::sin(phase)) * 0.8 + 0.2 * std::sin(2.0 * phase));
+    }
+
+    // Rafaga: hunde la llama al 20-50% en ~50 ms y se recupera en 0.15..0.6 s.
+    if (gustLeft <= 0 && uni(rng) < 0.05 * dt) {
+      gustLeft = 0.15 + 0.45 * uni(rng);
+      gustTarget = 0.5 + 0.3 * uni(rng);
+    }
+    if (gustLeft > 0) {
+      gustLeft -= dt;
+      gust += (gustTarget - gust) * dt / 0.05;
+    } else {
+      gust += (0.0 - gust) * dt / 0.25;
+    }
+
+    double v = (base + dance) * (1.0 - gust) + 0.005 * gauss(rng);
+    long adc = std::lround(std::max(0.0, std::min(1.0, v)) * 1023.0);
+    out << adc << "\n";
+  }
+  std::printf("%s: %ld lecturas a %d Hz (%.1f s)\n", path, total, hz, seconds);
+  return 0;
+}
+
+// ==== Codificacion ====
+
+struct Recording {
+  double hz = 200;
+  std::vector<double> values;
+};
+
+Recording readRecording(const char* path) {
+  std::ifstream in(path);
+  if (!in) fail(std::string("no se puede abrir ") + path);
+  Recording rec;
+  int lineNo = 0;
+  for (std::string line; std::getline(in, line);) {
+    lineNo++;
+    size_t hash = line.find('#');
+    if (hash != std::string::npos) line.erase(hash);
+    std::istringstream ls(line);
+    std::string word;
+    if (!(ls >> word)) continue;
+    if (word == "hz") {
+      if (!(ls >> rec.hz) || rec.hz <= 0) fail("linea " + std::to_string(lineNo) + ": hz invalido");
+      continue;
+    }
+    char* end = nullptr;
+    double v = std::strtod(word.c_str(), &end);
+    if (*end) fail("linea " + std::to_string(lineNo) + ": lectura invalida '" + word + "'");
+    rec.values.push_back(v);
+  }
+  return rec;
+}
+
+// Media de cada ventana de sampleMs.
+std::vector<double> resample(const Recording& rec, int sampleMs) {
+  std::vector<double> out;
+  const double perSample = rec.hz * sampleMs / 1000.0;
+  for (size_t k = 0;; k++) {
+    size_t from = (size_t)std::floor(k * perSample), to = (size_t)std::floor((k + 1) * perSample);
+    if (to > rec.values.size()) break;
+    if (to == from) to = from + 1;
+    double acc = 0;
+    for (size_t i = from; i < to; i++) acc += rec.values[i];
+    out.push_back(acc / (double)(to - from));
+  }
+  return out;
+}
+
+const int LOOKAHEAD = 3;
+
+// Error cuadratico minimo de las proximas 'depth' muestras desde (pred, stepIdx).
+long searchError(uint8_t pred, uint8_t stepIdx, const uint8_t* target, int depth, uint8_t* first) {
+  long best = -1;
+  for (uint8_t n = 0; n < 16; n++) {
+    uint8_t idx = stepIdx;
+    uint8_t v = flameApplyNibble(pred, idx, n);
+    long err = (long)(v - target[0]) * (v - target[0]);
+    if (depth > 1 && (best < 0 || err < best)) err += searchError(v, idx, target + 1, depth - 1, nullptr);
+    if (best < 0 || err < best) {
+      best = err;
+      if (first) *first = n;
+    }
+  }
+  return best;
+}
+
+// Nibble de la mejor secuencia de LOOKAHEAD muestras (mismo paso que el
+// decodificador): el paso se adapta a tiempo para los saltos bruscos.
+uint8_t bestNibble(uint8_t pred, uint8_t stepIdx, const uint8_t* target, int remaining) {
+  uint8_t n = 0;
+  searchError(pred, stepIdx, target, std::min(LOOKAHEAD, remaining), &n);
+  return n;
+}
+
+// Indice de paso inicial del bloque: el que cubre el primer salto.
+uint8_t initialStep(int firstDelta) {
+  uint8_t idx = 0;
+  while (idx + 1 < FLAME_STEP_COUNT && FLAME_STEPS[idx] * 4 < std::abs(firstDelta)) idx++;
+  return idx;
+}
+
+std::vector<uint8_t> encode(const std::vector<uint8_t>& samples) {
+  std::vector<uint8_t> blob;
+  for (size_t start = 0; start < samples.size(); start += FLAME_BLOCK_SAMPLES) {
+    uint8_t pred = samples[start];
+    uint8_t stepIdx = initialStep(start + 1 < samples.size() ? samples[start + 1] - samples[start] : 0);
+    blob.push_back(pred);
+    blob.push_back(stepIdx);
+    uint8_t packed = 0;
+    for (uint8_t i = 0; i < FLAME_BLOCK_SAMPLES; i++) {
+      uint8_t n = bestNibble(pred, stepIdx, &samples[start + i], FLAME_BLOCK_SAMPLES - i);
+      pred = flameApplyNibble(pred, stepIdx, n);
+      if (i & 1) blob.push_back((uint8_t)(packed | (n << 4)));
+      else packed = n;
+    }
+  }
+  return blob;
+}
+
+std::string fileName(const std::string& path) {
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc >= 4 && std::string(argv[1]) == "sintetica") {
+    double seconds = std::atof(argv[2]);
+    if (seconds <= 0) fail("segundos invalidos");
+    return writeSynthetic(seconds, argv[3], argc > 4 ? (unsigned)std::atoi(argv[4]) : 1u);
+  }
+  if (argc < 3) {
+    std::fprintf(stderr,
+                 "uso: %s <grabacion.txt> <salida.h> [NOMBRE=FLAME_VELA] [ms_muestra=16] [segundos_max=33]\n"
+                 "     %s sintetica <segundos> <salida.txt> [semilla]\n",
+                 argv[0], argv[0]);
+    return 2;
+  }
+  const std::string symbol = argc > 3 ? argv[3] : "FLAME_VELA";
+  const int sampleMs = argc > 4 ? std::atoi(argv[4]) : 16;
+  const double maxSeconds = argc > 5 ? std::atof(argv[5]) : 33.0;
+  if (sampleMs < 4 || sampleMs > 100) fail("ms_muestra fuera de 4..100");
+
+  Recording rec = readRecording(argv[1]);
+  std::vector<double> res = resample(rec, sampleMs);
+  size_t maxSamples = (size_t)(maxSeconds * 1000.0 / sampleMs);
+  if (res.size() > maxSamples) res.resize(maxSamples);
+  res.resize(res.size() / FLAME_BLOCK_SAMPLES * FLAME_BLOCK_SAMPLES);
+  const size_t blocks = res.size() / FLAME_BLOCK_SAMPLES;
+  if (blocks < FLAME_GRAIN_MAX_BLOCKS) {
+    fail("grabacion corta: hacen falta " + std::to_string(FLAME_GRAIN_MAX_BLOCKS * FLAME_BLOCK_SAMPLES * sampleMs / 1000) +
+         " s como minimo");
+  }
+
+  std::vector<double> sorted = res;
+  std::sort(sorted.begin(), sorted.end());
+  const double peak = sorted[(size_t)(sorted.size() * 0.995)];
+  if (peak <= 0) fail("grabacion sin senal");
+  std::vector<uint8_t> samples(res.size());
+  for (size_t i = 0; i < res.size(); i++) samples[i] = (uint8_t)std::lround(std::min(255.0, res[i] * 255.0 / peak));
+
+  std::vector<uint8_t> blob = encode(samples);
+
+  // Validacion con el decodificador del firmware.
+  double sq = 0;
+  int maxErr = 0;
+  long mean = 0;
+  FlameCursor c;
+  flameSeek(c, blob.data(), 0);
+  for (size_t i = 0; i < samples.size(); i++) {
+    int err = std::abs((int)flameNext(c, blob.data()) - (int)samples[i]);
+    sq += err * err;
+    maxErr = std::max(maxErr, err);
+    mean += samples[i];
+  }
+  const double rms = std::sqrt(sq / samples.size());
+  const double seconds = samples.size() * sampleMs / 1000.0;
+
+  std::ofstream out(argv[2]);
+  if (!out) fail(std::string("no se puede escribir ") + argv[2]);
+  char line[160];
+  out << "#pragma once\n\n";
+  out << "// Generado por src/tools/flame_encoder.cpp desde " << fileName(argv[1]) << ". No editar a mano.\n";
+  std::snprintf(line, sizeof(line), "// %zu muestras de %d ms (%.1f s), %zu bloques; error RMS %.2f, maximo %d.\n",
+                samples.size(), sampleMs, seconds, blocks, rms, maxErr);
+  out << line << "\n#include \"flame_format.h\"\n\n";
+  out << "const uint8_t " << symbol << "_SAMPLE_MS = " << sampleMs << ";\n";
+  out << "const uint16_t " << symbol << "_BLOCKS = " << blocks << ";\n\n";
+  out << "const uint8_t " << symbol << "[] PROGMEM = {";
+  for (size_t i = 0; i < blob.size(); i++) {
+    std::snprintf(line, sizeof(line), "%s0x%02X", i % 12 ? ", " : (i ? ",\n  " : "\n  "), blob[i]);
+    out << line;
+  }
+  out << "\n};\n";
+
+  std::printf("%s: %zu lecturas a %.0f Hz -> %zu muestras de %d ms (%.1f s)\n", argv[1], rec.values.size(), rec.hz,
+              samples.size(), sampleMs, seconds);
+  std::printf("  %zu bloques, %zu bytes (%.2f bits/muestra), intensidad media %ld/255\n", blocks, blob.size(),
+              blob.size() * 8.0 / samples.size(), mean / (long)samples.size());
+  std::printf("  error de decodificacion: RMS %.2f, maximo %d (de 255)\n", rms, maxErr);
+  std::printf("  -> %s (%s, %s_BLOCKS)\n", argv[2], symbol.c_str(), symbol.c_str());
+  return 0;
+}
@@ -0,0 +1,404 @@
+// Banco de tormentas de entradas: boton con rebotes y PIR que chisporrotea.
+//
+// Uso:
+//   input_storm [segundos=60] [pir_hz=20] [pulsaciones_hz=3] [rebotes=6] [gastado_pct=30] [escena_us=600] [semilla=1]
+//
+// Genera una tormenta: flancos de PIR Poisson a pir_hz y pulsaciones Poisson a
+// pulsaciones_hz (al menos 120 ms suelto entre pulsaciones). Cada flanco del
+// boton trae 'rebotes' rebotes de 0.2-8 ms y, con probabilidad gastado_pct, el
+// corte de un contacto gastado: 55-90 ms al nivel contrario, mas que el
+// antirrebote de 50 ms. La tormenta pasa frame a frame por
+// include/input_guard.h, el mismo codigo que usa shrineInputs() en el
+// firmware, tres veces: sin proteccion (como antes), con la del firmware
+// (INPUT_PRESS_MIN_MS, INPUT_SETTLE_MS, INPUT_PIR_LOG_MIN_MS) pero imprimiendo
+// con Serial.print, y con la proteccion y el log en cola del firmware (seccion
+// "Log sin esperas": cada frame escribe solo el hueco libre del buffer TX).
+//
+// El loop del firmware no tiene ritmo fijo: un frame dura lo que cuesta. Aqui
+// cuesta escena_us de render, ~30 us por allLedsOff() y ~6 us de CPU por byte
+// impreso, mas la espera cuando el buffer TX de 64 bytes esta lleno (115200
+// baudios: 86.8 us por byte). El log en cola no espera: regenera la parte en
+// curso en cada pasada (el mismo coste por byte, escrito o descartado). Los
+// textos se miden decodificando la tabla de
+// include/ui_consola.h (snapshot y perfiles de los modos 1-7; escenas VM sin
+// cargar, como de fabrica). Informa percentiles de duracion de frame, huecos
+// de salida (un frame largo congela los LEDs), latencia de muestreo de las
+// entradas y de pulsacion -> modo, y los eventos aceptados, descartados e
+// impresos.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "../../include/input_guard.h"
+#include "../../include/ui_consola.h"
+
+namespace {
+
+const double BYTE_US = 10.0 * 1e6 / 115200.0;
+const uint8_t TX_BUFFER = 64;
+const double BYTE_CPU_US = 6.0;      // Serial.write + decodificacion de la tabla
+const double LEDS_OFF_US = 30.0;     // allLedsOff(): 6 canales
+const double STUTTER_US = 20000.0;   // frame visible como tiron (< 50 Hz)
+const size_t LOG_QUEUE_JOBS = 6;     // LOG_QUEUE_JOBS del firmware
+const size_t LOG_MIN_ROOM = 16;      // LOG_MIN_ROOM
+const double BOUNCE_MIN_MS = 0.2;      // rebote normal del contacto
+const double BOUNCE_MAX_MS = 8.0;
+const double WORN_BEFORE_MIN_MS = 20.0; // contacto gastado: corte tras el flanco
+const double WORN_BEFORE_MAX_MS = 80.0;
+const double WORN_CUT_MIN_MS = 55.0;    // mas largo que el antirrebote
+const double WORN_CUT_MAX_MS = 90.0;
+const double HOLD_MIN_MS = 80.0;
+const double HOLD_MAX_MS = 250.0;
+const double RELEASE_MIN_MS = 120.0; // nadie vuelve a pulsar antes
+const uint8_t MODES = 7;             // modos 1-7 (escenas VM sin cargar)
+const uint32_t DEBOUNCE_MS = 50;     // DEBOUNCE_DELAY
+const uint16_t MOTION_HOLD_MS = 15000;  // MOTION_* del firmware (MOTION_BLEND 1)
+const uint8_t MOTION_GAIN_PCT = 60;
+const uint16_t MOTION_ATTACK_MS = 1200;
+const uint16_t MOTION_DECAY_MS = 25000;
+
+const char* const LINE_MOTION = ">>> MOVIMIENTO DETECTADO: SUBMODO ACTIVO <<<";
+const char* const LINE_RETRIGGER = ">>> PIR ALTO (refuerzo, carga 100%) <<<";
+const char* const LINE_PIR_LOW = ">>> PIR bajo (esperando timeout) <<<";
+const char* const LINE_TIMEOUT = ">>> Timeout de movimiento (volviendo a modo base) <<<";
+const char* const MODE1_NAME = "Balanceado"; // MODE1_PROFILE_INDEX
+
+struct CountOut {
+  size_t n = 0;
+  void write(uint8_t) { n++; }
+};
+
+size_t textBytes(UiText id, const uint16_t* args = nullptr) {
+  CountOut c;
+  uiTextEmit(c, UI_TEXT_TABLE, id, args);
+  return c.n;
+}
+
+size_t lineBytes(const char* s) {
+  size_t n = 0;
+  while (s[n]) n++;
+  return n + 2; // println: "\r\n"
+}
+
+// printModeProfile() (argumentos representativos: mismas columnas).
+size_t profileBytes(uint8_t mode, bool movement) {
+  size_t n = textBytes(movement ? UI_PERFIL_MOVIMIENTO : UI_PERFIL_BASE);
+  const uint16_t m1[] = {75, 35, 65, 45, 55};
+  const uint16_t m7[] = {60, 300};
+  switch (mode) {
+    case 0: return n + textBytes(UI_M1_VARIANTE) + lineBytes(MODE1_NAME) + textBytes(movement ? UI_M1_MOVIMIENTO : UI_M1_BASE, m1);
+    case 1: return n + textBytes(movement ? UI_M2_MOVIMIENTO : UI_M2_BASE);
+    case 2: return n + textBytes(movement ? UI_M3_MOVIMIENTO : UI_M3_BASE);
+    case 3: return n + textBytes(movement ? UI_M4_MOVIMIENTO : UI_M4_BASE);
+    case 4: return n + textBytes(movement ? UI_M5_MOVIMIENTO : UI_M5_BASE);
+    case 5: return n + textBytes(movement ? UI_M6_MOVIMIENTO : UI_M6_BASE);
+    default: return n + textBytes(movement ? UI_M7_MOVIMIENTO : UI_M7_BASE) + textBytes(UI_M7_TIMELINE, m7);
+  }
+}
+
+typedef std::vector<size_t> LogParts; // bytes de cada parte de un trabajo del log
+
+// printModeSnapshotPart(), parte a parte.
+LogParts snapshotParts(uint8_t mode) {
+  return {10 * 2 + textBytes(UI_SNAPSHOT_CABECERA),
+          textBytes((UiText)(UI_MODO_1 + mode)),
+          textBytes(UI_SEPARADOR) + textBytes(UI_DUTY_CABECERA),
+          textBytes(UI_DUTY_BASE) + lineBytes("21.3% 25.6 mA en 1260 s"), // printSnapshotDutyLine()
+          textBytes(UI_DUTY_MOV) + lineBytes("33.7% 40.5 mA en 170 s"),
+          textBytes(UI_SEPARADOR) + profileBytes(mode, false),
+          textBytes(UI_SEPARADOR) + profileBytes(mode, true) + textBytes(UI_CIERRE)};
+}
+
+size_t totalBytes(const LogParts& parts) {
+  size_t n = 0;
+  for (size_t b : parts) n += b;
+  return n;
+}
+
+// Aviso de PIR con los flancos agrupados (printPirFolded()).
+size_t pirLineBytes(const char* s, uint16_t folded) {
+  size_t n = lineBytes(s);
+  if (folded) n += std::snprintf(nullptr, 0, " [+%u flancos de PIR]", (unsigned)folded);
+  return n;
+}
+
+struct Edge {
+  double atUs;
+  uint8_t level;
+};
+
+struct Storm {
+  std::vector<Edge> button;   // niveles crudos del pin (0 = pulsado)
+  std::vector<Edge> pir;
+  std::vector<double> presses; // inicio de cada pulsacion fisica
+};
+
+Storm makeStorm(double seconds, double pirHz, double pressHz, int bounces, double wornPct, unsigned seed) {
+  Storm s;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  auto gap = [&](double hz) { return -std::log(1.0 - uni(rng)) / hz * 1e6; };
+  auto between = [&](double lo, double hi) { return (lo + (hi - lo) * uni(rng)) * 1000.0; };
+  const double endUs = seconds * 1e6;
+
+  if (pirHz > 0) {
+    uint8_t level = 0;
+    for (double t = gap(pirHz); t < endUs; t += gap(pirHz)) {
+      level ^= 1;
+      s.pir.push_back({t, level});
+    }
+  }
+  // Un flanco del boton hacia 'level': rebotes cortos y, en un contacto
+  // gastado, un corte largo poco despues.
+  auto contact = [&](double& t, uint8_t level) {
+    s.button.push_back({t, level});
+    for (int b = 0; b < bounces; b++) {
+      t += between(BOUNCE_MIN_MS, BOUNCE_MAX_MS);
+      s.button.push_back({t, (uint8_t)(level ^ 1)});
+      t += between(BOUNCE_MIN_MS, BOUNCE_MAX_MS);
+      s.button.push_back({t, level});
+    }
+    if (uni(rng) * 100.0 < wornPct) {
+      t += between(WORN_BEFORE_MIN_MS, WORN_BEFORE_MAX_MS);
+      s.button.push_back({t, (uint8_t)(level ^ 1)});
+      t += between(WORN_CUT_MIN_MS, WORN_CUT_MAX_MS);
+      s.button.push_back({t, level});
+    }
+  };
+  if (pressHz > 0) {
+    double t = gap(pressHz);
+    while (t < endUs) {
+      s.presses.push_back(t);
+      contact(t, 0);
+      t += between(HOLD_MIN_MS, HOLD_MAX_MS);
+      contact(t, 1);
+      t += RELEASE_MIN_MS * 1000.0 + gap(pressHz);
+    }
+  }
+  return s;
+}
+
+// UART con buffer TX de 64 bytes: write() espera si esta lleno.
+struct Uart {
+  double busyUntil = 0; // fin de la transmision de lo ya encolado
+  size_t bytes = 0;
+
+  // Escribe n bytes a partir de t; devuelve el instante en que vuelve write().
+  double write(double t, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      t += BYTE_CPU_US;
+      double full = busyUntil - (TX_BUFFER - 1) * BYTE_US; // hueco para un byte mas
+      if (t < full) t = full;
+      busyUntil = std::max(busyUntil, t) + BYTE_US;
+    }
+    bytes += n;
+    return t;
+  }
+
+  // Serial.availableForWrite() en t.
+  size_t room(double t) const {
+    size_t queued = busyUntil > t ? (size_t)std::ceil((busyUntil - t) / BYTE_US) : 0;
+    return queued < TX_BUFFER - 1 ? TX_BUFFER - 1 - queued : 0;
+  }
+};
+
+// Log en cola del firmware (logSpoolPush/logSpoolPump).
+struct LogSpool {
+  std::deque<LogParts> jobs;
+  size_t part = 0; // parte en curso del primer trabajo
+  size_t sent = 0; // bytes de esa parte ya escritos
+  long flushes = 0; // cola llena: vaciada esperando
+
+  // Lo que cabe ahora en el buffer TX; devuelve el instante al terminar.
+  double pump(Uart& uart, double t) {
+    while (!jobs.empty()) {
+      const LogParts& parts = jobs.front();
+      if (part == parts.size()) {
+        jobs.pop_front();
+        part = sent = 0;
+        continue;
+      }
+      size_t room = uart.room(t);
+      if (room < LOG_MIN_ROOM) break;
+      size_t total = parts[part];
+      if (sent == 0) { // pasada de prueba: entera si cabe en el buffer
+        t += total * BYTE_CPU_US;
+        if (total > room && total < TX_BUFFER) break;
+      }
+      size_t n = std::min(room, total - sent);
+      t = uart.write(t + (total - n) * BYTE_CPU_US, n); // regenera la parte y descarta el resto
+      sent += n;
+      if (sent < total) break;
+      part++;
+      sent = 0;
+    }
+    return t;
+  }
+
+  // Todo lo pendiente, esperando al puerto (logSpoolFlush()).
+  double flush(Uart& uart, double t) {
+    flushes++;
+    for (; !jobs.empty(); jobs.pop_front(), part = sent = 0) {
+      const LogParts& parts = jobs.front();
+      for (; part < parts.size(); part++, sent = 0) t = uart.write(t, parts[part] - sent);
+    }
+    return t;
+  }
+
+  double push(Uart& uart, double t, LogParts parts) {
+    if (jobs.size() == LOG_QUEUE_JOBS) t = flush(uart, t);
+    jobs.push_back(parts);
+    return t;
+  }
+};
+
+struct Stats {
+  std::vector<double> frames;
+  std::vector<double> sampleLatency; // flanco fisico -> primera lectura
+  std::vector<double> modeLatency;   // pulsacion fisica -> cambio de modo
+  double stutterUs = 0;
+  long accepted = 0;
+  long phantom = 0;
+  long dropped = 0;
+  long snapshots = 0;
+  long pirLines = 0;
+  long motionStarts = 0;
+  long logFlushes = 0;
+  size_t serialBytes = 0;
+};
+
+// spool = false: cada aviso con Serial.print (espera si el buffer esta lleno).
+Stats run(const Storm& storm, const InputGuardConfig& cfg, double seconds, double sceneUs, bool spool) {
+  Stats st;
+  InputGuard g;
+  inputBegin(g, 0);
+  Uart uart;
+  LogSpool log;
+  auto emit = [&](double at, LogParts parts) {
+    return spool ? log.push(uart, at, parts) : uart.write(at, totalBytes(parts));
+  };
+  uint8_t mode = 0;
+  size_t bi = 0, pi = 0, nextPress = 0, nextSample = 0;
+  uint8_t button = 1, pir = 0;
+  std::vector<double> edges; // todos los flancos, para la latencia de muestreo
+  for (const Edge& e : storm.button) edges.push_back(e.atUs);
+  for (const Edge& e : storm.pir) edges.push_back(e.atUs);
+  std::sort(edges.begin(), edges.end());
+
+  const double endUs = seconds * 1e6;
+  double t = 0;
+  while (t < endUs) {
+    while (bi < storm.button.size() && storm.button[bi].atUs <= t) button = storm.button[bi++].level;
+    while (pi < storm.pir.size() && storm.pir[pi].atUs <= t) pir = storm.pir[pi++].level;
+    while (nextSample < edges.size() && edges[nextSample] <= t) st.sampleLatency.push_back(t - edges[nextSample++]);
+
+    uint8_t r = inputStep(g, cfg, (uint32_t)(t / 1000.0), button, pir != 0);
+    double now = t;
+    if (r & INPUT_PRESS) {
+      mode = (uint8_t)((mode + 1) % MODES);
+      now += LEDS_OFF_US;
+      st.accepted++;
+      // Atribuye el cambio a la pulsacion fisica mas antigua sin atender;
+      // si no la hay, es un rebote que paso el antirrebote.
+      if (nextPress < storm.presses.size() && storm.presses[nextPress] <= t) {
+        st.modeLatency.push_back(t - storm.presses[nextPress]);
+        while (nextPress < storm.presses.size() && storm.presses[nextPress] <= t) nextPress++;
+      } else {
+        st.phantom++;
+      }
+    }
+    if (r & INPUT_SNAPSHOT) {
+      now = emit(now, snapshotParts(mode));
+      st.snapshots++;
+    }
+    if (r & INPUT_MOTION_START) {
+      now = emit(now, {lineBytes(LINE_MOTION), profileBytes(mode, true)});
+      st.motionStarts++;
+    }
+    if (r & INPUT_PIR_RETRIGGER) {
+      now = emit(now, {pirLineBytes(LINE_RETRIGGER, g.pirFolded)});
+      st.pirLines++;
+    }
+    if (r & INPUT_PIR_LOW) {
+      now = emit(now, {pirLineBytes(LINE_PIR_LOW, g.pirFolded)});
+      st.pirLines++;
+    }
+    if (r & INPUT_TIMEOUT) now = emit(now, {lineBytes(LINE_TIMEOUT), profileBytes(mode, false)});
+    now += sceneUs;
+    if (spool) now = log.pump(uart, now);
+
+    double frame = now - t;
+    st.frames.push_back(frame);
+    if (frame > STUTTER_US) st.stutterUs += frame;
+    t = now;
+  }
+  st.dropped = g.pressesDropped;
+  st.logFlushes = log.flushes;
+  st.serialBytes = uart.bytes;
+  return st;
+}
+
+double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+  return v[i];
+}
+
+void report(const char* name, const Stats& st, double seconds) {
+  std::printf("  %s\n", name);
+  std::printf("    frame (ms)          p50 %6.2f  p95 %6.2f  p99 %6.2f  max %7.2f  (%zu frames)\n",
+              percentile(st.frames, 0.50) / 1000, percentile(st.frames, 0.95) / 1000,
+              percentile(st.frames, 0.99) / 1000, percentile(st.frames, 1.0) / 1000, st.frames.size());
+  std::printf("    salida congelada    %.2f%% del tiempo en frames > %.0f ms\n", 100.0 * st.stutterUs / (seconds * 1e6),
+              STUTTER_US / 1000);
+  std::printf("    muestreo (ms)       p50 %6.2f  p99 %6.2f  max %7.2f\n", percentile(st.sampleLatency, 0.50) / 1000,
+              percentile(st.sampleLatency, 0.99) / 1000, percentile(st.sampleLatency, 1.0) / 1000);
+  std::printf("    pulsacion->modo (ms) p50 %6.1f  p99 %6.1f  max %7.1f\n", percentile(st.modeLatency, 0.50) / 1000,
+              percentile(st.modeLatency, 0.99) / 1000, percentile(st.modeLatency, 1.0) / 1000);
+  std::printf("    pulsaciones         %ld aceptadas (%ld por rebote), %ld descartadas, %ld snapshots\n", st.accepted,
+              st.phantom, st.dropped, st.snapshots);
+  std::printf("    PIR                 %ld ventanas, %ld avisos\n", st.motionStarts, st.pirLines);
+  std::printf("    serie               %zu bytes (%.0f%% de la UART), %ld veces la cola llena\n", st.serialBytes,
+              100.0 * st.serialBytes * BYTE_US / (seconds * 1e6), st.logFlushes);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+  const double pirHz = argc > 2 ? std::atof(argv[2]) : 20.0;
+  const double pressHz = argc > 3 ? std::atof(argv[3]) : 3.0;
+  const int bounces = argc > 4 ? std::atoi(argv[4]) : 6;
+  const double wornPct = argc > 5 ? std::atof(argv[5]) : 30.0;
+  const double sceneUs = argc > 6 ? std::atof(argv[6]) : 600.0;
+  const unsigned seed = argc > 7 ? (unsigned)std::atoi(argv[7]) : 1;
+  if (seconds <= 0 || pirHz < 0 || pressHz < 0 || bounces < 0 || wornPct < 0 || wornPct > 100 || sceneUs <= 0) {
+    std::fprintf(stderr, "uso: %s [segundos] [pir_hz] [pulsaciones_hz] [rebotes] [gastado_pct] [escena_us] [semilla]\n",
+                 argv[0]);
+    return 2;
+  }
+
+  const Storm storm = makeStorm(seconds, pirHz, pressHz, bounces, wornPct, seed);
+  const uint32_t gain = motionGainPct(MOTION_GAIN_PCT);
+  const uint32_t attack = motionRatePerMs(MOTION_ATTACK_MS), decay = motionRatePerMs(MOTION_DECAY_MS);
+  const InputGuardConfig unguarded = {DEBOUNCE_MS, MOTION_HOLD_MS, 0, 0, 0, gain, attack, decay};
+  const InputGuardConfig guarded = {DEBOUNCE_MS, MOTION_HOLD_MS, INPUT_PRESS_MIN_MS, INPUT_SETTLE_MS, INPUT_PIR_LOG_MIN_MS,
+                                    gain, attack, decay};
+
+  std::printf("input_storm: %.0f s, PIR %.1f flancos/s, %.1f pulsaciones/s con %d rebotes (%.0f%% gastadas), escena %.0f us\n",
+              seconds, pirHz, pressHz, bounces, wornPct, sceneUs);
+  std::printf("  tormenta: %zu flancos de PIR, %zu pulsaciones (%zu flancos de boton); snapshot ~%zu bytes\n\n",
+              storm.pir.size(), storm.presses.size(), storm.button.size(), totalBytes(snapshotParts(0)));
+  report("sin proteccion", run(storm, unguarded, seconds, sceneUs, false), seconds);
+  std::printf("\n");
+  report("con proteccion, log con Serial.print", run(storm, guarded, seconds, sceneUs, false), seconds);
+  std::printf("\n");
+  report("con proteccion y log en cola (firmware)", run(storm, guarded, seconds, sceneUs, true), seconds);
+  return 0;
+}
@@ -0,0 +1,121 @@
+// Simulador de consumo del reposo por inactividad: corriente media por estado.
+//
+// Uso:
+//   power_sim [dias=7] [visitas_hora_dia=6] [visitas_hora_noche=0.5] [idle_min=15] [suelo_pct=0]
+//
+// Simula dias completos en pasos de 1 s con visitas aleatorias (Poisson; de
+// dia 8-21 h, de noche el resto). Cada visita dispara el PIR y abre la ventana
+// de movimiento de 30 s; el reposo sigue la misma politica que el firmware
+// (SLEEP_IDLE_MIN, SLEEP_FADE_MS, SLEEP_FLOOR_PCT). Las corrientes salen de
+// include/power_model.h. Los niveles medios de escena son los del Modo 1
+// (base y movimiento) medidos sobre el firmware; para otros modos, leer los
+// niveles con el comando "sleep" y cambiarlos aqui.
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "../../include/power_model.h"
+
+namespace {
+
+const uint8_t MODE1_BASE_LEVELS[POWER_CHANNEL_COUNT] = {52, 41, 65, 31, 32, 31};
+const uint8_t MODE1_MOVE_LEVELS[POWER_CHANNEL_COUNT] = {113, 89, 133, 79, 79, 79};
+const long MOVEMENT_S = 30;      // un flanco suelto: MOTION_HOLD_MS + bajada (MOVEMENT_TIMEOUT_MS con MOTION_BLEND 0)
+const long FADE_S = 4;           // SLEEP_FADE_MS
+const long DAY_S = 24L * 3600L;
+
+const char* const STATE_NAMES[POWER_STATE_COUNT] = {"activo", "bajando", "idle al suelo", "power-down"};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int days = argc > 1 ? std::atoi(argv[1]) : 7;
+  const double dayRate = argc > 2 ? std::atof(argv[2]) : 6.0;
+  const double nightRate = argc > 3 ? std::atof(argv[3]) : 0.5;
+  const long idleMin = argc > 4 ? std::atol(argv[4]) : 15;
+  const int floorPct = argc > 5 ? std::atoi(argv[5]) : 0;
+  if (days < 1 || idleMin < 1 || floorPct < 0 || floorPct > 100) {
+    std::fprintf(stderr, "uso: %s [dias] [visitas_hora_dia] [visitas_hora_noche] [idle_min] [suelo_pct]\n", argv[0]);
+    return 2;
+  }
+  const long idleS = idleMin * 60;
+  const uint8_t floorQ8 = (uint8_t)((floorPct * 255 + 50) / 100);
+  const PowerState sleepState = floorPct == 0 ? POWER_SLEEP_OFF : POWER_SLEEP_FLOOR;
+
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+  double stateSeconds[POWER_STATE_COUNT] = {};
+  double stateUaSeconds[POWER_STATE_COUNT] = {};
+  double alwaysOnUaSeconds = 0;
+  long visits = 0;
+  long sleeps = 0;
+  long motionLeft = 0;     // s de ventana de movimiento restantes
+  long idle = 0;           // s sin actividad
+  bool asleep = false;
+
+  const uint32_t baseLed = powerLedUa(MODE1_BASE_LEVELS, 255);
+  const uint32_t moveLed = powerLedUa(MODE1_MOVE_LEVELS, 255);
+
+  for (long t = 0; t < days * DAY_S; t++) {
+    long hour = (t % DAY_S) / 3600;
+    double rate = (hour >= 8 && hour < 21) ? dayRate : nightRate;
+    if (uni(rng) < rate / 3600.0) {
+      visits++;
+      motionLeft = MOVEMENT_S;  // cada flanco renueva la ventana (un flanco suelto: ~30 s de intensidad)
+      asleep = false;                                // el PIR despierta
+    }
+
+    PowerState s;
+    uint32_t ua;
+    if (motionLeft > 0) {
+      motionLeft--;
+      idle = 0;
+      s = POWER_ACTIVE;
+      ua = powerStateUa(s, moveLed);
+      alwaysOnUaSeconds += ua;
+    } else {
+      alwaysOnUaSeconds += powerStateUa(POWER_ACTIVE, baseLed);
+      if (!asleep && idle >= idleS + FADE_S) {
+        asleep = true;
+        sleeps++;
+      }
+      if (asleep) {
+        s = sleepState;
+        ua = powerStateUa(s, powerLedUa(MODE1_BASE_LEVELS, floorQ8));
+      } else if (idle >= idleS) {
+        // Bajada lineal 255 -> suelo: nivel medio del segundo en curso.
+        long into = idle - idleS;
+        uint8_t dim = (uint8_t)(255 - (255 - floorQ8) * (2 * into + 1) / (2 * FADE_S));
+        s = POWER_FADING;
+        ua = powerStateUa(s, powerLedUa(MODE1_BASE_LEVELS, dim));
+      } else {
+        s = POWER_ACTIVE;
+        ua = powerStateUa(s, baseLed);
+      }
+      idle++;
+    }
+    stateSeconds[s] += 1;
+    stateUaSeconds[s] += ua;
+  }
+
+  const double total = (double)days * DAY_S;
+  double sumUaSeconds = 0;
+  for (double v : stateUaSeconds) sumUaSeconds += v;
+  std::printf("power_sim: %d dias, visitas/h dia %.2f noche %.2f, reposo tras %ld min, suelo %d%%\n", days, dayRate,
+              nightRate, idleMin, floorPct);
+  std::printf("  visitas: %ld, reposos: %ld (%.1f por dia)\n\n", visits, sleeps, sleeps / (double)days);
+  std::printf("  estado         | horas/dia | corriente media\n");
+  for (int s = 0; s < POWER_STATE_COUNT; s++) {
+    if (stateSeconds[s] == 0) continue;
+    std::printf("  %-14s | %9.2f | %8.2f mA\n", STATE_NAMES[s], stateSeconds[s] / days / 3600.0,
+                stateUaSeconds[s] / stateSeconds[s] / 1000.0);
+  }
+  const double avgMa = sumUaSeconds / total / 1000.0;
+  const double alwaysMa = alwaysOnUaSeconds / total / 1000.0;
+  std::printf("\n  media total: %.2f mA (%.0f mAh/dia)\n", avgMa, avgMa * 24.0);
+  std::printf("  sin reposo:  %.2f mA (%.0f mAh/dia) -> ahorro %.0f%%\n", alwaysMa, alwaysMa * 24.0,
+              100.0 * (1.0 - avgMa / alwaysMa));
+  return 0;
+}
@@ -0,0 +1,749 @@
+// Barrido de parametros de efectos en host: miles de combinaciones en paralelo
+// con una puntuacion de suavidad y una tabla ordenada.
+//
+// Uso:
+//   profile_sweep <vela|modo1|modo5|modo6> [minutos=3] [hilos=0] [top=15]
+//   profile_sweep escala <familia> [minutos=1]
+//   profile_sweep duty [minutos=10]
+//
+// Cada combinacion se simula milisegundo a milisegundo con los nucleos del
+// firmware (include/effect_kernels.h: candelita, deriva, fade y ondas), con el
+// mismo generador que avr-libc y la misma semilla para todas (las diferencias
+// vienen de los parametros, no del azar). hilos=0 usa todos los nucleos.
+//
+// Familias:
+//   vela   coeficientes del parpadeo (CANDLE_COEFS) sobre la candelita al 80%.
+//   modo1  deriva de CARA base + halo de la triada (MODE1_PROFILES, Balanceado).
+//   modo5  fades de CARA y FIZO/FDEP (MODE5_*).
+//   modo6  ola de mar ATRA / FIZO+FDEP (MODE6_OLA_*).
+//
+// Metricas por canal (se toma el peor canal de la escena):
+//   dL*     mayor salto visible entre dos ms (claridad CIE L* del duty).
+//   dPWM    mayor salto en cuentas de PWM.
+//   bajo/s  cambios por segundo mientras el nivel esta en <= 25 (~10%): a poco
+//           brillo cada cuenta se ve como escalon.
+//   4-12Hz  fraccion de la potencia de parpadeo (L* a 100 Hz, FFT de 1024 con
+//           ventana de Hann) en 4-12 Hz, donde el parpadeo molesta mas.
+//   tope    fraccion del tiempo pegado al suelo o al techo del rango.
+// Puntuacion (menor = mejor): dL*/4 + bajo/s/10 + 4-12Hz*2 + tope*2. Una escena
+// quieta puntua perfecto, asi que cada familia exige una actividad minima
+// (desviacion de L*); las combinaciones por debajo se descartan.
+//
+// duty: corre cada modo por el motor de escena del firmware
+// (include/shrine_engine.h: candelita, fades, destellos, timeline, VM y la
+// mezcla base -> movimiento) con un guion de visitas al PIR, pasa la salida
+// por el gobernador (include/power_governor.h) y la cuenta con
+// include/duty_meter.h por escena (shrineSceneKey), igual que el comando
+// "duty" del firmware: duty y corriente media, pico, recortes y duty por canal.
+// El Modo 8 corre una escena VM de ejemplo; los slots 9-10 van vacios.
+//
+// Reparto: una cola por hilo; el dueno saca del final y, cuando se queda sin
+// trabajo, roba del principio de la cola de otro (work stealing). Al final se
+// imprime el rendimiento en horas simuladas por segundo.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../include/duty_meter.h"
+#include "../../include/effect_kernels.h"
+#include "../../include/power_governor.h"
+#include "../../include/shrine_engine.h"
+
+namespace {
+
+const uint8_t LOW_LEVEL_PWM = 25;
+const int FFT_N = 1024;
+const int SAMPLE_MS = 10;  // 100 Hz
+
+// random() de avr-libc (Park-Miller, metodo de Schrage) y random(lo, hi) de Arduino.
+struct AvrRng {
+  uint32_t state = 1;
+  long next() {
+    long hi = (long)state / 127773L, lo = (long)state % 127773L;
+    long x = 16807L * lo - 2836L * hi;
+    if (x < 0) x += 0x7fffffffL;
+    state = (uint32_t)x;
+    if (state == 0) state = 123459876UL;
+    return (long)(state % 0x80000000UL);
+  }
+  long operator()(long lo, long hi) {
+    if (lo >= hi) return lo;
+    return lo + next() % (hi - lo);
+  }
+};
+
+enum Family { FAM_VELA, FAM_MODO1, FAM_MODO5, FAM_MODO6 };
+
+const char* const FAMILY_NAMES[] = {"vela", "modo1", "modo5", "modo6"};
+const double MIN_ACTIVITY_LSTAR[] = {4.0, 1.5, 5.0, 2.0};  // desviacion minima de L*
+
+struct Candidate {
+  Family fam;
+  // vela
+  CandleCoefs k;
+  // modo1 (CARA base + halo base)
+  uint16_t caraTargetMinMs, caraTargetMaxMs;
+  uint8_t caraStepMaxPct;
+  uint16_t caraStepIntervalMs;
+  uint8_t haloPeakPct;
+  uint32_t haloPeriodMs;
+  // modo5
+  uint8_t caraMinPct, caraMaxPct;
+  uint16_t caraSpeedMs, frenteSpeedMs;
+  // modo6
+  uint8_t atraMinPct, atraMaxPct, grupoMinPct, grupoMaxPct;
+  uint32_t olaPeriodMs;
+};
+
+struct Result {
+  double dLstar = 0, lowRate = 0, band = 0, edge = 0, activity = 0, score = 0;
+  int dPwm = 0;
+  bool rejected = false;
+};
+
+// ==== Grids (alrededor de los valores del firmware) ====
+
+std::vector<Candidate> buildGrid(Family fam) {
+  std::vector<Candidate> out;
+  Candidate c{};
+  c.fam = fam;
+  if (fam == FAM_VELA) {
+    const uint8_t intervals[][2] = {{10, 40}, {15, 55}, {20, 70}, {25, 90}, {35, 110}};
+    const uint8_t bases[] = {25, 35, 45};
+    const uint8_t drops[] = {60, 75, 86};
+    const uint8_t tenths[] = {1, 2, 3, 4};
+    const uint8_t snaps[][2] = {{12, 8}, {5, 3}, {0, 0}};
+    const uint8_t smooth1[][2] = {{1, 3}, {1, 2}, {2, 3}, {3, 4}};
+    const uint8_t smooth2[][2] = {{3, 4}, {2, 3}, {7, 8}};
+    for (auto& iv : intervals)
+      for (uint8_t b : bases)
+        for (uint8_t d : drops)
+          for (uint8_t t : tenths)
+            for (auto& sn : snaps)
+              for (auto& s1 : smooth1)
+                for (auto& s2 : smooth2) {
+                  c.k = CandleCoefs{iv[0], iv[1], b, d, t, sn[0], sn[1], s1[0], s1[1], s2[0], s2[1]};
+                  out.push_back(c);
+                }
+  } else if (fam == FAM_MODO1) {
+    const uint16_t targetMins[] = {500, 900, 1300, 1800};
+    const uint8_t stepMaxes[] = {1, 2, 3};
+    const uint16_t stepIntervals[] = {20, 30, 45, 60, 80};
+    const uint8_t peaks[] = {16, 22, 28};
+    const uint32_t periods[] = {6000, 9000, 12000};
+    for (uint16_t tm : targetMins)
+      for (uint8_t f = 2; f <= 3; f++)
+        for (uint8_t sm : stepMaxes)
+          for (uint16_t si : stepIntervals)
+            for (uint8_t pk : peaks)
+              for (uint32_t per : periods) {
+                c.caraTargetMinMs = tm;
+                c.caraTargetMaxMs = (uint16_t)(tm * f + tm / 2);
+                c.caraStepMaxPct = sm;
+                c.caraStepIntervalMs = si;
+                c.haloPeakPct = pk;
+                c.haloPeriodMs = per;
+                out.push_back(c);
+              }
+  } else if (fam == FAM_MODO5) {
+    const uint8_t mins[] = {30, 40, 50};
+    const uint8_t maxes[] = {70, 80, 90, 100};
+    const uint16_t speeds[] = {20, 25, 30, 35, 45, 60, 80};
+    const uint16_t frente[] = {16, 24, 32, 48, 64};
+    for (uint8_t mn : mins)
+      for (uint8_t mx : maxes)
+        for (uint16_t sp : speeds)
+          for (uint16_t fs : frente) {
+            c.caraMinPct = mn;
+            c.caraMaxPct = mx;
+            c.caraSpeedMs = sp;
+            c.frenteSpeedMs = fs;
+            out.push_back(c);
+          }
+  } else {
+    const uint8_t atraMins[] = {5, 10, 15};
+    const uint8_t atraMaxes[] = {20, 30, 40};
+    const uint8_t grupoMins[] = {4, 8, 12};
+    const uint8_t grupoMaxes[] = {16, 24, 32};
+    const uint32_t periods[] = {3000, 4000, 5200, 6500, 8000};
+    for (uint8_t a0 : atraMins)
+      for (uint8_t a1 : atraMaxes)
+        for (uint8_t g0 : grupoMins)
+          for (uint8_t g1 : grupoMaxes)
+            for (uint32_t per : periods) {
+              c.atraMinPct = a0;
+              c.atraMaxPct = a1;
+              c.grupoMinPct = g0;
+              c.grupoMaxPct = g1;
+              c.olaPeriodMs = per;
+              out.push_back(c);
+            }
+  }
+  return out;
+}
+
+// ==== Metricas ====
+
+double lstarOfPwm(int pwm) {
+  double y = pwm / 255.0;
+  return y <= 0.008856 ? 903.3 * y : 116.0 * std::cbrt(y) - 16.0;
+}
+
+struct LstarTable {
+  double v[256];
+  LstarTable() {
+    for (int i = 0; i < 256; i++) v[i] = lstarOfPwm(i);
+  }
+};
+const LstarTable LSTAR;
+
+void fft(std::vector<std::complex<double>>& a) {
+  const size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(a[i], a[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    double ang = -2.0 * M_PI / (double)len;
+    std::complex<double> wl(std::cos(ang), std::sin(ang));
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> w(1.0);
+      for (size_t k = 0; k < len / 2; k++) {
+        std::complex<double> u = a[i + k], v = a[i + k + len / 2] * w;
+        a[i + k] = u + v;
+        a[i + k + len / 2] = u - v;
+        w *= wl;
+      }
+    }
+  }
+}
+
+// Traza de un canal (un nivel por ms) -> metricas; lo, hi = rango nominal.
+Result measure(const std::vector<uint8_t>& trace, uint8_t lo, uint8_t hi) {
+  Result r;
+  double maxDl = 0, sum = 0, sumSq = 0;
+  long lowMs = 0, lowChanges = 0, edgeMs = 0;
+  const size_t n = trace.size();
+  for (size_t i = 0; i < n; i++) {
+    uint8_t v = trace[i];
+    double l = LSTAR.v[v];
+    sum += l;
+    sumSq += l * l;
+    if (v <= lo || v >= hi) edgeMs++;
+    if (v <= LOW_LEVEL_PWM) lowMs++;
+    if (i == 0) continue;
+    uint8_t p = trace[i - 1];
+    if (v == p) continue;
+    r.dPwm = std::max(r.dPwm, std::abs((int)v - (int)p));
+    maxDl = std::max(maxDl, std::fabs(l - LSTAR.v[p]));
+    if (v <= LOW_LEVEL_PWM || p <= LOW_LEVEL_PWM) lowChanges++;
+  }
+  const double mean = sum / (double)n;
+  r.activity = std::sqrt(std::max(0.0, sumSq / (double)n - mean * mean));
+  r.dLstar = maxDl;
+  r.lowRate = lowMs ? lowChanges * 1000.0 / (double)lowMs : 0.0;
+  r.edge = edgeMs / (double)n;
+
+  // Espectro de L* a 100 Hz (media de cada 10 ms), bloques de FFT_N con Hann.
+  std::vector<double> samples;
+  samples.reserve(n / SAMPLE_MS);
+  for (size_t i = 0; i + SAMPLE_MS <= n; i += SAMPLE_MS) {
+    double acc = 0;
+    for (int k = 0; k < SAMPLE_MS; k++) acc += LSTAR.v[trace[i + k]];
+    samples.push_back(acc / SAMPLE_MS);
+  }
+  double bandPower = 0, totalPower = 0;
+  std::vector<std::complex<double>> buf(FFT_N);
+  for (size_t start = 0; start + FFT_N <= samples.size(); start += FFT_N / 2) {
+    double m = 0;
+    for (int i = 0; i < FFT_N; i++) m += samples[start + i];
+    m /= FFT_N;
+    for (int i = 0; i < FFT_N; i++) {
+      double w = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / (FFT_N - 1));
+      buf[i] = (samples[start + i] - m) * w;
+    }
+    fft(buf);
+    for (int b = 1; b < FFT_N / 2; b++) {
+      double hz = b * (1000.0 / SAMPLE_MS) / FFT_N;
+      double p = std::norm(buf[b]);
+      totalPower += p;
+      if (hz >= 4.0 && hz <= 12.0) bandPower += p;
+    }
+  }
+  r.band = totalPower > 0 ? bandPower / totalPower : 0.0;
+  return r;
+}
+
+// Peor de dos canales: saltos y tasas el mayor, actividad la menor.
+Result worst(const Result& a, const Result& b) {
+  Result r;
+  r.dLstar = std::max(a.dLstar, b.dLstar);
+  r.dPwm = std::max(a.dPwm, b.dPwm);
+  r.lowRate = std::max(a.lowRate, b.lowRate);
+  r.band = std::max(a.band, b.band);
+  r.edge = std::max(a.edge, b.edge);
+  r.activity = std::min(a.activity, b.activity);
+  return r;
+}
+
+// ==== Simulacion de una combinacion ====
+
+Result simulate(const Candidate& c, long ms) {
+  AvrRng rng;
+  std::vector<uint8_t> t1(ms), t2(ms);
+  Result r;
+  if (c.fam == FAM_VELA) {
+    const uint8_t max1 = 204;  // CAN_80
+    CandleDesc d = candleDescFor(max1, (uint8_t)(max1 * 80 / 100), c.k);
+    CandleState s{0, 30, 0, 0};
+    for (long now = 0; now < ms; now++) {
+      candleStep(s, d, (uint16_t)now, rng);
+      t1[now] = s.level1;
+      t2[now] = s.level2;
+    }
+    r = worst(measure(t1, CANDLE_FLOOR_PWM, d.max1), measure(t2, CANDLE_FLOOR_PWM, d.max2));
+  } else if (c.fam == FAM_MODO1) {
+    DriftDesc d = driftDesc(18, 32, c.caraTargetMinMs, c.caraTargetMaxMs, 1, c.caraStepMaxPct, c.caraStepIntervalMs);
+    WaveDesc halo = waveDesc(3, c.haloPeakPct, c.haloPeriodMs);
+    DriftSlot st{};
+    driftStart(st, d, 0, rng);
+    for (long now = 0; now < ms; now++) {
+      t1[now] = driftStep(st, d, (uint16_t)now, rng);
+      t2[now] = waveLevel(halo.minPwm, halo.spanPwm, triangleQ8(wavePhase((unsigned long)now, halo.phaseInc)));
+    }
+    r = worst(measure(t1, d.minPwm, d.maxPwm), measure(t2, halo.minPwm, (uint8_t)(halo.minPwm + halo.spanPwm)));
+  } else if (c.fam == FAM_MODO5) {
+    FadeSlot cara{percentToPwm(c.caraMinPct), percentToPwm(c.caraMinPct), percentToPwm(c.caraMaxPct), 1, 1, true, 0,
+                  c.caraSpeedMs};
+    FadeSlot frente{0, 0, percentToPwm(5), 1, 1, true, 0, c.frenteSpeedMs};
+    for (long now = 0; now < ms; now++) {
+      fadeStep(cara, (uint16_t)now, rng);
+      fadeStep(frente, (uint16_t)now, rng);
+      t1[now] = cara.val;
+      t2[now] = frente.val;
+    }
+    // FIZO/FDEP (0..5%) solo pesa en la tasa a bajo brillo; la actividad es la de CARA.
+    Result a = measure(t1, cara.min, cara.max), b = measure(t2, frente.min, frente.max);
+    r = worst(a, b);
+    r.activity = a.activity;
+    r.edge = a.edge;
+  } else {
+    WaveDesc atra = waveDesc(c.atraMinPct, c.atraMaxPct, c.olaPeriodMs);
+    WaveDesc grupo = waveDesc(c.grupoMinPct, c.grupoMaxPct, c.olaPeriodMs);
+    for (long now = 0; now < ms; now++) {
+      uint16_t phase = wavePhase((unsigned long)now, atra.phaseInc);
+      t1[now] = waveLevel(atra.minPwm, atra.spanPwm, triangleQ8(phase));
+      t2[now] = waveLevel(grupo.minPwm, grupo.spanPwm, triangleQ8(phase + 32768U));
+    }
+    r = worst(measure(t1, atra.minPwm, (uint8_t)(atra.minPwm + atra.spanPwm)),
+              measure(t2, grupo.minPwm, (uint8_t)(grupo.minPwm + grupo.spanPwm)));
+  }
+  r.rejected = r.activity < MIN_ACTIVITY_LSTAR[c.fam];
+  r.score = r.dLstar / 4.0 + r.lowRate / 10.0 + r.band * 2.0 + r.edge * 2.0;
+  return r;
+}
+
+// ==== Pool con work stealing ====
+
+struct WorkQueue {
+  std::mutex m;
+  std::deque<size_t> jobs;
+};
+
+bool popOwn(WorkQueue& q, size_t& job) {
+  std::lock_guard<std::mutex> lock(q.m);
+  if (q.jobs.empty()) return false;
+  job = q.jobs.back();
+  q.jobs.pop_back();
+  return true;
+}
+
+bool steal(WorkQueue& q, size_t& job) {
+  std::lock_guard<std::mutex> lock(q.m);
+  if (q.jobs.empty()) return false;
+  job = q.jobs.front();
+  q.jobs.pop_front();
+  return true;
+}
+
+// Devuelve segundos de reloj; steals = trabajos robados.
+double runPool(const std::vector<Candidate>& grid, long ms, unsigned threads, std::vector<Result>& results,
+               unsigned long& steals) {
+  results.assign(grid.size(), Result());
+  std::vector<WorkQueue> queues(threads);
+  // Bloques contiguos por hilo: las combinaciones vecinas cuestan parecido, asi
+  // el desequilibrio aparece y lo corrige el robo.
+  for (size_t i = 0; i < grid.size(); i++) queues[i * threads / grid.size()].jobs.push_back(i);
+  std::atomic<unsigned long> stolen(0);
+  auto worker = [&](unsigned self) {
+    size_t job;
+    for (;;) {
+      if (!popOwn(queues[self], job)) {
+        bool got = false;
+        for (unsigned k = 1; k < threads && !got; k++) got = steal(queues[(self + k) % threads], job);
+        if (!got) return;  // no se crean trabajos nuevos: todas vacias = fin
+        stolen++;
+      }
+      results[job] = simulate(grid[job], ms);
+    }
+  };
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned i = 1; i < threads; i++) pool.emplace_back(worker, i);
+  worker(0);
+  for (std::thread& t : pool) t.join();
+  steals = stolen;
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ==== Salida ====
+
+std::string describe(const Candidate& c) {
+  char buf[160];
+  switch (c.fam) {
+    case FAM_VELA:
+      std::snprintf(buf, sizeof(buf), "int %u-%u base %u%% caida %u%% x%u/10 salto %u/%u suav %u/%u %u/%u",
+                    c.k.intervalMinMs, c.k.intervalMaxMs, c.k.minBasePct, c.k.dropMaxPct, c.k.dropTenths, c.k.snap1Pct,
+                    c.k.snap2Pct, c.k.keep1, c.k.den1, c.k.keep2, c.k.den2);
+      break;
+    case FAM_MODO1:
+      std::snprintf(buf, sizeof(buf), "cara target %u-%u paso 1-%u%%/%u ms; halo 3-%u%% %lu ms", c.caraTargetMinMs,
+                    c.caraTargetMaxMs, c.caraStepMaxPct, c.caraStepIntervalMs, c.haloPeakPct,
+                    (unsigned long)c.haloPeriodMs);
+      break;
+    case FAM_MODO5:
+      std::snprintf(buf, sizeof(buf), "cara %u-%u%% %u ms; fizo/fdep %u ms", c.caraMinPct, c.caraMaxPct, c.caraSpeedMs,
+                    c.frenteSpeedMs);
+      break;
+    case FAM_MODO6:
+      std::snprintf(buf, sizeof(buf), "atra %u-%u%% grupo %u-%u%% %lu ms", c.atraMinPct, c.atraMaxPct, c.grupoMinPct,
+                    c.grupoMaxPct, (unsigned long)c.olaPeriodMs);
+      break;
+  }
+  return buf;
+}
+
+// Linea para pegar en src/virgencitaluces.cpp.
+void printPaste(const Candidate& c) {
+  switch (c.fam) {
+    case FAM_VELA:
+      std::printf("constexpr CandleCoefs CANDLE_COEFS = {%u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u};\n",
+                  c.k.intervalMinMs, c.k.intervalMaxMs, c.k.minBasePct, c.k.dropMaxPct, c.k.dropTenths, c.k.snap1Pct,
+                  c.k.snap2Pct, c.k.keep1, c.k.den1, c.k.keep2, c.k.den2);
+      break;
+    case FAM_MODO1:
+      std::printf("  {\"Barrido\", 35, 75, 18, 32, 35, 65, %u, %u, 320, 900, 1, %u, 1, 3, %u, 28, 3, %u, %lu, 8, 55, 3600},\n",
+                  c.caraTargetMinMs, c.caraTargetMaxMs, c.caraStepMaxPct, c.caraStepIntervalMs, c.haloPeakPct,
+                  (unsigned long)c.haloPeriodMs);
+      break;
+    case FAM_MODO5:
+      std::printf("const uint8_t MODE5_CARA_MIN_PCT = %u;\nconst uint8_t MODE5_CARA_MAX_PCT = %u;\n"
+                  "const unsigned long MODE5_CARA_SPEED_MS = %u; // ms\n"
+                  "const unsigned long MODE5_FIZO_FDEP_SPEED_MS = %u; // ms\n",
+                  c.caraMinPct, c.caraMaxPct, c.caraSpeedMs, c.frenteSpeedMs);
+      break;
+    case FAM_MODO6:
+      std::printf("const uint8_t MODE6_OLA_ATRA_MIN_PCT = %u;\nconst uint8_t MODE6_OLA_ATRA_MAX_PCT = %u;\n"
+                  "const uint8_t MODE6_OLA_GRUPO_MIN_PCT = %u;\nconst uint8_t MODE6_OLA_GRUPO_MAX_PCT = %u;\n"
+                  "const unsigned long MODE6_OLA_PERIOD_MS = %lu; // ms\n",
+                  c.atraMinPct, c.atraMaxPct, c.grupoMinPct, c.grupoMaxPct, (unsigned long)c.olaPeriodMs);
+      break;
+  }
+}
+
+bool isFirmwareDefault(const Candidate& c) {
+  switch (c.fam) {
+    case FAM_VELA: return std::memcmp(&c.k, &CANDLE_COEFS_DEFAULT, sizeof(CandleCoefs)) == 0;
+    case FAM_MODO1:
+      return c.caraTargetMinMs == 900 && c.caraTargetMaxMs == 2250 && c.caraStepMaxPct == 2 &&
+             c.caraStepIntervalMs == 45 && c.haloPeakPct == 22 && c.haloPeriodMs == 9000;
+    case FAM_MODO5: return c.caraMinPct == 40 && c.caraMaxPct == 90 && c.caraSpeedMs == 35 && c.frenteSpeedMs == 32;
+    case FAM_MODO6:
+      return c.atraMinPct == 10 && c.atraMaxPct == 30 && c.grupoMinPct == 8 && c.grupoMaxPct == 24 &&
+             c.olaPeriodMs == 5200;
+  }
+  return false;
+}
+
+void printRow(int rank, const Candidate& c, const Result& r) {
+  std::printf("  %4d | %6.2f | %5.2f | %4d | %6.1f | %5.3f | %5.3f | %5.1f | %s%s\n", rank, r.score, r.dLstar, r.dPwm,
+              r.lowRate, r.band, r.edge, r.activity, describe(c).c_str(), isFirmwareDefault(c) ? "  (firmware)" : "");
+}
+
+bool parseFamily(const char* s, Family& fam) {
+  for (int i = 0; i < 4; i++) {
+    if (std::strcmp(s, FAMILY_NAMES[i]) == 0) {
+      fam = (Family)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// ==== Duty de las escenas del firmware ====
+
+const char* const CHANNEL_NAMES[POWER_CHANNEL_COUNT] = {"CAN1", "CAN2", "CARA", "FIZO", "FDEP", "ATRA"};
+const uint16_t DUTY_EEPROM_BYTES = 1024;
+
+// Escena VM del slot 0 para el Modo 8 (la del banco, shrine_bench.cpp): ATRA a
+// saltos por RAND y ola de FIZO/FDEP. Los slots 1 y 2 quedan vacios.
+const uint8_t DUTY_VM_SCENE[] = {
+  VM_OP_PUSH8, 10, VM_OP_PUSH8, 200, VM_OP_RAND, VM_OP_OUT, 5,
+  VM_OP_PUSH8, 26, VM_OP_PUSH8, 77, VM_OP_OSC, 0x50, 0x14, VM_OP_DUP, VM_OP_OUT, 3, VM_OP_OUT, 4,
+  VM_OP_PUSH8, 120, VM_OP_WAIT,
+  VM_OP_JMP, 0, 0
+};
+
+// Guion de visitas: el PIR sube DUTY_VISIT_MS cada DUTY_VISIT_GAP_MS, la
+// primera tras un minuto de base.
+const uint32_t DUTY_VISIT_GAP_MS = 120000;
+const uint32_t DUTY_VISIT_MS = 5000;
+const uint32_t DUTY_FIRST_VISIT_MS = 60000;
+
+// Plataforma y sink de una placa simulada (una hornacina con las 6 salidas).
+struct DutyBoard {
+  AvrRng rng;
+  unsigned long us;
+  uint8_t eeprom[DUTY_EEPROM_BYTES];
+  uint8_t slots;
+  uint8_t out[POWER_CHANNEL_COUNT];
+  uint32_t vmFaults;
+};
+
+long dutyRandom(void* ctx, long lo, long hi) {
+  return ((DutyBoard*)ctx)->rng(lo, hi);
+}
+
+unsigned long dutyMicros(void* ctx) {
+  return ((DutyBoard*)ctx)->us += 7;
+}
+
+uint8_t dutyStorageRead(void* ctx, uint16_t addr) {
+  return addr < DUTY_EEPROM_BYTES ? ((DutyBoard*)ctx)->eeprom[addr] : 0xFF;
+}
+
+uint8_t dutySceneSlots(void* ctx) {
+  return ((DutyBoard*)ctx)->slots;
+}
+
+void dutySinkWrite(void* ctx, ShrineController&, const uint8_t* levels) {
+  std::memcpy(((DutyBoard*)ctx)->out, levels, POWER_CHANNEL_COUNT);
+}
+
+void dutySinkEvent(void* ctx, ShrineController&, ShrineEvent type, uint8_t) {
+  if (type == SHRINE_EVT_VM_FAULT) ((DutyBoard*)ctx)->vmFaults++;
+}
+
+void dutyWriteVmSlot(DutyBoard& b, uint8_t slot, const uint8_t* code, uint16_t len) {
+  uint8_t* at = b.eeprom + vmSlotAddr(slot);
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < len; i++) crc = vmCrc16Update(crc, code[i]);
+  at[0] = 'V';
+  at[1] = 'M';
+  at[2] = VM_BYTECODE_VERSION;
+  at[3] = 1;
+  at[4] = (uint8_t)len;
+  at[5] = (uint8_t)(len >> 8);
+  at[6] = (uint8_t)crc;
+  at[7] = (uint8_t)(crc >> 8);
+  std::memcpy(at + VM_HEADER_BYTES, code, len);
+}
+
+// Una escena (base o movimiento de un modo): lo mismo que el comando "duty"
+// del firmware mas el duty por canal y los recortes del gobernador.
+struct DutyRow {
+  DutyScene scene;
+  uint32_t channelS[POWER_CHANNEL_COUNT];
+  uint16_t throttles;
+  uint32_t throttledMs;
+};
+
+// Corre el modo m ms a ms por el motor de escena (shrineInputs + shrineRender,
+// include/shrine_engine.h), el gobernador y el contador de duty del firmware,
+// con la escena de cada frame elegida por shrineSceneKey(). false si el modo
+// no tiene escena (slot VM vacio).
+bool dutyMode(Mode m, long ms, DutyRow* rows, uint32_t& vmFaults) {
+  static DutyBoard board;
+  board = DutyBoard();
+  std::memset(board.eeprom, 0xFF, sizeof(board.eeprom));
+  dutyWriteVmSlot(board, 0, DUTY_VM_SCENE, sizeof(DUTY_VM_SCENE));
+  const ShrinePlatform platform = {dutyRandom, dutyMicros, dutyStorageRead, dutySceneSlots, &board};
+  uint16_t len;
+  for (uint8_t k = 0; k < VM_SLOT_COUNT; k++) {
+    if (vmCheckSlot(platform, k, len)) board.slots |= (uint8_t)(1 << k);
+  }
+  if (m >= MODE_8_ESCENA_1 && !(board.slots & (1 << (m - MODE_8_ESCENA_1)))) return false;
+
+  const ShrineConfig config = {0, 0, {0, 1, 2, 3, 4, 5}};
+  const ShrineSink sink = {dutySinkWrite, dutySinkEvent, &board};
+  static SceneCache cache;
+  static ShrineController s;
+  std::memset(&cache, 0, sizeof(cache));
+  shrineBegin(s, config, platform, sink, &cache, 0);
+  s.currentMode = m;
+
+  PowerGovernor gov = POWER_GOVERNOR_IDLE;
+  DutyLive live{};
+  uint8_t key = 0;
+  FrameContext fc = {0, 0, 1, 0, false, 0};
+  for (long now = 1; now <= ms; now++) {
+    fc.now = (unsigned long)now;
+    fc.tick = (uint16_t)now;
+    fc.frame++;
+    uint32_t t = (uint32_t)now;
+    bool pir = t >= DUTY_FIRST_VISIT_MS && (t - DUTY_FIRST_VISIT_MS) % DUTY_VISIT_GAP_MS < DUTY_VISIT_MS;
+    shrineInputs(s, fc, 1, pir);
+    shrineRender(s, fc, 255);
+    uint16_t events = gov.events;
+    powerGovernorStep(gov, board.out, fc.dtMs);
+    uint8_t k = shrineSceneKey(s) & 1;
+    if (k != key) {
+      dutyFold(live, rows[key].scene, rows[key].channelS);
+      key = k;
+    }
+    if (gov.events != events) rows[key].throttles++;
+    if (gov.throttling) rows[key].throttledMs += fc.dtMs;
+    if (dutyFrame(live, board.out, fc.dtMs)) dutyFold(live, rows[key].scene, rows[key].channelS);
+  }
+  dutyFold(live, rows[key].scene, rows[key].channelS);
+  vmFaults = board.vmFaults;
+  return true;
+}
+
+int runDuty(double minutes) {
+  const long ms = (long)(minutes * 60000.0);
+  std::printf("profile_sweep duty: motor de escena del firmware, %.1f min por modo, PIR %u s cada %u s\n", minutes,
+              (unsigned)(DUTY_VISIT_MS / 1000), (unsigned)(DUTY_VISIT_GAP_MS / 1000));
+  std::printf("  (include/duty_meter.h tras el gobernador de %u mA; 100%% = %u mA con los %u canales)\n\n",
+              (unsigned)POWER_BUDGET_MA, POWER_LED_TOTAL_MA, POWER_CHANNEL_COUNT);
+  std::printf("  escena  |    s | medio |    mA | pico mA | recortes   |");
+  for (uint8_t i = 0; i < POWER_CHANNEL_COUNT; i++) std::printf(" %5s", CHANNEL_NAMES[i]);
+  std::printf("\n");
+  DutyScene all{};
+  for (uint8_t m = 0; m < MODE_COUNT; m++) {
+    DutyRow rows[2] = {};
+    uint32_t vmFaults = 0;
+    if (!dutyMode((Mode)m, ms, rows, vmFaults)) {
+      std::printf("  M%-2u     | sin escena VM en el slot %u\n", m + 1, m - MODE_8_ESCENA_1);
+      continue;
+    }
+    for (uint8_t k = 0; k < 2; k++) {
+      const DutyRow& r = rows[k];
+      if (r.scene.seconds == 0) continue;
+      all.seconds += r.scene.seconds;
+      all.ledMaS += r.scene.ledMaS;
+      uint16_t deciMa = dutyAvgDeciMa(r.scene);
+      std::printf("  M%-2u %-4s | %4u | %4.1f%% | %5.1f | %7u | %3u %5.1f s |", m + 1, k ? "mov" : "base",
+                  (unsigned)r.scene.seconds, dutyPermille(deciMa) / 10.0, deciMa / 10.0, r.scene.peakMa, r.throttles,
+                  r.throttledMs / 1000.0);
+      for (uint8_t i = 0; i < POWER_CHANNEL_COUNT; i++) {
+        std::printf(" %4.1f%%", dutyChannelPermille(r.channelS[i], r.scene.seconds) / 10.0);
+      }
+      std::printf("\n");
+    }
+    if (vmFaults) std::printf("  M%-2u     | %u fallos de la VM\n", m + 1, (unsigned)vmFaults);
+  }
+  uint16_t deciMa = dutyAvgDeciMa(all);
+  std::printf("\n  todos los modos por igual: LEDs %.1f mA + MCU y placa %.1f mA = %.1f mA de media\n", deciMa / 10.0,
+              (POWER_MCU_ACTIVE_UA + POWER_BOARD_UA) / 1000.0, deciMa / 10.0 + (POWER_MCU_ACTIVE_UA + POWER_BOARD_UA) / 1000.0);
+  return 0;
+}
+
+int usage(const char* argv0) {
+  std::fprintf(stderr,
+               "uso: %s <vela|modo1|modo5|modo6> [minutos=3] [hilos=0] [top=15]\n"
+               "     %s escala <familia> [minutos=1]\n"
+               "     %s duty [minutos=10]\n",
+               argv0, argv0, argv0);
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) return usage(argv[0]);
+  if (std::strcmp(argv[1], "duty") == 0) {
+    const double minutes = argc > 2 ? std::atof(argv[2]) : 10.0;
+    if (minutes <= 0) return usage(argv[0]);
+    return runDuty(minutes);
+  }
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+  if (std::strcmp(argv[1], "escala") == 0) {
+    Family fam;
+    if (argc < 3 || !parseFamily(argv[2], fam)) return usage(argv[0]);
+    const double minutes = argc > 3 ? std::atof(argv[3]) : 1.0;
+    const long ms = (long)(minutes * 60000.0);
+    if (ms < FFT_N * SAMPLE_MS) return usage(argv[0]);
+    std::vector<Candidate> grid = buildGrid(fam);
+    std::vector<Result> results;
+    std::printf("escala: %s, %zu combinaciones x %.1f min, %u nucleos\n", FAMILY_NAMES[fam], grid.size(), minutes, cores);
+    std::printf("  hilos | segundos | horas sim/s | aceleracion | robos\n");
+    double base = 0;
+    for (unsigned t = 1;; t = std::min(t * 2, cores)) {
+      unsigned long steals = 0;
+      double s = runPool(grid, ms, t, results, steals);
+      if (t == 1) base = s;
+      std::printf("  %5u | %8.2f | %11.1f | %10.2fx | %5lu\n", t, s, grid.size() * minutes / 60.0 / s, base / s, steals);
+      if (t == cores) break;
+    }
+    return 0;
+  }
+
+  Family fam;
+  if (!parseFamily(argv[1], fam)) return usage(argv[0]);
+  const double minutes = argc > 2 ? std::atof(argv[2]) : 3.0;
+  unsigned threads = argc > 3 ? (unsigned)std::atoi(argv[3]) : 0;
+  const int top = argc > 4 ? std::atoi(argv[4]) : 15;
+  const long ms = (long)(minutes * 60000.0);
+  if (ms < FFT_N * SAMPLE_MS || top < 1) return usage(argv[0]);
+  if (threads == 0) threads = cores;
+
+  std::vector<Candidate> grid = buildGrid(fam);
+  std::vector<Result> results;
+  unsigned long steals = 0;
+  double seconds = runPool(grid, ms, threads, results, steals);
+
+  std::vector<size_t> order;
+  size_t rejected = 0, defaultIdx = grid.size();
+  for (size_t i = 0; i < grid.size(); i++) {
+    if (isFirmwareDefault(grid[i])) defaultIdx = i;
+    if (results[i].rejected) rejected++;
+    else order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return results[a].score < results[b].score; });
+
+  std::printf("profile_sweep %s: %zu combinaciones x %.1f min (%zu descartadas por poca actividad)\n",
+              FAMILY_NAMES[fam], grid.size(), minutes, rejected);
+  std::printf("  %u hilos, %.2f s, %.1f horas simuladas/s, %lu robos\n\n", threads, seconds,
+              grid.size() * minutes / 60.0 / seconds, steals);
+  std::printf("  pos. | puntos |   dL* | dPWM | bajo/s | 4-12Hz |  tope | act.L* | parametros\n");
+  for (int i = 0; i < top && i < (int)order.size(); i++) printRow(i + 1, grid[order[i]], results[order[i]]);
+  if (defaultIdx < grid.size()) {
+    auto it = std::find(order.begin(), order.end(), defaultIdx);
+    int rank = it == order.end() ? 0 : (int)(it - order.begin()) + 1;
+    if (rank == 0 || rank > top) {
+      std::printf("  ...\n");
+      printRow(rank, grid[defaultIdx], results[defaultIdx]);
+      if (rank == 0) std::printf("  (los valores del firmware quedan por debajo de la actividad minima)\n");
+    }
+  }
+  if (!order.empty()) {
+    std::printf("\nMejor combinacion, para src/virgencitaluces.cpp:\n");
+    printPaste(grid[order[0]]);
+  }
+  return 0;
+}
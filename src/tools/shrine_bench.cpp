@@ -0,0 +1,291 @@
+// Banco de hornacinas en host: muchas instancias del motor de escena
+// (include/shrine_engine.h, el mismo codigo que corre en la placa) a la vez,
+// para comprobar que no hay estado compartido entre controladores.
+//
+// Uso:
+//   shrine_bench [hornacinas=300] [segundos=600] [semilla=1]
+//
+// Cada hornacina tiene su plataforma propia: random() de avr-libc con su
+// semilla, micros() simulado y una EEPROM de 1 KB; las pares llevan en el
+// slot 0 una escena VM (ola + RAND), las impares no tienen slots (el boton se
+// salta los modos 8-10). Cada una recibe su guion de entradas: pulsaciones con
+// rebotes y flancos de PIR a ritmos distintos, asi que recorren todos los
+// modos, ventanas de movimiento, timeouts y escenas VM a destiempo.
+//
+// El reloj de la placa avanza 1-6 ms por frame (el loop no tiene ritmo fijo)
+// y es el mismo en las dos pasadas:
+//   sola       cada hornacina corre entera sin ninguna otra viva.
+//   intercalada  todas en el mismo frame, una detras de otra, como en la placa.
+// De cada frame se acumula un hash (FNV-1a) de los niveles que llegan al sink
+// y de los eventos. Sin diafonia, el hash de cada hornacina es identico en las
+// dos pasadas. Cada hornacina usa su propia cache de escena: la cache de la
+// placa es el unico estado prestado a proposito (una duena a la vez, 4.15) y
+// su reparto cambia la salida de las demas por diseno, no por diafonia.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../../include/shrine_engine.h"
+
+namespace {
+
+const uint16_t EEPROM_BYTES = 1024;
+
+// Escena VM del slot 0: ola de FIZO/FDEP y ATRA a saltos por RAND.
+const uint8_t VM_SCENE[] = {
+  VM_OP_PUSH8, 10, VM_OP_PUSH8, 200, VM_OP_RAND, VM_OP_OUT, 5,
+  VM_OP_PUSH8, 26, VM_OP_PUSH8, 77, VM_OP_OSC, 0x50, 0x14, VM_OP_DUP, VM_OP_OUT, 3, VM_OP_OUT, 4,
+  VM_OP_PUSH8, 120, VM_OP_WAIT,
+  VM_OP_JMP, 0, 0
+};
+
+// random() de avr-libc (Park-Miller, metodo de Schrage) y random(lo, hi) de Arduino.
+struct AvrRng {
+  uint32_t state = 1;
+  long next() {
+    long hi = (long)state / 127773L, lo = (long)state % 127773L;
+    long x = 16807L * lo - 2836L * hi;
+    if (x < 0) x += 0x7fffffffL;
+    state = (uint32_t)x;
+    if (state == 0) state = 123459876UL;
+    return (long)(state % 0x80000000UL);
+  }
+  long operator()(long lo, long hi) {
+    if (lo >= hi) return lo;
+    return lo + next() % (hi - lo);
+  }
+};
+
+struct BenchBoard {
+  AvrRng rng;
+  unsigned long us;
+  uint8_t eeprom[EEPROM_BYTES];
+  uint8_t slots;
+};
+
+long benchRandom(void* ctx, long lo, long hi) {
+  return (*(BenchBoard*)ctx).rng(lo, hi);
+}
+
+unsigned long benchMicros(void* ctx) {
+  return ((BenchBoard*)ctx)->us += 7;
+}
+
+uint8_t benchStorageRead(void* ctx, uint16_t addr) {
+  return addr < EEPROM_BYTES ? ((BenchBoard*)ctx)->eeprom[addr] : 0xFF;
+}
+
+uint8_t benchSceneSlots(void* ctx) {
+  return ((BenchBoard*)ctx)->slots;
+}
+
+void writeVmSlot(BenchBoard& b, uint8_t slot, const uint8_t* code, uint16_t len) {
+  uint8_t* at = b.eeprom + vmSlotAddr(slot);
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < len; i++) crc = vmCrc16Update(crc, code[i]);
+  at[0] = 'V';
+  at[1] = 'M';
+  at[2] = VM_BYTECODE_VERSION;
+  at[3] = 1;
+  at[4] = (uint8_t)len;
+  at[5] = (uint8_t)(len >> 8);
+  at[6] = (uint8_t)crc;
+  at[7] = (uint8_t)(crc >> 8);
+  memcpy(at + VM_HEADER_BYTES, code, len);
+}
+
+// Lo que llega al sink de una hornacina.
+struct Trace {
+  uint64_t hash;
+  uint32_t frames;
+  uint32_t events[SHRINE_EVT_VM_FAULT + 1];
+  uint32_t modeFrames[MODE_COUNT];
+};
+
+void traceByte(Trace& t, uint8_t b) {
+  t.hash = (t.hash ^ b) * 0x100000001B3ULL;
+}
+
+void benchWrite(void* ctx, ShrineController& s, const uint8_t* levels) {
+  Trace& t = *(Trace*)ctx;
+  for (uint8_t i = 0; i < LED_COUNT; i++) traceByte(t, levels[i]);
+  t.frames++;
+  t.modeFrames[s.currentMode]++;
+}
+
+void benchEvent(void* ctx, ShrineController&, ShrineEvent type, uint8_t arg) {
+  Trace& t = *(Trace*)ctx;
+  traceByte(t, (uint8_t)(0x80 | type));
+  traceByte(t, arg);
+  t.events[type]++;
+}
+
+// Guion de entradas de una hornacina: niveles del boton y del PIR en cada ms.
+struct Script {
+  std::vector<uint8_t> button; // 1 = suelto (pull-up)
+  std::vector<uint8_t> pir;
+};
+
+Script makeScript(uint32_t seed, uint32_t ms) {
+  std::mt19937 g(seed);
+  Script sc;
+  sc.button.assign(ms, 1);
+  sc.pir.assign(ms, 0);
+  std::uniform_int_distribution<uint32_t> pressGap(1500, 9000), hold(90, 400), bounce(1, 8), bounces(0, 5);
+  for (uint32_t t = pressGap(g); t < ms; t += pressGap(g)) {
+    uint32_t end = t + hold(g);
+    for (uint32_t k = t; k < end && k < ms; k++) sc.button[k] = 0;
+    uint32_t at = t;
+    for (uint32_t n = bounces(g); n > 0; n--) { // rebotes al pulsar
+      at += bounce(g);
+      if (at < ms) sc.button[at] = 1;
+    }
+  }
+  std::uniform_int_distribution<uint32_t> pirGap(800, 90000), pirHigh(200, 5000);
+  for (uint32_t t = pirGap(g); t < ms; t += pirGap(g)) {
+    uint32_t end = t + pirHigh(g);
+    for (uint32_t k = t; k < end && k < ms; k++) sc.pir[k] = 1;
+    t = end;
+  }
+  return sc;
+}
+
+struct Bench {
+  std::vector<BenchBoard> boards;
+  std::vector<ShrinePlatform> platforms;
+  std::vector<ShrineController> shrines;
+  std::vector<SceneCache> caches;
+  std::vector<Trace> traces;
+  std::vector<Script> scripts;
+  std::vector<uint16_t> steps; // dt de cada frame de la placa
+  ShrineConfig config;
+  uint32_t seed;
+};
+
+void resetShrine(Bench& b, size_t k) {
+  BenchBoard& board = b.boards[k];
+  board = BenchBoard();
+  memset(board.eeprom, 0xFF, sizeof(board.eeprom));
+  board.rng.state = b.seed * 7919u + (uint32_t)k + 1;
+  if (k % 2 == 0) writeVmSlot(board, 0, VM_SCENE, sizeof(VM_SCENE));
+  b.platforms[k] = {benchRandom, benchMicros, benchStorageRead, benchSceneSlots, &board};
+  uint16_t len;
+  for (uint8_t s = 0; s < VM_SLOT_COUNT; s++) {
+    if (vmCheckSlot(b.platforms[k], s, len)) board.slots |= (uint8_t)(1 << s);
+  }
+  memset(&b.traces[k], 0, sizeof(Trace));
+  b.traces[k].hash = 0xCBF29CE484222325ULL;
+  memset(&b.caches[k], 0, sizeof(SceneCache));
+  const ShrineSink sink = {benchWrite, benchEvent, &b.traces[k]};
+  shrineBegin(b.shrines[k], b.config, b.platforms[k], sink, &b.caches[k], 0);
+}
+
+void stepShrine(Bench& b, size_t k, const FrameContext& fc) {
+  const Script& sc = b.scripts[k];
+  uint32_t at = (uint32_t)fc.now < sc.button.size() ? (uint32_t)fc.now : (uint32_t)sc.button.size() - 1;
+  shrineInputs(b.shrines[k], fc, sc.button[at], sc.pir[at] != 0);
+  shrineRender(b.shrines[k], fc, 255);
+}
+
+FrameContext advance(FrameContext fc, uint16_t dt) {
+  fc.now += dt;
+  fc.tick = (uint16_t)fc.now;
+  fc.dtMs = dt;
+  fc.frame++;
+  return fc;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const long count = argc > 1 ? std::atol(argv[1]) : 300;
+  const double seconds = argc > 2 ? std::atof(argv[2]) : 600.0;
+  const uint32_t seed = argc > 3 ? (uint32_t)std::atol(argv[3]) : 1;
+  if (count < 1 || seconds <= 0) {
+    std::fprintf(stderr, "uso: %s [hornacinas] [segundos] [semilla]\n", argv[0]);
+    return 2;
+  }
+  const uint32_t ms = (uint32_t)(seconds * 1000.0);
+
+  Bench b;
+  b.seed = seed;
+  b.config = {0, 0, {0, 1, 2, 3, 4, 5}};
+  b.boards.resize(count);
+  b.platforms.resize(count);
+  b.shrines.resize(count);
+  b.caches.resize(count);
+  b.traces.resize(count);
+  for (long k = 0; k < count; k++) b.scripts.push_back(makeScript(seed * 104729u + (uint32_t)k, ms));
+  std::mt19937 g(seed);
+  std::uniform_int_distribution<int> dt(1, 6);
+  for (uint32_t t = 0; t < ms;) {
+    b.steps.push_back((uint16_t)dt(g));
+    t += b.steps.back();
+  }
+  std::printf("shrine_bench: %ld hornacinas, %.0f s (%zu frames de placa), controlador %zu bytes, cache %zu bytes\n",
+              count, seconds, b.steps.size(), sizeof(ShrineController), sizeof(SceneCache));
+
+  // Pasada 1: cada hornacina sola.
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<Trace> alone(count);
+  for (long k = 0; k < count; k++) {
+    resetShrine(b, k);
+    FrameContext fc = {0, 0, 0, 0, false, 0};
+    for (uint16_t d : b.steps) {
+      fc = advance(fc, d);
+      stepShrine(b, k, fc);
+    }
+    alone[k] = b.traces[k];
+  }
+  const double aloneS = secondsSince(t0);
+
+  // Pasada 2: todas en cada frame.
+  t0 = std::chrono::steady_clock::now();
+  for (long k = 0; k < count; k++) resetShrine(b, k);
+  FrameContext fc = {0, 0, 0, 0, false, 0};
+  for (uint16_t d : b.steps) {
+    fc = advance(fc, d);
+    for (long k = 0; k < count; k++) stepShrine(b, k, fc);
+  }
+  const double mixedS = secondsSince(t0);
+
+  long mismatches = 0;
+  Trace total = {};
+  for (long k = 0; k < count; k++) {
+    const Trace& a = alone[k];
+    const Trace& m = b.traces[k];
+    if (a.hash != m.hash || a.frames != m.frames) {
+      if (mismatches < 10) {
+        std::printf("  DIAFONIA hornacina %ld: sola %016llx, intercalada %016llx\n", k, (unsigned long long)a.hash,
+                    (unsigned long long)m.hash);
+      }
+      mismatches++;
+    }
+    total.frames += m.frames;
+    for (int e = 0; e <= SHRINE_EVT_VM_FAULT; e++) total.events[e] += m.events[e];
+    for (int md = 0; md < MODE_COUNT; md++) total.modeFrames[md] += m.modeFrames[md];
+  }
+
+  const double renders = (double)total.frames;
+  std::printf("  sola %.1f s, intercalada %.1f s (%.2f us por frame de hornacina)\n", aloneS, mixedS,
+              mixedS * 1e6 / renders);
+  std::printf("  eventos: %u cambios de modo, %u flancos de PIR, %u timeouts, %u caches, %u fallos VM\n",
+              total.events[SHRINE_EVT_MODE], total.events[SHRINE_EVT_MOTION], total.events[SHRINE_EVT_TIMEOUT],
+              total.events[SHRINE_EVT_CACHE], total.events[SHRINE_EVT_VM_FAULT]);
+  std::printf("  frames por modo:");
+  for (int md = 0; md < MODE_COUNT; md++) std::printf(" %d:%.1f%%", md + 1, 100.0 * total.modeFrames[md] / renders);
+  std::printf("\n");
+  if (mismatches) {
+    std::printf("FALLO: %ld de %ld hornacinas cambian al correr juntas\n", mismatches, count);
+    return 1;
+  }
+  std::printf("OK: las %ld hornacinas dan la misma salida solas que juntas\n", count);
+  return 0;
+}
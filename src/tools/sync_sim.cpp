@@ -0,0 +1,296 @@
+// Simulador de sincronizacion multi-nodo sobre ptys.
+//
+// Uso:
+//   sync_sim [nodos=4] [segundos=180]
+//
+// Cada nodo ejecuta include/sync_protocol.h con su propio reloj local (deriva
+// de resonador y arranque escalonado) y habla por el lado esclavo de una pty,
+// igual que por su UART. Un hub lee el lado maestro de cada pty y reenvia los
+// bytes a los demas nodos con la latencia de un bus a SYNC_BAUD (bus
+// compartido half-duplex). El tiempo es virtual (pasos de 1 ms); las ptys son
+// reales.
+//
+// Escenario: arranque escalonado; PIR en el nodo 3 a los 40 s; el maestro se
+// apaga a los 90 s (re-eleccion). Informa tiempo de convergencia, error de
+// fase residual, saltos, paso maximo de slew y latencia de eventos.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include "../../include/sync_protocol.h"
+
+namespace {
+
+const double BYTE_MS = 10.0 * 1000.0 / SYNC_BAUD;
+// Error maximo para considerar el grupo sincronizado: cada reloj avanza en ms
+// enteros y los bytes llegan en pasos de 1 ms, asi que +-3 ms es el suelo.
+const int CONVERGED_MS = 3;
+
+struct PendingByte {
+  double at;                  // tiempo real de entrega (ms)
+  uint8_t b;
+};
+
+struct SimNode {
+  int masterFd = -1;          // lado del hub
+  int slaveFd = -1;           // "UART" del nodo
+  double skewPpm = 0;
+  double bootMs = 0;
+  double powerOffMs = 1e18;
+  bool alive = false;
+  SyncNode sync;
+  SyncParser parser{};
+  std::deque<PendingByte> toNode;
+  size_t inFlight = 0;        // bytes escritos al maestro de la pty aun sin leer
+  uint32_t lastSynced = 0;
+  int maxStep = 0;            // mayor avance del reloj sincronizado en un paso de 1 ms
+  int minStep = 1 << 30;
+  bool motion = false;
+  double motionSeenAt = -1;
+  bool wasMaster = false;
+  bool wasLocked = false;
+};
+
+uint32_t localMs(const SimNode& n, double trueMs) {
+  // Reloj local: arranca en 0 al encender y corre con la deriva del resonador.
+  return (uint32_t)std::floor((trueMs - n.bootMs) * (1.0 + n.skewPpm * 1e-6));
+}
+
+void makeRaw(int fd) {
+  termios t;
+  tcgetattr(fd, &t);
+  cfmakeraw(&t);
+  tcsetattr(fd, TCSANOW, &t);
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Lee exactamente n bytes (las ptys entregan de forma asincrona).
+size_t readExact(int fd, uint8_t* buf, size_t n) {
+  size_t got = 0;
+  while (got < n) {
+    pollfd p{fd, POLLIN, 0};
+    if (poll(&p, 1, 200) <= 0) break;
+    ssize_t r = read(fd, buf + got, n - got);
+    if (r > 0) got += (size_t)r;
+  }
+  return got;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int nodeCount = argc > 1 ? std::atoi(argv[1]) : 4;
+  const int seconds = argc > 2 ? std::atoi(argv[2]) : 180;
+  if (nodeCount < 2 || nodeCount > 16) {
+    std::fprintf(stderr, "nodos: 2..16\n");
+    return 2;
+  }
+
+  const double skews[] = {3200, -4100, 1500, -900, 4700, -2600, 600, -4800};
+  std::vector<SimNode> nodes(nodeCount);
+  for (int i = 0; i < nodeCount; i++) {
+    SimNode& n = nodes[i];
+    if (openpty(&n.masterFd, &n.slaveFd, nullptr, nullptr, nullptr) != 0) {
+      std::perror("openpty");
+      return 1;
+    }
+    makeRaw(n.masterFd);
+    makeRaw(n.slaveFd);
+    n.skewPpm = skews[i % 8];
+    n.bootMs = 700.0 * i + 137.0 * ((i * 7) % 5);
+  }
+  const int PIR_NODE = nodeCount > 2 ? 2 : 1;
+  const double PIR_AT = 40000;
+  nodes[0].powerOffMs = 90000;  // el maestro inicial (id 1) se apaga
+
+  std::printf("sync_sim: %d nodos, %d s, bus %u baud (%.2f ms/byte, transito %u ms)\n", nodeCount, seconds,
+              (unsigned)SYNC_BAUD, BYTE_MS, (unsigned)SYNC_TRANSIT_MS);
+  for (int i = 0; i < nodeCount; i++) {
+    std::printf("  nodo %d: deriva %+6.0f ppm, arranca en %5.0f ms\n", i + 1, nodes[i].skewPpm, nodes[i].bootMs);
+  }
+
+  double busFreeAt = 0;         // bus compartido: un mensaje a la vez
+  double convergedAt = -1;
+  double reconvergedAt = -1;
+  double sumSq = 0;
+  long samples = 0;
+  int maxResidual = 0;
+  int pirSeen = 0;
+  int electedAfterFailure = 0;
+  double failoverAt = -1;
+  const long totalMs = (long)seconds * 1000;
+
+  for (long t = 0; t <= totalMs; t++) {
+    const double now = (double)t;
+
+    // Encendido / apagado.
+    for (int i = 0; i < nodeCount; i++) {
+      SimNode& n = nodes[i];
+      if (!n.alive && now >= n.bootMs && now < n.powerOffMs) {
+        n.alive = true;
+        syncNodeInit(n.sync, (uint8_t)(i + 1), localMs(n, now));
+        n.lastSynced = syncClockNow(n.sync.clock, localMs(n, now));
+      }
+      if (n.alive && now >= n.powerOffMs) n.alive = false;
+    }
+
+    // 1) Los nodos emiten (BEACON / MOTION) por su UART.
+    for (int i = 0; i < nodeCount; i++) {
+      SimNode& n = nodes[i];
+      if (!n.alive) continue;
+      uint32_t local = localMs(n, now);
+      bool sendBeacon = syncNodePoll(n.sync, local);
+      bool sendMotion = (i == PIR_NODE && t == (long)PIR_AT);
+      if (sendMotion) n.motion = true;
+      if (!sendBeacon && !sendMotion) continue;
+      SyncMessage m{sendBeacon ? (uint8_t)SYNC_MSG_BEACON : (uint8_t)SYNC_MSG_MOTION, n.sync.id,
+                    syncClockNow(n.sync.clock, local), 1, (uint8_t)(n.motion ? SYNC_FLAG_MOTION : 0)};
+      uint8_t buf[SYNC_MSG_BYTES];
+      syncEncode(m, buf);
+      if (write(n.slaveFd, buf, sizeof(buf)) != (ssize_t)sizeof(buf)) std::perror("write");
+      n.inFlight += sizeof(buf);
+    }
+
+    // 2) Hub: recoge lo emitido y lo reparte con la latencia del bus.
+    for (int i = 0; i < nodeCount; i++) {
+      SimNode& src = nodes[i];
+      if (src.inFlight == 0) continue;
+      std::vector<uint8_t> buf(src.inFlight);
+      size_t got = readExact(src.masterFd, buf.data(), buf.size());
+      src.inFlight -= got;
+      double start = (busFreeAt > now) ? busFreeAt : now;
+      for (size_t k = 0; k < got; k++) {
+        double at = start + (k + 1) * BYTE_MS;
+        for (int d = 0; d < nodeCount; d++) {
+          if (d != i) nodes[d].toNode.push_back({at, buf[k]});
+        }
+      }
+      busFreeAt = start + got * BYTE_MS;
+    }
+
+    // 3) Entrega al nodo (pty maestro -> esclavo) y decodificacion en su hora local.
+    for (int d = 0; d < nodeCount; d++) {
+      SimNode& n = nodes[d];
+      std::vector<uint8_t> due;
+      while (!n.toNode.empty() && n.toNode.front().at <= now) {
+        due.push_back(n.toNode.front().b);
+        n.toNode.pop_front();
+      }
+      if (due.empty()) continue;
+      if (write(n.masterFd, due.data(), due.size()) != (ssize_t)due.size()) std::perror("write");
+      std::vector<uint8_t> in(due.size());
+      size_t got = readExact(n.slaveFd, in.data(), in.size());
+      if (!n.alive) continue;
+      uint32_t local = localMs(n, now);
+      for (size_t k = 0; k < got; k++) {
+        SyncMessage m;
+        if (!syncParse(n.parser, in[k], m)) continue;
+        syncNodeOnMessage(n.sync, m, local);
+        if ((m.flags & SYNC_FLAG_MOTION) && !n.motion) {
+          n.motion = true;
+          n.motionSeenAt = now;
+          pirSeen++;
+        }
+      }
+    }
+
+    // 4) Medidas: error de cada nodo contra el maestro vivo de menor id.
+    int master = -1;
+    for (int i = 0; i < nodeCount; i++) {
+      if (nodes[i].alive) {
+        master = i;
+        break;
+      }
+    }
+    uint32_t ref = 0;
+    int worst = 0;
+    bool allLocked = true;
+    for (int i = 0; i < nodeCount; i++) {
+      SimNode& n = nodes[i];
+      if (!n.alive) continue;
+      uint32_t s = syncClockNow(n.sync.clock, localMs(n, now));
+      int step = (int)(int32_t)(s - n.lastSynced);
+      n.lastSynced = s;
+      if (i == master) ref = s;
+      // Paso del reloj ya enganchado (el salto de union se cuenta aparte).
+      if (n.wasLocked || i == master) {
+        if (step > n.maxStep) n.maxStep = step;
+        if (step < n.minStep) n.minStep = step;
+      }
+      if (!n.sync.clock.locked && i != master) allLocked = false;
+      n.wasLocked = n.sync.clock.locked;
+      if (n.sync.isMaster && !n.wasMaster && now > nodes[0].powerOffMs && failoverAt < 0) {
+        failoverAt = now;
+        electedAfterFailure = i + 1;
+      }
+      n.wasMaster = n.sync.isMaster;
+    }
+    for (int i = 0; i < nodeCount; i++) {
+      if (!nodes[i].alive || i == master) continue;
+      int err = (int)(int32_t)(nodes[i].lastSynced - ref);
+      if (std::abs(err) > worst) worst = std::abs(err);
+    }
+    bool everyoneUp = true;
+    for (int i = 0; i < nodeCount; i++) {
+      if (nodes[i].bootMs > now) everyoneUp = false;
+    }
+    if (everyoneUp && allLocked) {
+      if (now < nodes[0].powerOffMs) {
+        if (worst <= CONVERGED_MS) {
+          if (convergedAt < 0) convergedAt = now;
+        } else {
+          convergedAt = -1;  // solo cuenta si se mantiene
+        }
+      } else if (reconvergedAt < 0 && failoverAt >= 0 && worst <= CONVERGED_MS) {
+        reconvergedAt = now;
+      }
+      if (convergedAt >= 0 && now - convergedAt > 5000) {
+        sumSq += (double)worst * worst;
+        samples++;
+        if (worst > maxResidual) maxResidual = worst;
+      }
+    }
+  }
+
+  std::printf("\nResultados:\n");
+  double lastBoot = 0;
+  for (const SimNode& n : nodes) lastBoot = n.bootMs > lastBoot ? n.bootMs : lastBoot;
+  if (convergedAt >= 0) {
+    std::printf("  convergencia (|error| <= %d ms estable): %.0f ms tras el ultimo arranque\n", CONVERGED_MS,
+                convergedAt - lastBoot);
+  } else {
+    std::printf("  convergencia: NO alcanzada\n");
+  }
+  std::printf("  error residual (peor nodo, tras converger): rms %.2f ms, max %d ms\n",
+              samples ? std::sqrt(sumSq / samples) : 0.0, maxResidual);
+  std::printf("  re-eleccion tras apagar el maestro: nodo %d en %.0f ms", electedAfterFailure,
+              failoverAt >= 0 ? failoverAt - nodes[0].powerOffMs : -1.0);
+  if (reconvergedAt >= 0) std::printf(", re-sincronizado en %.0f ms", reconvergedAt - nodes[0].powerOffMs);
+  std::printf("\n");
+  std::printf("  PIR del nodo %d visto por %d/%d nodos", PIR_NODE + 1, pirSeen, nodeCount - 1);
+  double worstLatency = 0;
+  for (const SimNode& n : nodes) {
+    if (n.motionSeenAt >= 0 && n.motionSeenAt - PIR_AT > worstLatency) worstLatency = n.motionSeenAt - PIR_AT;
+  }
+  std::printf(" (latencia max %.1f ms)\n", worstLatency);
+  std::printf("  nodo | saltos | beacons | deriva est. (ppm) | paso reloj min..max (ms/ms)\n");
+  for (int i = 0; i < nodeCount; i++) {
+    const SimNode& n = nodes[i];
+    std::printf("  %4d | %6u | %7u | %17.0f | %d..%d\n", i + 1, n.sync.jumps, n.sync.beaconsHeard,
+                n.sync.clock.driftQ16 * 1e6 / 65536.0, n.minStep == (1 << 30) ? 0 : n.minStep, n.maxStep);
+  }
+  for (SimNode& n : nodes) {
+    close(n.masterFd);
+    close(n.slaveFd);
+  }
+  return convergedAt >= 0 ? 0 : 1;
+}
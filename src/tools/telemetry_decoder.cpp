@@ -0,0 +1,234 @@
+// Decodificador de telemetria: volcado "tlm dump" del firmware -> informe.
+//
+// Uso:
+//   telemetry_decoder <captura.txt>     ('-' = stdin)
+//
+// Lee una captura del monitor serie (puede tener otras lineas mezcladas),
+// toma el ultimo volcado completo "tlm begin / tlm data / tlm end", comprueba
+// longitud y CRC y lo decodifica con include/telemetry_format.h: eventos con
+// hora absoluta, sesiones de movimiento, re-disparos del PIR dentro de la
+// ventana (para ajustar MOVEMENT_TIMEOUT_MS) y la tabla de horas de EEPROM.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../include/telemetry_format.h"
+#include "../../include/vm_bytecode.h"
+
+namespace {
+
+const long MOVEMENT_WINDOW_S = 30;  // ventana de un flanco suelto del firmware (MOTION_HOLD_MS + bajada)
+
+struct Dump {
+  unsigned version = 0;
+  size_t declared = 0;
+  std::vector<uint8_t> bytes;
+  unsigned crc = 0;
+  bool complete = false;
+};
+
+[[noreturn]] void fail(const std::string& msg) {
+  std::fprintf(stderr, "error: %s\n", msg.c_str());
+  std::exit(1);
+}
+
+bool parseHex(const std::string& hex, std::vector<uint8_t>& out) {
+  if (hex.size() % 2) return false;
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    char* end = nullptr;
+    std::string pair = hex.substr(i, 2);
+    long v = std::strtol(pair.c_str(), &end, 16);
+    if (*end) return false;
+    out.push_back((uint8_t)v);
+  }
+  return true;
+}
+
+std::string clock(uint32_t s) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%3u:%02u:%02u", (unsigned)(s / 3600), (unsigned)(s / 60 % 60), (unsigned)(s % 60));
+  return buf;
+}
+
+std::string resetCause(uint8_t c) {
+  if (c == 0) return "desconocida";
+  std::string s;
+  if (c & TLM_RESET_POWER) s += " encendido";
+  if (c & TLM_RESET_EXTERNAL) s += " reset-externo";
+  if (c & TLM_RESET_BROWNOUT) s += " brown-out";
+  if (c & TLM_RESET_WATCHDOG) s += " watchdog";
+  return s.substr(1);
+}
+
+struct Reader {
+  const std::vector<uint8_t>& b;
+  size_t pos = 0;
+  uint8_t u8() {
+    if (pos >= b.size()) fail("volcado truncado");
+    return b[pos++];
+  }
+  uint32_t u32() {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)u8() << (8 * i);
+    return v;
+  }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "uso: %s <captura.txt|->\n", argv[0]);
+    return 2;
+  }
+  std::ifstream file;
+  std::istream* in = &std::cin;
+  if (std::string(argv[1]) != "-") {
+    file.open(argv[1]);
+    if (!file) fail(std::string("no se puede abrir ") + argv[1]);
+    in = &file;
+  }
+
+  Dump last, cur;
+  bool inDump = false;
+  for (std::string line; std::getline(*in, line);) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    size_t at = line.find("tlm ");
+    if (at == std::string::npos) continue;
+    std::istringstream ls(line.substr(at + 4));
+    std::string word;
+    ls >> word;
+    if (word == "begin") {
+      cur = Dump();
+      ls >> cur.version >> cur.declared;
+      inDump = true;
+    } else if (word == "data" && inDump) {
+      std::string hex;
+      ls >> hex;
+      if (!parseHex(hex, cur.bytes)) fail("linea de datos invalida: " + line);
+    } else if (word == "end" && inDump) {
+      ls >> std::hex >> cur.crc;
+      cur.complete = true;
+      last = cur;
+      inDump = false;
+    }
+  }
+  if (!last.complete) fail("no hay ningun volcado 'tlm dump' completo");
+  if (last.version != TLM_VERSION) fail("version de formato distinta (" + std::to_string(last.version) + ")");
+  if (last.bytes.size() != last.declared) fail("longitud distinta de la declarada");
+  uint16_t crc = 0xFFFF;
+  for (uint8_t b : last.bytes) crc = vmCrc16Update(crc, b);
+  if (crc != last.crc) fail("CRC distinto: la captura esta corrupta");
+
+  Reader r{last.bytes};
+  if (r.u8() != 'T' || r.u8() != 'M') fail("cabecera invalida");
+  r.u8();  // version (ya comprobada)
+  const unsigned modeCount = r.u8();
+  const uint32_t nowS = r.u32();
+  const uint8_t cause = r.u8();
+  const unsigned eventCount = r.u8();
+  uint32_t t = r.u32();
+
+  std::printf("Telemetria: %u bytes, %u modos, reloj %s (segundos despiertos), ultimo reset: %s\n\n",
+              (unsigned)last.bytes.size(), modeCount, clock(nowS).c_str(), resetCause(cause).c_str());
+
+  // Eventos y analisis de sesiones de movimiento.
+  std::printf("Eventos (%u, del mas antiguo al mas reciente):\n", eventCount);
+  long sessionStart = -1;
+  std::vector<long> sessions;     // duracion de cada sesion cerrada por timeout
+  std::vector<long> retriggers;   // segundos desde el inicio de la sesion
+  unsigned lateRetriggerSessions = 0;
+  bool sessionHadLate = false;
+  for (unsigned i = 0; i < eventCount; i++) {
+    uint8_t head = r.u8();
+    uint16_t delta = (uint16_t)(r.u8() | (r.u8() << 8));
+    t += delta;
+    uint8_t type = head >> 4, arg = head & 0x0F;
+    if (type == TLM_EVT_GAP) continue;
+    std::string what;
+    switch (type) {
+      case TLM_EVT_RESET: what = "ARRANQUE (" + resetCause(arg) + ")"; sessionStart = -1; break;
+      case TLM_EVT_MODE: what = "MODO " + std::to_string(arg + 1); break;
+      case TLM_EVT_PIR:
+        if (arg) {
+          what = "PIR (re-disparo, suma intensidad)";
+          if (sessionStart >= 0) {
+            long off = (long)t - sessionStart;
+            retriggers.push_back(off);
+            if (off >= MOVEMENT_WINDOW_S * 2 / 3) sessionHadLate = true;
+          }
+        } else {
+          what = "PIR -> submodo movimiento";
+          sessionStart = (long)t;
+          sessionHadLate = false;
+        }
+        break;
+      case TLM_EVT_TIMEOUT:
+        what = "fin de submodo (timeout)";
+        if (sessionStart >= 0) {
+          sessions.push_back((long)t - sessionStart);
+          if (sessionHadLate) lateRetriggerSessions++;
+        }
+        sessionStart = -1;
+        break;
+      case TLM_EVT_SLEEP: what = "REPOSO"; break;
+      case TLM_EVT_WAKE: what = arg ? "DESPIERTA (boton)" : "DESPIERTA (PIR)"; break;
+      default: what = "tipo desconocido " + std::to_string(type); break;
+    }
+    std::printf("  %s  %s\n", clock(t).c_str(), what.c_str());
+  }
+  if (!sessions.empty()) {
+    std::printf("\nSesiones de movimiento cerradas: %zu; re-disparos: %zu", sessions.size(), retriggers.size());
+    if (!retriggers.empty()) {
+      long sum = 0;
+      for (long v : retriggers) sum += v;
+      std::printf(" (a %.1f s del inicio de media)", sum / (double)retriggers.size());
+    }
+    std::printf("\nSesiones con alguien aun presente en el ultimo tercio de la ventana: %u de %zu\n",
+                lateRetriggerSessions, sessions.size());
+    if (lateRetriggerSessions * 2 > sessions.size()) {
+      std::printf("  -> la mayoria sigue ahi al cerrar: conviene alargar MOTION_HOLD_MS\n");
+    }
+  }
+
+  // Hora en curso + registros horarios.
+  uint8_t rec[TLM_RECORD_BYTES];
+  TlmHourRecord hr;
+  for (uint8_t& b : rec) b = r.u8();
+  if (!tlmDecodeRecord(rec, hr)) fail("registro de la hora en curso invalido");
+  std::vector<TlmHourRecord> hours;
+  unsigned stored = r.u8();
+  for (unsigned i = 0; i < stored; i++) {
+    for (uint8_t& b : rec) b = r.u8();
+    TlmHourRecord h;
+    if (tlmDecodeRecord(rec, h)) hours.push_back(h);
+  }
+  std::printf("\nHoras (EEPROM, %zu de %u):\n", hours.size(), (unsigned)TLM_RECORD_COUNT);
+  std::printf("   hora |  PIR | timeouts | cambios modo | movimiento | modo principal | reposos\n");
+  unsigned long pirTotal = 0, movementTotal = 0;
+  std::vector<unsigned> mainModes(16, 0);
+  for (const TlmHourRecord& h : hours) {
+    std::printf("  %5u | %4u | %8u | %12u | %6u min | %14u | %7u\n", h.seq, h.pirRises, h.timeouts, h.modeChanges,
+                h.movementUnits * TLM_MOVEMENT_UNIT_S / 60, h.mainMode + 1, h.sleeps);
+    pirTotal += h.pirRises;
+    movementTotal += h.movementUnits * TLM_MOVEMENT_UNIT_S;
+    mainModes[h.mainMode]++;
+  }
+  std::printf("  %5u | %4u | %8u | %12u | %6u min | %14u | %7u  (en curso)\n", hr.seq, hr.pirRises, hr.timeouts,
+              hr.modeChanges, hr.movementUnits * TLM_MOVEMENT_UNIT_S / 60, hr.mainMode + 1, hr.sleeps);
+  if (!hours.empty()) {
+    std::printf("\nMedia: %.1f subidas de PIR por hora, %.1f%% del tiempo en submodo movimiento\n",
+                pirTotal / (double)hours.size(), 100.0 * movementTotal / (hours.size() * (double)TLM_HOUR_S));
+    std::printf("Modo principal por horas:");
+    for (unsigned m = 0; m < modeCount && m < 16; m++) {
+      if (mainModes[m]) std::printf(" M%u=%u", m + 1, mainModes[m]);
+    }
+    std::printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,357 @@
+// Compilador de coreografias: texto legible -> blob binario para PROGMEM.
+//
+// Uso:
+//   timeline_compiler <entrada.tl> <salida.h> [NOMBRE_SIMBOLO]
+//
+// Formato de entrada (una directiva por linea, '#' = comentario):
+//   duration 60s            duracion total (ms o Ns)
+//   loop 12000              punto de loop en ms (por defecto 0)
+//   track CARA              abre la pista de un canal (CAN1 CAN2 CARA FIZO FDEP ATRA)
+//   1500 80% in-out         keyframe: tiempo (ms o Ns), nivel (0-255 o N%), easing
+//                           opcional del tramo que llega aqui (linear|in|out|in-out)
+//
+// Genera un .h con `const uint8_t NOMBRE[] PROGMEM` y lo valida decodificandolo
+// con el mismo reproductor que usa el firmware (include/timeline_format.h).
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../include/timeline_format.h"
+
+namespace {
+
+const char* const CHANNEL_NAMES[TIMELINE_MAX_CHANNELS] = {"CAN1", "CAN2", "CARA", "FIZO", "FDEP", "ATRA"};
+
+struct Keyframe {
+  uint32_t ms;
+  uint8_t value;
+  uint8_t easing;
+  int line;
+};
+
+struct Timeline {
+  uint32_t durationMs = 0;
+  uint32_t loopMs = 0;
+  std::vector<Keyframe> tracks[TIMELINE_MAX_CHANNELS];
+};
+
+[[noreturn]] void fail(const std::string& file, int line, const std::string& msg) {
+  std::fprintf(stderr, "%s:%d: error: %s\n", file.c_str(), line, msg.c_str());
+  std::exit(1);
+}
+
+bool parseTime(const std::string& s, uint32_t& out) {
+  if (s.empty()) return false;
+  char* end = nullptr;
+  double v = std::strtod(s.c_str(), &end);
+  if (end == s.c_str() || v < 0) return false;
+  std::string unit(end);
+  if (unit == "" || unit == "ms") out = (uint32_t)(v + 0.5);
+  else if (unit == "s") out = (uint32_t)(v * 1000.0 + 0.5);
+  else return false;
+  return true;
+}
+
+bool parseLevel(const std::string& s, uint8_t& out) {
+  if (s.empty()) return false;
+  char* end = nullptr;
+  double v = std::strtod(s.c_str(), &end);
+  if (end == s.c_str()) return false;
+  std::string unit(end);
+  if (unit == "%") {
+    if (v < 0 || v > 100) return false;
+    out = (uint8_t)((v * 255.0) / 100.0 + 0.5);  // mismo redondeo que percentToPwm()
+    return true;
+  }
+  if (!unit.empty() || v < 0 || v > 255) return false;
+  out = (uint8_t)v;
+  return true;
+}
+
+bool parseEasing(const std::string& s, uint8_t& out) {
+  if (s == "linear") out = EASE_LINEAR;
+  else if (s == "in") out = EASE_IN;
+  else if (s == "out") out = EASE_OUT;
+  else if (s == "in-out") out = EASE_IN_OUT;
+  else return false;
+  return true;
+}
+
+Timeline parseFile(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) fail(path, 0, "no se puede abrir");
+  Timeline tl;
+  int current = -1;
+  bool haveDuration = false;
+  std::string raw;
+  int lineNo = 0;
+  while (std::getline(in, raw)) {
+    lineNo++;
+    size_t hash = raw.find('#');
+    if (hash != std::string::npos) raw.erase(hash);
+    std::istringstream ls(raw);
+    std::vector<std::string> tok;
+    for (std::string t; ls >> t;) tok.push_back(t);
+    if (tok.empty()) continue;
+
+    if (tok[0] == "timeline") continue;  // nombre informativo
+    if (tok[0] == "duration" || tok[0] == "loop") {
+      uint32_t v;
+      if (tok.size() != 2 || !parseTime(tok[1], v)) fail(path, lineNo, "tiempo invalido");
+      if (tok[0] == "duration") { tl.durationMs = v; haveDuration = true; }
+      else tl.loopMs = v;
+      continue;
+    }
+    if (tok[0] == "track") {
+      if (tok.size() != 2) fail(path, lineNo, "track requiere un canal");
+      current = -1;
+      for (int i = 0; i < TIMELINE_MAX_CHANNELS; i++) {
+        if (tok[1] == CHANNEL_NAMES[i]) current = i;
+      }
+      if (current < 0) fail(path, lineNo, "canal desconocido: " + tok[1]);
+      if (!tl.tracks[current].empty()) fail(path, lineNo, "pista repetida: " + tok[1]);
+      continue;
+    }
+
+    if (current < 0) fail(path, lineNo, "keyframe fuera de una pista");
+    Keyframe k{0, 0, EASE_LINEAR, lineNo};
+    if (tok.size() < 2 || tok.size() > 3) fail(path, lineNo, "se esperaba: <tiempo> <nivel> [easing]");
+    if (!parseTime(tok[0], k.ms)) fail(path, lineNo, "tiempo invalido: " + tok[0]);
+    if (!parseLevel(tok[1], k.value)) fail(path, lineNo, "nivel invalido: " + tok[1]);
+    if (tok.size() == 3 && !parseEasing(tok[2], k.easing)) fail(path, lineNo, "easing invalido: " + tok[2]);
+    std::vector<Keyframe>& tr = tl.tracks[current];
+    if (tr.empty() && k.ms != 0) fail(path, lineNo, "el primer keyframe de una pista debe estar en 0");
+    if (!tr.empty() && k.ms <= tr.back().ms) fail(path, lineNo, "los tiempos deben ser crecientes");
+    if (!tr.empty() && k.ms - tr.back().ms > 0xFFFF) fail(path, lineNo, "tramo mayor de 65535 ms");
+    tr.push_back(k);
+  }
+  if (!haveDuration) fail(path, lineNo, "falta 'duration'");
+  if (tl.loopMs >= tl.durationMs) fail(path, lineNo, "loop debe ser menor que duration");
+  bool any = false;
+  for (int i = 0; i < TIMELINE_MAX_CHANNELS; i++) {
+    if (tl.tracks[i].empty()) continue;
+    any = true;
+    if (tl.tracks[i].back().ms > tl.durationMs) fail(path, tl.tracks[i].back().line, "keyframe despues de duration");
+  }
+  if (!any) fail(path, lineNo, "no hay pistas");
+  return tl;
+}
+
+// Un registro codificado: se guarda aparte para que el RLE solo corte en limites de registro.
+typedef std::vector<uint8_t> Record;
+
+std::vector<Record> encodeTrack(const std::vector<Keyframe>& kf) {
+  std::vector<Record> out;
+  uint32_t lastDt = 0;
+  uint8_t prev = 0;
+  for (size_t i = 0; i < kf.size(); i++) {
+    uint32_t dt = i ? kf[i].ms - kf[i - 1].ms : 0;
+    int delta = (int)kf[i].value - (int)prev;
+    bool abs = (i == 0) || delta < -8 || delta > 7;
+    uint8_t h = (uint8_t)((kf[i].easing & 0x03) << 4);
+    Record r;
+    if (i > 0 && dt != lastDt) h |= TIMELINE_FLAG_NEW_DT;
+    if (abs) h |= TIMELINE_FLAG_ABS;
+    else h |= (uint8_t)(delta & 0x0F);
+    r.push_back(h);
+    if (h & TIMELINE_FLAG_NEW_DT) {
+      uint32_t v = dt;
+      do {
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        if (v) b |= 0x80;
+        r.push_back(b);
+      } while (v);
+      lastDt = dt;
+    }
+    if (abs) r.push_back(kf[i].value);
+    prev = kf[i].value;
+    out.push_back(r);
+  }
+  return out;
+}
+
+size_t bytesOf(const std::vector<Record>& recs, size_t from, size_t count) {
+  size_t n = 0;
+  for (size_t i = from; i < from + count; i++) n += recs[i].size();
+  return n;
+}
+
+bool sameRecords(const std::vector<Record>& recs, size_t a, size_t b, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (recs[a + i] != recs[b + i]) return false;
+  }
+  return true;
+}
+
+// RLE de patrones: bloques consecutivos identicos -> bloque + REPEAT(back, veces).
+// Bytes identicos decodifican igual (el dt reutilizado sale del bloque anterior),
+// asi que la sustitucion es exacta.
+std::vector<uint8_t> packTrack(const std::vector<Record>& recs, size_t& repeats) {
+  std::vector<uint8_t> out;
+  size_t i = 0;
+  while (i < recs.size()) {
+    size_t bestLen = 0, bestTimes = 0, bestSaving = 0;
+    for (size_t len = 1; i + 2 * len <= recs.size(); len++) {
+      size_t blockBytes = bytesOf(recs, i, len);
+      if (blockBytes > 255) break;
+      size_t times = 0;
+      while (times < 255 && i + (times + 2) * len <= recs.size() &&
+             sameRecords(recs, i, i + (times + 1) * len, len)) {
+        times++;
+      }
+      if (times == 0) continue;
+      size_t saving = times * blockBytes;
+      if (saving > 3 && saving - 3 > bestSaving) {
+        bestSaving = saving - 3;
+        bestLen = len;
+        bestTimes = times;
+      }
+    }
+    if (bestLen == 0) {
+      out.insert(out.end(), recs[i].begin(), recs[i].end());
+      i++;
+      continue;
+    }
+    size_t blockBytes = bytesOf(recs, i, bestLen);
+    for (size_t k = 0; k < bestLen; k++) out.insert(out.end(), recs[i + k].begin(), recs[i + k].end());
+    out.push_back(TIMELINE_REPEAT);
+    out.push_back((uint8_t)blockBytes);
+    out.push_back((uint8_t)bestTimes);
+    repeats++;
+    i += bestLen * (bestTimes + 1);
+  }
+  return out;
+}
+
+void putU16(std::vector<uint8_t>& b, size_t at, uint32_t v) {
+  b[at] = v & 0xFF;
+  b[at + 1] = (v >> 8) & 0xFF;
+}
+
+void putU32(std::vector<uint8_t>& b, size_t at, uint32_t v) {
+  putU16(b, at, v & 0xFFFF);
+  putU16(b, at + 2, v >> 16);
+}
+
+// Nivel esperado en ms, calculado directamente desde los keyframes.
+uint8_t referenceLevel(const std::vector<Keyframe>& kf, uint32_t ms) {
+  if (ms >= kf.back().ms) return kf.back().value;
+  size_t k = 1;
+  while (kf[k].ms <= ms) k++;
+  const Keyframe& a = kf[k - 1];
+  const Keyframe& b = kf[k];
+  uint32_t len = b.ms - a.ms;
+  uint16_t p = (uint16_t)(((uint64_t)(ms - a.ms) * (16777216UL / len)) >> 16);
+  uint16_t e = timelineEase(b.easing, p);
+  return (uint8_t)(((uint16_t)a.value * (256 - e) + (uint16_t)b.value * e) >> 8);
+}
+
+// Reproduce el blob con el decodificador del firmware y lo compara con los keyframes.
+bool verifyBlob(const std::vector<uint8_t>& blob, const Timeline& tl) {
+  TimelineTrack tracks[TIMELINE_MAX_CHANNELS];
+  uint8_t n = timelineOpen(blob.data(), tracks);
+  for (uint8_t k = 0; k < n; k++) {
+    const std::vector<Keyframe>& kf = tl.tracks[tracks[k].channel];
+    for (uint32_t ms = 0; ms <= tl.durationMs; ms += 10) {
+      uint8_t got = timelineSample(blob.data(), tracks[k], ms);
+      uint8_t want = referenceLevel(kf, ms);
+      if (got != want) {
+        std::fprintf(stderr, "verificacion: %s en %u ms = %u (esperado %u)\n",
+                     CHANNEL_NAMES[tracks[k].channel], (unsigned)ms, got, want);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::string baseName(const std::string& path) {
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::fprintf(stderr, "uso: %s <entrada.tl> <salida.h> [NOMBRE_SIMBOLO]\n", argv[0]);
+    return 2;
+  }
+  const std::string inPath = argv[1];
+  const std::string outPath = argv[2];
+  const std::string symbol = argc > 3 ? argv[3] : "TIMELINE_DATA";
+
+  Timeline tl = parseFile(inPath);
+
+  uint8_t mask = 0;
+  uint8_t trackCount = 0;
+  for (int i = 0; i < TIMELINE_MAX_CHANNELS; i++) {
+    if (!tl.tracks[i].empty()) {
+      mask |= (uint8_t)(1 << i);
+      trackCount++;
+    }
+  }
+
+  std::vector<uint8_t> blob(TIMELINE_HEADER_BYTES + 2 * trackCount, 0);
+  blob[0] = 'T';
+  blob[1] = 'L';
+  blob[2] = TIMELINE_VERSION;
+  blob[3] = mask;
+  putU32(blob, 4, tl.durationMs);
+  putU32(blob, 8, tl.loopMs);
+
+  size_t keyframes = 0, repeats = 0, unpacked = 0;
+  uint8_t slot = 0;
+  for (int i = 0; i < TIMELINE_MAX_CHANNELS; i++) {
+    if (tl.tracks[i].empty()) continue;
+    std::vector<Record> recs = encodeTrack(tl.tracks[i]);
+    for (const Record& r : recs) unpacked += r.size();
+    std::vector<uint8_t> packed = packTrack(recs, repeats);
+    putU16(blob, TIMELINE_HEADER_BYTES + 2 * slot, (uint32_t)blob.size());
+    blob.insert(blob.end(), packed.begin(), packed.end());
+    keyframes += tl.tracks[i].size();
+    slot++;
+  }
+  if (blob.size() > 0xFFFF) {
+    std::fprintf(stderr, "error: el blob supera 64 KB (%zu bytes)\n", blob.size());
+    return 1;
+  }
+  putU16(blob, 12, (uint32_t)blob.size());
+
+  if (!verifyBlob(blob, tl)) return 1;
+
+  FILE* out = std::fopen(outPath.c_str(), "w");
+  if (!out) {
+    std::fprintf(stderr, "error: no se puede escribir %s\n", outPath.c_str());
+    return 1;
+  }
+  std::fprintf(out, "#pragma once\n\n");
+  std::fprintf(out, "// Generado por src/tools/timeline_compiler.cpp desde %s. No editar a mano.\n",
+               baseName(inPath).c_str());
+  std::fprintf(out, "// %u pistas, %zu keyframes, %u ms (loop en %u ms).\n\n", trackCount, keyframes,
+               (unsigned)tl.durationMs, (unsigned)tl.loopMs);
+  std::fprintf(out, "#include \"timeline_format.h\"\n\n");
+  std::fprintf(out, "const uint16_t %s_SIZE = %zu;\n\n", symbol.c_str(), blob.size());
+  std::fprintf(out, "const uint8_t %s[] PROGMEM = {", symbol.c_str());
+  for (size_t i = 0; i < blob.size(); i++) {
+    std::fprintf(out, "%s0x%02X%s", (i % 12) ? " " : "\n  ", blob[i], i + 1 < blob.size() ? "," : "");
+  }
+  std::fprintf(out, "\n};\n");
+  std::fclose(out);
+
+  // Referencia: 4 bytes por keyframe (u16 tiempo + nivel + easing) sin compresion.
+  std::printf("%s: %u pistas, %zu keyframes, %u ms\n", baseName(inPath).c_str(), trackCount, keyframes,
+              (unsigned)tl.durationMs);
+  std::printf("  blob: %zu bytes de flash (cabecera %u, registros %zu -> %zu con %zu REPEAT)\n", blob.size(),
+              (unsigned)(TIMELINE_HEADER_BYTES + 2 * trackCount), unpacked,
+              blob.size() - TIMELINE_HEADER_BYTES - 2 * trackCount, repeats);
+  std::printf("  sin comprimir: %zu bytes (4 B/keyframe)\n", keyframes * 4);
+  std::printf("  RAM del reproductor: %zu bytes por pista (host)\n", sizeof(TimelineTrack));
+  return 0;
+}
@@ -0,0 +1,378 @@
+// Compilador de textos de la consola: ui/consola.txt -> tabla comprimida con
+// diccionario para PROGMEM (include/ui_text_format.h).
+//
+// Uso:
+//   ui_text_compiler <entrada.txt> <salida.h>
+//
+// Formato de entrada ('#' al principio de linea = comentario):
+//   leds CAN1 CAN2 CARA FIZO FDEP ATRA   nombres de los LEDs (hasta 4 letras)
+//   [NOMBRE]                             abre un texto (UI_NOMBRE en el firmware)
+//   texto                                una linea de salida; acaba en \ = sin salto
+//   {k} {k:3} {k:led}                    argumento k: decimal, 3 columnas, nombre de LED
+// Los nombres de LED y los porcentajes literales se convierten solos en tokens.
+//
+// Compresion: se elige de forma voraz el fragmento que mas bytes ahorra (hasta
+// UI_MAX_FRAGMENTS, sin fragmentos dentro de fragmentos) y se sustituye en
+// todos los textos. La tabla se valida decodificando cada texto con el mismo
+// codigo del firmware. Informa el tamano antes (literales F() equivalentes) y
+// despues (diccionario + textos + indices).
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../include/ui_text_format.h"
+
+namespace {
+
+[[noreturn]] void fail(const std::string& file, int line, const std::string& msg) {
+  if (line > 0) std::fprintf(stderr, "%s:%d: error: %s\n", file.c_str(), line, msg.c_str());
+  else std::fprintf(stderr, "%s: error: %s\n", file.c_str(), msg.c_str());
+  std::exit(1);
+}
+
+// Simbolo: byte literal o token de un byte (< 0x100), token con argumento
+// (token << 8 | arg) o referencia a fragmento (FRAG_REF | f).
+typedef char16_t Sym;
+const Sym FRAG_REF = 0x8000;
+
+inline size_t symBytes(Sym s) { return (s & FRAG_REF) ? 1 : ((s >> 8) ? 2 : 1); }
+
+struct Line {
+  std::string source;  // texto tal cual (para la referencia)
+  bool newline;
+  int lineNo;
+};
+
+struct Text {
+  std::string name;
+  std::vector<Line> lines;
+  std::u16string syms;
+};
+
+struct Source {
+  std::vector<std::string> leds;
+  std::vector<Text> texts;
+};
+
+bool isAlnum(char c) { return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); }
+
+Source readSource(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) fail(path, 0, "no se puede abrir");
+  Source src;
+  std::string raw;
+  int lineNo = 0;
+  while (std::getline(in, raw)) {
+    lineNo++;
+    if (!raw.empty() && raw.back() == '\r') raw.pop_back();
+    if (!raw.empty() && raw[0] == '#') continue;
+    if (raw.size() > 2 && raw[0] == '[' && raw.back() == ']') {
+      Text t;
+      t.name = raw.substr(1, raw.size() - 2);
+      for (char c : t.name) {
+        if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')) fail(path, lineNo, "nombre invalido: " + t.name);
+      }
+      for (const Text& o : src.texts) {
+        if (o.name == t.name) fail(path, lineNo, "texto repetido: " + t.name);
+      }
+      src.texts.push_back(t);
+      continue;
+    }
+    if (src.texts.empty()) {
+      if (raw.empty()) continue;
+      std::istringstream ls(raw);
+      std::string word;
+      ls >> word;
+      if (word != "leds") fail(path, lineNo, "se esperaba 'leds' o [NOMBRE]");
+      while (ls >> word) {
+        if (word.size() >= UI_LED_NAME_BYTES) fail(path, lineNo, "nombre de LED de mas de 4 letras: " + word);
+        src.leds.push_back(word);
+      }
+      if (src.leds.size() != UI_LED_COUNT) fail(path, lineNo, "'leds' necesita " + std::to_string(UI_LED_COUNT) + " nombres");
+      continue;
+    }
+    Line l;
+    l.newline = !(raw.size() && raw.back() == '\\');
+    l.source = l.newline ? raw : raw.substr(0, raw.size() - 1);
+    l.lineNo = lineNo;
+    src.texts.back().lines.push_back(l);
+  }
+  if (src.leds.empty()) fail(path, 0, "falta 'leds'");
+  if (src.texts.empty()) fail(path, 0, "sin textos");
+  if (src.texts.size() > 255) fail(path, 0, "mas de 255 textos");
+  for (Text& t : src.texts) {
+    while (!t.lines.empty() && t.lines.back().source.empty() && t.lines.back().newline) t.lines.pop_back();
+    if (t.lines.empty()) fail(path, 0, "texto vacio: " + t.name);
+  }
+  return src;
+}
+
+// Linea -> simbolos. Cuenta tambien los bytes que ocupaba como literales F()
+// (cada tramo entre argumentos con su 0 final).
+void tokenize(const std::string& path, const Source& src, const Line& l, std::u16string& out, size_t& rawBytes) {
+  const std::string& s = l.source;
+  size_t segment = 0;
+  for (size_t i = 0; i < s.size();) {
+    char c = s[i];
+    if (c == '{') {
+      size_t close = s.find('}', i);
+      if (close == std::string::npos) fail(path, l.lineNo, "'{' sin cerrar");
+      std::string body = s.substr(i + 1, close - i - 1);
+      std::string kind;
+      size_t colon = body.find(':');
+      if (colon != std::string::npos) {
+        kind = body.substr(colon + 1);
+        body = body.substr(0, colon);
+      }
+      if (body.size() != 1 || body[0] < '0' || body[0] >= '0' + UI_MAX_ARGS) fail(path, l.lineNo, "argumento invalido: {" + body + "}");
+      uint8_t tok = kind.empty() ? UI_TOK_ARG : kind == "3" ? UI_TOK_ARG3 : kind == "led" ? UI_TOK_ARGLED : 0;
+      if (!tok) fail(path, l.lineNo, "formato de argumento desconocido: " + kind);
+      out.push_back((Sym)((tok << 8) | (body[0] - '0')));
+      if (segment) rawBytes += segment + 1;
+      segment = 0;
+      i = close + 1;
+      continue;
+    }
+    if (c < 0x20 || c > 0x7E) fail(path, l.lineNo, "caracter no ASCII imprimible");
+    bool wordStart = i == 0 || !isAlnum(s[i - 1]);
+    if (wordStart) {
+      bool matched = false;
+      for (size_t k = 0; k < src.leds.size() && !matched; k++) {
+        const std::string& n = src.leds[k];
+        if (s.compare(i, n.size(), n) == 0 && (i + n.size() == s.size() || !isAlnum(s[i + n.size()]))) {
+          out.push_back((Sym)(UI_TOK_LED + k));
+          segment += n.size();
+          i += n.size();
+          matched = true;
+        }
+      }
+      if (matched) continue;
+      if (c >= '0' && c <= '9') {
+        size_t j = i;
+        while (j < s.size() && s[j] >= '0' && s[j] <= '9') j++;
+        long v = std::strtol(s.substr(i, j - i).c_str(), nullptr, 10);
+        bool canonical = j - i == 1 || s[i] != '0';
+        if (j < s.size() && s[j] == '%' && canonical && v <= 255) {
+          out.push_back((Sym)((UI_TOK_PCT << 8) | v));
+          segment += j + 1 - i;
+          i = j + 1;
+          continue;
+        }
+      }
+    }
+    out.push_back((Sym)(uint8_t)c);
+    segment++;
+    i++;
+  }
+  if (l.newline) out.push_back((Sym)'\n');
+  rawBytes += segment + 1;  // "" de un println() vacio tambien ocupa su 0
+}
+
+size_t bytesOf(const std::u16string& syms) {
+  size_t n = 0;
+  for (Sym s : syms) n += symBytes(s);
+  return n;
+}
+
+// Fragmento voraz: el que mas ahorra contando su entrada en el diccionario.
+std::vector<std::u16string> compress(std::vector<Text>& texts) {
+  const size_t MAX_LEN = 64;
+  std::vector<std::u16string> dict;
+  while (dict.size() < UI_MAX_FRAGMENTS) {
+    struct Cand {
+      size_t count = 0;
+      size_t text = (size_t)-1;
+      size_t end = 0;
+    };
+    std::unordered_map<std::u16string, Cand> cands;
+    for (size_t t = 0; t < texts.size(); t++) {
+      const std::u16string& s = texts[t].syms;
+      for (size_t i = 0; i < s.size(); i++) {
+        for (size_t len = 2; len <= MAX_LEN && i + len <= s.size(); len++) {
+          if (s[i + len - 1] & FRAG_REF) break;
+          if (s[i] & FRAG_REF) break;
+          Cand& c = cands[s.substr(i, len)];
+          if (c.text == t && i < c.end) continue;  // solapada con la anterior
+          c.count++;
+          c.text = t;
+          c.end = i + len;
+        }
+      }
+    }
+    long bestGain = 0;
+    std::u16string best;
+    for (const auto& kv : cands) {
+      size_t bytes = bytesOf(kv.first);
+      if (bytes > 255) continue;
+      long gain = (long)kv.second.count * (long)(bytes - 1) - (long)(bytes + 1);
+      if (gain > bestGain || (gain == bestGain && gain > 0 && kv.first < best)) {
+        bestGain = gain;
+        best = kv.first;
+      }
+    }
+    if (bestGain <= 0) break;
+    const Sym ref = (Sym)(FRAG_REF | dict.size());
+    dict.push_back(best);
+    for (Text& t : texts) {
+      std::u16string out;
+      for (size_t i = 0; i < t.syms.size();) {
+        if (t.syms.compare(i, best.size(), best) == 0) {
+          out.push_back(ref);
+          i += best.size();
+        } else {
+          out.push_back(t.syms[i++]);
+        }
+      }
+      t.syms = out;
+    }
+  }
+  return dict;
+}
+
+void appendSyms(std::vector<uint8_t>& out, const std::u16string& syms) {
+  for (Sym s : syms) {
+    if (s & FRAG_REF) {
+      out.push_back((uint8_t)(UI_FRAGMENT + (s & 0x7F)));
+    } else if (s >> 8) {
+      out.push_back((uint8_t)(s >> 8));
+      out.push_back((uint8_t)(s & 0xFF));
+    } else {
+      out.push_back((uint8_t)s);
+    }
+  }
+}
+
+// Salida de prueba para el decodificador del firmware.
+struct StringOut {
+  std::string s;
+  void write(uint8_t c) { s.push_back((char)c); }
+};
+
+// Lo que deberia imprimir el texto con esos argumentos.
+std::string expand(const Source& src, const Text& t, const uint16_t* args) {
+  std::string r;
+  for (const Line& l : t.lines) {
+    const std::string& s = l.source;
+    for (size_t i = 0; i < s.size(); i++) {
+      if (s[i] != '{') {
+        r.push_back(s[i]);
+        continue;
+      }
+      size_t close = s.find('}', i);
+      std::string body = s.substr(i + 1, close - i - 1);
+      uint16_t v = args[body[0] - '0'];
+      std::string num = std::to_string(v);
+      if (body.size() > 2 && body.substr(2) == "led") num = v < src.leds.size() ? src.leds[v] : "";
+      else if (body.size() > 2 && body.substr(2) == "3") num = std::string(num.size() < 3 ? 3 - num.size() : 0, ' ') + num;
+      r += num;
+      i = close;
+    }
+    if (l.newline) r += "\r\n";
+  }
+  return r;
+}
+
+std::string fileName(const std::string& path) {
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+void writeBytes(std::ofstream& out, const std::vector<uint8_t>& bytes) {
+  char buf[16];
+  for (size_t i = 0; i < bytes.size(); i++) {
+    std::snprintf(buf, sizeof(buf), "%s0x%02X", i % 12 ? ", " : (i ? ",\n  " : "\n  "), bytes[i]);
+    out << buf;
+  }
+  out << "\n};\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::fprintf(stderr, "uso: %s <entrada.txt> <salida.h>\n", argv[0]);
+    return 2;
+  }
+  Source src = readSource(argv[1]);
+
+  size_t rawBytes = 0;
+  for (Text& t : src.texts) {
+    for (const Line& l : t.lines) tokenize(argv[1], src, l, t.syms, rawBytes);
+  }
+  size_t plainBytes = 0;
+  for (const Text& t : src.texts) plainBytes += bytesOf(t.syms) + 1;
+
+  std::vector<std::u16string> dict = compress(src.texts);
+
+  std::vector<uint8_t> dictBytes, textBytes;
+  std::vector<uint16_t> index;
+  for (const std::u16string& f : dict) {
+    dictBytes.push_back((uint8_t)bytesOf(f));
+    appendSyms(dictBytes, f);
+  }
+  for (const Text& t : src.texts) {
+    if (textBytes.size() > 0xFFFF) fail(argv[1], 0, "tabla de textos mayor de 64 KB");
+    index.push_back((uint16_t)textBytes.size());
+    appendSyms(textBytes, t.syms);
+    textBytes.push_back(0);
+  }
+  char ledNames[UI_LED_COUNT][UI_LED_NAME_BYTES] = {};
+  for (size_t k = 0; k < UI_LED_COUNT; k++) src.leds[k].copy(ledNames[k], UI_LED_NAME_BYTES - 1);
+  const size_t packed = dictBytes.size() + textBytes.size() + index.size() * 2 + sizeof(ledNames);
+
+  // Validacion con el decodificador del firmware (dos juegos de argumentos).
+  const UiTextTable table = {dictBytes.data(), index.data(), textBytes.data(), ledNames};
+  const uint16_t argSets[2][UI_MAX_ARGS] = {{0, 1, 2, 3, 4, 5, 6, 7}, {5, 99, 100, 255, 1000, 65535, 4, 0}};
+  for (size_t id = 0; id < src.texts.size(); id++) {
+    for (const uint16_t* args : argSets) {
+      StringOut got;
+      uiTextEmit(got, table, (uint8_t)id, args);
+      if (got.s != expand(src, src.texts[id], args)) fail(argv[1], 0, "la tabla no decodifica igual: " + src.texts[id].name);
+    }
+  }
+
+  std::ofstream out(argv[2]);
+  if (!out) fail(argv[2], 0, "no se puede escribir");
+  char line[200];
+  out << "#pragma once\n\n";
+  out << "// Generado por src/tools/ui_text_compiler.cpp desde " << fileName(argv[1]) << ". No editar a mano.\n";
+  std::snprintf(line, sizeof(line),
+                "// %zu textos: %zu bytes como literales F() -> %zu bytes (diccionario %zu fragmentos %zu,\n"
+                "// textos %zu, indice %zu, nombres de LED %zu).\n",
+                src.texts.size(), rawBytes, packed, dict.size(), dictBytes.size(), textBytes.size(), index.size() * 2,
+                sizeof(ledNames));
+  out << line << "\n#include \"ui_text_format.h\"\n\n";
+  out << "enum UiText : uint8_t {\n";
+  for (size_t i = 0; i < src.texts.size(); i++) out << "  UI_" << src.texts[i].name << (i ? ",\n" : " = 0,\n");
+  out << "  UI_TEXT_COUNT\n};\n\n";
+  out << "const uint16_t UI_TEXT_RAW_BYTES = " << rawBytes << ";    // como literales F()\n";
+  out << "const uint16_t UI_TEXT_PACKED_BYTES = " << packed << ";\n\n";
+  out << "const char UI_LED_NAMES[" << (int)UI_LED_COUNT << "][" << (int)UI_LED_NAME_BYTES << "] PROGMEM = {";
+  for (size_t k = 0; k < UI_LED_COUNT; k++) out << (k ? ", " : "") << '"' << src.leds[k] << '"';
+  out << "};\n\n";
+  out << "const uint8_t UI_DICT[] PROGMEM = {";
+  writeBytes(out, dictBytes);
+  out << "\nconst uint16_t UI_TEXT_INDEX[] PROGMEM = {";
+  for (size_t i = 0; i < index.size(); i++) {
+    std::snprintf(line, sizeof(line), "%s%u", i % 12 ? ", " : (i ? ",\n  " : "\n  "), index[i]);
+    out << line;
+  }
+  out << "\n};\n\n";
+  out << "const uint8_t UI_TEXTS[] PROGMEM = {";
+  writeBytes(out, textBytes);
+  out << "\nconst UiTextTable UI_TEXT_TABLE = {UI_DICT, UI_TEXT_INDEX, UI_TEXTS, UI_LED_NAMES};\n";
+
+  std::printf("%s: %zu textos, %zu bytes como literales F()\n", argv[1], src.texts.size(), rawBytes);
+  std::printf("  tokens (LEDs, porcentajes, argumentos): %zu bytes\n", plainBytes);
+  std::printf("  diccionario: %zu fragmentos, %zu bytes; textos %zu bytes; indice %zu bytes\n", dict.size(),
+              dictBytes.size(), textBytes.size(), index.size() * 2);
+  std::printf("  total %zu -> %zu bytes de flash (%.0f%%)\n", rawBytes, packed, packed * 100.0 / rawBytes);
+  std::printf("  -> %s (UI_TEXT_TABLE)\n", argv[2]);
+  return 0;
+}
@@ -0,0 +1,217 @@
+// Ensamblador de escenas VM: texto -> bytecode + comandos de subida por serie.
+//
+// Uso:
+//   vm_assembler <entrada.vm> <slot> [revision]
+//
+// Escribe en stdout las lineas "vm begin / vm data / vm end" para pegar (o
+// enviar linea a linea esperando "OK") en la consola serie del firmware, y en
+// stderr el tamano y el CRC del programa.
+//
+// Sintaxis (una instruccion por linea, '#' = comentario):
+//   etiqueta:            destino de salto
+//   push 40%             apila un nivel (0-255, N% o ms); elige PUSH8/PUSH16
+//   ramp CARA            canales: CAN1 CAN2 CARA FIZO FDEP ATRA (o 0..5)
+//   osc 4200             periodo en ms
+//   jnz etiqueta
+// Mnemonicos: end push dup drop swap add sub scale dec load store jmp jz jnz
+//             out ramp level wait yield rand osc wave motion intensity
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../include/vm_bytecode.h"
+
+namespace {
+
+const char* const CHANNEL_NAMES[VM_CHANNEL_COUNT] = {"CAN1", "CAN2", "CARA", "FIZO", "FDEP", "ATRA"};
+
+struct Mnemonic {
+  const char* name;
+  uint8_t op;
+};
+
+const Mnemonic MNEMONICS[] = {
+  {"end", VM_OP_END},     {"dup", VM_OP_DUP},     {"drop", VM_OP_DROP},   {"swap", VM_OP_SWAP},
+  {"add", VM_OP_ADD},     {"sub", VM_OP_SUB},     {"scale", VM_OP_SCALE}, {"dec", VM_OP_DEC},
+  {"load", VM_OP_LOAD},   {"store", VM_OP_STORE}, {"jmp", VM_OP_JMP},     {"jz", VM_OP_JZ},
+  {"jnz", VM_OP_JNZ},     {"out", VM_OP_OUT},     {"ramp", VM_OP_RAMP},   {"level", VM_OP_LEVEL},
+  {"wait", VM_OP_WAIT},   {"yield", VM_OP_YIELD}, {"rand", VM_OP_RAND},   {"osc", VM_OP_OSC},
+  {"wave", VM_OP_WAVE},   {"motion", VM_OP_MOTION}, {"intensity", VM_OP_INTENSITY},
+};
+
+struct Line {
+  int number;
+  std::string mnemonic;
+  std::string arg;
+};
+
+[[noreturn]] void fail(const std::string& file, int line, const std::string& msg) {
+  std::fprintf(stderr, "%s:%d: error: %s\n", file.c_str(), line, msg.c_str());
+  std::exit(1);
+}
+
+// Entero con signo, "N%" (nivel PWM) o "Ns" (ms).
+bool parseValue(const std::string& s, long& out) {
+  if (s.empty()) return false;
+  char* end = nullptr;
+  double v = std::strtod(s.c_str(), &end);
+  if (end == s.c_str()) return false;
+  std::string unit(end);
+  if (unit == "%") {
+    if (v < 0 || v > 100) return false;
+    out = (long)((v * 255.0) / 100.0 + 0.5);  // mismo redondeo que percentToPwm()
+  } else if (unit == "s") {
+    out = (long)(v * 1000.0 + 0.5);
+  } else if (unit.empty() || unit == "ms") {
+    out = (long)v;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parseChannel(const std::string& s, long& out) {
+  for (int i = 0; i < VM_CHANNEL_COUNT; i++) {
+    if (s == CHANNEL_NAMES[i]) {
+      out = i;
+      return true;
+    }
+  }
+  return parseValue(s, out) && out >= 0 && out < VM_CHANNEL_COUNT;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::fprintf(stderr, "uso: %s <entrada.vm> <slot> [revision]\n", argv[0]);
+    return 2;
+  }
+  const std::string path = argv[1];
+  const int slot = std::atoi(argv[2]);
+  const int rev = argc > 3 ? std::atoi(argv[3]) : 1;
+  if (slot < 0 || slot > 2 || rev < 0 || rev > 255) {
+    std::fprintf(stderr, "error: slot 0..2, revision 0..255\n");
+    return 2;
+  }
+
+  std::ifstream in(path);
+  if (!in) fail(path, 0, "no se puede abrir");
+
+  // Pasada 1: etiquetas y tamanos.
+  std::vector<Line> lines;
+  std::map<std::string, uint16_t> labels;
+  uint16_t pc = 0;
+  std::string raw;
+  int lineNo = 0;
+  while (std::getline(in, raw)) {
+    lineNo++;
+    size_t hash = raw.find('#');
+    if (hash != std::string::npos) raw.erase(hash);
+    std::istringstream ls(raw);
+    std::vector<std::string> tok;
+    for (std::string t; ls >> t;) tok.push_back(t);
+    if (tok.empty()) continue;
+    if (tok[0].back() == ':') {
+      std::string name = tok[0].substr(0, tok[0].size() - 1);
+      if (labels.count(name)) fail(path, lineNo, "etiqueta repetida: " + name);
+      labels[name] = pc;
+      tok.erase(tok.begin());
+      if (tok.empty()) continue;
+    }
+    if (tok.size() > 2) fail(path, lineNo, "se esperaba: <mnemonico> [argumento]");
+    Line l{lineNo, tok[0], tok.size() > 1 ? tok[1] : ""};
+    if (l.mnemonic == "push") {
+      long v;
+      if (!parseValue(l.arg, v) || v < -32768 || v > 32767) fail(path, lineNo, "valor invalido: " + l.arg);
+      pc = (uint16_t)(pc + ((v >= 0 && v <= 255) ? 2 : 3));
+    } else {
+      const Mnemonic* m = nullptr;
+      for (const Mnemonic& cand : MNEMONICS) {
+        if (l.mnemonic == cand.name) m = &cand;
+      }
+      if (!m) fail(path, lineNo, "mnemonico desconocido: " + l.mnemonic);
+      uint8_t imm = vmImmBytes(m->op);
+      if ((imm > 0) != !l.arg.empty()) fail(path, lineNo, imm ? "falta el argumento" : "sobra el argumento");
+      pc = (uint16_t)(pc + 1 + imm);
+    }
+    lines.push_back(l);
+  }
+
+  // Pasada 2: emision.
+  std::vector<uint8_t> code;
+  for (const Line& l : lines) {
+    if (l.mnemonic == "push") {
+      long v;
+      parseValue(l.arg, v);
+      if (v >= 0 && v <= 255) {
+        code.push_back(VM_OP_PUSH8);
+        code.push_back((uint8_t)v);
+      } else {
+        code.push_back(VM_OP_PUSH16);
+        code.push_back((uint8_t)(v & 0xFF));
+        code.push_back((uint8_t)((v >> 8) & 0xFF));
+      }
+      continue;
+    }
+    uint8_t op = 0;
+    for (const Mnemonic& cand : MNEMONICS) {
+      if (l.mnemonic == cand.name) op = cand.op;
+    }
+    code.push_back(op);
+    long v = 0;
+    switch (op) {
+      case VM_OP_JMP:
+      case VM_OP_JZ:
+      case VM_OP_JNZ:
+        if (!labels.count(l.arg)) fail(path, l.number, "etiqueta desconocida: " + l.arg);
+        v = labels[l.arg];
+        break;
+      case VM_OP_OUT:
+      case VM_OP_RAMP:
+      case VM_OP_LEVEL:
+        if (!parseChannel(l.arg, v)) fail(path, l.number, "canal invalido: " + l.arg);
+        break;
+      case VM_OP_LOAD:
+      case VM_OP_STORE:
+        if (!parseValue(l.arg, v) || v < 0 || v >= VM_VAR_COUNT) fail(path, l.number, "variable 0..3");
+        break;
+      case VM_OP_OSC:
+      case VM_OP_WAVE:
+        if (!parseValue(l.arg, v) || v < 1 || v > 65535) fail(path, l.number, "periodo 1..65535 ms");
+        break;
+      default:
+        break;
+    }
+    uint8_t imm = vmImmBytes(op);
+    if (imm >= 1) code.push_back((uint8_t)(v & 0xFF));
+    if (imm == 2) code.push_back((uint8_t)((v >> 8) & 0xFF));
+  }
+
+  uint16_t errAt;
+  VmVerifyResult res = vmVerifyProgram([&code](uint16_t a) { return code[a]; }, (uint16_t)code.size(), errAt);
+  if (res != VM_VERIFY_OK) {
+    std::fprintf(stderr, "error: programa invalido (codigo %u en pc=%u, %zu bytes; maximo %u)\n", (unsigned)res,
+                 (unsigned)errAt, code.size(), (unsigned)VM_MAX_CODE_BYTES);
+    return 1;
+  }
+
+  uint16_t crc = 0xFFFF;
+  for (uint8_t b : code) crc = vmCrc16Update(crc, b);
+
+  std::printf("vm begin %d %zu %d\n", slot, code.size(), rev);
+  for (size_t i = 0; i < code.size(); i += 32) {
+    std::printf("vm data ");
+    for (size_t k = i; k < code.size() && k < i + 32; k++) std::printf("%02X", code[k]);
+    std::printf("\n");
+  }
+  std::printf("vm end %04X\n", crc);
+  std::fprintf(stderr, "%s: %zu bytes de %u (slot %d, rev %d, crc %04X)\n", path.c_str(), code.size(),
+               (unsigned)VM_MAX_CODE_BYTES, slot, rev, crc);
+  return 0;
+}
@@ -1,4 +1,40 @@
 #include <Arduino.h>
+#include <EEPROM.h>
+#include <avr/wdt.h>
+#include "shrine_engine.h"
+#include "power_model.h"
+#include "power_governor.h"
+#include "duty_meter.h"
+#include "telemetry_format.h"
+#include "ui_consola.h"
+
+// Bus de sincronizacion entre varios controladores (ver seccion "Sincronizacion
+// multi-nodo"). Desactivado por defecto: una sola hornacina no lo necesita.
+#ifndef SYNC_BUS_ENABLED
+#define SYNC_BUS_ENABLED 0
+#endif
+#if SYNC_BUS_ENABLED
+#include <SoftwareSerial.h>
+#include "sync_protocol.h"
+#endif
+
+// Dos hornacinas independientes en una placa (ver seccion "Controlador de
+// hornacina"): cada una con CAN1, CAN2 y CARA, su boton y su PIR.
+#ifndef SHRINE_SPLIT
+#define SHRINE_SPLIT 0
+#endif
+
+// Reposo por inactividad (ver seccion "Reposo por inactividad"). Un nodo del
+// bus no puede dormir: perderia el reloj y la eleccion de maestro del grupo.
+#ifndef SLEEP_ENABLED
+#define SLEEP_ENABLED (!SYNC_BUS_ENABLED)
+#endif
+#if SLEEP_ENABLED && SYNC_BUS_ENABLED
+#error "SLEEP_ENABLED y SYNC_BUS_ENABLED son incompatibles"
+#endif
+#if SLEEP_ENABLED
+#include <avr/sleep.h>
+#endif
 
 /*
  LED MAPEADO (PIN -> CODIGO -> descripcion)
@@ -14,1020 +50,2117 @@
 const uint8_t BTN_PIN = 2;
 const uint8_t PIR_PIN = 4;
 const uint8_t LED_PINS[] = {3, 5, 6, 9, 10, 11};
-const uint8_t LED_COUNT = sizeof(LED_PINS) / sizeof(LED_PINS[0]);
+static_assert(sizeof(LED_PINS) == LED_COUNT, "una salida de la placa por canal de la hornacina");
 
 // Nombres para cada LED
 String ledNames[6];
 
-// Estados actuales (brillo 0-255)
-uint8_t ledBrightness[6] = {0, 0, 0, 0, 0, 0};
+// Memoria justa (seccion "Memoria"): se recorta el log verboso por serie.
+bool memLow = false;
+
+// Contexto de frame de la placa: una sola lectura de millis() por vuelta de
+// loop() (ver beginFrame()); cada hornacina lo recibe en shrineRender().
+FrameContext frameCtx = {0, 0, 0, 0, false, 0};
+
+// Hornacinas de la placa (motor en include/shrine_engine.h). La principal,
+// shrines[0], es la que siguen consola, bus, telemetria y watchdog.
+const uint8_t SHRINE_COUNT = SHRINE_SPLIT ? 2 : 1;
+ShrineController shrines[SHRINE_COUNT];
+
+// Hornacinas de la placa. Con SHRINE_SPLIT cada una tiene 3 LEDs (CAN1, CAN2,
+// CARA); FIZO/FDEP/ATRA quedan sin cablear.
+#if SHRINE_SPLIT
+const ShrineConfig SHRINE_CONFIGS[SHRINE_COUNT] = {
+  {BTN_PIN, PIR_PIN, {0, 1, 2, SHRINE_UNWIRED, SHRINE_UNWIRED, SHRINE_UNWIRED}}, // D3 D5 D6
+  {A2, A3, {3, 4, 5, SHRINE_UNWIRED, SHRINE_UNWIRED, SHRINE_UNWIRED}},           // D9 D10 D11
+};
+#else
+const ShrineConfig SHRINE_CONFIGS[SHRINE_COUNT] = {
+  {BTN_PIN, PIR_PIN, {0, 1, 2, 3, 4, 5}},
+};
+#endif
+
+uint8_t vmSlotValidMask = 0; // bit s = slot VM s con programa valido
+
+// Plataforma del motor en la placa: random() de Arduino, micros() y EEPROM.
+long boardRandom(void*, long lo, long hi) { return random(lo, hi); }
+unsigned long boardMicros(void*) { return micros(); }
+uint8_t boardStorageRead(void*, uint16_t addr) { return EEPROM.read(addr); }
+uint8_t boardSceneSlots(void*) { return vmSlotValidMask; }
+
+const ShrinePlatform BOARD_PLATFORM = {boardRandom, boardMicros, boardStorageRead, boardSceneSlots, 0};
+
+void setLedName(uint8_t index, const char* name) {
+  if (index >= LED_COUNT) return;
+  ledNames[index] = String(name);
+}
+
+const char* getLedName(uint8_t index) {
+  if (index >= LED_COUNT) return "";
+  return ledNames[index].c_str();
+}
+
+
+
+void printLedNames() {
+  Serial.println(F("Mapeo LEDs (PIN -> NOMBRE):"));
+  for (uint8_t i = 0; i < LED_COUNT; i++) {
+    Serial.print(F("PIN "));
+    Serial.print(LED_PINS[i]);
+    Serial.print(F(" -> "));
+    if (ledNames[i].length()) Serial.println(ledNames[i]);
+    else {
+      Serial.print(F("LED"));
+      Serial.println(i + 1);
+    }
+  }
+}
+
+// Textos de la consola (ui/consola.txt, comprimidos en include/ui_consola.h):
+// se decodifican directo a la salida (el puerto serie o el log en cola).
+void uiPrint(Print& out, UiText id, const uint16_t* args = 0) {
+  uiTextEmit(out, UI_TEXT_TABLE, id, args);
+}
+
+void uiPrint(UiText id, const uint16_t* args = 0) {
+  uiPrint(Serial, id, args);
+}
+
+void describeCurrentMode(Print& out, Mode m) {
+  switch (m) {
+    case MODE_1_CONTEMPLATIVO: uiPrint(out, UI_MODO_1); break;
+    case MODE_2_SOLO_CANDELITA: uiPrint(out, UI_MODO_2); break;
+    case MODE_3_CANDELITA_PASTOR: uiPrint(out, UI_MODO_3); break;
+    case MODE_4_CANDELITA_PASTOR_VIRGEN: uiPrint(out, UI_MODO_4); break;
+    case MODE_5_CANDELITA_PASTOR_VIRGEN_CARA: uiPrint(out, UI_MODO_5); break;
+    case MODE_6_ENFASIS_VIRGEN: uiPrint(out, UI_MODO_6); break;
+    case MODE_7_SECUENCIA: uiPrint(out, UI_MODO_7); break;
+    case MODE_8_ESCENA_1:
+    case MODE_9_ESCENA_2:
+    case MODE_10_ESCENA_3:
+      {
+        const uint16_t args[] = {(uint16_t)(m + 1), (uint16_t)(m - MODE_8_ESCENA_1)};
+        uiPrint(out, UI_MODO_VM, args);
+      }
+      break;
+    default: uiPrint(out, UI_MODO_DESCONOCIDO); break;
+  }
+}
+
+void printModeProfile(Print& out, Mode m, bool movement) {
+  if (memLow) return;
+  uiPrint(out, movement ? UI_PERFIL_MOVIMIENTO : UI_PERFIL_BASE);
+  switch (m) {
+    case MODE_1_CONTEMPLATIVO:
+      {
+        const Mode1Profile& p = getMode1Profile();
+        uiPrint(out, UI_M1_VARIANTE);
+        out.println(p.name);
+        if (movement) {
+          const uint16_t args[] = {p.canMovePct, p.caraMoveMinPct, p.caraMoveMaxPct, p.triadMoveBasePct, p.triadMovePeakPct};
+          uiPrint(out, UI_M1_MOVIMIENTO, args);
+        } else {
+          const uint16_t args[] = {p.canBasePct, p.caraBaseMinPct, p.caraBaseMaxPct, p.triadBasePct, p.triadPeakBasePct};
+          uiPrint(out, UI_M1_BASE, args);
+        }
+      }
+      break;
+
+    case MODE_2_SOLO_CANDELITA: uiPrint(out, movement ? UI_M2_MOVIMIENTO : UI_M2_BASE); break;
+    case MODE_3_CANDELITA_PASTOR: uiPrint(out, movement ? UI_M3_MOVIMIENTO : UI_M3_BASE); break;
+    case MODE_4_CANDELITA_PASTOR_VIRGEN: uiPrint(out, movement ? UI_M4_MOVIMIENTO : UI_M4_BASE); break;
+    case MODE_5_CANDELITA_PASTOR_VIRGEN_CARA: uiPrint(out, movement ? UI_M5_MOVIMIENTO : UI_M5_BASE); break;
+    case MODE_6_ENFASIS_VIRGEN: uiPrint(out, movement ? UI_M6_MOVIMIENTO : UI_M6_BASE); break;
+
+    case MODE_7_SECUENCIA:
+      {
+        uiPrint(out, movement ? UI_M7_MOVIMIENTO : UI_M7_BASE);
+        const uint16_t args[] = {(uint16_t)(timelineReadU32(TIMELINE_FIESTA, 4) / 1000), (uint16_t)TIMELINE_FIESTA_SIZE};
+        uiPrint(out, UI_M7_TIMELINE, args);
+      }
+      break;
+
+    case MODE_8_ESCENA_1:
+    case MODE_9_ESCENA_2:
+    case MODE_10_ESCENA_3:
+      uiPrint(out, UI_VM_PROGRAMA);
+      break;
+
+    default:
+      uiPrint(out, UI_PERFIL_INDEFINIDO);
+      break;
+  }
+}
+
+void printSnapshotDutyLine(Print& out, Mode mode, uint8_t mv); // duty medido (seccion "Duty y energia")
+
+// Snapshot del modo por partes, para el log en cola (seccion "Log sin
+// esperas"). Las partes con numeros vivos (el duty) caben enteras en el
+// buffer TX; false = no quedan partes.
+bool printModeSnapshotPart(Print& out, Mode mode, uint8_t part) {
+  if (memLow) { // solo la linea del modo: la tabla y los perfiles son lo mas hondo de la consola
+    if (part > 0) return false;
+    describeCurrentMode(out, mode);
+    return true;
+  }
+  switch (part) {
+    case 0:
+      // Limpiar pantalla (10 saltos de linea)
+      for (int i = 0; i < 10; i++) out.println();
+      uiPrint(out, UI_SNAPSHOT_CABECERA);
+      break;
+    case 1: describeCurrentMode(out, mode); break;
+    case 2:
+      uiPrint(out, UI_SEPARADOR);
+      uiPrint(out, UI_DUTY_CABECERA);
+      break;
+    // Duty medido de la escena base y de movimiento (seccion "Duty y energia")
+    case 3: printSnapshotDutyLine(out, mode, 0); break;
+    case 4: printSnapshotDutyLine(out, mode, 1); break;
+    case 5:
+      uiPrint(out, UI_SEPARADOR);
+      printModeProfile(out, mode, false);
+      break;
+    case 6:
+      uiPrint(out, UI_SEPARADOR);
+      printModeProfile(out, mode, true);
+      uiPrint(out, UI_CIERRE);
+      break;
+    default: return false;
+  }
+  return true;
+}
 
 // ==============================================================================
-// Modos de presentación
+// Luz ambiente: ADC en modo libre por interrupcion + brillo maestro adaptativo
 // ==============================================================================
-enum Mode {
-  MODE_1_CONTEMPLATIVO = 0,
-  MODE_2_SOLO_CANDELITA,
-  MODE_3_CANDELITA_PASTOR,
-  MODE_4_CANDELITA_PASTOR_VIRGEN,
-  MODE_5_CANDELITA_PASTOR_VIRGEN_CARA,
-  MODE_6_ENFASIS_VIRGEN,
-  MODE_COUNT
+// Una LDR en A1 (LDR a 5V, 10k a GND: mas luz = mas tension) ajusta el brillo
+// de todas las escenas: mas tenue de noche, completo de dia. El ADC convierte
+// solo (modo libre, prescaler 128: ~9.6 kmuestras/s) y la ISR hace todo el
+// filtrado:
+//   1. sobremuestreo: suma de 64 muestras por bloque (~150 bloques/s)
+//   2. anillo de 8 bloques (media movil de ~53 ms, quita el rizado de 50/60 Hz
+//      de la iluminacion de red)
+//   3. EMA de 1/256 por bloque (~1.7 s) para que el brillo no "respire"
+//   4. mapa lineal oscuro..claro -> AMBIENT_MIN_PCT..100% con 1 paso de histeresis
+// El frame solo lee ambientDimQ8 (un byte, lectura atomica). Coste de fondo:
+// ~3% de CPU en la ISR. analogRead() ya no se puede usar con esto activo.
+
+#ifndef AMBIENT_SENSOR_ENABLED
+#define AMBIENT_SENSOR_ENABLED 0
+#endif
+
+volatile uint8_t ambientDimQ8 = 255; // brillo maestro por luz ambiente (255 = completo)
+
+#if AMBIENT_SENSOR_ENABLED
+
+#ifndef AMBIENT_MIN_PCT
+#define AMBIENT_MIN_PCT 40
+#endif
+
+const uint8_t AMBIENT_ADC_CHANNEL = 1;      // A1
+const uint8_t AMBIENT_OVERSAMPLE = 64;
+const uint8_t AMBIENT_RING_BLOCKS = 8;
+const uint16_t AMBIENT_DARK_RAW = 80;       // lectura de 10 bits: por debajo, noche
+const uint16_t AMBIENT_BRIGHT_RAW = 600;    // por encima, dia
+const uint8_t AMBIENT_MIN_Q8 = (uint8_t)((AMBIENT_MIN_PCT * 255UL + 50) / 100);
+const uint16_t AMBIENT_SLOPE_Q8 = (uint16_t)(((255U - AMBIENT_MIN_Q8) << 8) / (AMBIENT_BRIGHT_RAW - AMBIENT_DARK_RAW));
+
+struct AmbientAdc {
+  uint16_t acc;                          // suma del bloque en curso
+  uint8_t left;                          // muestras que faltan para cerrar el bloque
+  uint8_t head;
+  uint16_t ring[AMBIENT_RING_BLOCKS];    // bloques en 12 bits (suma >> 4)
+  uint16_t ringSum;                      // 15 bits: lectura de 10 bits * 32
+  uint32_t emaAcc;                       // EMA de ringSum en Q8
+  uint16_t raw;                          // lectura filtrada de 10 bits
+  bool primed;
 };
 
-Mode currentMode = MODE_1_CONTEMPLATIVO;
-
-// Control de tiempo
-unsigned long lastDebounceTime = 0;
-const unsigned long DEBOUNCE_DELAY = 50;
-int lastButtonState = HIGH;
-bool lastBtnPressed = false;
-
-// PIR y movimiento
-const unsigned long MOVEMENT_TIMEOUT_MS = 30000; // 30 segundos
-unsigned long lastMotionTime = 0;
-bool lastMotionState = false;
-bool inMovementMode = false;
-
-// Control de animación/flicker
-unsigned long lastCandleUpdate = 0;
-unsigned long candleNextInterval = 30; // ms (dinamico 15..55)
-uint8_t candleLevel1 = 0; // salida actual CAN1
-uint8_t candleLevel2 = 0; // salida actual CAN2 (20% menor maximo)
-
-// Reusable FADE state (usable for CARA or any other LED)
-struct FadeState {
-  uint8_t val;
-  uint8_t min;
-  uint8_t max;
-  uint8_t step;
-  int8_t dir;
-  unsigned long last;
-  unsigned long interval;
-  bool active;
-};
+volatile AmbientAdc ambient;
+
+ISR(ADC_vect) {
+  ambient.acc += ADC;
+  if (--ambient.left) return;
+  ambient.left = AMBIENT_OVERSAMPLE;
+  uint16_t block = ambient.acc >> 4;
+  ambient.acc = 0;
+  if (!ambient.primed) {
+    // Primer bloque: llena anillo y EMA para no arrancar con un fundido.
+    for (uint8_t i = 0; i < AMBIENT_RING_BLOCKS; i++) ambient.ring[i] = block;
+    ambient.ringSum = (uint16_t)(block * AMBIENT_RING_BLOCKS);
+    ambient.emaAcc = (uint32_t)ambient.ringSum << 8;
+    ambient.primed = true;
+  } else {
+    ambient.ringSum = (uint16_t)(ambient.ringSum - ambient.ring[ambient.head] + block);
+    ambient.ring[ambient.head] = block;
+    ambient.head = (uint8_t)((ambient.head + 1) % AMBIENT_RING_BLOCKS);
+    ambient.emaAcc += ambient.ringSum;
+    ambient.emaAcc -= ambient.emaAcc >> 8;
+  }
+  uint16_t raw = (uint16_t)(ambient.emaAcc >> 13); // Q8 y *32 -> 10 bits
+  ambient.raw = raw;
+  uint8_t dim;
+  if (raw <= AMBIENT_DARK_RAW) dim = AMBIENT_MIN_Q8;
+  else if (raw >= AMBIENT_BRIGHT_RAW) dim = 255;
+  else dim = (uint8_t)(AMBIENT_MIN_Q8 + (((uint32_t)(raw - AMBIENT_DARK_RAW) * AMBIENT_SLOPE_Q8) >> 8));
+  uint8_t pub = ambientDimQ8;
+  if (dim > pub + 1 || dim + 1 < pub || dim == 255 || dim == AMBIENT_MIN_Q8) ambientDimQ8 = dim;
+}
 
-FadeState fades[6];
-
-// Defaults for CARA fade (40% - 60%)
-const uint8_t DEFAULT_CARA_MIN_PCT = 40;
-const uint8_t DEFAULT_CARA_MAX_PCT = 60;
-const unsigned long DEFAULT_CARA_SPEED_MS = 40; // ms
-// Modo 1 - Contemplativo (3 variantes seleccionables)
-struct Mode1Profile {
-  const char* name;
-  uint8_t canBasePct;
-  uint8_t canMovePct;
-  uint8_t caraBaseMinPct;
-  uint8_t caraBaseMaxPct;
-  uint8_t caraMoveMinPct;
-  uint8_t caraMoveMaxPct;
-  unsigned long caraBaseTargetMinMs;
-  unsigned long caraBaseTargetMaxMs;
-  unsigned long caraMoveTargetMinMs;
-  unsigned long caraMoveTargetMaxMs;
-  uint8_t caraBaseStepMinPct;
-  uint8_t caraBaseStepMaxPct;
-  uint8_t caraMoveStepMinPct;
-  uint8_t caraMoveStepMaxPct;
-  unsigned long caraBaseStepIntervalMs;
-  unsigned long caraMoveStepIntervalMs;
-  uint8_t triadBasePct;
-  uint8_t triadPeakBasePct;
-  unsigned long triadBasePeriodMs;
-  uint8_t triadMoveBasePct;
-  uint8_t triadMovePeakPct;
-  unsigned long triadMovePeriodMs;
-};
+void ambientBegin() {
+  ambient.left = AMBIENT_OVERSAMPLE;
+  DIDR0 |= _BV(AMBIENT_ADC_CHANNEL);               // sin buffer digital en A1
+  ADMUX = _BV(REFS0) | AMBIENT_ADC_CHANNEL;        // referencia AVcc
+  ADCSRB = 0;                                      // disparo: modo libre
+  ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  Serial.println(F("Luz ambiente: LDR en A1 (ADC libre)"));
+}
 
-const Mode1Profile MODE1_PROFILES[] = {
-  // 0 - Contemplativo profundo (muy sereno)
-  {"Contemplativo", 25, 60, 14, 26, 28, 52, 1100, 2500, 420, 1100, 1, 2, 1, 2, 55, 35, 2, 16, 11000, 6, 38, 4500},
-  // 1 - Balanceado (RECOMENDADO)
-  {"Balanceado", 35, 75, 18, 32, 35, 65, 900, 2200, 320, 900, 1, 2, 1, 3, 45, 28, 3, 22, 9000, 8, 55, 3600},
-  // 2 - Vivo (mas presencia en movimiento)
-  {"Vivo", 45, 90, 22, 40, 40, 78, 700, 1700, 220, 700, 1, 3, 2, 4, 30, 20, 5, 30, 7000, 12, 75, 2600},
-};
-const uint8_t MODE1_PROFILE_COUNT = sizeof(MODE1_PROFILES) / sizeof(MODE1_PROFILES[0]);
-const uint8_t MODE1_PROFILE_INDEX = 1; // 0=Contemplativo, 1=Balanceado, 2=Vivo
-
-const Mode1Profile& getMode1Profile() {
-  uint8_t idx = MODE1_PROFILE_INDEX;
-  if (idx >= MODE1_PROFILE_COUNT) idx = 0;
-  return MODE1_PROFILES[idx];
-}
-
-const uint8_t MODE5_CARA_MIN_PCT = 40;
-const uint8_t MODE5_CARA_MAX_PCT = 90;
-const unsigned long MODE5_CARA_SPEED_MS = 35; // ms
-const uint8_t MODE5_FIZO_FDEP_MIN_PCT = 0;
-const uint8_t MODE5_FIZO_FDEP_MAX_PCT = 5;
-const unsigned long MODE5_FIZO_FDEP_SPEED_MS = 32; // ms (medio-rapido)
-const uint8_t MODE6_OLA_ATRA_MIN_PCT = 10;
-const uint8_t MODE6_OLA_ATRA_MAX_PCT = 30;
-const uint8_t MODE6_OLA_GRUPO_MIN_PCT = 8;
-const uint8_t MODE6_OLA_GRUPO_MAX_PCT = 24;
-const unsigned long MODE6_OLA_PERIOD_MS = 5200; // ms
-const uint8_t DEFAULT_FDEP_MIN_PCT = 5;
-const uint8_t DEFAULT_FDEP_MAX_PCT = 100;
-const unsigned long DEFAULT_FDEP_SPEED_MS = 40; // ms (velocidad media)
-const uint8_t DEFAULT_ATRA_M4_MIN_PCT = 0;
-const uint8_t DEFAULT_ATRA_M4_MAX_PCT = 100;
-const unsigned long DEFAULT_ATRA_M4_SPEED_MS = 30;
-
-// Suavizado al apagar (soft-off) - no bloqueante, por LED
-bool softOffActive[6] = {false, false, false, false, false, false};
-unsigned long softOffLast[6] = {0,0,0,0,0,0};
-const uint8_t SOFTOFF_STEP = 8; // decrement per step
-const unsigned long SOFTOFF_INTERVAL = 30; // ms per step
-
-// Efecto tenue + destello aleatorio (por LED)
-bool randomFlashOn[6] = {false, false, false, false, false, false};
-unsigned long randomFlashEndAt[6] = {0,0,0,0,0,0};
-unsigned long randomFlashNextCheckAt[6] = {0,0,0,0,0,0};
-uint8_t randomFlashPeakPct[6] = {0,0,0,0,0,0};
-
-// Deriva organica (por LED): brillo no periodico con targets aleatorios
-struct OrganicDriftState {
-  uint8_t currentPct;
-  uint8_t targetPct;
-  unsigned long nextTargetAt;
-  unsigned long lastStepAt;
-  bool initialized;
-};
-OrganicDriftState organicDrift[6] = {};
+void printAmbientStatus() {
+  cli();
+  uint16_t raw = ambient.raw;
+  sei();
+  Serial.print(F("ambient: lectura "));
+  Serial.print(raw);
+  Serial.print(F("/1023 | brillo maestro "));
+  Serial.print((ambientDimQ8 * 100U + 127) / 255);
+  Serial.println('%');
+}
+
+#else
+
+void ambientBegin() {}
+void printAmbientStatus() { Serial.println(F("ambient: desactivado (AMBIENT_SENSOR_ENABLED=0)")); }
+
+#endif
 
 // ==============================================================================
-// Funciones auxiliares
+// Commit del frame: etapas de salida + escritura a hardware con dirty tracking
 // ==============================================================================
 
-// Forward declarations (definidas mas abajo)
-void initFade(uint8_t idx, uint8_t minV, uint8_t maxV, uint8_t step, unsigned long interval);
-void setFadeActive(uint8_t idx, bool active);
-
-void setLedState(uint8_t idx, uint8_t value) {
-  if (idx >= LED_COUNT) return;
-  value = constrain(value, 0, 255);
-  // Cancelar soft-off si estamos escribiendo un valor distinto de 0
-  if (value != 0) {
-    softOffActive[idx] = false;
-    if (idx == 0 || idx == 1) { softOffActive[0] = softOffActive[1] = false; }
+// Atenuacion global de salida (255 = sin cambio). La usa el reposo para bajar
+// la escena al suelo sin tocar capas ni efectos.
+uint8_t outputDimQ8 = 255;
+
+
+// Gobernador de potencia de la placa (include/power_governor.h): recorta el
+// frame si la demanda pasa de POWER_BUDGET_MA, primero FIZO/FDEP/ATRA.
+PowerGovernor governor = POWER_GOVERNOR_IDLE;
+
+
+// ==============================================================================
+// Duty y energia por escena
+// ==============================================================================
+// Integra lo que de verdad sale por cada pin (tras el gobernador y la
+// atenuacion) por escena de la hornacina principal: modo x base/movimiento
+// (include/duty_meter.h). Por frame, 6 productos y sumas; una vez por segundo
+// un volcado con una division por canal. El comando "duty" lo imprime.
+
+#ifndef DUTY_METER_ENABLED
+#define DUTY_METER_ENABLED 1
+#endif
+
+static_assert(LED_COUNT == POWER_CHANNEL_COUNT, "duty: una corriente por salida");
+
+#if DUTY_METER_ENABLED
+const uint8_t DUTY_SCENE_COUNT = MODE_COUNT * 2;
+DutyScene dutyScenes[DUTY_SCENE_COUNT];
+DutyLive dutyLive;
+uint32_t dutyChannelS[LED_COUNT]; // nivel x s por salida desde el reset
+uint8_t dutySceneKey = 0;         // shrineSceneKey() de la principal
+
+void dutyMeterFrame(const uint8_t* out, uint16_t dtMs) {
+  uint8_t key = shrineSceneKey(shrines[0]);
+  if (key != dutySceneKey) {
+    dutyFold(dutyLive, dutyScenes[dutySceneKey], dutyChannelS);
+    dutySceneKey = key;
   }
+  if (dutyFrame(dutyLive, out, dtMs)) dutyFold(dutyLive, dutyScenes[dutySceneKey], dutyChannelS);
+}
 
-  // Si piden apagar (value==0) y el led está encendido, activar soft-off y devolver
-  if (value == 0 && ledBrightness[idx] > 0) {
-    // activar soft-off para el LED (y pareja en caso de candelitas)
-    if (idx == 0 || idx == 1) { softOffActive[0] = softOffActive[1] = true; }
-    else softOffActive[idx] = true;
-    return;
+void dutyReset() {
+  memset(dutyScenes, 0, sizeof(dutyScenes));
+  memset(&dutyLive, 0, sizeof(dutyLive));
+  memset(dutyChannelS, 0, sizeof(dutyChannelS));
+}
+#else
+inline void dutyMeterFrame(const uint8_t*, uint16_t) {}
+inline void dutyReset() {}
+#endif
+
+// Sink de la placa: cada controlador deja sus canales cableados en boardOut y
+// boardFlush() escribe la placa entera una vez por vuelta.
+uint8_t boardOut[6] = {0, 0, 0, 0, 0, 0};     // por salida (indice en LED_PINS)
+uint8_t boardWritten[6] = {0, 0, 0, 0, 0, 0}; // ya escrito en hardware
+
+void boardSinkWrite(void*, ShrineController& s, const uint8_t* levels) {
+  for (uint8_t i = 0; i < LED_COUNT; i++) {
+    uint8_t o = s.config->output[i];
+    if (o != SHRINE_UNWIRED) boardOut[o] = levels[i];
   }
+}
 
-  // Escritura inmediata (no soft-off)
-  if (idx == 0 || idx == 1) {
-    for (uint8_t k = 0; k <= 1; k++) {
-      if (ledBrightness[k] != value) {
-        analogWrite(LED_PINS[k], value);
-        ledBrightness[k] = value;
-      }
+// Tras el commit de todos los controladores: gobernador de potencia sobre la
+// placa entera y una sola escritura por pin, solo si el valor final cambio.
+// Lo que de verdad se ve vuelve a ledBrightness de cada controlador.
+void blackBoxLevels(const uint8_t* out); // caja negra (seccion "Watchdog")
+
+void boardFlush(uint16_t dtMs) {
+  powerGovernorStep(governor, boardOut, dtMs);
+  blackBoxLevels(boardOut);
+  dutyMeterFrame(boardOut, dtMs);
+  for (uint8_t o = 0; o < LED_COUNT; o++) {
+    if (boardOut[o] != boardWritten[o]) {
+      analogWrite(LED_PINS[o], boardOut[o]);
+      boardWritten[o] = boardOut[o];
     }
-  } else {
-    if (ledBrightness[idx] != value) {
-      analogWrite(LED_PINS[idx], value);
-      ledBrightness[idx] = value;
+  }
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) {
+    ShrineController& s = shrines[k];
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+      uint8_t o = s.config->output[i];
+      if (o != SHRINE_UNWIRED) s.ledBrightness[i] = boardOut[o];
     }
   }
 }
 
-uint8_t percentToPwm(uint8_t percent) {
-  percent = constrain(percent, 0, 100);
-  return (uint8_t)((percent * 255UL + 50) / 100); // redondeo a entero mas cercano
+// Niveles de escena de la placa (frameLevels de cada hornacina, por salida).
+void boardSceneLevels(uint8_t* out) {
+  memset(out, 0, LED_COUNT);
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) {
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+      uint8_t o = shrines[k].config->output[i];
+      if (o != SHRINE_UNWIRED) out[o] = shrines[k].frameLevels[i];
+    }
+  }
 }
 
-void setLedStaticPercent(uint8_t idx, uint8_t percent) {
-  setLedState(idx, percentToPwm(percent));
+
+// Cache de escena de la placa (4.15): una, prestada a todas las hornacinas.
+SceneCache sceneCache = {};
+
+// En dos partes para el log en cola: cada una cabe en el buffer TX.
+bool printSceneCacheReport(Print& out, uint8_t part) {
+  if (memLow || part > 1) return false;
+  const SceneCache& c = sceneCache;
+  if (part == 0) {
+    out.print(F("CACHE escena: "));
+    if (!c.valid) {
+      out.print(F("en vivo ("));
+      out.print(c.usedBytes);
+      out.print(F("/"));
+      out.print(SCENE_CACHE_BYTES);
+      return true;
+    }
+    out.print(c.usedBytes);
+    out.print(F(" bytes, "));
+    out.print(c.frameCount);
+    out.print(F(" frames x "));
+    out.print(c.channelCount);
+    out.print(F(" canales @"));
+    out.print(SCENE_CACHE_FRAME_MS);
+    out.print(F("ms"));
+    return true;
+  }
+  if (!c.valid) {
+    out.println(F(" bytes necesarios o deltas fuera de rango)"));
+    return true;
+  }
+  out.print(F(" | vivo ~"));
+  out.print(c.liveUs);
+  out.print(F("us/frame, cache ~"));
+  out.print(c.playUs / 100.0, 2);
+  out.println(F("us/paso"));
+  return true;
 }
 
-// API reutilizable para cualquier LED: FADE IN/OUT por porcentaje y velocidad.
-// idx: 0..5 (CAN1, CAN2, CARA, FIZO, FDEP, ATRA)
-void configureLedFadeInOutPercent(uint8_t idx, uint8_t minPct, uint8_t maxPct, unsigned long speedMs) {
-  minPct = constrain(minPct, 0, 100);
-  maxPct = constrain(maxPct, 0, 100);
-  if (minPct > maxPct) {
-    uint8_t t = minPct;
-    minPct = maxPct;
-    maxPct = t;
+void refreshVmSlots() {
+  vmSlotValidMask = 0;
+  uint16_t len;
+  for (uint8_t s = 0; s < VM_SLOT_COUNT; s++) {
+    if (vmCheckSlot(BOARD_PLATFORM, s, len)) vmSlotValidMask |= (uint8_t)(1 << s);
   }
-  if (speedMs < 5) speedMs = 5;
-  uint8_t minV = percentToPwm(minPct);
-  uint8_t maxV = percentToPwm(maxPct);
-  // Evita reiniciar el fade cuando ya esta configurado igual.
-  if (fades[idx].min == minV && fades[idx].max == maxV && fades[idx].interval == speedMs) return;
-  initFade(idx, minV, maxV, 1, speedMs);
-}
-
-void setLedFadeInOutActive(uint8_t idx, bool active) {
-  setFadeActive(idx, active);
-}
-
-void disableRandomFlashEffect(uint8_t idx) {
-  if (idx >= LED_COUNT) return;
-  randomFlashOn[idx] = false;
-  randomFlashEndAt[idx] = 0;
-  randomFlashNextCheckAt[idx] = 0;
-  randomFlashPeakPct[idx] = 0;
-}
-
-void resetOrganicDriftState(uint8_t idx) {
-  if (idx >= LED_COUNT) return;
-  organicDrift[idx].currentPct = 0;
-  organicDrift[idx].targetPct = 0;
-  organicDrift[idx].nextTargetAt = 0;
-  organicDrift[idx].lastStepAt = 0;
-  organicDrift[idx].initialized = false;
-}
-
-// Efecto general: LED tenue (basePct) con destellos altos aleatorios.
-void applyRandomFlashTenue(
-  uint8_t idx,
-  uint8_t basePct,
-  uint8_t flashMinPct,
-  uint8_t flashMaxPct,
-  unsigned long checkIntervalMs,
-  uint8_t chancePct,
-  unsigned long flashMinMs,
-  unsigned long flashMaxMs
-) {
-  if (idx >= LED_COUNT) return;
-  basePct = constrain(basePct, 0, 100);
-  flashMinPct = constrain(flashMinPct, 1, 100);
-  flashMaxPct = constrain(flashMaxPct, 1, 100);
-  if (flashMinPct > flashMaxPct) {
-    uint8_t t = flashMinPct;
-    flashMinPct = flashMaxPct;
-    flashMaxPct = t;
+}
+
+
+// ==============================================================================
+// Log sin esperas: snapshot y avisos por el hueco libre del buffer TX
+// ==============================================================================
+// Serial.print bloquea cuando el buffer TX (64 bytes, 5.6 ms a 115200) esta
+// lleno: un snapshot de ~870 bytes congelaba la salida ~75 ms. Los eventos
+// dejan aqui un trabajo (datos capturados en el momento) y cada frame se
+// escribe solo lo que cabe en Serial.availableForWrite(). Cada trabajo se
+// imprime por partes; una pasada regenera la parte en curso y descarta los
+// bytes ya enviados. Las partes con numeros vivos caben enteras en el buffer
+// y solo se empiezan si hay hueco para todas, asi no se mezclan dos valores.
+// La consola y el reposo vacian la cola (esperando) antes de escribir.
+
+enum LogKind : uint8_t {
+  LOG_SNAPSHOT,       // mode
+  LOG_MOTION,         // mode: aviso + perfil de movimiento
+  LOG_REMOTE_MOTION,  // mode: igual, movimiento en otro nodo del bus
+  LOG_RETRIGGER,      // arg = carga %, value = flancos agrupados
+  LOG_PIR_LOW,        // value = flancos agrupados
+  LOG_TIMEOUT,        // mode: aviso + perfil base
+  LOG_CACHE,
+  LOG_VM_FAULT        // arg = fallo, value = pc
+};
+
+struct LogJob {
+  uint8_t kind;   // LogKind
+  uint8_t shrine; // hornacina (prefijo "[Hk]" si hay varias)
+  uint8_t mode;
+  uint8_t arg;
+  uint16_t value;
+};
+
+#ifndef LOG_QUEUE_JOBS
+#define LOG_QUEUE_JOBS 6
+#endif
+const uint8_t LOG_MIN_ROOM = 16; // hueco minimo para una pasada (acota el coste por frame)
+
+struct LogSpool {
+  LogJob job[LOG_QUEUE_JOBS];
+  uint8_t head;
+  uint8_t count;
+  uint8_t part;  // parte en curso del primer trabajo
+  uint16_t sent; // bytes de esa parte ya escritos
+};
+
+LogSpool logSpool = {};
+
+// Salida de una pasada: cuenta lo generado, salta los bytes ya enviados y
+// escribe en Serial como mucho "room".
+class LogWindow : public Print {
+public:
+  LogWindow(uint16_t skipBytes, uint16_t roomBytes) : skip(skipBytes), room(roomBytes), total(0) {}
+  size_t write(uint8_t c) override {
+    if (total++ >= skip && room > 0) {
+      Serial.write(c);
+      room--;
+    }
+    return 1;
   }
-  if (checkIntervalMs < 20) checkIntervalMs = 20;
-  chancePct = constrain(chancePct, 1, 100);
-  if (flashMinMs < 20) flashMinMs = 20;
-  if (flashMaxMs < flashMinMs) flashMaxMs = flashMinMs;
+  uint16_t skip;
+  uint16_t room;
+  uint16_t total;
+};
 
-  unsigned long now = millis();
+// Flancos de PIR agrupados en el aviso (input_guard.h) y fin de linea.
+void printPirFolded(Print& out, uint16_t folded) {
+  if (folded) {
+    out.print(F(" [+"));
+    out.print(folded);
+    out.print(F(" flancos de PIR]"));
+  }
+  out.println();
+}
 
-  if (randomFlashOn[idx]) {
-    if (now >= randomFlashEndAt[idx]) {
-      randomFlashOn[idx] = false;
-      setLedStaticPercent(idx, basePct);
-      return;
+// Parte "part" de un trabajo; false = no quedan partes.
+bool printLogPart(Print& out, const LogJob& j, uint8_t part) {
+  switch (j.kind) {
+    case LOG_SNAPSHOT: return printModeSnapshotPart(out, (Mode)j.mode, part);
+    case LOG_CACHE: return printSceneCacheReport(out, part); // la cache es de la placa: sin prefijo
+    default: break;
+  }
+  if (part == 1) { // perfil tras el aviso
+    if (j.kind == LOG_MOTION || j.kind == LOG_REMOTE_MOTION) printModeProfile(out, (Mode)j.mode, true);
+    else if (j.kind == LOG_TIMEOUT) printModeProfile(out, (Mode)j.mode, false);
+    else return false;
+    return true;
+  }
+  if (part > 1) return false;
+  if (SHRINE_COUNT > 1 && j.kind != LOG_REMOTE_MOTION) {
+    out.print(F("[H"));
+    out.print(j.shrine + 1);
+    out.print(F("] "));
+  }
+  switch (j.kind) {
+    case LOG_MOTION: out.println(F(">>> MOVIMIENTO DETECTADO: SUBMODO ACTIVO <<<")); break;
+    case LOG_REMOTE_MOTION: out.println(F(">>> MOVIMIENTO EN OTRO NODO: SUBMODO ACTIVO <<<")); break;
+    case LOG_RETRIGGER:
+      out.print(F(">>> PIR ALTO (refuerzo, carga "));
+      out.print(j.arg);
+      out.print(F("%) <<<"));
+      printPirFolded(out, j.value);
+      break;
+    case LOG_PIR_LOW:
+      out.print(F(">>> PIR bajo (esperando timeout) <<<"));
+      printPirFolded(out, j.value);
+      break;
+    case LOG_TIMEOUT: out.println(F(">>> Timeout de movimiento (volviendo a modo base) <<<")); break;
+    case LOG_VM_FAULT:
+      out.print(F("VM fallo: "));
+      out.print(j.arg == VM_FAULT_UNDERFLOW ? F("pila vacia") : j.arg == VM_FAULT_OVERFLOW ? F("pila llena") : F("opcode"));
+      out.print(F(" pc="));
+      out.println(j.value);
+      break;
+  }
+  return true;
+}
+
+void logSpoolPop() {
+  logSpool.head = (uint8_t)((logSpool.head + 1) % LOG_QUEUE_JOBS);
+  logSpool.count--;
+  logSpool.part = 0;
+  logSpool.sent = 0;
+}
+
+// Escribe lo que cabe ahora en el buffer TX (wait = false) o todo lo
+// pendiente, esperando al puerto como un Serial.print (wait = true).
+void logSpoolPump(bool wait) {
+  while (logSpool.count) {
+    const LogJob& j = logSpool.job[logSpool.head];
+    uint16_t room = 0xFFFF;
+    if (!wait) {
+      room = (uint16_t)Serial.availableForWrite();
+      if (room < LOG_MIN_ROOM) return;
+      if (logSpool.sent == 0) { // parte nueva: entera si cabe en el buffer
+        LogWindow probe(0xFFFF, 0);
+        if (!printLogPart(probe, j, logSpool.part)) {
+          logSpoolPop();
+          continue;
+        }
+        if (probe.total > room && probe.total < SERIAL_TX_BUFFER_SIZE) return;
+      }
     }
-    setLedStaticPercent(idx, randomFlashPeakPct[idx]);
-    return;
+    LogWindow w(logSpool.sent, room);
+    if (!printLogPart(w, j, logSpool.part)) {
+      logSpoolPop();
+      continue;
+    }
+    logSpool.sent += room - w.room;
+    if (logSpool.sent < w.total) return; // buffer lleno: sigue en otro frame
+    logSpool.part++;
+    logSpool.sent = 0;
   }
+}
 
-  if (now >= randomFlashNextCheckAt[idx]) {
-    randomFlashNextCheckAt[idx] = now + checkIntervalMs;
-    if (random(0, 100) < chancePct) {
-      randomFlashOn[idx] = true;
-      randomFlashPeakPct[idx] = (uint8_t)random(flashMinPct, flashMaxPct + 1);
-      randomFlashEndAt[idx] = now + random(flashMinMs, flashMaxMs + 1);
-      setLedStaticPercent(idx, randomFlashPeakPct[idx]);
-      return;
+void logSpoolFlush() {
+  logSpoolPump(true);
+}
+
+// Cola llena: se vacia esperando (como antes de la cola), nunca se pierde.
+void logSpoolPush(LogKind kind, uint8_t shrine, uint8_t mode, uint8_t arg = 0, uint16_t value = 0) {
+  if (logSpool.count == LOG_QUEUE_JOBS) logSpoolFlush();
+  LogJob& j = logSpool.job[(logSpool.head + logSpool.count) % LOG_QUEUE_JOBS];
+  j.kind = kind;
+  j.shrine = shrine;
+  j.mode = mode;
+  j.arg = arg;
+  j.value = value;
+  logSpool.count++;
+}
+
+
+// ==============================================================================
+// Diagnostico: memoria de estado y coste por frame
+// ==============================================================================
+
+// Poner a 1 para medir al arrancar el coste medio de un frame por modo.
+#ifndef BENCH_EFFECTS
+#define BENCH_EFFECTS 0
+#endif
+
+void printEffectStateFootprint() {
+  Serial.print(F("Estado efectos: "));
+  Serial.print(EFFECT_STATE_BYTES_PER_CHANNEL);
+  Serial.print(F(" bytes/canal ("));
+  Serial.print((unsigned)sizeof(EffectStateTable));
+  Serial.println(F(" bytes total)"));
+  Serial.print(F("Hornacinas: "));
+  Serial.print(SHRINE_COUNT);
+  Serial.print(F(" x "));
+  Serial.print((unsigned)sizeof(ShrineController));
+  Serial.println(F(" bytes"));
+  Serial.print(F("Secuencias: "));
+  Serial.print(SEQUENCE_SLOTS);
+  Serial.print(F(" x "));
+  Serial.print((unsigned)sizeof(SequenceTask));
+  Serial.println(F(" bytes"));
+  Serial.print(F("Textos UI: "));
+  Serial.print(UI_TEXT_RAW_BYTES);
+  Serial.print(F(" -> "));
+  Serial.print(UI_TEXT_PACKED_BYTES);
+  Serial.println(F(" bytes flash (diccionario)"));
+}
+
+#if BENCH_EFFECTS
+// Corre BENCH_FRAMES frames sinteticos (reloj avanzando 1 ms por frame) de cada
+// modo, base, mezcla al 50% y movimiento, y reporta us/frame de applyMode +
+// composeFrame.
+void benchEffectFrames() {
+  const uint16_t BENCH_FRAMES = 2000;
+  ShrineController& s = shrines[0];
+  Mode savedMode = s.currentMode;
+  FrameContext fc = {0, 0, 0, 0, false, 0};
+  Serial.println(F("BENCH us/frame (base / mezcla 50% / movimiento):"));
+  for (uint8_t m = 0; m < MODE_COUNT; m++) {
+    s.currentMode = (Mode)m;
+    Serial.print(F("  Modo "));
+    Serial.print(m + 1);
+    Serial.print(F(": "));
+    for (uint8_t mv = 0; mv < 3; mv++) {
+      allLedsOff(s);
+      fc.motion = (mv > 0);
+      fc.motionQ8 = (uint16_t)(mv * MOTION_HALF_Q8);
+      unsigned long t0 = micros();
+      for (uint16_t f = 0; f < BENCH_FRAMES; f++) {
+        fc.now++;
+        fc.tick = (uint16_t)fc.now;
+        fc.frame++;
+        for (uint8_t i = 0; i < LED_COUNT; i++) updateFade(s, fc, i);
+        applyMode(s, fc);
+        composeFrame(s);
+      }
+      unsigned long us = micros() - t0;
+      Serial.print((float)us / BENCH_FRAMES, 1);
+      Serial.print(mv == 2 ? F("\n") : F(" / "));
     }
   }
+  s.currentMode = savedMode;
+  allLedsOff(s);
+}
+#endif
+
+// Programas de referencia para medir la VM (en flash, no ocupan slots).
+const uint8_t VM_BENCH_ARITH[] PROGMEM = {
+  VM_OP_PUSH8, 7, VM_OP_DUP, VM_OP_ADD, VM_OP_DROP, VM_OP_JMP, 0, 0
+};
+
+// Equivalente VM de la ola de mar del Modo 6 base (ATRA contra FIZO+FDEP).
+const uint8_t VM_BENCH_OLA[] PROGMEM = {
+  VM_OP_PUSH8, 26, VM_OP_PUSH8, 77, VM_OP_OSC, 0x50, 0x14, VM_OP_OUT, 5,
+  VM_OP_PUSH8, 61, VM_OP_PUSH8, 20, VM_OP_OSC, 0x50, 0x14, VM_OP_DUP, VM_OP_OUT, 3, VM_OP_OUT, 4,
+  VM_OP_YIELD, VM_OP_JMP, 0, 0
+};
+
+// Coste de despacho por opcode y coste por frame de una escena VM frente a su
+// version nativa. Se restaura la VM en curso al terminar.
+void benchVm() {
+  const uint16_t BENCH_OPS = 4000;
+  const uint16_t BENCH_FRAMES = 1000;
+  ShrineController& s = shrines[0];
+  VmMachine saved = s.vm;
+  FrameContext fc = {0, 0, 0, 0, false, 0};
+
+  s.vm.flash = VM_BENCH_ARITH;
+  s.vm.len = sizeof(VM_BENCH_ARITH);
+  vmReset(s.vm, 0);
+  unsigned long t0 = micros();
+  uint16_t ops = vmExecute(s.vm, BOARD_PLATFORM, fc, BENCH_OPS);
+  unsigned long us = micros() - t0;
+  Serial.print(F("VM despacho: "));
+  Serial.print((float)us / ops, 2);
+  Serial.println(F(" us/opcode (flash; EEPROM suma la lectura de cada byte)"));
+
+  s.vm.flash = VM_BENCH_OLA;
+  s.vm.len = sizeof(VM_BENCH_OLA);
+  vmReset(s.vm, 0);
+  t0 = micros();
+  for (uint16_t f = 0; f < BENCH_FRAMES; f++) {
+    fc.now++;
+    fc.tick = (uint16_t)fc.now;
+    applyVmScene(s, fc);
+  }
+  us = micros() - t0;
+  Serial.print(F("Ola Modo 6: VM "));
+  Serial.print((float)us / BENCH_FRAMES, 1);
+  t0 = micros();
+  for (uint16_t f = 0; f < BENCH_FRAMES; f++) {
+    fc.now++;
+    applySeaWaveCircularMode6Base<M6_SEA_WAVE>(s, fc);
+  }
+  us = micros() - t0;
+  Serial.print(F(" us/frame, nativo "));
+  Serial.print((float)us / BENCH_FRAMES, 1);
+  Serial.println(F(" us/frame"));
+
+  s.vm = saved;
+  allLedsOff(s);
+}
+
+// ==============================================================================
+// Watchdog y caja negra (post-mortem tras un cuelgue)
+// ==============================================================================
+// El loop alimenta el watchdog una vez por vuelta. Si una vuelta se cuelga mas
+// de 2 s, el WDT salta en modo interrupcion + reset: la ISR guarda el contador
+// de programa interrumpido y el siguiente vencimiento (15 ms) resetea. La caja
+// negra vive en .noinit (el arranque no la borra): ultimos tiempos de vuelta,
+// modo, etapa del loop en curso y ultimos niveles enviados a los LEDs. Tras el
+// reset se retoma el mismo modo y el informe queda en la consola ("wdt").
+
+#ifndef WATCHDOG_ENABLED
+#define WATCHDOG_ENABLED 1
+#endif
+
+// Causa del reset, leida en .init3 (antes del core): tras un reset por
+// watchdog el WDT sigue activo a 15 ms y hay que apagarlo antes de setup().
+// El bootloader corre antes y borra MCUSR: optiboot deja la copia en r2, que
+// se guarda en .init0 (r2 no lo toca el arranque). Sin bootloader MCUSR llega
+// intacto y manda. El ATmegaBOOT viejo no deja copia (r2 es basura: se
+// descarta si trae bits que MCUSR no tiene) y watchdogBegin() se apoya en la
+// caja negra.
+uint8_t bootResetFlags __attribute__((section(".noinit")));
+uint8_t bootloaderResetFlags __attribute__((section(".noinit")));
+
+void captureBootloaderFlags() __attribute__((naked, used, section(".init0")));
+void captureBootloaderFlags() {
+  asm volatile("sts %0, r2" : "=m"(bootloaderResetFlags));
+}
+
+void captureResetFlags() __attribute__((naked, used, section(".init3")));
+void captureResetFlags() {
+  bootResetFlags = MCUSR;
+  if (bootResetFlags == 0 && !(bootloaderResetFlags & 0xF0)) bootResetFlags = bootloaderResetFlags;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+// Etapa del loop en curso (la ultima marcada antes del cuelgue).
+enum LoopStage : uint8_t {
+  STAGE_SYNC = 0,
+  STAGE_INPUT,
+  STAGE_CONSOLE,
+  STAGE_MOTION,
+  STAGE_RENDER,
+  STAGE_COMMIT,
+  STAGE_SLEEP,
+  STAGE_LOG
+};
+
+const uint16_t BB_MAGIC = 0xB10C;
+const uint8_t BB_FRAME_TIMES = 8;
+const uint8_t BB_LEVEL_FRAMES = 4;
+
+struct BlackBox {
+  uint16_t magic;                   // BB_MAGIC = contenido valido
+  uint8_t watchdogResets;           // desde el ultimo encendido
+  uint8_t stage;                    // LoopStage
+  uint8_t mode;
+  bool movement;
+  uint16_t pc;                      // direccion de palabra interrumpida (0 = sin capturar)
+  uint32_t now;                     // fc.now de la ultima vuelta
+  uint16_t frameUs[BB_FRAME_TIMES]; // duracion de cada vuelta (saturada)
+  uint8_t frameHead;
+  uint8_t levels[BB_LEVEL_FRAMES][LED_COUNT];
+  uint8_t levelsHead;
+};
+
+BlackBox blackBox __attribute__((section(".noinit")));
+BlackBox crashReport; // copia del post-mortem (valida si magic == BB_MAGIC)
+
+void printLoopStage(uint8_t s) {
+  switch (s) {
+    case STAGE_SYNC: Serial.print(F("bus/telemetria")); break;
+    case STAGE_INPUT: Serial.print(F("boton/PIR")); break;
+    case STAGE_CONSOLE: Serial.print(F("consola")); break;
+    case STAGE_MOTION: Serial.print(F("atenuacion de reposo")); break;
+    case STAGE_RENDER: Serial.print(F("escena")); break;
+    case STAGE_COMMIT: Serial.print(F("commit")); break;
+    case STAGE_SLEEP: Serial.print(F("reposo")); break;
+    case STAGE_LOG: Serial.print(F("log")); break;
+    default: Serial.print(s); break;
+  }
+}
+
+// Al arrancar, antes de todo: guarda el post-mortem y reinicia la caja negra.
+// Reset por watchdog: WDRF, o caja negra valida sin encendido ni brownout y
+// con el PC capturado por la ISR (el bootloader se comio los flags; un reset
+// por boton o al abrir el monitor serie no pasa por la ISR). La causa deducida
+// se anade a bootResetFlags para la telemetria.
+void watchdogBegin() {
+  bool valid = blackBox.magic == BB_MAGIC;
+  bool warm = valid && !(bootResetFlags & (_BV(PORF) | _BV(BORF)));
+  if (warm && blackBox.pc != 0) bootResetFlags |= _BV(WDRF);
+  crashReport.magic = 0;
+  if (valid && (bootResetFlags & _BV(WDRF))) crashReport = blackBox;
+  uint8_t resets = warm ? blackBox.watchdogResets : 0;
+  memset(&blackBox, 0, sizeof(blackBox));
+  blackBox.magic = BB_MAGIC;
+  blackBox.watchdogResets = resets;
+}
 
-  setLedStaticPercent(idx, basePct);
+// Tras un reset por watchdog: mismo modo (si su slot VM sigue valido) y, si
+// habia movimiento, una ventana nueva.
+void watchdogResume() {
+  if (crashReport.magic != BB_MAGIC || crashReport.mode >= MODE_COUNT) return;
+  Mode m = (Mode)crashReport.mode;
+  if (isVmMode(m) && !(vmSlotValidMask & (1 << vmSlotForMode(m)))) return;
+  ShrineController& s = shrines[0];
+  s.currentMode = m;
+  if (crashReport.movement && inputMotionStart(s.input, INPUT_GUARD, millis())) raiseEvent(s, EVT_MOTION_START);
+  Serial.println(F(">>> Reset por watchdog: escena retomada (detalle: wdt) <<<"));
 }
 
-// Efecto respiracion devocional: CARA lidera, ATRA sigue con desfase e intensidad relativa.
-void applyDevotionalBreathing(uint8_t caraMinPct, uint8_t caraMaxPct, unsigned long periodMs, unsigned long delayMs, uint8_t atraScalePct) {
-  caraMinPct = constrain(caraMinPct, 1, 100);
-  caraMaxPct = constrain(caraMaxPct, 1, 100);
-  if (caraMinPct > caraMaxPct) {
-    uint8_t t = caraMinPct;
-    caraMinPct = caraMaxPct;
-    caraMaxPct = t;
+void printWatchdogStatus() {
+#if WATCHDOG_ENABLED
+  Serial.print(F("wdt: armado 2 s"));
+#else
+  Serial.print(F("wdt: desactivado (WATCHDOG_ENABLED=0)"));
+#endif
+  Serial.print(F(" | resets por watchdog desde el encendido "));
+  Serial.println(blackBox.watchdogResets);
+  if (crashReport.magic != BB_MAGIC) {
+    Serial.println(F("  sin post-mortem"));
+    return;
   }
-  if (periodMs < 1000) periodMs = 1000;
-  delayMs = min(delayMs, periodMs - 1);
-  atraScalePct = constrain(atraScalePct, 1, 100);
-
-  auto trianglePct = [](unsigned long tMs, unsigned long pMs) -> uint8_t {
-    unsigned long ph = tMs % pMs;
-    unsigned long half = pMs / 2;
-    if (ph < half) return (uint8_t)((ph * 100UL) / half); // 0..100
-    return (uint8_t)(((pMs - ph) * 100UL) / half);         // 100..0
-  };
-
-  unsigned long now = millis();
-  uint8_t faceWave = trianglePct(now, periodMs);
-  uint8_t backWave = trianglePct(now + delayMs, periodMs);
-
-  uint8_t caraSpan = caraMaxPct - caraMinPct;
-  uint8_t caraPct = caraMinPct + (uint8_t)((caraSpan * faceWave) / 100UL);
-  uint8_t atraBasePct = caraMinPct + (uint8_t)((caraSpan * backWave) / 100UL);
-  uint8_t atraPct = (uint8_t)((atraBasePct * atraScalePct) / 100UL);
-
-  setLedStaticPercent(2, caraPct); // CARA
-  setLedStaticPercent(5, atraPct); // ATRA
-}
-
-// Respiracion suave para un LED individual (0..5), por porcentaje.
-void applySingleBreathing(uint8_t idx, uint8_t minPct, uint8_t maxPct, unsigned long periodMs) {
-  if (idx >= LED_COUNT) return;
-  minPct = constrain(minPct, 1, 100);
-  maxPct = constrain(maxPct, 1, 100);
-  if (minPct > maxPct) {
-    uint8_t t = minPct;
-    minPct = maxPct;
-    maxPct = t;
+  // Direccion de byte, la de avr-objdump -d / avr-addr2line sobre el .elf.
+  Serial.print(F("  post-mortem: pc 0x"));
+  Serial.print((unsigned)(crashReport.pc << 1), HEX);
+  Serial.print(F(" | etapa "));
+  printLoopStage(crashReport.stage);
+  Serial.print(F(" | modo "));
+  Serial.print(crashReport.mode + 1);
+  Serial.print(crashReport.movement ? F(" movimiento") : F(" base"));
+  Serial.print(F(" | t "));
+  Serial.print(crashReport.now / 1000);
+  Serial.println(F(" s"));
+  Serial.print(F("  vueltas (us, antigua -> reciente):"));
+  for (uint8_t k = 0; k < BB_FRAME_TIMES; k++) {
+    Serial.print(' ');
+    Serial.print(crashReport.frameUs[(crashReport.frameHead + k) % BB_FRAME_TIMES]);
   }
-  if (periodMs < 1000) periodMs = 1000;
-
-  auto trianglePct = [](unsigned long tMs, unsigned long pMs) -> uint8_t {
-    unsigned long ph = tMs % pMs;
-    unsigned long half = pMs / 2;
-    if (ph < half) return (uint8_t)((ph * 100UL) / half); // 0..100
-    return (uint8_t)(((pMs - ph) * 100UL) / half);         // 100..0
-  };
-
-  uint8_t wave = trianglePct(millis(), periodMs);
-  uint8_t span = maxPct - minPct;
-  uint8_t pct = minPct + (uint8_t)((span * wave) / 100UL);
-  setLedStaticPercent(idx, pct);
-}
-
-// Efecto nuevo: deriva organica (sin ciclo fijo).
-void applyOrganicDrift(
-  uint8_t idx,
-  uint8_t minPct,
-  uint8_t maxPct,
-  unsigned long targetMinMs,
-  unsigned long targetMaxMs,
-  uint8_t stepMinPct,
-  uint8_t stepMaxPct,
-  unsigned long stepIntervalMs
-) {
-  if (idx >= LED_COUNT) return;
-  minPct = constrain(minPct, 0, 100);
-  maxPct = constrain(maxPct, 0, 100);
-  if (minPct > maxPct) {
-    uint8_t t = minPct;
-    minPct = maxPct;
-    maxPct = t;
+  Serial.println();
+  Serial.println(F("  niveles CAN1 CAN2 CARA FIZO FDEP ATRA (antiguo -> reciente):"));
+  for (uint8_t k = 0; k < BB_LEVEL_FRAMES; k++) {
+    const uint8_t* lv = crashReport.levels[(crashReport.levelsHead + k) % BB_LEVEL_FRAMES];
+    Serial.print(F("   "));
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+      Serial.print(' ');
+      Serial.print(lv[i]);
+    }
+    Serial.println();
   }
-  if (targetMinMs < 60) targetMinMs = 60;
-  if (targetMaxMs < targetMinMs) targetMaxMs = targetMinMs;
-  stepMinPct = constrain(stepMinPct, 1, 20);
-  stepMaxPct = constrain(stepMaxPct, stepMinPct, 20);
-  if (stepIntervalMs < 10) stepIntervalMs = 10;
-
-  unsigned long now = millis();
-  if (!organicDrift[idx].initialized) {
-    uint8_t start = (uint8_t)random(minPct, maxPct + 1);
-    organicDrift[idx].currentPct = start;
-    organicDrift[idx].targetPct = start;
-    organicDrift[idx].nextTargetAt = now + random(targetMinMs, targetMaxMs + 1);
-    organicDrift[idx].lastStepAt = 0;
-    organicDrift[idx].initialized = true;
+}
+
+#if WATCHDOG_ENABLED
+
+uint32_t watchdogLastUs = 0;
+
+void watchdogArm() {
+  wdt_enable(WDTO_2S);
+  WDTCSR |= _BV(WDIE); // interrupcion + reset: primero la ISR
+}
+
+// El reposo puede durar horas: el watchdog se apaga al dormir y se rearma al despertar.
+void watchdogPause() {
+  wdt_disable();
+}
+
+// Naked: sin prologo, la direccion de retorno (PC interrumpido) esta en la
+// cima de la pila. No vuelve: se reprograma a 15 ms y espera el reset.
+ISR(WDT_vect, ISR_NAKED) {
+  asm volatile("clr __zero_reg__");
+  const uint8_t* sp = (const uint8_t*)SP;
+  blackBox.pc = (uint16_t)((sp[1] << 8) | sp[2]);
+  if (blackBox.watchdogResets < 255) blackBox.watchdogResets++;
+  wdt_enable(WDTO_15MS); // el hardware ya borro WDIE: el siguiente vencimiento resetea
+  for (;;) {
   }
+}
 
-  if (now >= organicDrift[idx].nextTargetAt) {
-    organicDrift[idx].targetPct = (uint8_t)random(minPct, maxPct + 1);
-    organicDrift[idx].nextTargetAt = now + random(targetMinMs, targetMaxMs + 1);
+// Al empezar cada vuelta: tiempo de la anterior, modo y alimentacion del WDT.
+void watchdogFrame(const FrameContext& fc) {
+  uint32_t us = micros();
+  uint32_t d = us - watchdogLastUs;
+  watchdogLastUs = us;
+  blackBox.frameUs[blackBox.frameHead] = (uint16_t)(d > 65535UL ? 65535UL : d);
+  blackBox.frameHead = (uint8_t)((blackBox.frameHead + 1) % BB_FRAME_TIMES);
+  blackBox.mode = shrines[0].currentMode;
+  blackBox.movement = shrineSceneKey(shrines[0]) & 1;
+  blackBox.now = fc.now;
+  blackBox.stage = STAGE_SYNC;
+  wdt_reset();
+}
+
+inline void loopStage(LoopStage s) {
+  blackBox.stage = s;
+}
+
+void blackBoxLevels(const uint8_t* out) {
+  memcpy(blackBox.levels[blackBox.levelsHead], out, LED_COUNT);
+  blackBox.levelsHead = (uint8_t)((blackBox.levelsHead + 1) % BB_LEVEL_FRAMES);
+}
+
+// Prueba del detector: cuelga el loop (consola "wdt test").
+void watchdogTest() {
+  Serial.println(F("wdt: bucle infinito, reset en ~2 s"));
+  Serial.flush();
+  for (;;) {
   }
+}
 
-  if (now - organicDrift[idx].lastStepAt < stepIntervalMs) {
-    setLedStaticPercent(idx, organicDrift[idx].currentPct);
-    return;
+#else
+
+void watchdogArm() {}
+void watchdogPause() {}
+void watchdogFrame(const FrameContext&) {}
+inline void loopStage(LoopStage) {}
+void blackBoxLevels(const uint8_t*) {}
+void watchdogTest() { Serial.println(F("ERR watchdog desactivado")); }
+
+#endif
+
+// ==============================================================================
+// Memoria: marca de agua de la pila por pintado de la SRAM libre
+// ==============================================================================
+// Al arrancar (.init3) se pinta la SRAM libre entre el heap y la pila con
+// MEM_PAINT. Cada frame se revisan MEM_SCAN_BYTES desde el tope del heap hacia
+// arriba: el primer byte que ya no tiene la pintura es lo mas hondo que ha
+// llegado la pila. Al cambiar de escena (modo o submodo) se termina la pasada,
+// se apunta el minimo de la escena que sale y se vuelve a pintar: asi cada
+// escena tiene su propio minimo de memoria libre. La vuelta que cambia de
+// escena cuenta para la escena que sale; el snapshot por serie sale despues
+// (INPUT_SETTLE_MS) y cuenta para la nueva.
+
+#ifndef MEM_WATCH_ENABLED
+#define MEM_WATCH_ENABLED 1
+#endif
+#ifndef MEM_LOW_BYTES
+#define MEM_LOW_BYTES 128 // por debajo se recorta el log verboso
+#endif
+
+extern char __heap_start;
+extern char* __brkval; // tope del heap de malloc (0 si nunca se uso)
+
+const uint8_t MEM_PAINT = 0xC5;
+const uint8_t MEM_SCAN_BYTES = 16;
+const uint8_t MEM_PAINT_GUARD = 16; // bytes bajo SP que no se pintan (frame en curso)
+
+inline char* memHeapTop() {
+  return __brkval ? __brkval : &__heap_start;
+}
+
+// SRAM libre ahora mismo entre el heap y la pila.
+uint16_t memFreeNow() {
+  char here;
+  return (uint16_t)(&here - memHeapTop());
+}
+
+#if MEM_WATCH_ENABLED
+
+void memPaintAtBoot() __attribute__((naked, used, section(".init3")));
+void memPaintAtBoot() {
+  for (uint8_t* p = (uint8_t*)&__heap_start; p < (uint8_t*)SP; p++) *p = MEM_PAINT;
+}
+
+struct MemWatch {
+  uint8_t* low;               // byte mas hondo usado por la pila en la escena
+  uint8_t* scan;              // siguiente byte a revisar
+  uint16_t minFree;           // minimo global desde el arranque (o "mem reset")
+  uint8_t sceneKey;           // shrineSceneKey() (0xFF = arranque)
+  uint32_t seen;              // bit por escena con datos
+  uint8_t sceneFree4[MODE_COUNT][2]; // minimo por escena, en unidades de 4 bytes (255 = 1020+)
+};
+
+MemWatch mem = {0, 0, 0xFFFF, 0xFF, 0, {}};
+static_assert(MODE_COUNT * 2 <= 32, "MemWatch.seen necesita un bit por escena");
+
+// Revisa hasta maxBytes desde el cursor; true si la pasada llego al final.
+bool memScan(uint16_t maxBytes) {
+  uint8_t* top = (uint8_t*)memHeapTop();
+  if (mem.scan < top) mem.scan = top;
+  while (maxBytes-- && mem.scan < mem.low) {
+    if (*mem.scan != MEM_PAINT) {
+      mem.low = mem.scan;
+      break;
+    }
+    mem.scan++;
   }
-  organicDrift[idx].lastStepAt = now;
-
-  uint8_t step = (uint8_t)random(stepMinPct, stepMaxPct + 1);
-  if (organicDrift[idx].currentPct < organicDrift[idx].targetPct) {
-    uint16_t next = organicDrift[idx].currentPct + step;
-    organicDrift[idx].currentPct = (next > organicDrift[idx].targetPct) ? organicDrift[idx].targetPct : (uint8_t)next;
-  } else if (organicDrift[idx].currentPct > organicDrift[idx].targetPct) {
-    int next = (int)organicDrift[idx].currentPct - step;
-    organicDrift[idx].currentPct = (next < organicDrift[idx].targetPct) ? organicDrift[idx].targetPct : (uint8_t)next;
+  uint16_t freeBytes = (uint16_t)(mem.low - top);
+  if (freeBytes < mem.minFree) mem.minFree = freeBytes;
+  if (mem.sceneKey != 0xFF) {
+    uint8_t f4 = (uint8_t)(freeBytes / 4 > 255 ? 255 : freeBytes / 4);
+    uint8_t& slot = mem.sceneFree4[mem.sceneKey >> 1][mem.sceneKey & 1];
+    if (!(mem.seen & (1UL << mem.sceneKey)) || f4 < slot) slot = f4;
+    mem.seen |= 1UL << mem.sceneKey;
   }
+  if (mem.scan < mem.low) return false;
+  mem.scan = top; // pasada completa: la siguiente empieza de nuevo abajo
+  return true;
+}
+
+// Pinta de nuevo la SRAM libre; la marca de agua vuelve a SP.
+void memRepaint() {
+  uint8_t* end = (uint8_t*)SP - MEM_PAINT_GUARD;
+  for (uint8_t* p = (uint8_t*)memHeapTop(); p < end; p++) *p = MEM_PAINT;
+  mem.low = end;
+  mem.scan = (uint8_t*)memHeapTop();
+}
 
-  setLedStaticPercent(idx, organicDrift[idx].currentPct);
+// Unica degradacion: recortar el log verboso. La cache de escena es un buffer
+// estatico en .bss; reducirla no acerca ni aleja la pila del heap.
+void memCheckMargin() {
+  if (memLow || mem.minFree >= MEM_LOW_BYTES) return;
+  memLow = true;
+  logSpoolFlush(); // el aviso va detras de lo que ya estaba en cola
+  Serial.print(F(">>> Memoria baja: "));
+  Serial.print(mem.minFree);
+  Serial.println(F(" bytes libres minimo, se recorta el log <<<"));
 }
 
-// Efecto nuevo: halo circular en triada ATRA -> FDEP -> FIZO (ciclico).
-void applyTriadCircularHalo(uint8_t basePct, uint8_t peakPct, unsigned long periodMs) {
-  basePct = constrain(basePct, 0, 100);
-  peakPct = constrain(peakPct, 0, 100);
-  if (basePct > peakPct) {
-    uint8_t t = basePct;
-    basePct = peakPct;
-    peakPct = t;
+// Cada frame: trozo de la pasada de fondo y cambio de escena.
+void memFrame() {
+  uint8_t key = shrineSceneKey(shrines[0]);
+  if (key != mem.sceneKey) {
+    if (mem.low == 0) mem.low = (uint8_t*)SP - MEM_PAINT_GUARD; // primera vuelta: pintado de .init3
+    while (!memScan(0xFFFF)) {
+    }
+    mem.sceneKey = key;
+    memRepaint();
+  } else {
+    memScan(MEM_SCAN_BYTES);
   }
-  if (periodMs < 1200) periodMs = 1200;
-
-  auto trianglePct = [](unsigned long tMs, unsigned long pMs, unsigned long offsetMs) -> uint8_t {
-    unsigned long ph = (tMs + offsetMs) % pMs;
-    unsigned long half = pMs / 2;
-    if (ph < half) return (uint8_t)((ph * 100UL) / half); // 0..100
-    return (uint8_t)(((pMs - ph) * 100UL) / half);         // 100..0
-  };
-
-  unsigned long now = millis();
-  unsigned long offset1 = 0;
-  unsigned long offset2 = periodMs / 3;
-  unsigned long offset3 = (periodMs * 2UL) / 3UL;
-  uint8_t span = peakPct - basePct;
-
-  uint8_t waveAtra = trianglePct(now, periodMs, offset1);
-  uint8_t waveFdep = trianglePct(now, periodMs, offset2);
-  uint8_t waveFizo = trianglePct(now, periodMs, offset3);
-
-  uint8_t atraPct = basePct + (uint8_t)((span * waveAtra) / 100UL);
-  uint8_t fdepPct = basePct + (uint8_t)((span * waveFdep) / 100UL);
-  uint8_t fizoPct = basePct + (uint8_t)((span * waveFizo) / 100UL);
-
-  setLedStaticPercent(5, atraPct); // ATRA
-  setLedStaticPercent(4, fdepPct); // FDEP
-  setLedStaticPercent(3, fizoPct); // FIZO
-}
-
-// Efecto "ola de mar" circular para Modo 6 base:
-// Fase A: ATRA sube mientras FIZO+FDEP bajan.
-// Fase B: FIZO+FDEP suben juntos mientras ATRA baja.
-void applySeaWaveCircularMode6Base(
-  uint8_t atraMinPct,
-  uint8_t atraMaxPct,
-  uint8_t grupoMinPct,
-  uint8_t grupoMaxPct,
-  unsigned long periodMs
-) {
-  atraMinPct = constrain(atraMinPct, 0, 100);
-  atraMaxPct = constrain(atraMaxPct, 0, 100);
-  grupoMinPct = constrain(grupoMinPct, 0, 100);
-  grupoMaxPct = constrain(grupoMaxPct, 0, 100);
-  if (atraMinPct > atraMaxPct) { uint8_t t = atraMinPct; atraMinPct = atraMaxPct; atraMaxPct = t; }
-  if (grupoMinPct > grupoMaxPct) { uint8_t t = grupoMinPct; grupoMinPct = grupoMaxPct; grupoMaxPct = t; }
-  if (periodMs < 1200) periodMs = 1200;
-
-  auto trianglePct = [](unsigned long tMs, unsigned long pMs) -> uint8_t {
-    unsigned long ph = tMs % pMs;
-    unsigned long half = pMs / 2;
-    if (ph < half) return (uint8_t)((ph * 100UL) / half); // 0..100
-    return (uint8_t)(((pMs - ph) * 100UL) / half);         // 100..0
-  };
-
-  unsigned long now = millis();
-  uint8_t waveAtra = trianglePct(now, periodMs);
-  uint8_t waveGrupo = trianglePct(now + (periodMs / 2), periodMs); // opuesto
-
-  uint8_t atraSpan = atraMaxPct - atraMinPct;
-  uint8_t grupoSpan = grupoMaxPct - grupoMinPct;
-
-  uint8_t atraPct = atraMinPct + (uint8_t)((atraSpan * waveAtra) / 100UL);
-  uint8_t grupoPct = grupoMinPct + (uint8_t)((grupoSpan * waveGrupo) / 100UL);
-
-  setLedStaticPercent(5, atraPct);  // ATRA lider
-  setLedStaticPercent(3, grupoPct); // FIZO
-  setLedStaticPercent(4, grupoPct); // FDEP (junto con FIZO)
+  memCheckMargin();
 }
 
-void setLedName(uint8_t index, const char* name) {
-  if (index >= LED_COUNT) return;
-  ledNames[index] = String(name);
+void memReset() {
+  mem.minFree = 0xFFFF;
+  mem.seen = 0;
+  memRepaint();
 }
 
-const char* getLedName(uint8_t index) {
-  if (index >= LED_COUNT) return "";
-  return ledNames[index].c_str();
+#else
+
+void memFrame() {}
+void memReset() {}
+
+#endif
+
+void printMemStatus() {
+  Serial.print(F("mem: estatica "));
+  Serial.print((unsigned)(&__heap_start - (char*)RAMSTART));
+  Serial.print(F(" | heap "));
+  Serial.print((unsigned)(memHeapTop() - &__heap_start));
+  Serial.print(F(" | libre ahora "));
+  Serial.print(memFreeNow());
+#if MEM_WATCH_ENABLED
+  Serial.print(F(" | minimo "));
+  Serial.print(mem.minFree);
+  Serial.print(F(" | log "));
+  Serial.println(memLow ? F("reducido") : F("completo"));
+  Serial.println(F("  minimo libre por escena (base / movimiento, - = sin datos):"));
+  for (uint8_t m = 0; m < MODE_COUNT; m++) {
+    if (!(mem.seen & (3UL << (m * 2)))) continue;
+    Serial.print(F("   M"));
+    Serial.print(m + 1);
+    for (uint8_t k = 0; k < 2; k++) {
+      Serial.print(k ? F(" / ") : F(": "));
+      if (!(mem.seen & (1UL << (m * 2 + k)))) Serial.print('-');
+      else if (mem.sceneFree4[m][k] == 255) Serial.print(F("1020+"));
+      else Serial.print(mem.sceneFree4[m][k] * 4);
+    }
+    Serial.println();
+  }
+#else
+  Serial.println(F(" | marca de agua desactivada (MEM_WATCH_ENABLED=0)"));
+#endif
 }
 
-void allLedsOff() {
-  for (uint8_t i = 0; i < LED_COUNT; i++) {
-    disableRandomFlashEffect(i);
-    resetOrganicDriftState(i);
-    setFadeActive(i, false);
-    setLedState(i, 0);
+// ==============================================================================
+// Telemetria de ocupacion (anillo de eventos en RAM + horas en EEPROM)
+// ==============================================================================
+// Formato en include/telemetry_format.h. Los eventos van a un anillo de RAM
+// con deltas en segundos; cada hora se cierra un registro de contadores que se
+// escribe en el anillo de EEPROM (tras los slots VM) a razon de un byte por
+// frame y solo si la EEPROM ya termino el anterior: el render nunca espera
+// los ~3.3 ms de cada escritura. El anillo reparte el desgaste: cada celda se
+// reescribe una vez cada TLM_RECORD_COUNT horas.
+
+const uint16_t TLM_EEPROM_BASE = VM_EEPROM_BASE + VM_SLOT_COUNT * VM_SLOT_BYTES; // 768..1023
+const uint8_t TLM_RING_EVENTS = 20;
+
+struct Telemetry {
+  uint8_t ring[TLM_RING_EVENTS * TLM_EVENT_BYTES];
+  uint8_t head;                    // hueco del siguiente evento (= el mas antiguo si esta lleno)
+  uint8_t count;
+  uint32_t baseS;                  // instante del evento anterior al mas antiguo
+  uint32_t lastEventS;
+  uint32_t nowS;                   // reloj de telemetria: segundos despiertos
+  uint16_t msAcc;
+  unsigned long lastMs;
+  uint8_t resetCause;
+  uint16_t hourS;                  // hora en curso
+  uint16_t movementS;
+  uint16_t modeS[MODE_COUNT];
+  TlmHourRecord hour;              // contadores de la hora; hour.seq = siguiente secuencia
+  uint8_t nextSlot;                // hueco de EEPROM del siguiente registro
+  uint8_t pending[TLM_RECORD_BYTES];
+  uint8_t pendingLeft;             // bytes del registro aun por escribir
+  uint16_t pendingAddr;
+};
+
+Telemetry tlm;
+
+uint16_t tlmSlotAddr(uint8_t slot) {
+  return (uint16_t)(TLM_EEPROM_BASE + (uint16_t)slot * TLM_RECORD_BYTES);
+}
+
+bool tlmReadSlot(uint8_t slot, TlmHourRecord& r) {
+  uint8_t b[TLM_RECORD_BYTES];
+  for (uint8_t i = 0; i < TLM_RECORD_BYTES; i++) b[i] = EEPROM.read(tlmSlotAddr(slot) + i);
+  return tlmDecodeRecord(b, r);
+}
+
+void tlmPushRaw(uint8_t typeArg, uint16_t delta) {
+  if (tlm.count == TLM_RING_EVENTS) {
+    // Se pisa el mas antiguo: su delta pasa a la base.
+    const uint8_t* old = &tlm.ring[tlm.head * TLM_EVENT_BYTES];
+    tlm.baseS += (uint16_t)(old[1] | (old[2] << 8));
+    tlm.count--;
   }
+  uint8_t* e = &tlm.ring[tlm.head * TLM_EVENT_BYTES];
+  e[0] = typeArg;
+  e[1] = (uint8_t)delta;
+  e[2] = (uint8_t)(delta >> 8);
+  tlm.head = (uint8_t)((tlm.head + 1) % TLM_RING_EVENTS);
+  tlm.count++;
 }
 
-void printLedNames() {
-  Serial.println(F("Mapeo LEDs (PIN -> NOMBRE):"));
-  for (uint8_t i = 0; i < LED_COUNT; i++) {
-    Serial.print(F("PIN "));
-    Serial.print(LED_PINS[i]);
-    Serial.print(F(" -> "));
-    if (ledNames[i].length()) Serial.println(ledNames[i]);
-    else {
-      Serial.print(F("LED"));
-      Serial.println(i + 1);
+inline void tlmCount(uint8_t& c) {
+  if (c != 255) c++;
+}
+
+void telemetryEvent(TlmEventType type, uint8_t arg) {
+  uint32_t delta = tlm.nowS - tlm.lastEventS;
+  for (; delta > 0xFFFFUL; delta -= 0xFFFFUL) tlmPushRaw((uint8_t)(TLM_EVT_GAP << 4), 0xFFFF);
+  tlmPushRaw((uint8_t)((type << 4) | (arg & 0x0F)), (uint16_t)delta);
+  tlm.lastEventS = tlm.nowS;
+  if (type == TLM_EVT_PIR) tlmCount(tlm.hour.pirRises);
+  else if (type == TLM_EVT_TIMEOUT) tlmCount(tlm.hour.timeouts);
+  else if (type == TLM_EVT_MODE) tlmCount(tlm.hour.modeChanges);
+  else if (type == TLM_EVT_SLEEP) tlmCount(tlm.hour.sleeps);
+}
+
+// Contadores de la hora en curso -> registro (sin tocar la secuencia).
+void tlmFillHour(TlmHourRecord& r) {
+  r = tlm.hour;
+  uint8_t main = 0;
+  for (uint8_t m = 1; m < MODE_COUNT; m++) {
+    if (tlm.modeS[m] > tlm.modeS[main]) main = m;
+  }
+  r.mainMode = main;
+  uint16_t units = tlm.movementS / TLM_MOVEMENT_UNIT_S;
+  r.movementUnits = (uint8_t)(units > 225 ? 225 : units);
+}
+
+void tlmCloseHour() {
+  TlmHourRecord r;
+  tlmFillHour(r);
+  tlmEncodeRecord(r, tlm.pending);
+  tlm.pendingAddr = tlmSlotAddr(tlm.nextSlot);
+  tlm.pendingLeft = TLM_RECORD_BYTES;
+  tlm.nextSlot = (uint8_t)((tlm.nextSlot + 1) % TLM_RECORD_COUNT);
+  uint16_t seq = tlm.hour.seq;
+  memset(&tlm.hour, 0, sizeof(tlm.hour));
+  tlm.hour.seq = (uint16_t)(seq + 1);
+  memset(tlm.modeS, 0, sizeof(tlm.modeS));
+  tlm.movementS = 0;
+  tlm.hourS = (uint16_t)(tlm.hourS - TLM_HOUR_S);
+}
+
+// Un byte por llamada; el CRC va el ultimo, asi un corte deja el hueco invalido.
+void tlmFlushStep() {
+  if (tlm.pendingLeft == 0 || !eeprom_is_ready()) return;
+  uint8_t i = (uint8_t)(TLM_RECORD_BYTES - tlm.pendingLeft);
+  EEPROM.update(tlm.pendingAddr + i, tlm.pending[i]);
+  tlm.pendingLeft--;
+}
+
+// Antes de dormir: termina el registro pendiente (aqui si se puede esperar).
+void telemetryFlushNow() {
+  while (tlm.pendingLeft) tlmFlushStep();
+}
+
+void telemetryBegin(uint8_t resetCause) {
+  tlm.lastMs = millis();
+  tlm.resetCause = resetCause;
+  // El registro valido de mayor secuencia es el ultimo escrito.
+  bool found = false;
+  uint16_t best = 0;
+  for (uint8_t s = 0; s < TLM_RECORD_COUNT; s++) {
+    TlmHourRecord r;
+    if (!tlmReadSlot(s, r)) continue;
+    if (!found || (int16_t)(r.seq - best) > 0) {
+      best = r.seq;
+      tlm.nextSlot = (uint8_t)((s + 1) % TLM_RECORD_COUNT);
     }
+    found = true;
   }
+  tlm.hour.seq = found ? (uint16_t)(best + 1) : 0;
+  telemetryEvent(TLM_EVT_RESET, resetCause);
 }
 
-void describeCurrentMode(Mode m) {
-  Serial.print(F(" > MODO ACTUAL: "));
-  switch (m) {
-    case MODE_1_CONTEMPLATIVO: Serial.println(F("1 - CONTEMPLATIVO AURORA")); break;
-    case MODE_2_SOLO_CANDELITA: Serial.println(F("2 - SOLO CANDELITA")); break;
-    case MODE_3_CANDELITA_PASTOR: Serial.println(F("3 - CANDELITA + PASTOR")); break;
-    case MODE_4_CANDELITA_PASTOR_VIRGEN: Serial.println(F("4 - CANDELITA + PASTOR + VIRGEN")); break;
-    case MODE_5_CANDELITA_PASTOR_VIRGEN_CARA: Serial.println(F("5 - VIRGEN SOLO CARA")); break;
-    case MODE_6_ENFASIS_VIRGEN: Serial.println(F("6 - ENFASIS VIRGEN")); break;
-    default: Serial.println(F("DESCONOCIDO")); break;
+// Cada frame: reloj de segundos, contadores de la hora y escritura pendiente.
+void telemetryFrame() {
+  unsigned long ms = millis();
+  uint32_t elapsed = (uint32_t)(ms - tlm.lastMs) + tlm.msAcc;
+  tlm.lastMs = ms;
+  if (elapsed >= 1000) {
+    uint32_t secs = elapsed / 1000; // una division por segundo
+    elapsed -= secs * 1000;
+    tlm.nowS += secs;
+    // Tras un reposo largo en idle llega todo junto: se recorta a una hora.
+    uint16_t add = (uint16_t)(secs > TLM_HOUR_S ? TLM_HOUR_S : secs);
+    tlm.hourS += add;
+    tlm.modeS[shrines[0].currentMode] += add;
+    if (shrineSceneKey(shrines[0]) & 1) tlm.movementS += add;
+    if (tlm.hourS >= TLM_HOUR_S) tlmCloseHour();
   }
+  tlm.msAcc = (uint16_t)elapsed;
+  tlmFlushStep();
 }
 
-void printModeProfile(Mode m, bool movement) {
-  Serial.println(movement ? F("PERFIL MOVIMIENTO (30s)") : F("PERFIL BASE"));
-  switch (m) {
-    case MODE_1_CONTEMPLATIVO:
-      {
-        const Mode1Profile& p = getMode1Profile();
-        Serial.print(F(" VARIANTE M1: "));
-        Serial.println(p.name);
-      }
-      if (movement) {
-        const Mode1Profile& p = getMode1Profile();
-        Serial.print(F(" CAN1/CAN2: Candelita "));
-        Serial.print(p.canMovePct);
-        Serial.println(F("% (CAN2 con 20% menos tope)"));
-        Serial.print(F(" CARA: Deriva Organica "));
-        Serial.print(p.caraMoveMinPct);
-        Serial.print(F("%-"));
-        Serial.print(p.caraMoveMaxPct);
-        Serial.println(F("%"));
-        Serial.print(F(" HALO TRIADA: ATRA->FDEP->FIZO ("));
-        Serial.print(p.triadMoveBasePct);
-        Serial.print(F("%-"));
-        Serial.print(p.triadMovePeakPct);
-        Serial.println(F("%, ciclo rapido)"));
-      } else {
-        const Mode1Profile& p = getMode1Profile();
-        Serial.print(F(" CAN1/CAN2: Candelita "));
-        Serial.print(p.canBasePct);
-        Serial.println(F("% (CAN2 con 20% menos tope)"));
-        Serial.print(F(" CARA: Deriva Organica "));
-        Serial.print(p.caraBaseMinPct);
-        Serial.print(F("%-"));
-        Serial.print(p.caraBaseMaxPct);
-        Serial.println(F("%"));
-        Serial.print(F(" HALO TRIADA: ATRA->FDEP->FIZO ("));
-        Serial.print(p.triadBasePct);
-        Serial.print(F("%-"));
-        Serial.print(p.triadPeakBasePct);
-        Serial.println(F("%, ciclo lento)"));
-      }
-      break;
+uint8_t tlmStoredRecords() {
+  uint8_t n = 0;
+  TlmHourRecord r;
+  for (uint8_t s = 0; s < TLM_RECORD_COUNT; s++) n += tlmReadSlot(s, r) ? 1 : 0;
+  return n;
+}
 
-    case MODE_2_SOLO_CANDELITA:
-      if (movement) {
-        Serial.println(F(" CAN1/CAN2: Candelita 70% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Fade 40%-60%"));
-        Serial.println(F(" FIZO/FDEP/ATRA: OFF"));
-      } else {
-        Serial.println(F(" CAN1/CAN2: Candelita 20% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Estatico 5%"));
-        Serial.println(F(" FIZO/FDEP/ATRA: OFF"));
-      }
-      break;
+void printTelemetryStatus() {
+  Serial.print(F("tlm: reloj "));
+  Serial.print(tlm.nowS);
+  Serial.print(F(" s | eventos "));
+  Serial.print(tlm.count);
+  Serial.print('/');
+  Serial.print(TLM_RING_EVENTS);
+  Serial.print(F(" | hora en curso "));
+  Serial.print(tlm.hourS / 60);
+  Serial.print(F(" min, PIR "));
+  Serial.print(tlm.hour.pirRises);
+  Serial.print(F(" | registros EEPROM "));
+  Serial.print(tlmStoredRecords());
+  Serial.print('/');
+  Serial.println(TLM_RECORD_COUNT);
+}
 
-    case MODE_3_CANDELITA_PASTOR:
-      if (movement) {
-        Serial.println(F(" CAN1/CAN2: Candelita 90% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Estatico 50%"));
-        Serial.println(F(" FIZO: Estatico 10%"));
-        Serial.println(F(" FDEP: Fade 5%-100% (vel media)"));
-        Serial.println(F(" ATRA: OFF"));
-      } else {
-        Serial.println(F(" CAN1/CAN2: Candelita 70% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Estatico 10%"));
-        Serial.println(F(" FIZO: Respiracion suave 10%-50%"));
-        Serial.println(F(" FDEP: Estatico 40%"));
-        Serial.println(F(" ATRA: OFF"));
-      }
-      break;
+struct TlmDumpWriter {
+  uint16_t crc;
+  uint8_t lineLen;
+};
 
-    case MODE_4_CANDELITA_PASTOR_VIRGEN:
-      if (movement) {
-        Serial.println(F(" CAN1/CAN2: Candelita 90% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Estatico 40%"));
-        Serial.println(F(" FIZO/FDEP: Estatico 80%"));
-        Serial.println(F(" ATRA: Fade 0%-100%"));
-      } else {
-        Serial.println(F(" CAN1/CAN2: Candelita 70% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Estatico 10%"));
-        Serial.println(F(" FIZO/FDEP/ATRA: Tenue 10% + destello aleatorio"));
-      }
-      break;
+void tlmDumpByte(TlmDumpWriter& w, uint8_t b) {
+  if (w.lineLen == 0) Serial.print(F("tlm data "));
+  if (b < 0x10) Serial.print('0');
+  Serial.print(b, HEX);
+  w.crc = vmCrc16Update(w.crc, b);
+  if (++w.lineLen == 32) {
+    Serial.println();
+    w.lineLen = 0;
+  }
+}
 
-    case MODE_5_CANDELITA_PASTOR_VIRGEN_CARA:
-      if (movement) {
-        Serial.println(F(" CAN1/CAN2: Candelita 80% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Fade 40%-90%"));
-        Serial.println(F(" FIZO/FDEP/ATRA: Fade 0%-5% (medio-rapido)"));
-      } else {
-        Serial.println(F(" CAN1/CAN2: Candelita 70% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Estatico 40%"));
-        Serial.println(F(" FIZO/FDEP/ATRA: Estatico 10%"));
-      }
-      break;
+void tlmDumpU32(TlmDumpWriter& w, uint32_t v) {
+  for (uint8_t i = 0; i < 4; i++) tlmDumpByte(w, (uint8_t)(v >> (8 * i)));
+}
 
-    case MODE_6_ENFASIS_VIRGEN:
-      if (movement) {
-        Serial.println(F(" CAN1/CAN2: Candelita 100% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA+ATRA: Respiracion devocional 40%-80% (ATRA desfasado/tenue)"));
-        Serial.println(F(" FIZO/FDEP: Estatico 30%"));
-      } else {
-        Serial.println(F(" CAN1/CAN2: Candelita 70% (CAN2 con 20% menos tope)"));
-        Serial.println(F(" CARA: Estatico 60%"));
-        Serial.println(F(" OLA MAR circular: ATRA <-> (FIZO+FDEP) juntos"));
-        Serial.println(F(" ATRA: Oscila 10%-30%"));
-        Serial.println(F(" FIZO/FDEP: Oscilan 8%-24% (sincronizados)"));
-      }
-      break;
+// Volcado binario en hexadecimal (decodificar con src/tools/telemetry_decoder.cpp).
+void dumpTelemetry() {
+  uint8_t stored = tlmStoredRecords();
+  uint16_t bytes = (uint16_t)(14 + tlm.count * TLM_EVENT_BYTES + TLM_RECORD_BYTES + 1 + stored * TLM_RECORD_BYTES);
+  Serial.print(F("tlm begin "));
+  Serial.print(TLM_VERSION);
+  Serial.print(' ');
+  Serial.println(bytes);
+  TlmDumpWriter w = {0xFFFF, 0};
+  tlmDumpByte(w, 'T');
+  tlmDumpByte(w, 'M');
+  tlmDumpByte(w, TLM_VERSION);
+  tlmDumpByte(w, MODE_COUNT);
+  tlmDumpU32(w, tlm.nowS);
+  tlmDumpByte(w, tlm.resetCause);
+  tlmDumpByte(w, tlm.count);
+  tlmDumpU32(w, tlm.baseS);
+  uint8_t first = (uint8_t)((tlm.head + TLM_RING_EVENTS - tlm.count) % TLM_RING_EVENTS);
+  for (uint8_t k = 0; k < tlm.count; k++) {
+    const uint8_t* e = &tlm.ring[((first + k) % TLM_RING_EVENTS) * TLM_EVENT_BYTES];
+    for (uint8_t i = 0; i < TLM_EVENT_BYTES; i++) tlmDumpByte(w, e[i]);
+  }
+  TlmHourRecord cur;
+  tlmFillHour(cur);
+  uint8_t rec[TLM_RECORD_BYTES];
+  tlmEncodeRecord(cur, rec);
+  for (uint8_t i = 0; i < TLM_RECORD_BYTES; i++) tlmDumpByte(w, rec[i]);
+  tlmDumpByte(w, stored);
+  // Del mas antiguo al mas reciente: el anillo empieza en el hueco siguiente al ultimo.
+  for (uint8_t k = 0; k < TLM_RECORD_COUNT; k++) {
+    uint8_t s = (uint8_t)((tlm.nextSlot + k) % TLM_RECORD_COUNT);
+    TlmHourRecord r;
+    if (!tlmReadSlot(s, r)) continue;
+    for (uint8_t i = 0; i < TLM_RECORD_BYTES; i++) tlmDumpByte(w, EEPROM.read(tlmSlotAddr(s) + i));
+  }
+  if (w.lineLen) Serial.println();
+  Serial.print(F("tlm end "));
+  if (w.crc < 0x1000) Serial.print('0');
+  if (w.crc < 0x100) Serial.print('0');
+  if (w.crc < 0x10) Serial.print('0');
+  Serial.println(w.crc, HEX);
+}
 
-    default:
-      Serial.println(F(" Perfil no definido"));
-      break;
+// Borra eventos y registros (bloquea ~0.85 s si la EEPROM estaba llena).
+void clearTelemetry() {
+  tlm.pendingLeft = 0;
+  for (uint16_t a = 0; a < (uint16_t)TLM_RECORD_COUNT * TLM_RECORD_BYTES; a++) EEPROM.update(TLM_EEPROM_BASE + a, 0xFF);
+  tlm.count = 0;
+  tlm.head = 0;
+  tlm.baseS = tlm.nowS;
+  tlm.lastEventS = tlm.nowS;
+  tlm.nextSlot = 0;
+  tlm.hour.seq = 0;
+}
+
+// ==============================================================================
+// Sincronizacion multi-nodo (bus UART compartido)
+// ==============================================================================
+// Varios Nano (uno por hornacina) comparten reloj, modo y movimiento. El
+// protocolo (mensajes, eleccion de maestro, slew y deriva) esta en
+// include/sync_protocol.h; aqui solo se engancha al frame. Con el bus activo
+// fc.now es el reloj sincronizado, asi que los efectos periodicos (funciones
+// puras de fc.now) quedan en fase entre nodos sin tocarlos.
+
+#if SYNC_BUS_ENABLED
+
+#ifndef SYNC_NODE_ID
+#define SYNC_NODE_ID 0 // 0 = id aleatorio 1..254 en cada arranque
+#endif
+
+const uint8_t SYNC_RX_PIN = 7;
+const uint8_t SYNC_TX_PIN = 8;
+const uint8_t SYNC_BYTES_PER_FRAME = 2 * SYNC_MSG_BYTES;
+// Tras pulsar el boton, los BEACON que aun traen el modo anterior se ignoran
+// durante dos intervalos; si el maestro no adopta el modo (MODE perdido en una
+// colision), el nodo vuelve al modo del grupo.
+const uint16_t SYNC_MODE_HOLD_MS = 2 * SYNC_BEACON_INTERVAL_MS + SYNC_TRANSIT_MS;
+
+SoftwareSerial syncBus(SYNC_RX_PIN, SYNC_TX_PIN);
+SyncNode syncNode;
+SyncParser syncParser = {{0}, 0};
+unsigned long syncModeHoldUntil = 0; // millis() hasta el que se ignora el modo del BEACON
+bool syncRemoteMotion = false;       // flag de movimiento del ultimo BEACON del maestro
+
+void shrineJump(ShrineController& s, int32_t delta); // seccion "Frame de un controlador"
+
+void syncBegin() {
+  uint8_t id = SYNC_NODE_ID;
+  if (id == 0) id = (uint8_t)random(1, 255);
+  syncBus.begin(SYNC_BAUD);
+  syncNodeInit(syncNode, id, (uint32_t)millis());
+  Serial.print(F("Bus sync: nodo "));
+  Serial.print(id);
+  Serial.println(F(" (RX D7, TX D8)"));
+}
+
+unsigned long syncFrameTime(unsigned long local) {
+  return syncClockNow(syncNode.clock, (uint32_t)local);
+}
+
+// La marca de tiempo se toma justo antes de transmitir (el receptor suma
+// SYNC_TRANSIT_MS). SoftwareSerial bloquea ~10 ms por mensaje a 9600 baud.
+void syncSend(uint8_t type) {
+  uint32_t ts = syncClockNow(syncNode.clock, (uint32_t)millis());
+  const ShrineController& s = shrines[0];
+  SyncMessage m = {type, syncNode.id, ts, (uint8_t)s.currentMode, (uint8_t)(s.input.inMovementMode ? SYNC_FLAG_MOTION : 0)};
+  uint8_t buf[SYNC_MSG_BYTES];
+  syncEncode(m, buf);
+  syncBus.write(buf, SYNC_MSG_BYTES);
+}
+
+void syncAdoptMode(uint8_t mode) {
+  ShrineController& s = shrines[0];
+  if (mode >= MODE_COUNT || mode == s.currentMode) return;
+  Mode m = (Mode)mode;
+  if (isVmMode(m) && !(vmSlotValidMask & (1 << vmSlotForMode(m)))) return; // escena no cargada aqui
+  s.currentMode = m;
+  allLedsOff(s);
+  logSpoolPush(LOG_SNAPSHOT, 0, s.currentMode);
+  telemetryEvent(TLM_EVT_MODE, s.currentMode);
+}
+
+// Movimiento en otro nodo: suma intensidad como un flanco del PIR local.
+void syncRemoteMotionStart(unsigned long now) {
+  ShrineController& s = shrines[0];
+  if (!inputMotionStart(s.input, INPUT_GUARD, now)) return;
+  raiseEvent(s, EVT_MOTION_START);
+  logSpoolPush(LOG_REMOTE_MOTION, 0, s.currentMode);
+}
+
+// Salto de reloj (union al bus o cambio de maestro): se desplazan las marcas
+// absolutas y se reinicia la escena, porque los timers de 16 bits de los
+// efectos no sobreviven a un salto largo.
+void syncApplyJump(FrameContext& fc, int32_t delta) {
+  fc.now = (uint32_t)(fc.now + delta);
+  fc.tick = (uint16_t)fc.now;
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) shrineJump(shrines[k], delta);
+}
+
+void pollSyncBus(FrameContext& fc) {
+  uint32_t local = (uint32_t)millis();
+  for (uint8_t n = 0; n < SYNC_BYTES_PER_FRAME && syncBus.available() > 0; n++) {
+    SyncMessage m;
+    if (!syncParse(syncParser, (uint8_t)syncBus.read(), m) || m.node == syncNode.id) continue;
+    int32_t offsetBefore = syncNode.clock.offset;
+    uint16_t jumpsBefore = syncNode.jumps;
+    syncNodeOnMessage(syncNode, m, local);
+    if (syncNode.jumps != jumpsBefore) syncApplyJump(fc, syncNode.clock.offset - offsetBefore);
+    if (m.type == SYNC_MSG_MODE) {
+      syncAdoptMode(m.mode);
+    } else if (m.type == SYNC_MSG_MOTION) {
+      syncRemoteMotionStart(fc.now);
+    } else if (m.type == SYNC_MSG_BEACON && m.node == syncNode.masterId) {
+      if ((long)(local - syncModeHoldUntil) >= 0) syncAdoptMode(m.mode);
+      // Solo el flanco: el fin de ventana de cada nodo lo decide su timeout.
+      bool motion = (m.flags & SYNC_FLAG_MOTION) != 0;
+      if (motion && !syncRemoteMotion) syncRemoteMotionStart(fc.now);
+      syncRemoteMotion = motion;
+    }
   }
+  if (syncNodePoll(syncNode, local)) syncSend(SYNC_MSG_BEACON);
 }
 
-void printModeSnapshot() {
-  // Limpiar pantalla (10 saltos de linea)
-  for (int i = 0; i < 10; i++) Serial.println();
+void syncNotifyMode() {
+  syncModeHoldUntil = (uint32_t)millis() + SYNC_MODE_HOLD_MS;
+  syncSend(SYNC_MSG_MODE);
+}
 
-  Serial.println(F("=========================================="));
-  Serial.println(F("         CAMBIO DE MODO / MODE CHANGED"));
-  Serial.println(F("=========================================="));
-  Serial.print(F("  "));
-  describeCurrentMode(currentMode);
-  Serial.println(F("------------------------------------------"));
+void syncNotifyMotion() {
+  syncSend(SYNC_MSG_MOTION);
+}
 
-  // Mostrar configuracion de cada LED (base y movimiento)
-  uint8_t baseValues[6], moveValues[6];
+void printSyncStatus() {
+  Serial.print(F("sync: nodo "));
+  Serial.print(syncNode.id);
+  Serial.print(syncNode.isMaster ? F(" MAESTRO") : F(" seguidor de "));
+  if (!syncNode.isMaster) Serial.print(syncNode.masterId);
+  Serial.print(F(" | error "));
+  Serial.print(syncNode.lastError);
+  Serial.print(F(" ms | deriva "));
+  Serial.print((long)syncNode.clock.driftQ16 * 15625L / 1024L); // Q16 -> ppm
+  Serial.print(F(" ppm | saltos "));
+  Serial.print(syncNode.jumps);
+  Serial.print(F(" | beacons "));
+  Serial.println(syncNode.beaconsHeard);
+}
 
-  // Volcado de valores segun modo
-  switch (currentMode) {
-    case MODE_1_CONTEMPLATIVO:
-      {
-        const Mode1Profile& p = getMode1Profile();
-        uint8_t caraBaseMid = (uint8_t)((p.caraBaseMinPct + p.caraBaseMaxPct) / 2);
-        uint8_t caraMoveMid = (uint8_t)((p.caraMoveMinPct + p.caraMoveMaxPct) / 2);
-        uint8_t triadBaseMid = (uint8_t)((p.triadBasePct + p.triadPeakBasePct) / 2);
-        uint8_t triadMoveMid = (uint8_t)((p.triadMoveBasePct + p.triadMovePeakPct) / 2);
-
-        baseValues[0] = percentToPwm(p.canBasePct);
-        moveValues[0] = percentToPwm(p.canMovePct);
-        baseValues[1] = (uint8_t)((uint16_t)baseValues[0] * 80 / 100);
-        moveValues[1] = (uint8_t)((uint16_t)moveValues[0] * 80 / 100);
-        baseValues[2] = percentToPwm(caraBaseMid);
-        moveValues[2] = percentToPwm(caraMoveMid);
-        baseValues[3] = percentToPwm(triadBaseMid);
-        moveValues[3] = percentToPwm(triadMoveMid);
-        baseValues[4] = percentToPwm(triadBaseMid);
-        moveValues[4] = percentToPwm(triadMoveMid);
-        baseValues[5] = percentToPwm(triadBaseMid);
-        moveValues[5] = percentToPwm(triadMoveMid);
-      }
-      break;
-    case MODE_2_SOLO_CANDELITA:
-      baseValues[0] = 51;  moveValues[0] = 178;
-      baseValues[1] = 41;  moveValues[1] = 142;
-      baseValues[2] = 13;  moveValues[2] = 127;
-      for(int i=3; i<6; i++) { baseValues[i] = 0; moveValues[i] = 0; }
-      break;
-    case MODE_3_CANDELITA_PASTOR:
-      baseValues[0] = 178; moveValues[0] = 230;
-      baseValues[1] = 142; moveValues[1] = 184;
-      baseValues[2] = 25;  moveValues[2] = 127;
-      baseValues[3] = 127; moveValues[3] = 25;
-      baseValues[4] = 102; moveValues[4] = 255;
-      baseValues[5] = 0;   moveValues[5] = 0;
-      break;
-    case MODE_4_CANDELITA_PASTOR_VIRGEN:
-      baseValues[0] = 178; moveValues[0] = 230;
-      baseValues[1] = 142; moveValues[1] = 184;
-      baseValues[2] = 25;  moveValues[2] = 102;
-      baseValues[3] = 25;  moveValues[3] = 204;
-      baseValues[4] = 25;  moveValues[4] = 204;
-      baseValues[5] = 25;  moveValues[5] = 127; // ATRA fade 0-100% (valor medio)
-      break;
-    case MODE_5_CANDELITA_PASTOR_VIRGEN_CARA:
-      baseValues[0] = 178; moveValues[0] = 204;
-      baseValues[1] = 142; moveValues[1] = 163;
-      baseValues[2] = 102; moveValues[2] = 204;
-      baseValues[3] = 25;  moveValues[3] = 6;   // FIZO fade 0-5% (valor medio)
-      baseValues[4] = 25;  moveValues[4] = 6;   // FDEP fade 0-5% (valor medio)
-      baseValues[5] = 25;  moveValues[5] = 6;   // ATRA fade 0-5% (valor medio)
-      break;
-    case MODE_6_ENFASIS_VIRGEN:
-      baseValues[0] = 178; moveValues[0] = 255;
-      baseValues[1] = 142; moveValues[1] = 204;
-      baseValues[2] = 153; moveValues[2] = 153;
-      baseValues[3] = 41;  moveValues[3] = 76; // FIZO ola mar 8-24% (valor medio)
-      baseValues[4] = 41;  moveValues[4] = 76; // FDEP ola mar 8-24% (valor medio)
-      baseValues[5] = 51;  moveValues[5] = 89; // ATRA ola mar 10-30% (valor medio)
-      break;
-    default:
-      for(int i=0; i<6; i++) { baseValues[i] = 0; moveValues[i] = 0; }
+#else
+
+void syncBegin() {}
+unsigned long syncFrameTime(unsigned long local) { return local; }
+void pollSyncBus(FrameContext&) {}
+void syncNotifyMode() {}
+void syncNotifyMotion() {}
+void printSyncStatus() { Serial.println(F("sync: desactivado (compilar con -DSYNC_BUS_ENABLED=1)")); }
+
+#endif
+
+// ==============================================================================
+// Reposo por inactividad (power-down con despertar por PIR / boton)
+// ==============================================================================
+// Tras SLEEP_IDLE_MIN minutos sin PIR, boton ni consola, la salida baja en
+// SLEEP_FADE_MS hasta SLEEP_FLOOR_PCT (atenuacion de commitFrame) y el MCU duerme:
+//   suelo 0  -> power-down: se para el oscilador (y millis()); solo un cambio
+//               en D2 (boton) o D4 (PIR) lo despierta via PCINT2.
+//   suelo >0 -> idle: el PWM sigue mostrando el suelo y timer0 despierta la
+//               CPU cada ms solo para mirar los pines.
+// En ambos casos el reloj de escena (fc.now) queda congelado mientras duerme:
+// al despertar el modo y la fase de todos los efectos siguen donde se quedaron
+// y el siguiente frame ya sale a brillo completo (~1 ms de arranque del
+// cristal + un frame).
+
+unsigned long sleepPausedMs = 0; // ms de millis() pasados durmiendo (se restan en beginFrame)
+
+// Corriente en mA con una decimal (reposo y duty).
+void printMilliamps(Print& out, uint32_t ua) {
+  out.print(ua / 1000);
+  out.print('.');
+  out.print((ua % 1000) / 100);
+  out.print(F(" mA"));
+}
+
+#if SLEEP_ENABLED
+
+#ifndef SLEEP_IDLE_MIN
+#define SLEEP_IDLE_MIN 15
+#endif
+#ifndef SLEEP_FLOOR_PCT
+#define SLEEP_FLOOR_PCT 0 // 0 = apagado y power-down
+#endif
+
+const unsigned long SLEEP_IDLE_MS = SLEEP_IDLE_MIN * 60000UL;
+const uint16_t SLEEP_FADE_MS = 4000;
+const uint8_t SLEEP_FLOOR_Q8 = (uint8_t)((SLEEP_FLOOR_PCT * 255UL + 50) / 100);
+
+unsigned long lastActivityTime = 0; // fc.now de la ultima actividad
+uint16_t sleepCount = 0;
+
+#if SLEEP_FLOOR_PCT == 0
+// Solo despiertan; el loop lee los pines. Botones y PIR van en D0-D7 (PCINT2)
+// o A0-A5 (PCINT1, la segunda hornacina con SHRINE_SPLIT).
+EMPTY_INTERRUPT(PCINT2_vect);
+#if SHRINE_SPLIT
+EMPTY_INTERRUPT(PCINT1_vect);
+#endif
+#endif
+
+void sleepNoteActivity(unsigned long now) {
+  lastActivityTime = now;
+}
+
+// Cada frame, antes del commit: fija la atenuacion segun el tiempo sin actividad.
+// La actividad (PIR, ventana de movimiento, boton) la anota shrineInputs().
+void updateSleep(const FrameContext& fc) {
+  unsigned long idle = fc.now - lastActivityTime;
+  if (idle < SLEEP_IDLE_MS) {
+    outputDimQ8 = 255; // actividad durante la bajada: vuelve al instante
+    return;
+  }
+  unsigned long t = idle - SLEEP_IDLE_MS;
+  if (t >= SLEEP_FADE_MS) outputDimQ8 = SLEEP_FLOOR_Q8;
+  else outputDimQ8 = (uint8_t)(255 - (uint32_t)(255 - SLEEP_FLOOR_Q8) * t / SLEEP_FADE_MS);
+}
+
+// Boton o PIR de cualquier hornacina activo.
+bool sleepWakePinsActive() {
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) {
+    const ShrineConfig& cfg = SHRINE_CONFIGS[k];
+    if (digitalRead(cfg.btnPin) == LOW || digitalRead(cfg.pirPin) == HIGH) return true;
   }
+  return false;
+}
 
-  Serial.println(F("LED      | MODO BASE | MODO MOVIMIENTO"));
-  Serial.println(F("---------+-----------+-----------------"));
-
-  const char* ledNamesShort[] = {"CAN1", "CAN2", "CARA", "FIZO", "FDEP", "ATRA"};
-  for (uint8_t i = 0; i < 6; i++) {
-    Serial.print(F(" "));
-    Serial.print(ledNamesShort[i]);
-    Serial.print(F("    |  "));
-    if (baseValues[i] < 100) Serial.print(F(" "));
-    if (baseValues[i] < 10)  Serial.print(F(" "));
-    Serial.print(baseValues[i]);
-    Serial.print(F("      |  "));
-    if (moveValues[i] < 100) Serial.print(F(" "));
-    if (moveValues[i] < 10)  Serial.print(F(" "));
-    Serial.println(moveValues[i]);
+#if SLEEP_FLOOR_PCT == 0
+// Cambio de pin (PCINT) de los botones y PIR de todas las hornacinas como
+// fuente de despertar del power-down.
+void sleepWakeArm(bool on) {
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) {
+    const uint8_t pins[2] = {SHRINE_CONFIGS[k].btnPin, SHRINE_CONFIGS[k].pirPin};
+    for (uint8_t j = 0; j < 2; j++) {
+      volatile uint8_t* pcmsk = digitalPinToPCMSK(pins[j]);
+      uint8_t bit = (uint8_t)_BV(digitalPinToPCMSKbit(pins[j]));
+      uint8_t pcie = (uint8_t)_BV(digitalPinToPCICRbit(pins[j]));
+      if (on) {
+        *pcmsk |= bit;
+        PCIFR = pcie;
+        PCICR |= pcie;
+      } else {
+        *pcmsk &= (uint8_t)~bit;
+        PCICR &= (uint8_t)~pcie;
+      }
+    }
+  }
+}
+#endif
+
+// Despues del commit: si la bajada termino, duerme hasta PIR o boton.
+void sleepIfIdle(const FrameContext& fc) {
+  if (fc.now - lastActivityTime < SLEEP_IDLE_MS + SLEEP_FADE_MS) return;
+  logSpoolFlush();
+  Serial.println(F(">>> Sin actividad: reposo (despierta con PIR o boton) <<<"));
+  Serial.flush();
+  sleepCount++;
+  telemetryEvent(TLM_EVT_SLEEP, 0);
+  telemetryFlushNow();
+  watchdogPause();
+#if SLEEP_FLOOR_PCT == 0
+  uint8_t adcsra = ADCSRA;
+  ADCSRA &= (uint8_t)~_BV(ADEN);
+  sleepWakeArm(true);
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  // Un flanco espurio (ruido en el cable del PIR) no enciende: vuelve a dormir.
+  while (!sleepWakePinsActive()) {
+    cli();
+    sleep_enable();
+    sleep_bod_disable();
+    sei();
+    sleep_cpu(); // tras sei se ejecuta sleep_cpu: un PCINT pendiente despierta al momento
+    sleep_disable();
+  }
+  sleepWakeArm(false);
+  ADCSRA = adcsra;
+#else
+  unsigned long t0 = millis();
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  while (!sleepWakePinsActive()) sleep_mode();
+  sleepPausedMs += millis() - t0;
+#endif
+  watchdogArm();
+  // La pulsacion que despierta no cambia de modo: se da por ya vista en la
+  // hornacina cuyo boton se pulso.
+  bool byButton = false;
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) {
+    if (digitalRead(SHRINE_CONFIGS[k].btnPin) != LOW) continue;
+    shrines[k].input.lastReading = LOW;
+    shrines[k].input.stableLevel = LOW;
+    byButton = true;
   }
+  telemetryEvent(TLM_EVT_WAKE, byButton ? 1 : 0);
+  lastActivityTime = fc.now;
+  outputDimQ8 = 255;
+  Serial.println(F(">>> Despierta: escena restaurada <<<"));
+}
 
-  Serial.println(F("------------------------------------------"));
-  printModeProfile(currentMode, false);
-  Serial.println(F("------------------------------------------"));
-  printModeProfile(currentMode, true);
-  Serial.println(F("=========================================="));
+void printSleepStatus(unsigned long now) {
+  Serial.print(F("sleep: inactivo "));
+  Serial.print((now - lastActivityTime) / 1000);
+  Serial.print(F(" s de "));
+  Serial.print(SLEEP_IDLE_MIN);
+  Serial.print(F(" min | suelo "));
+  Serial.print(SLEEP_FLOOR_PCT);
+  Serial.print(F("% | reposos "));
+  Serial.println(sleepCount);
+  // Estimacion con los niveles de la escena de este frame (include/power_model.h).
+  uint8_t scene[6];
+  boardSceneLevels(scene);
+  uint32_t ledUa = powerLedUa(scene, 255);
+  Serial.print(F("  activo "));
+  printMilliamps(Serial, powerStateUa(POWER_ACTIVE, ledUa));
+#if SLEEP_FLOOR_PCT == 0
+  Serial.print(F(" | power-down "));
+  printMilliamps(Serial, powerStateUa(POWER_SLEEP_OFF, 0));
+#else
+  Serial.print(F(" | idle al suelo "));
+  printMilliamps(Serial, powerStateUa(POWER_SLEEP_FLOOR, powerLedUa(scene, SLEEP_FLOOR_Q8)));
+#endif
+  Serial.println();
 }
 
+#else
+
+void sleepNoteActivity(unsigned long) {}
+void updateSleep(const FrameContext&) {}
+void sleepIfIdle(const FrameContext&) {}
+void printSleepStatus(unsigned long) { Serial.println(F("sleep: desactivado (SLEEP_ENABLED=0)")); }
+
+#endif
+
 // ==============================================================================
-// Función de flicker para candelitas (CON INDEPENDENCIA)
+// Consola serie (no bloqueante)
 // ==============================================================================
+// Lee como maximo CONSOLE_BYTES_PER_FRAME bytes por vuelta y ejecuta la linea
+// al recibir '\n'. Cada comando termina con "OK" o "ERR ...": el host debe
+// esperar esa linea antes de mandar la siguiente (las escrituras a EEPROM
+// tardan ~3.3 ms por byte y el buffer de recepcion es de 64 bytes).
 
-void updateCandleFlicker(uint8_t maxValueCan1) {
-  unsigned long now = millis();
-  if (now - lastCandleUpdate < candleNextInterval) return;
-  lastCandleUpdate = now;
+const uint8_t CONSOLE_LINE_MAX = 80;
+const uint8_t CONSOLE_BYTES_PER_FRAME = 32;
 
-  // Intervalo variable para evitar patron mecanico
-  candleNextInterval = random(15, 56); // 15..55 ms
+char consoleLine[CONSOLE_LINE_MAX + 1];
+uint8_t consoleLen = 0;
+bool consoleOverflow = false;
+
+// Estado de la subida de un programa VM (vm begin/data/end).
+struct VmUpload {
+  bool active;
+  uint8_t slot;
+  uint8_t rev;
+  uint16_t len;
+  uint16_t written;
+};
 
-  uint8_t max1 = constrain(maxValueCan1, 0, 255);
-  uint8_t max2 = (uint8_t)((uint16_t)max1 * 80 / 100); // CAN2 siempre 20% menor de maximo
+VmUpload vmUpload = {false, 0, 0, 0, 0};
 
-  int minBase1 = max(5, (int)max1 * 35 / 100);
-  int minBase2 = max(5, (int)max2 * 35 / 100);
-  int dropMax1 = max(5, (int)max1 * 86 / 100);
-  int dropMax2 = max(5, (int)max2 * 86 / 100);
+// Separa el siguiente token (espacios) modificando la linea; "" al final.
+char* consoleToken(char*& p) {
+  while (*p == ' ') p++;
+  char* tok = p;
+  while (*p && *p != ' ') p++;
+  if (*p) *p++ = '\0';
+  return tok;
+}
 
-  if (candleLevel1 == 0 && max1 > 0) candleLevel1 = (uint8_t)((minBase1 + max1) / 2);
-  if (candleLevel2 == 0 && max2 > 0) candleLevel2 = (uint8_t)((minBase2 + max2) / 2);
+bool parseUnsigned(const char* tok, uint8_t base, uint16_t& out) {
+  if (!*tok) return false;
+  uint32_t v = 0;
+  for (; *tok; tok++) {
+    char c = *tok;
+    uint8_t d;
+    if (c >= '0' && c <= '9') d = (uint8_t)(c - '0');
+    else if (base == 16 && c >= 'a' && c <= 'f') d = (uint8_t)(c - 'a' + 10);
+    else if (base == 16 && c >= 'A' && c <= 'F') d = (uint8_t)(c - 'A' + 10);
+    else return false;
+    v = v * base + d;
+    if (v > 0xFFFF) return false;
+  }
+  out = (uint16_t)v;
+  return true;
+}
 
-  // ===== CAN1 (mas vivo) =====
-  int target1 = random(minBase1, max1 + 1);
-  if (random(0, 10) > 5) target1 = random(5, dropMax1 + 1);
-  if (random(0, 100) < 12) candleLevel1 = (uint8_t)target1;
-  else candleLevel1 = (uint8_t)((candleLevel1 + target1 * 2) / 3);
+void consoleOk() {
+  Serial.println(F("OK"));
+}
 
-  // ===== CAN2 (desincronizado y mas suave) =====
-  int target2 = random(minBase2, max2 + 1);
-  if (random(0, 10) > 5) target2 = random(5, dropMax2 + 1);
-  if (random(0, 100) < 8) candleLevel2 = (uint8_t)target2;
-  else candleLevel2 = (uint8_t)((candleLevel2 * 3 + target2) / 4);
+void consoleError(const __FlashStringHelper* why) {
+  Serial.print(F("ERR "));
+  Serial.println(why);
+}
 
-  if (!softOffActive[0]) {
-    analogWrite(LED_PINS[0], candleLevel1);
-    ledBrightness[0] = candleLevel1;
+void printVmSlots() {
+  for (uint8_t s = 0; s < VM_SLOT_COUNT; s++) {
+    uint16_t at = vmSlotAddr(s);
+    Serial.print(F("  slot "));
+    Serial.print(s);
+    Serial.print(F(" (modo "));
+    Serial.print(MODE_8_ESCENA_1 + s + 1);
+    Serial.print(F("): "));
+    if (vmSlotValidMask & (1 << s)) {
+      Serial.print(F("rev "));
+      Serial.print(EEPROM.read(at + 3));
+      Serial.print(F(", "));
+      Serial.print(storageReadU16(BOARD_PLATFORM, at + 4));
+      Serial.print(F(" bytes, crc "));
+      Serial.println(storageReadU16(BOARD_PLATFORM, at + 6), HEX);
+    } else {
+      Serial.println(F("vacio"));
+    }
   }
-  if (!softOffActive[1]) {
-    analogWrite(LED_PINS[1], candleLevel2);
-    ledBrightness[1] = candleLevel2;
+}
+
+// Si la escena que corre es la de este slot, se recarga (o se detiene).
+void reloadVmSlotIfActive(uint8_t slot, unsigned long now) {
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) {
+    ShrineController& s = shrines[k];
+    if (isVmMode(s.currentMode) && vmSlotForMode(s.currentMode) == slot) vmLoadSlot(s, slot, now);
   }
 }
 
-// ======================================================================
-// FADE reutilizable (estado y funciones)
-// ======================================================================
-
-void initFade(uint8_t idx, uint8_t minV, uint8_t maxV, uint8_t step, unsigned long interval) {
-  if (idx >= LED_COUNT) return;
-  fades[idx].min = minV;
-  fades[idx].max = maxV;
-  fades[idx].step = step;
-  fades[idx].interval = interval;
-  fades[idx].val = minV;
-  fades[idx].dir = 1;
-  fades[idx].last = 0;
-  fades[idx].active = false;
-}
-
-void setFadeActive(uint8_t idx, bool active) {
-  if (idx >= LED_COUNT) return;
-  fades[idx].active = active;
-  if (active && fades[idx].val == 0) fades[idx].val = fades[idx].min;
-}
-
-void updateFade(uint8_t idx) {
-  if (idx >= LED_COUNT) return;
-  if (!fades[idx].active) return;
-  unsigned long now = millis();
-  if (now - fades[idx].last < fades[idx].interval) return;
-  fades[idx].last = now;
-  int jitter = random(-1, 2); // -1,0,1
-  int step = (int)fades[idx].step + jitter;
-  int next = (int)fades[idx].val + (int)fades[idx].dir * step;
-  if (next >= fades[idx].max) { next = fades[idx].max; fades[idx].dir = -1; }
-  else if (next <= fades[idx].min) { next = fades[idx].min; fades[idx].dir = 1; }
-  fades[idx].val = (uint8_t)next;
-  setLedState(idx, fades[idx].val);
-}
-
-// Soft-off update: decrement brightness to 0 smoothly (no bloqueo)
-void updateSoftOffs() {
-  unsigned long now = millis();
-  for (uint8_t i = 0; i < LED_COUNT; i++) {
-    if (!softOffActive[i]) continue;
-    if (now - softOffLast[i] < SOFTOFF_INTERVAL) continue;
-    softOffLast[i] = now;
-    uint8_t prev = ledBrightness[i];
-    if (prev <= SOFTOFF_STEP) {
-      // reached zero
-      analogWrite(LED_PINS[i], 0);
-      ledBrightness[i] = 0;
-      softOffActive[i] = false;
-      // If candle pair, ensure both off
-      if (i == 0) { analogWrite(LED_PINS[1], 0); ledBrightness[1] = 0; softOffActive[1] = false; }
-      if (i == 1) { analogWrite(LED_PINS[0], 0); ledBrightness[0] = 0; softOffActive[0] = false; }
+void handleVmCommand(char* p, unsigned long now) {
+  char* sub = consoleToken(p);
+  uint16_t a, b, c;
+
+  if (strcmp(sub, "list") == 0) {
+    printVmSlots();
+    consoleOk();
+  } else if (strcmp(sub, "begin") == 0) {
+    // vm begin <slot> <bytes> <revision>
+    if (!parseUnsigned(consoleToken(p), 10, a) || !parseUnsigned(consoleToken(p), 10, b) ||
+        !parseUnsigned(consoleToken(p), 10, c)) {
+      consoleError(F("uso: vm begin <slot> <bytes> <rev>"));
+    } else if (a >= VM_SLOT_COUNT || b == 0 || b > VM_MAX_CODE_BYTES || c > 255) {
+      consoleError(F("slot/tamano/rev fuera de rango"));
+    } else {
+      vmUpload.active = true;
+      vmUpload.slot = (uint8_t)a;
+      vmUpload.len = b;
+      vmUpload.rev = (uint8_t)c;
+      vmUpload.written = 0;
+      EEPROM.update(vmSlotAddr(vmUpload.slot), 0xFF); // invalida el slot hasta el commit
+      vmSlotValidMask &= (uint8_t)~(1 << vmUpload.slot);
+      reloadVmSlotIfActive(vmUpload.slot, now);
+      consoleOk();
+    }
+  } else if (strcmp(sub, "data") == 0) {
+    // vm data <hex>
+    char* hex = consoleToken(p);
+    uint8_t n = (uint8_t)(strlen(hex) / 2);
+    if (!vmUpload.active) {
+      consoleError(F("sin vm begin"));
+    } else if (n == 0 || (strlen(hex) & 1)) {
+      consoleError(F("hex invalido"));
+    } else if (vmUpload.written + n > vmUpload.len) {
+      consoleError(F("excede el tamano declarado"));
+    } else {
+      uint16_t at = (uint16_t)(vmSlotAddr(vmUpload.slot) + VM_HEADER_BYTES + vmUpload.written);
+      for (uint8_t i = 0; i < n; i++) {
+        char pair[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+        if (!parseUnsigned(pair, 16, a)) {
+          consoleError(F("hex invalido"));
+          return;
+        }
+        EEPROM.update(at + i, (uint8_t)a);
+      }
+      vmUpload.written = (uint16_t)(vmUpload.written + n);
+      consoleOk();
+    }
+  } else if (strcmp(sub, "end") == 0) {
+    // vm end <crc16 hex>
+    if (!vmUpload.active) {
+      consoleError(F("sin vm begin"));
+      return;
+    }
+    if (!parseUnsigned(consoleToken(p), 16, a)) {
+      consoleError(F("uso: vm end <crc hex>"));
+      return;
+    }
+    vmUpload.active = false;
+    uint16_t at = vmSlotAddr(vmUpload.slot);
+    uint16_t base = (uint16_t)(at + VM_HEADER_BYTES);
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < vmUpload.written; i++) crc = vmCrc16Update(crc, EEPROM.read(base + i));
+    uint16_t errAt;
+    if (vmUpload.written != vmUpload.len) {
+      consoleError(F("faltan bytes"));
+    } else if (crc != a) {
+      consoleError(F("CRC no coincide"));
+    } else if (vmVerifyProgram([base](uint16_t x) { return EEPROM.read(base + x); }, vmUpload.len, errAt) != VM_VERIFY_OK) {
+      Serial.print(F("ERR programa invalido en pc="));
+      Serial.println(errAt);
+    } else {
+      EEPROM.update(at + 2, VM_BYTECODE_VERSION);
+      EEPROM.update(at + 3, vmUpload.rev);
+      EEPROM.update(at + 4, (uint8_t)(vmUpload.len & 0xFF));
+      EEPROM.update(at + 5, (uint8_t)(vmUpload.len >> 8));
+      EEPROM.update(at + 6, (uint8_t)(crc & 0xFF));
+      EEPROM.update(at + 7, (uint8_t)(crc >> 8));
+      EEPROM.update(at + 1, 'M');
+      EEPROM.update(at, 'V'); // commit: la cabecera queda valida al final
+      refreshVmSlots();
+      reloadVmSlotIfActive(vmUpload.slot, now);
+      consoleOk();
+    }
+  } else if (strcmp(sub, "del") == 0) {
+    if (!parseUnsigned(consoleToken(p), 10, a) || a >= VM_SLOT_COUNT) {
+      consoleError(F("uso: vm del <slot>"));
     } else {
-      uint8_t next = prev - SOFTOFF_STEP;
-      analogWrite(LED_PINS[i], next);
-      ledBrightness[i] = next;
-      // keep paired candle in sync
-      if (i == 0) { analogWrite(LED_PINS[1], next); ledBrightness[1] = next; }
-      if (i == 1) { analogWrite(LED_PINS[0], next); ledBrightness[0] = next; }
+      EEPROM.update(vmSlotAddr((uint8_t)a), 0xFF);
+      refreshVmSlots();
+      reloadVmSlotIfActive((uint8_t)a, now);
+      consoleOk();
+    }
+  } else if (strcmp(sub, "bench") == 0) {
+    benchVm();
+    consoleOk();
+  } else {
+    consoleError(F("vm list|begin|data|end|del|bench"));
+  }
+}
+
+void printGovernorStatus() {
+  Serial.print(F("power: presupuesto "));
+  Serial.print(POWER_BUDGET_MA);
+  Serial.print(F(" mA | pico "));
+  Serial.print(governor.peakMa);
+  Serial.print(F(" mA | recortes "));
+  Serial.print(governor.events);
+  Serial.print(F(" ("));
+  Serial.print(governor.throttledMs / 1000);
+  Serial.print(F(" s) | ganancia prio0/prio1 "));
+  Serial.print(governor.gain[0]);
+  Serial.print('/');
+  Serial.println(governor.gain[1]);
+}
+
+void printPermille(Print& out, uint16_t pm) {
+  out.print(pm / 10);
+  out.print('.');
+  out.print(pm % 10);
+  out.print('%');
+}
+
+// Duty medio y pico, corriente y carga de los LEDs por escena; duty medio por
+// salida y consumo medio de la placa (LEDs + MCU activa, include/power_model.h).
+void printDutyStatus() {
+#if DUTY_METER_ENABLED
+  Serial.print(F("duty: LEDs por escena, tiempo despierto (100% = "));
+  Serial.print(POWER_LED_TOTAL_MA);
+  Serial.println(F(" mA)"));
+  DutyScene all = {0, 0, 0};
+  for (uint8_t k = 0; k < DUTY_SCENE_COUNT; k++) {
+    const DutyScene& d = dutyScenes[k];
+    if (d.seconds == 0) continue;
+    all.seconds += d.seconds;
+    all.ledMaS += d.ledMaS;
+    uint16_t deciMa = dutyAvgDeciMa(d);
+    Serial.print(F("  M"));
+    Serial.print(k / 2 + 1);
+    Serial.print((k & 1) ? F(" mov  | ") : F(" base | "));
+    Serial.print(d.seconds);
+    Serial.print(F(" s | medio "));
+    printPermille(Serial, dutyPermille(deciMa));
+    Serial.print(' ');
+    printMilliamps(Serial, deciMa * 100UL);
+    Serial.print(F(" | pico "));
+    printPermille(Serial, dutyPermille(d.peakMa * 10U));
+    Serial.print(' ');
+    Serial.print(d.peakMa);
+    Serial.print(F(" mA | "));
+    Serial.print(d.ledMaS / 3600);
+    Serial.print('.');
+    Serial.print((d.ledMaS % 3600) / 360);
+    Serial.println(F(" mAh"));
+  }
+  Serial.print(F("  salidas:"));
+  for (uint8_t i = 0; i < LED_COUNT; i++) {
+    Serial.print(' ');
+    uiEmitLedName(Serial, UI_TEXT_TABLE, i);
+    Serial.print(' ');
+    printPermille(Serial, dutyChannelPermille(dutyChannelS[i], all.seconds));
+  }
+  Serial.println();
+  uint16_t deciMa = dutyAvgDeciMa(all);
+  Serial.print(F("  placa: LEDs "));
+  printMilliamps(Serial, deciMa * 100UL);
+  Serial.print(F(" + MCU y placa "));
+  printMilliamps(Serial, POWER_MCU_ACTIVE_UA + POWER_BOARD_UA);
+  Serial.print(F(" = "));
+  printMilliamps(Serial, deciMa * 100UL + POWER_MCU_ACTIVE_UA + POWER_BOARD_UA);
+  Serial.print(F(" de media en "));
+  Serial.print(all.seconds);
+  Serial.println(F(" s"));
+#else
+  Serial.println(F("duty: desactivado (DUTY_METER_ENABLED=0)"));
+#endif
+}
+
+// Duty medido de una escena del modo en la hornacina principal (mv = 0 base,
+// 1 movimiento), para el snapshot: "sin medir" hasta que acumula un segundo.
+// Una linea corta: cabe entera en el buffer TX (log en cola).
+void printSnapshotDutyLine(Print& out, Mode mode, uint8_t mv) {
+  uiPrint(out, mv ? UI_DUTY_MOV : UI_DUTY_BASE);
+#if DUTY_METER_ENABLED
+  const DutyScene& d = dutyScenes[sceneKeyFor(mode, mv ? MOTION_HALF_Q8 : 0)];
+  if (d.seconds > 0) {
+    uint16_t deciMa = dutyAvgDeciMa(d);
+    printPermille(out, dutyPermille(deciMa));
+    out.print(' ');
+    printMilliamps(out, deciMa * 100UL);
+    out.print(F(" en "));
+    out.print(d.seconds);
+    out.println(F(" s"));
+    return;
+  }
+#endif
+  uiPrint(out, UI_DUTY_SIN_MEDIR);
+}
+
+void handleConsoleLine(char* line, unsigned long now) {
+  char* p = line;
+  char* cmd = consoleToken(p);
+  if (strcmp(cmd, "vm") == 0) {
+    handleVmCommand(p, now);
+  } else if (strcmp(cmd, "sync") == 0) {
+    printSyncStatus();
+    consoleOk();
+  } else if (strcmp(cmd, "mem") == 0) {
+    if (strcmp(consoleToken(p), "reset") == 0) memReset();
+    printMemStatus();
+    consoleOk();
+  } else if (strcmp(cmd, "wdt") == 0) {
+    char* sub = consoleToken(p);
+    if (strcmp(sub, "test") == 0) watchdogTest();
+    else if (strcmp(sub, "clear") == 0) crashReport.magic = 0;
+    printWatchdogStatus();
+    consoleOk();
+  } else if (strcmp(cmd, "tlm") == 0) {
+    char* sub = consoleToken(p);
+    if (strcmp(sub, "dump") == 0) dumpTelemetry();
+    else if (strcmp(sub, "clear") == 0) clearTelemetry();
+    printTelemetryStatus();
+    consoleOk();
+  } else if (strcmp(cmd, "ambient") == 0) {
+    printAmbientStatus();
+    consoleOk();
+  } else if (strcmp(cmd, "power") == 0) {
+    if (strcmp(consoleToken(p), "reset") == 0) {
+      governor.events = 0;
+      governor.throttledMs = 0;
+      governor.peakMa = 0;
+    }
+    printGovernorStatus();
+    consoleOk();
+  } else if (strcmp(cmd, "sleep") == 0) {
+    printSleepStatus(now);
+    consoleOk();
+  } else if (strcmp(cmd, "duty") == 0) {
+    if (strcmp(consoleToken(p), "reset") == 0) dutyReset();
+    printDutyStatus();
+    consoleOk();
+  } else if (strcmp(cmd, "help") == 0) {
+    Serial.println(F("Comandos: help | mem [reset] | wdt [clear|test] | tlm [dump|clear] | ambient | power [reset] | sleep | duty [reset] | sync | vm list | vm begin <slot> <bytes> <rev> | vm data <hex> | vm end <crc> | vm del <slot> | vm bench"));
+    consoleOk();
+  } else if (*cmd) {
+    consoleError(F("comando desconocido (help)"));
+  }
+}
+
+void pollSerialConsole(const FrameContext& fc) {
+  for (uint8_t n = 0; n < CONSOLE_BYTES_PER_FRAME && Serial.available() > 0; n++) {
+    char c = (char)Serial.read();
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (consoleLen < CONSOLE_LINE_MAX) consoleLine[consoleLen++] = c;
+      else consoleOverflow = true;
+      continue;
     }
+    consoleLine[consoleLen] = '\0';
+    sleepNoteActivity(fc.now);
+    logSpoolFlush(); // la respuesta no se mezcla con un log a medias
+    if (consoleOverflow) consoleError(F("linea demasiado larga"));
+    else handleConsoleLine(consoleLine, fc.now);
+    consoleLen = 0;
+    consoleOverflow = false;
   }
 }
 
+
 // ==============================================================================
-// Funciones de modo (aplican configuración base o submodo)
+// Setup y Loop
 // ==============================================================================
 
-void applyMode() {
-  bool movementActive = inMovementMode;
-  // Por defecto, FIZO/FDEP/ATRA no hacen fade; se habilita solo donde aplique.
-  setLedFadeInOutActive(3, false);
-  setLedFadeInOutActive(4, false);
-  setLedFadeInOutActive(5, false);
-  
-  switch (currentMode) {
-    
-    case MODE_1_CONTEMPLATIVO:
-      {
-      const Mode1Profile& p = getMode1Profile();
-      setLedFadeInOutActive(2, false);
-      if (movementActive) {
-        updateCandleFlicker(percentToPwm(p.canMovePct));
-        applyOrganicDrift(
-          2,
-          p.caraMoveMinPct,
-          p.caraMoveMaxPct,
-          p.caraMoveTargetMinMs,
-          p.caraMoveTargetMaxMs,
-          p.caraMoveStepMinPct,
-          p.caraMoveStepMaxPct,
-          p.caraMoveStepIntervalMs
-        );
-        applyTriadCircularHalo(p.triadMoveBasePct, p.triadMovePeakPct, p.triadMovePeriodMs);
-      } else {
-        updateCandleFlicker(percentToPwm(p.canBasePct));
-        applyOrganicDrift(
-          2,
-          p.caraBaseMinPct,
-          p.caraBaseMaxPct,
-          p.caraBaseTargetMinMs,
-          p.caraBaseTargetMaxMs,
-          p.caraBaseStepMinPct,
-          p.caraBaseStepMaxPct,
-          p.caraBaseStepIntervalMs
-        );
-        applyTriadCircularHalo(p.triadBasePct, p.triadPeakBasePct, p.triadBasePeriodMs);
+// Eventos de un controlador: log por serie de todos (en cola, seccion "Log sin
+// esperas"); telemetria y bus solo de la principal.
+void boardShrineEvent(void*, ShrineController& s, ShrineEvent type, uint8_t arg) {
+  bool primary = &s == &shrines[0];
+  uint8_t k = (uint8_t)(&s - shrines);
+  switch (type) {
+    case SHRINE_EVT_MODE:
+      if (primary) {
+        telemetryEvent(TLM_EVT_MODE, arg);
+        syncNotifyMode();
       }
       break;
-      }
-    
-    case MODE_2_SOLO_CANDELITA:
-      if (movementActive) {
-        updateCandleFlicker(178); // CAN ~70% during movimiento
-        configureLedFadeInOutPercent(2, DEFAULT_CARA_MIN_PCT, DEFAULT_CARA_MAX_PCT, DEFAULT_CARA_SPEED_MS);
-        setLedFadeInOutActive(2, true); // enable CARA fade
-      } else {
-        updateCandleFlicker(51);  // CAN ~20% base
-        setLedFadeInOutActive(2, false);
-        setLedStaticPercent(2, 5); // CARA ~5% en reposo
-      }
-      setLedState(3, 0);
-      setLedState(4, 0);
-      setLedState(5, 0);
+    case SHRINE_EVT_MOTION:
+      if (arg == 0) logSpoolPush(LOG_MOTION, k, s.currentMode);
+      else logSpoolPush(LOG_RETRIGGER, k, s.currentMode, (uint8_t)((uint16_t)(s.input.motionCharge >> 16) * 100U / 256U), s.input.pirFolded);
+      if (primary) telemetryEvent(TLM_EVT_PIR, arg);
+      if (primary && arg == 0) syncNotifyMotion();
       break;
-    
-    case MODE_3_CANDELITA_PASTOR:
-      if (movementActive) {
-        updateCandleFlicker(230); // candelita ~90%
-        setLedStaticPercent(2, 50); // CARA
-        setLedFadeInOutActive(4, true); // FDEP fade in/out
-        setLedState(3, percentToPwm(10)); // FIZO fijo 10% (forzado)
-        // FDEP se actualiza por fade activo (0..100%)
-      } else {
-        updateCandleFlicker(178); // candelita ~70%
-        setLedStaticPercent(2, 10); // CARA
-        applySingleBreathing(3, 10, 50, 4200); // FIZO respiracion devocional hasta 50%
-        setLedStaticPercent(4, 40); // FDEP
-      }
-      setLedState(5, 0);
+    case SHRINE_EVT_PIR_LOW:
+      logSpoolPush(LOG_PIR_LOW, k, s.currentMode, 0, s.input.pirFolded);
       break;
-    
-    case MODE_4_CANDELITA_PASTOR_VIRGEN:
-      if (movementActive) {
-        updateCandleFlicker(230); // CAN ~90%
-        disableRandomFlashEffect(3); // FIZO
-        disableRandomFlashEffect(4); // FDEP
-        disableRandomFlashEffect(5); // ATRA
-        setLedStaticPercent(2, 40); // CARA
-        setLedStaticPercent(3, 80); // FIZO
-        setLedStaticPercent(4, 80); // FDEP
-        setLedFadeInOutActive(5, true); // ATRA fade in/out
-      } else {
-        updateCandleFlicker(178); // CAN ~70%
-        setLedStaticPercent(2, 10); // CARA
-        applyRandomFlashTenue(3, 10, 60, 100, 120, 18, 50, 130); // FIZO
-        applyRandomFlashTenue(4, 10, 60, 100, 140, 16, 50, 130); // FDEP
-        applyRandomFlashTenue(5, 10, 55, 95, 160, 14, 60, 150);  // ATRA
-      }
+    case SHRINE_EVT_TIMEOUT:
+      logSpoolPush(LOG_TIMEOUT, k, s.currentMode);
+      if (primary) telemetryEvent(TLM_EVT_TIMEOUT, 0);
       break;
-    
-    case MODE_5_CANDELITA_PASTOR_VIRGEN_CARA:
-      if (movementActive) {
-        updateCandleFlicker(204); // CAN ~80%
-        configureLedFadeInOutPercent(2, MODE5_CARA_MIN_PCT, MODE5_CARA_MAX_PCT, MODE5_CARA_SPEED_MS);
-        setLedFadeInOutActive(2, true); // CARA fade 40%..90%
-        configureLedFadeInOutPercent(3, MODE5_FIZO_FDEP_MIN_PCT, MODE5_FIZO_FDEP_MAX_PCT, MODE5_FIZO_FDEP_SPEED_MS);
-        configureLedFadeInOutPercent(4, MODE5_FIZO_FDEP_MIN_PCT, MODE5_FIZO_FDEP_MAX_PCT, MODE5_FIZO_FDEP_SPEED_MS);
-        configureLedFadeInOutPercent(5, MODE5_FIZO_FDEP_MIN_PCT, MODE5_FIZO_FDEP_MAX_PCT, MODE5_FIZO_FDEP_SPEED_MS);
-        setLedFadeInOutActive(3, true); // FIZO fade 0%..5%
-        setLedFadeInOutActive(4, true); // FDEP fade 0%..5%
-        setLedFadeInOutActive(5, true); // ATRA fade 0%..5%
-      } else {
-        updateCandleFlicker(178); // CAN ~70%
-        setLedFadeInOutActive(2, false);
-        setLedStaticPercent(2, 40); // CARA
-        setLedStaticPercent(3, 10); // FIZO
-        setLedStaticPercent(4, 10); // FDEP
-        setLedStaticPercent(5, 10); // ATRA
-      }
+    case SHRINE_EVT_SNAPSHOT:
+      logSpoolPush(LOG_SNAPSHOT, k, s.currentMode);
       break;
-    
-    case MODE_6_ENFASIS_VIRGEN:
-      if (movementActive) {
-        updateCandleFlicker(255); // CAN ~100%
-        applyDevotionalBreathing(40, 80, 4200, 450, 70); // CARA + ATRA
-        setLedStaticPercent(3, 30);  // FIZO
-        setLedStaticPercent(4, 30);  // FDEP
-      } else {
-        updateCandleFlicker(178); // CAN ~70%
-        setLedStaticPercent(2, 60); // CARA
-        applySeaWaveCircularMode6Base(
-          MODE6_OLA_ATRA_MIN_PCT,
-          MODE6_OLA_ATRA_MAX_PCT,
-          MODE6_OLA_GRUPO_MIN_PCT,
-          MODE6_OLA_GRUPO_MAX_PCT,
-          MODE6_OLA_PERIOD_MS
-        );
-      }
+    case SHRINE_EVT_CACHE:
+      logSpoolPush(LOG_CACHE, k, s.currentMode);
       break;
-
-    default:
+    case SHRINE_EVT_VM_FAULT:
+      logSpoolPush(LOG_VM_FAULT, k, s.currentMode, arg, s.vm.pc);
       break;
   }
 }
 
-// ==============================================================================
-// Setup y Loop
-// ==============================================================================
+const ShrineSink BOARD_SINK = {boardSinkWrite, boardShrineEvent, 0};
 
 void setup() {
+  watchdogBegin();
   Serial.begin(115200);
   delay(300);
-  Serial.println(F("\n=== VIRGO CITA LUCES - 6 MODOS ==="));
+  uiPrint(UI_ARRANQUE);
   randomSeed((unsigned long)analogRead(A0) + micros());
+  ambientBegin(); // despues del unico analogRead(): el ADC pasa a modo libre
   
-  pinMode(BTN_PIN, INPUT_PULLUP);
-  pinMode(PIR_PIN, INPUT);
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) {
+    shrineBegin(shrines[k], SHRINE_CONFIGS[k], BOARD_PLATFORM, BOARD_SINK, &sceneCache, millis());
+    pinMode(SHRINE_CONFIGS[k].btnPin, INPUT_PULLUP);
+    pinMode(SHRINE_CONFIGS[k].pirPin, INPUT);
+  }
   
   for (uint8_t i = 0; i < LED_COUNT; i++) {
     pinMode(LED_PINS[i], OUTPUT);
     digitalWrite(LED_PINS[i], LOW);
   }
   
-  Serial.println(F("Pines configurados:"));
-  Serial.println(F("  BTN: D2 (INPUT_PULLUP)"));
-  Serial.println(F("  PIR: D4 (INPUT)"));
-  Serial.println(F("  LEDs: D3, D5, D6, D9, D10, D11"));
+  uiPrint(UI_PINES);
+#if SHRINE_SPLIT
+  Serial.println(F("  Hornacina 1: D3 D5 D6 (CAN1 CAN2 CARA), boton D2, PIR D4"));
+  Serial.println(F("  Hornacina 2: D9 D10 D11 (CAN1 CAN2 CARA), boton A2, PIR A3"));
+#endif
   
   // Asignar nombres
   setLedName(0, "CAN1");
@@ -1037,79 +2170,93 @@ void setup() {
   setLedName(4, "FDEP");
   setLedName(5, "ATRA");
   printLedNames();
-  // Inicializar FADE IN/OUT reutilizable para CARA (indice 2)
-  configureLedFadeInOutPercent(2, DEFAULT_CARA_MIN_PCT, DEFAULT_CARA_MAX_PCT, DEFAULT_CARA_SPEED_MS);
-  // Inicializar FADE IN/OUT reutilizable para FDEP (indice 4)
-  configureLedFadeInOutPercent(4, DEFAULT_FDEP_MIN_PCT, DEFAULT_FDEP_MAX_PCT, DEFAULT_FDEP_SPEED_MS);
-  // Inicializar FADE IN/OUT reutilizable para ATRA en Modo 4 movimiento (indice 5)
-  configureLedFadeInOutPercent(5, DEFAULT_ATRA_M4_MIN_PCT, DEFAULT_ATRA_M4_MAX_PCT, DEFAULT_ATRA_M4_SPEED_MS);
+  // Los fades se configuran al activarse: el slot de efecto de cada canal es compartido.
+  printEffectStateFootprint();
+#if BENCH_EFFECTS
+  benchEffectFrames();
+#endif
   
-  Serial.println(F("\nModos disponibles:"));
-  Serial.println(F("  1. CONTEMPLATIVO AURORA"));
-  Serial.println(F("  2. SOLO CANDELITA"));
-  Serial.println(F("  3. CANDELITA + PASTOR"));
-  Serial.println(F("  4. CANDELITA + PASTOR + VIRGEN"));
-  Serial.println(F("  5. CANDELITA + PASTOR + VIRGEN SOLO CARA"));
-  Serial.println(F("  6. ENFASIS VIRGEN"));
-  Serial.println(F("\nPulsa el boton para cambiar modo."));
-  Serial.println(F("Movimiento detectable por PIR (D4)."));
+  uiPrint(UI_MODOS);
+  refreshVmSlots();
+  uiPrint(UI_MODOS_VM);
+  printVmSlots();
+  uiPrint(UI_AYUDA);
+#if SLEEP_ENABLED
+  {
+    const uint16_t args[] = {SLEEP_IDLE_MIN};
+    uiPrint(UI_REPOSO_AVISO, args);
+  }
+#endif
+  syncBegin();
+  telemetryBegin(bootResetFlags);
+  watchdogResume();
   
-  printModeSnapshot();
+  logSpoolPush(LOG_SNAPSHOT, 0, shrines[0].currentMode);
+  logSpoolFlush();
+  watchdogArm();
+}
+
+// Construye el contexto del frame: una sola lectura del reloj por vuelta (el
+// reloj sincronizado si el bus multi-nodo esta activo).
+FrameContext& beginFrame() {
+  unsigned long now = syncFrameTime(millis() - sleepPausedMs);
+  unsigned long dt = now - frameCtx.now;
+  frameCtx.dtMs = (dt > 65535UL) ? 65535 : (uint16_t)dt;
+  frameCtx.now = now;
+  frameCtx.tick = (uint16_t)now;
+  frameCtx.frame++;
+  frameCtx.motion = shrines[0].input.inMovementMode;
+  frameCtx.motionQ8 = inputMotionQ8(shrines[0].input);
+  return frameCtx;
 }
 
 void loop() {
-  unsigned long now = millis();
-  // Actualizaciones no bloqueantes de animaciones: fades y soft-offs
-  updateSoftOffs();
-  // también actualizar cualquier fade activo (por ejemplo CARA)
-  for (uint8_t i = 0; i < LED_COUNT; i++) updateFade(i);
-  
-  // ==== BOTON (Debounce) ====
-  int reading = digitalRead(BTN_PIN);
-  if (reading != lastButtonState) {
-    lastDebounceTime = now;
-  }
-  
-  if ((now - lastDebounceTime) > DEBOUNCE_DELAY) {
-    if (reading != lastBtnPressed) {
-      lastBtnPressed = reading;
-      if (lastBtnPressed == LOW) {
-        // Boton presionado: cambiar modo
-        currentMode = (Mode)((currentMode + 1) % MODE_COUNT);
-        allLedsOff();
-        printModeSnapshot();
-      }
-    }
-  }
-  lastButtonState = reading;
-  
-  // ==== PIR (Movimiento) ====
-  bool motionActive = (digitalRead(PIR_PIN) == HIGH);
-  
-  if (motionActive && !lastMotionState) {
-    // Inicia una ventana de 30s por deteccion (latch)
-    if (!inMovementMode) {
-      lastMotionTime = now;
-      inMovementMode = true;
-      Serial.println(F(">>> MOVIMIENTO DETECTADO: SUBMODO ACTIVO 30s <<<"));
-      printModeProfile(currentMode, true);
-    } else {
-      Serial.println(F(">>> PIR ALTO (ignorado, submodo activo) <<<"));
-    }
-    lastMotionState = true;
-  } else if (!motionActive && lastMotionState) {
-    // Solo informativo: no cortar submodo por PIR bajo
-    Serial.println(F(">>> PIR bajo (esperando timeout) <<<"));
-    lastMotionState = false;
-  }
-  
-  // Timeout de movimiento: si han pasado 30s desde lastMotionTime, salir del submodo
-  if (inMovementMode && (now - lastMotionTime >= MOVEMENT_TIMEOUT_MS)) {
-    Serial.println(F(">>> Timeout de movimiento (volviendo a modo base) <<<"));
-    inMovementMode = false;
-    printModeProfile(currentMode, false);
+  FrameContext& fc = beginFrame();
+
+  // ==== WATCHDOG (alimenta + caja negra) ====
+  watchdogFrame(fc);
+
+  // ==== BUS MULTI-NODO (reloj, modo y movimiento del grupo) ====
+  pollSyncBus(fc);
+
+  // ==== TELEMETRIA (reloj de segundos + escritura pendiente en EEPROM) ====
+  telemetryFrame();
+
+  // ==== MEMORIA (marca de agua de la pila, pasada de fondo) ====
+  memFrame();
+
+  // ==== CONSOLA SERIE ====
+  loopStage(STAGE_CONSOLE);
+  pollSerialConsole(fc);
+
+  // ==== BOTON (Debounce) + PIR (Movimiento) de cada hornacina ====
+  loopStage(STAGE_INPUT);
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) {
+    const ShrineConfig& cfg = SHRINE_CONFIGS[k];
+    shrineInputs(shrines[k], fc, digitalRead(cfg.btnPin), digitalRead(cfg.pirPin) == HIGH);
+    if (inputActive(shrines[k].input)) sleepNoteActivity(fc.now);
   }
-  
-  // ==== APLICAR MODO ====
-  applyMode();
-}
+  fc.motion = shrines[0].input.inMovementMode;
+  fc.motionQ8 = inputMotionQ8(shrines[0].input);
+
+  // ==== REPOSO (atenuacion por inactividad) ====
+  loopStage(STAGE_MOTION);
+  updateSleep(fc);
+
+  // ==== APLICAR MODO + SECUENCIAS + COMPOSICION (cada hornacina a su sink) ====
+  loopStage(STAGE_RENDER);
+  uint8_t dim = (uint8_t)(((uint16_t)outputDimQ8 * ambientDimQ8 + 255) >> 8);
+  for (uint8_t k = 0; k < SHRINE_COUNT; k++) shrineRender(shrines[k], fc, dim);
+
+  // ==== COMMIT DE LA PLACA (unica escritura a hardware) ====
+  loopStage(STAGE_COMMIT);
+  boardFlush(fc.dtMs);
+
+  // ==== LOG (lo que cabe en el buffer TX, sin esperar) ====
+  loopStage(STAGE_LOG);
+  logSpoolPump(false);
+
+  // ==== REPOSO (duerme aqui hasta PIR o boton) ====
+  loopStage(STAGE_SLEEP);
+  sleepIfIdle(fc);
+}
\ No newline at end of file